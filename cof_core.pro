@@ -26,6 +26,7 @@ QMAKE_LFLAGS += -Wl,-rpath,$$PWD/libtorch/lib
 QMAKE_LFLAGS += -Wl,--no-as-needed
 
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+#DEFINES += COF_COUNT_ALLOCATIONS    # replaces global operator new to report allocations/step in training throughput
 
 # Input
 HEADERS += lua/lauxlib.h \
@@ -34,47 +35,67 @@ HEADERS += lua/lauxlib.h \
            lua/luaconf.h \
            lua/lualib.h \
            game/src/core/adventure_map.h \
+           game/src/core/ai_value_field.h \
            game/src/core/artifact.h \
            game/src/core/battlefield.h \
            game/src/core/battlefield_hex_grid.h \
+           game/src/core/block_compression.h \
            game/src/core/creature.h \
+           game/src/core/fog_of_war.h \
            game/src/core/game.h \
            game/src/core/game_config.h \
            game/src/core/hero.h \
            game/src/core/interactable_object.h \
            game/src/core/lua_api.h \
            game/src/core/map_file.h \
-           game/src/core/script.h \
+           game/src/core/map_file_v2.h \
            game/src/core/network_actions.h \
+           game/src/core/object_index.h \
+           game/src/core/save_checkpoint.h \
+           game/src/core/save_worker.h \
+           game/src/core/script.h \
            game/src/core/spell.h \
+           game/src/core/tile_store.h \
            game/src/core/town.h \
            game/src/core/troop.h \
-           game/src/core/utils.h
+           game/src/core/utils.h \
+           game/src/core/zone_graph.h
 
 SOURCES += 	main.cpp \
             game/src/core/ai_adventure_map.cpp \
             game/src/core/ai_combat.cpp \
+            game/src/core/ai_value_field.cpp \
             game/src/core/adventure_map.cpp \
             game/src/core/hero.cpp \
             game/src/core/artifact.cpp \
             game/src/core/battlefield.cpp \
+            game/src/core/block_compression.cpp \
+            game/src/core/fog_of_war.cpp \
             game/src/core/lua_api.cpp \
             game/src/core/game.cpp \
             game/src/core/game_config.cpp \
             game/src/core/interactable_object.cpp \
             game/src/core/map_file.cpp \
-            game/src/core/town.cpp
+            game/src/core/map_file_v2.cpp \
+            game/src/core/save_checkpoint.cpp \
+            game/src/core/save_worker.cpp \
+            game/src/core/object_index.cpp \
+            game/src/core/tile_store.cpp \
+            game/src/core/town.cpp \
+            game/src/core/zone_graph.cpp
 
 HEADERS += game/src/rl/battle_sim.h \
            game/src/rl/battle_session.h \
            game/src/rl/combat_agent.h \
            game/src/rl/combat_environment.h \
+           game/src/rl/combat_league.h \
            game/src/rl/combat_observation.h \
            game/src/rl/combat_training.h
 SOURCES += game/src/rl/battle_sim.cpp \
            game/src/rl/battle_session.cpp \
            game/src/rl/combat_agent.cpp \
            game/src/rl/combat_environment.cpp \
+           game/src/rl/combat_league.cpp \
            game/src/rl/combat_observation.cpp \
            game/src/rl/combat_training.cpp
 
@@ -2,6 +2,7 @@
 #include "core/game.h"
 #include "core/utils.h"
 
+#include <algorithm>
 #include <queue>
 #include <map>
 #include <cmath>
@@ -264,7 +265,7 @@ void adventure_map_t::populate_refugee_camp(refugee_camp_t* camp) {
 }
 
 adventure_map_t::adventure_map_t(uint width, uint height) : width(width), height(height) {
-	tiles.resize(width * height);
+	tiles.reset(width, height);
 }
 
 bool adventure_map_t::tile_valid(int x, int y) const {
@@ -584,6 +585,11 @@ void adventure_map_t::clear(bool delete_objects, bool clear_tiles) {
 	player_object_visited_map.clear();
 	
 	monster_guarded_cache_valid = false;
+	hero_occupancy_valid = false;
+	object_index = object_index_t();
+	invalidate_reachability_fields();
+	reachability_object_count = 0;
+	zone_graph.invalidate();
 }
 
 bool adventure_map_t::remove_hero(hero_t* hero) {
@@ -602,6 +608,12 @@ bool adventure_map_t::remove_hero(hero_t* hero) {
 	
 	for(auto it = heroes.begin(); it != heroes.end(); it++) {
 		if(&(it->second) == hero) {
+			mark_zone_graph_dirty(hero->x, hero->y);
+			set_hero_occupancy(hero, false);
+			if(hero_occupancy_hero_count == heroes.size())
+				hero_occupancy_hero_count--;
+			
+			invalidate_reachability_fields(hero->x, hero->y, hero->x, hero->y);
 			heroes.erase(it);
 			return true;
 		}
@@ -618,11 +630,20 @@ bool adventure_map_t::remove_interactable_object(interactable_object_t* object)
 
 	for(uint i = 0; i < objects.size(); i++) {
 		if(objects[i] == object) {
-			auto& tile = get_tile(object->x, object->y);
+			const int x = object->x;
+			const int y = object->y;
+			auto tile = get_tile_ref(x, y);
 			tile.interactable_object = 0;
+			if(object->object_type == OBJECT_MAP_MONSTER)
+				set_monster_guard(i, false);
+			
+			if(i < object_index.indexed_count)
+				object_index.remove(i);
+			
 			delete objects[i];
 			objects[i] = nullptr;
-			monster_guarded_cache_valid = false;
+			invalidate_reachability_fields(x, y, x, y);
+			mark_zone_graph_dirty(x, y);
 			
 			return true;
 		}
@@ -630,44 +651,32 @@ bool adventure_map_t::remove_interactable_object(interactable_object_t* object)
 	return false;
 }
 
-const map_tile_t& adventure_map_t::get_tile(int x, int y) const {
-	assert(x >= 0 && x < width && y >= 0 && y < height);
-	assert(y * width + x < std::ssize(tiles));
-	return tiles[y * width + x];
-}
-
-map_tile_t& adventure_map_t::get_tile(int x, int y) {
-	assert(x >= 0 && x < width && y >= 0 && y < height);
-	assert(y * width + x < std::ssize(tiles));
-	return tiles[y * width + x];
-}
-
 bool adventure_map_t::is_tile_monster_guarded(int x, int y) const {
 	if(!tile_valid(x, y))
 		return false;
 
-	if(!monster_guarded_cache_valid)
+	if(is_monster_guard_cache_stale())
 		update_guarded_monster_cache();
 
 	return monster_guarded_cache.testBit(x + y * width);
 }
 
 map_monster_t* adventure_map_t::get_monster_guarding_tile(int x, int y) const {
-	interactable_object_t* object = nullptr;
 	if(!tile_valid(x, y))
 		return nullptr;
-		
-	for(auto obj : objects) {
-		if(!obj || obj->object_type != OBJECT_MAP_MONSTER)
-			continue;
-		
-		if(abs(x - obj->x) <= 1 && abs(y - obj->y) <= 1) {
-			object = obj;
-			break;
-		}
-	}
 	
-	return (map_monster_t*)object;
+	if(is_monster_guard_cache_stale())
+		update_guarded_monster_cache();
+	
+	const auto& guards = monster_guards[x + (y * width)];
+	if(guards.empty())
+		return nullptr;
+	
+	return (map_monster_t*)objects[guards.front()];
+}
+
+bool adventure_map_t::is_monster_guard_cache_stale() const {
+	return !monster_guarded_cache_valid || monster_guards.size() != (size_t)width * height;
 }
 
 void adventure_map_t::update_guarded_monster_cache() const {
@@ -676,20 +685,20 @@ void adventure_map_t::update_guarded_monster_cache() const {
 	}
 	monster_guarded_cache.fill(false);
 	
-	std::vector<map_monster_t*> monsters;
-	for(auto obj : objects) {
-		if(obj && obj->object_type == OBJECT_MAP_MONSTER)
-			monsters.push_back((map_monster_t*)(obj));
-	}
-
-	for(auto* monster : monsters) {
+	monster_guards.assign((size_t)width * height, {});
+	for(uint16_t i = 0; i < objects.size(); i++) {
+		auto obj = objects[i];
+		if(!obj || obj->object_type != OBJECT_MAP_MONSTER)
+			continue;
+		
 		for(int dy = -1; dy <= 1; dy++) {
 			for(int dx = -1; dx <= 1; dx++) {
-				int tx = monster->x + dx;
-				int ty = monster->y + dy;
-				if(tile_valid(tx, ty))
+				int tx = obj->x + dx;
+				int ty = obj->y + dy;
+				if(tile_valid(tx, ty)) {
 					monster_guarded_cache.setBit(tx + ty * width, true);
-				
+					monster_guards[tx + (ty * width)].push_back(i);
+				}
 			}
 		}
 	}
@@ -697,11 +706,37 @@ void adventure_map_t::update_guarded_monster_cache() const {
 	monster_guarded_cache_valid = true;
 }
 
+void adventure_map_t::set_monster_guard(uint16_t object_id, bool guarding) const {
+	//nothing to patch; the next query rebuilds from objects
+	if(is_monster_guard_cache_stale() || object_id >= objects.size() || !objects[object_id])
+		return;
+	
+	const auto* monster = objects[object_id];
+	for(int dy = -1; dy <= 1; dy++) {
+		for(int dx = -1; dx <= 1; dx++) {
+			int tx = monster->x + dx;
+			int ty = monster->y + dy;
+			if(!tile_valid(tx, ty))
+				continue;
+			
+			int offset = tx + (ty * width);
+			auto& guards = monster_guards[offset];
+			auto it = std::lower_bound(guards.begin(), guards.end(), object_id);
+			if(guarding && (it == guards.end() || *it != object_id))
+				guards.insert(it, object_id);
+			else if(!guarding && it != guards.end() && *it == object_id)
+				guards.erase(it);
+			
+			monster_guarded_cache.setBit(offset, !guards.empty());
+		}
+	}
+}
+
 bool adventure_map_t::is_tile_guarded_by_monster(int x, int y) const {
-	if(!monster_guarded_cache_valid)
+	if(is_monster_guard_cache_stale())
 		update_guarded_monster_cache();
 	
-	int offset = x + (y * height);
+	int offset = x + (y * width);
 	return monster_guarded_cache.testBit(offset);
 	
 	//return get_monster_guarding_tile(x, y) != nullptr;
@@ -713,16 +748,17 @@ float adventure_map_t::get_terrain_movement_base_cost(const hero_t* hero, int x,
 	if(!tile_valid(x, y))
 		return base_cost;
 	
-	const auto& tile = get_tile(x, y);
+	const size_t tile = tiles.index(x, y);
+	const auto road_type = tiles.road_type[tile];
 	
-	if(tile.road_type == ROAD_DIRT)
+	if(road_type == ROAD_DIRT)
 		return 8.f;
-	else if(tile.road_type == ROAD_GRAVEL)
+	else if(road_type == ROAD_GRAVEL)
 		return 7.f;
-	else if(tile.road_type == ROAD_COBBLESTONE)
+	else if(road_type == ROAD_COBBLESTONE)
 		return 5.f;
 	
-	switch(tile.terrain_type) {
+	switch(tiles.terrain_type[tile]) {
 		case TERRAIN_WATER:
 			base_cost = 5.f; break;
 		case TERRAIN_GRASS:
@@ -750,7 +786,7 @@ float adventure_map_t::get_terrain_movement_base_cost(const hero_t* hero, int x,
 	if(!hero)
 		return base_cost;
 
-	if(tile.terrain_type != TERRAIN_WATER) {
+	if(tiles.terrain_type[tile] != TERRAIN_WATER) {
 		if(hero->is_artifact_equipped(ARTIFACT_SWAMPWADERS))
 			return 10.f;
 		
@@ -775,66 +811,119 @@ int adventure_map_t::heuristic(int x1, int y1, int x2, int y2) const {
 	return 1 * (abs(x1 - x2) + abs(y1 - y2)); //manhattan distance
 }
 
+//per-thread scratch for find_route, sized to the largest map seen on this thread. entries are only valid when their
+//stamp matches the current search generation, so starting a new search is O(1) instead of clearing every array
+struct route_search_scratch_t {
+	uint32_t generation = 0;
+	std::vector<uint32_t> node_stamp; //g_score/came_from/penalty valid for this search
+	std::vector<uint32_t> queued_stamp; //node has been pushed onto the open set during this search
+	std::vector<uint32_t> cost_stamp; //movement_base_cost valid for this search
+	std::vector<int> g_score;
+	std::vector<int> came_from;
+	std::vector<int> penalty;
+	std::vector<float> movement_base_cost;
+	std::vector<uint64_t> open_set; //binary min-heap of packed (f, x, y) keys
+
+	void begin(size_t tile_count) {
+		if(node_stamp.size() < tile_count) {
+			node_stamp.assign(tile_count, 0);
+			queued_stamp.assign(tile_count, 0);
+			cost_stamp.assign(tile_count, 0);
+			g_score.resize(tile_count);
+			came_from.resize(tile_count);
+			penalty.resize(tile_count);
+			movement_base_cost.resize(tile_count);
+			generation = 0;
+		}
+
+		if(++generation == 0) {
+			std::fill(node_stamp.begin(), node_stamp.end(), 0);
+			std::fill(queued_stamp.begin(), queued_stamp.end(), 0);
+			std::fill(cost_stamp.begin(), cost_stamp.end(), 0);
+			generation = 1;
+		}
+
+		open_set.clear();
+	}
+};
+
+//the key orders exactly like the std::tuple<int, int, int>(f, x, y) the open set used to hold: f, then x, then y
+static uint64_t pack_open_set_key(int f, int x, int y) {
+	return ((uint64_t)(uint32_t)f << 32) | ((uint64_t)(uint16_t)x << 16) | (uint64_t)(uint16_t)y;
+}
+
 route_t adventure_map_t::get_route(const hero_t* hero, int x2, int y2, const game_t* game) const {
-	route_t route;
-	if(!hero || !tile_valid(x2, y2))
-		return route;
+	if(!hero)
+		return route_t();
 	
-	std::priority_queue<std::tuple<int, int, int>, std::vector<std::tuple<int, int, int>>, std::greater<std::tuple<int, int, int>>> open_set;
-	std::map<coord_t, coord_t> came_from;
+	return find_route(hero, hero->x, hero->y, x2, y2, game, false);
+}
+
+route_t adventure_map_t::get_route_ignoring_blockables(const hero_t* hero, int x2, int y2, const game_t* game) const {
+	if(!hero)
+		return route_t();
 	
-	std::map<coord_t, int> f_score;
-	std::map<coord_t, int> penalty_score;
+	return find_route(hero, hero->x, hero->y, x2, y2, game, true);
+}
 
-	//cannot make these static as it is would not be thread-safe
-	std::vector<int> g_score;
-	g_score.resize(width * height);
-	std::fill(g_score.begin(), g_score.end(), -1);
+//A* over flat width*height arrays. the search order matches the previous std::map/std::set implementation exactly:
+//a tile is pushed onto the open set at most once (later g_score improvements update its parent but keep its
+//original queue position), and ties pop in (f, x, y) order
+route_t adventure_map_t::find_route(const hero_t* hero, int x1, int y1, int x2, int y2, const game_t* game, bool ignore_blockables) const {
+	route_t route;
+	if(!hero || !tile_valid(x1, y1) || !tile_valid(x2, y2))
+		return route;
 	
-	std::vector<float> movement_base_cost_cache;
-	movement_base_cost_cache.resize(width * height);
-	std::fill(movement_base_cost_cache.begin(), movement_base_cost_cache.end(), -1);
+	static thread_local route_search_scratch_t scratch;
+	scratch.begin((size_t)width * height);
+	const uint32_t generation = scratch.generation;
+	auto& open_set = scratch.open_set;
 	
-	auto get_terrain_movement_base_cost_cached = [this, hero, &movement_base_cost_cache](int x, int y) {
+	auto get_g_score = [&](int index) {
+		return scratch.node_stamp[index] == generation ? scratch.g_score[index] : -1;
+	};
+	
+	auto get_terrain_movement_base_cost_cached = [&](int x, int y) {
 		int index = x + (y * width);
-		auto value = movement_base_cost_cache[index];
-		if(value <= -1) {
-			auto cost = get_terrain_movement_base_cost(hero, x, y);
-			movement_base_cost_cache[index] = cost;
-			return cost;
+		if(scratch.cost_stamp[index] != generation) {
+			scratch.movement_base_cost[index] = get_terrain_movement_base_cost(hero, x, y);
+			scratch.cost_stamp[index] = generation;
 		}
 		
-		return value;
+		return scratch.movement_base_cost[index];
+	};
+	
+	auto push_open_set = [&](int f, int x, int y) {
+		open_set.push_back(pack_open_set_key(f, x, y));
+		std::push_heap(open_set.begin(), open_set.end(), std::greater<uint64_t>());
 	};
 
-	int x1 = hero->x;
-	int y1 = hero->y;
-	coord_t start = {x1, y1};
-	coord_t goal = {x2, y2};
-
-	//g_score[start.x + (start.y * width)]; //g_score[start] = 0;
-	f_score[start] = heuristic(x1, y1, x2, y2);
+	const int start_index = x1 + (y1 * width);
+	const int goal_index = x2 + (y2 * width);
 
-	open_set.push(std::make_tuple(f_score[start], x1, y1));
+	push_open_set(heuristic(x1, y1, x2, y2), x1, y1);
 
 	bool on_land = get_tile(x1, y1).terrain_type != TERRAIN_WATER;
 	
-	std::set<coord_t> open_set_coords;
+	const int dx[] = { 1, 0, -1, 0, 1, 1, -1, -1 };
+	const int dy[] = { 0, 1, 0, -1, 1, -1, 1, -1 };
 	
 	while(!open_set.empty()) {
-		int current_x = std::get<1>(open_set.top());
-		int current_y = std::get<2>(open_set.top());
-		coord_t current = {current_x, current_y};
-		open_set.pop();
+		std::pop_heap(open_set.begin(), open_set.end(), std::greater<uint64_t>());
+		const uint64_t key = open_set.back();
+		open_set.pop_back();
+		
+		int current_x = (int)((key >> 16) & 0xFFFF);
+		int current_y = (int)(key & 0xFFFF);
+		int current_index = current_x + (current_y * width);
 
-		if(current == goal) {
+		if(current_index == goal_index) {
 			int max_steps = 10000;
 			int s = 0;
-			while(current != start) {
-				int step_cost = g_score[current.x + (current.y * width)];//g_score[current];
-				int penalty = penalty_score[current];
-				route.push_front({current, step_cost, penalty});
-				current = came_from[current];
+			while(current_index != start_index) {
+				coord_t current = {current_index % width, current_index / width};
+				route.push_front({current, scratch.g_score[current_index], scratch.penalty[current_index]});
+				current_index = scratch.came_from[current_index];
 				
 				if(s++ > max_steps)
 					break;
@@ -842,26 +931,28 @@ route_t adventure_map_t::get_route(const hero_t* hero, int x2, int y2, const gam
 			break;
 		}
 
-		int dx[] = { 1, 0, -1, 0, 1, 1, -1, -1 };
-		int dy[] = { 0, 1, 0, -1, 1, -1, 1, -1 };
-
 		for (int i = 0; i < 8; i++) {
 			int x = current_x + dx[i];
 			int y = current_y + dy[i];
-			coord_t neighbor = {x, y};
 
-			if (!tile_valid(x, y) || !get_tile(x, y).passability || get_tile(x, y).terrain_type == TERRAIN_UNKNOWN) {
+			if (!tile_valid(x, y))
+				continue;
+			
+			const auto tile = get_tile(x, y);
+			if (!tile.passability || tile.terrain_type == TERRAIN_UNKNOWN) {
 				continue;
 			}
 
-			if (!game->is_tile_visible(x, y, hero->player)) {
+			if (!ignore_blockables && !game->is_tile_visible(x, y, hero->player)) {
 				continue;
 			}
 
+			const bool is_goal = (x == x2 && y == y2);
+			
 			//the only case where we can go from land to water is if:
 			//we are already on land, and the destination tile has a boat
-			if(on_land && get_tile(x, y).terrain_type == TERRAIN_WATER) {
-				if(x != x2 || y != y2)
+			if(on_land && tile.terrain_type == TERRAIN_WATER) {
+				if(!is_goal)
 					continue;
 				
 				auto obj = get_interactable_object_for_tile(x, y);
@@ -870,16 +961,16 @@ route_t adventure_map_t::get_route(const hero_t* hero, int x2, int y2, const gam
 			}
 			
 			//we can only disembark onto land as the last step in a route
-			if(!on_land && get_tile(x, y).terrain_type != TERRAIN_WATER) {
-				if(x != x2 || y != y2)
+			if(!on_land && tile.terrain_type != TERRAIN_WATER) {
+				if(!is_goal)
 					continue;
 				
 				//we cannot interact with objects on land from a boat
-				if(get_tile(x, y).is_interactable())
+				if(tile.is_interactable())
 					continue;
 			}
 
-			if (get_tile(x, y).is_interactable() && !(x == x2 && y == y2)) {
+			if (!ignore_blockables && tile.is_interactable() && !is_goal) {
 				continue;
 			}
 			
@@ -895,17 +986,17 @@ route_t adventure_map_t::get_route(const hero_t* hero, int x2, int y2, const gam
 					continue;
 			}
 			
-			if(get_tile(x, y).is_interactable() && !is_tile_guarded_by_monster(x, y)) {
+			if(tile.is_interactable() && !is_tile_guarded_by_monster(x, y)) {
 				auto obj = get_interactable_object_for_tile(x, y);
 				//if the movement is from North or North-West or North-East
 				if(dy[i] == 1 && (!interactable_object_t::is_pickupable(obj) && (obj->object_type != OBJECT_SHIP)))
 					continue;
 			}
 			
-			if(get_hero_at_tile(x, y) && !(x == x2 && y == y2))
+			if(!is_goal && get_hero_at_tile(x, y))
 				continue;
 
-			if(is_tile_guarded_by_monster(x, y) && !(x == x2 && y == y2)) {
+			if(!ignore_blockables && !is_goal && is_tile_guarded_by_monster(x, y)) {
 				auto target_interactable = get_interactable_object_for_tile(x2, y2);
 				bool target_monster = target_interactable && target_interactable->object_type == OBJECT_MAP_MONSTER;
 				map_monster_t* current_tile_monster = get_monster_guarding_tile(x, y);
@@ -919,22 +1010,23 @@ route_t adventure_map_t::get_route(const hero_t* hero, int x2, int y2, const gam
 			bool diagonal = (i >= 4);
 			float base_cost = get_terrain_movement_base_cost_cached(x, y);
 			int move_cost = (int)(base_cost * (diagonal ? 14.f : 10.f));
-			int adjusted_g_score = g_score[current.x + (current.y * width)];
+			int adjusted_g_score = get_g_score(current_index);
 			if(adjusted_g_score == -1)
 				adjusted_g_score = 0;
 
-			int tentative_g_score = adjusted_g_score + move_cost;// g_score[current] + move_cost;
+			int tentative_g_score = adjusted_g_score + move_cost;
+			int neighbor_index = x + (y * width);
+			int neighbor_g_score = get_g_score(neighbor_index);
 
-			if(g_score[neighbor.x + (neighbor.y * width)] == -1 || tentative_g_score < g_score[neighbor.x + (neighbor.y * width)]) {
-			//if(g_score.find(neighbor) == g_score.end() || tentative_g_score < g_score[neighbor]) {
-				came_from[neighbor] = current;
-				g_score[neighbor.x + (neighbor.y * width)] = tentative_g_score; //g_score[neighbor] = tentative_g_score;
-				f_score[neighbor] = tentative_g_score + heuristic(x, y, x2, y2);
-				penalty_score[neighbor] = (int)(base_cost * 10.f);
+			if(neighbor_g_score == -1 || tentative_g_score < neighbor_g_score) {
+				scratch.node_stamp[neighbor_index] = generation;
+				scratch.came_from[neighbor_index] = current_index;
+				scratch.g_score[neighbor_index] = tentative_g_score;
+				scratch.penalty[neighbor_index] = (int)(base_cost * 10.f);
 				
-				if(open_set_coords.find(neighbor) == open_set_coords.end()) {
-					open_set.push(std::make_tuple(f_score[neighbor], x, y));
-					open_set_coords.insert(neighbor);
+				if(scratch.queued_stamp[neighbor_index] != generation) {
+					push_open_set(tentative_g_score + heuristic(x, y, x2, y2), x, y);
+					scratch.queued_stamp[neighbor_index] = generation;
 				}
 			}
 		}
@@ -943,173 +1035,308 @@ route_t adventure_map_t::get_route(const hero_t* hero, int x2, int y2, const gam
 	return route;
 }
 
-route_t adventure_map_t::get_route_ignoring_blockables(const hero_t* hero, int x2, int y2, const game_t*) const {
+route_t adventure_map_t::get_long_route(const hero_t* hero, int x2, int y2, const game_t* game) const {
 	route_t route;
 	if(!hero || !tile_valid(x2, y2))
 		return route;
 	
-	std::priority_queue<std::tuple<int, int, int>, std::vector<std::tuple<int, int, int>>, std::greater<std::tuple<int, int, int>>> open_set;
-	std::map<coord_t, coord_t> came_from;
+	std::vector<int> waypoints;
+	if(zone_graph.find_path(*this, hero->x, hero->y, x2, y2, &waypoints) == -1)
+		return route;
 	
-	std::map<coord_t, int> f_score;
-	std::map<coord_t, int> penalty_score;
+	waypoints.push_back(x2 + (y2 * width));
+	
+	int x = hero->x;
+	int y = hero->y;
+	int cost_offset = 0;
+	for(auto waypoint : waypoints) {
+		int wx = waypoint % width;
+		int wy = waypoint / width;
+		auto leg = find_route(hero, x, y, wx, wy, game, false);
+		if(leg.empty())
+			return route_t();
+		
+		for(auto step : leg) {
+			step.total_cost += cost_offset;
+			route.push_back(step);
+		}
+		
+		cost_offset = route.back().total_cost;
+		x = wx;
+		y = wy;
+	}
+	
+	return route;
+}
 
-	//cannot make these static as it is would not be thread-safe
-	std::vector<int> g_score;
-	g_score.resize(width * height);
-	std::fill(g_score.begin(), g_score.end(), -1);
+int adventure_map_t::estimate_route_cost(const hero_t* hero, int x2, int y2) const {
+	if(!hero)
+		return -1;
 	
-	std::vector<float> movement_base_cost_cache;
-	movement_base_cost_cache.resize(width * height);
-	std::fill(movement_base_cost_cache.begin(), movement_base_cost_cache.end(), -1);
+	return zone_graph.find_path(*this, hero->x, hero->y, x2, y2, nullptr);
+}
+
+bool reachability_field_t::is_reachable(int x, int y) const {
+	if(x < 0 || y < 0 || x >= width || y >= height)
+		return false;
 	
-	auto get_terrain_movement_base_cost_cached = [this, hero, &movement_base_cost_cache](int x, int y) {
-		int index = x + (y * width);
-		auto value = movement_base_cost_cache[index];
-		if(value <= -1) {
-			auto cost = get_terrain_movement_base_cost(hero, x, y);
-			movement_base_cost_cache[index] = cost;
-			return cost;
-		}
-		
-		return value;
-	};
+	return cost[x + (y * width)] != -1;
+}
 
-	int x1 = hero->x;
-	int y1 = hero->y;
-	coord_t start = {x1, y1};
-	coord_t goal = {x2, y2};
+//like get_route_cost_to_tile, the hero's own tile has no route and reports -1
+int reachability_field_t::get_cost(int x, int y) const {
+	if(x < 0 || y < 0 || x >= width || y >= height || (x == origin_x && y == origin_y))
+		return -1;
+	
+	return cost[x + (y * width)];
+}
 
-	//g_score[start.x + (start.y * width)]; //g_score[start] = 0;
-	f_score[start] = heuristic(x1, y1, x2, y2);
+route_t reachability_field_t::get_route(int x, int y) const {
+	route_t route;
+	if(!is_reachable(x, y) || (x == origin_x && y == origin_y))
+		return route;
+	
+	const int origin_index = origin_x + (origin_y * width);
+	int index = x + (y * width);
+	size_t max_steps = cost.size();
+	while(index != origin_index && index != -1 && max_steps--) {
+		route.push_front({{index % width, index / width}, cost[index], penalty[index]});
+		index = predecessor[index];
+	}
+	
+	return route;
+}
 
-	open_set.push(std::make_tuple(f_score[start], x1, y1));
+enum reachability_tile_class_e : int8_t {
+	REACHABILITY_UNCLASSIFIED = -1,
+	REACHABILITY_BLOCKED = 0,
+	REACHABILITY_PASSABLE, //can be walked through
+	REACHABILITY_ROUTE_END, //can only end a route (objects, heroes, boarding/disembarking)
+	REACHABILITY_GUARDED //can only end a route, or continue into the monster guarding it
+};
 
-	bool on_land = get_tile(x1, y1).terrain_type != TERRAIN_WATER;
+void adventure_map_t::compute_reachability_field(const hero_t* hero, const game_t* game, reachability_field_t& field) const {
+	const size_t tile_count = (size_t)width * height;
+	field.width = width;
+	field.height = height;
+	field.cost.assign(tile_count, -1);
+	field.predecessor.assign(tile_count, -1);
+	field.penalty.assign(tile_count, 0);
+	field.origin_x = -1;
+	field.origin_y = -1;
+	
+	if(!hero || !tile_valid(hero->x, hero->y))
+		return;
+	
+	const int x1 = hero->x;
+	const int y1 = hero->y;
+	const int start_index = x1 + (y1 * width);
+	field.origin_x = x1;
+	field.origin_y = y1;
+	
+	const bool on_land = get_tile(x1, y1).terrain_type != TERRAIN_WATER;
+	const interactable_object_t* start_object = get_tile(x1, y1).is_interactable() ? get_interactable_object_for_tile(x1, y1) : nullptr;
+	
+	//scratch kept between calls; thread_local so the AI's parallel planners each get their own
+	static thread_local std::vector<int8_t> tile_class;
+	static thread_local std::vector<uint8_t> settled;
+	static thread_local std::vector<uint64_t> open_set;
+	tile_class.assign(tile_count, REACHABILITY_UNCLASSIFIED);
+	settled.assign(tile_count, 0);
+	open_set.clear();
+	
+	//mirrors the per-goal rules of find_route: everything find_route only allows as the goal tile is a route end here
+	auto classify = [&](int x, int y) {
+		auto& value = tile_class[x + (y * width)];
+		if(value != REACHABILITY_UNCLASSIFIED)
+			return (reachability_tile_class_e)value;
+		
+		const auto tile = get_tile(x, y);
+		if(!tile.passability || tile.terrain_type == TERRAIN_UNKNOWN || (game && !game->is_tile_visible(x, y, hero->player)))
+			value = REACHABILITY_BLOCKED;
+		else if(on_land && tile.terrain_type == TERRAIN_WATER) {
+			auto obj = get_interactable_object_for_tile(x, y);
+			value = (obj && obj->object_type == OBJECT_SHIP) ? REACHABILITY_ROUTE_END : REACHABILITY_BLOCKED;
+		}
+		else if(!on_land && tile.terrain_type != TERRAIN_WATER)
+			value = tile.is_interactable() ? REACHABILITY_BLOCKED : REACHABILITY_ROUTE_END;
+		else if(tile.is_interactable() || get_hero_at_tile(x, y))
+			value = REACHABILITY_ROUTE_END;
+		else if(is_tile_guarded_by_monster(x, y))
+			value = REACHABILITY_GUARDED;
+		else
+			value = REACHABILITY_PASSABLE;
+		
+		return (reachability_tile_class_e)value;
+	};
+	
+	auto push_open_set = [&](int cost, int index) {
+		open_set.push_back(((uint64_t)(uint32_t)cost << 32) | (uint32_t)index);
+		std::push_heap(open_set.begin(), open_set.end(), std::greater<uint64_t>());
+	};
 	
-	std::set<coord_t> open_set_coords;
+	const int dx[] = { 1, 0, -1, 0, 1, 1, -1, -1 };
+	const int dy[] = { 0, 1, 0, -1, 1, -1, 1, -1 };
+	
+	field.cost[start_index] = 0;
+	push_open_set(0, start_index);
 	
 	while(!open_set.empty()) {
-		int current_x = std::get<1>(open_set.top());
-		int current_y = std::get<2>(open_set.top());
-		coord_t current = {current_x, current_y};
-		open_set.pop();
-
-		if(current == goal) {
-			int max_steps = 10000;
-			int s = 0;
-			while(current != start) {
-				int step_cost = g_score[current.x + (current.y * width)];//g_score[current];
-				int penalty = penalty_score[current];
-				route.push_front({current, step_cost, penalty});
-				current = came_from[current];
-				
-				if(s++ > max_steps)
-					break;
+		std::pop_heap(open_set.begin(), open_set.end(), std::greater<uint64_t>());
+		const uint64_t key = open_set.back();
+		open_set.pop_back();
+		
+		const int current_index = (int)(key & 0xFFFFFFFF);
+		if(settled[current_index])
+			continue;
+		settled[current_index] = 1;
+		
+		const int current_x = current_index % width;
+		const int current_y = current_index / width;
+		const int current_cost = field.cost[current_index];
+		
+		//route ends are not expanded, except that a route to a monster may step through a tile it guards
+		const interactable_object_t* guarding_monster = nullptr;
+		if(current_index != start_index) {
+			auto current_class = classify(current_x, current_y);
+			if(current_class == REACHABILITY_ROUTE_END)
+				continue;
+			if(current_class == REACHABILITY_GUARDED) {
+				guarding_monster = get_monster_guarding_tile(current_x, current_y);
+				if(!guarding_monster)
+					continue;
 			}
-			break;
 		}
-
-		int dx[] = { 1, 0, -1, 0, 1, 1, -1, -1 };
-		int dy[] = { 0, 1, 0, -1, 1, -1, 1, -1 };
-
-		for (int i = 0; i < 8; i++) {
+		
+		for(int i = 0; i < 8; i++) {
 			int x = current_x + dx[i];
 			int y = current_y + dy[i];
-			coord_t neighbor = {x, y};
-
-			if (!tile_valid(x, y) || !get_tile(x, y).passability || get_tile(x, y).terrain_type == TERRAIN_UNKNOWN) {
+			if(!tile_valid(x, y) || classify(x, y) == REACHABILITY_BLOCKED)
 				continue;
-			}
-
-			//ignore visibility for now
-			/*if (!game->is_tile_visible(x, y, hero->player)) {
-				continue;
-			}*/
-
-			//the only case where we can go from land to water is if:
-			//we are already on land, and the destination tile has a boat
-			if(on_land && get_tile(x, y).terrain_type == TERRAIN_WATER) {
-				if(x != x2 || y != y2)
-					continue;
-				
-				auto obj = get_interactable_object_for_tile(x, y);
-				if(!obj || obj->object_type != OBJECT_SHIP)
-					continue;
-			}
 			
-			//we can only disembark onto land as the last step in a route
-			if(!on_land && get_tile(x, y).terrain_type != TERRAIN_WATER) {
-				if(x != x2 || y != y2)
-					continue;
-				
-				//we cannot interact with objects on land from a boat
-				if(get_tile(x, y).is_interactable())
-					continue;
-			}
-
-			/*if (get_tile(x, y).is_interactable() && !(x == x2 && y == y2)) {
+			if(guarding_monster && (x != guarding_monster->x || y != guarding_monster->y))
 				continue;
-			}*/
 			
 			//we cannot move north (or NE/NW) 'through' an object if we are standing on it
-			if((current_x == x1 && current_y == y1) && get_tile(x1, y1).is_interactable() &&
-			   (	((x == x1) && ((y+1) == y1))
-				||  ((x+1 == x1) && ((y+1) == y1))
-				||  ((x == x1+1) && ((y+1) == y1))
-			   )) {
-				auto obj = get_interactable_object_for_tile(current_x, current_y);
-				
-				if(obj && obj->object_type != OBJECT_SHIP)
-					continue;
-			}
+			if(current_index == start_index && start_object && start_object->object_type != OBJECT_SHIP && (y + 1) == y1 && abs(x - x1) <= 1)
+				continue;
 			
-			if(get_tile(x, y).is_interactable() && !is_tile_guarded_by_monster(x, y)) {
+			const auto tile = get_tile(x, y);
+			if(tile.is_interactable() && !is_tile_guarded_by_monster(x, y)) {
 				auto obj = get_interactable_object_for_tile(x, y);
 				//if the movement is from North or North-West or North-East
 				if(dy[i] == 1 && (!interactable_object_t::is_pickupable(obj) && (obj->object_type != OBJECT_SHIP)))
 					continue;
 			}
 			
-			if(get_hero_at_tile(x, y) && !(x == x2 && y == y2))
+			const int neighbor_index = x + (y * width);
+			if(settled[neighbor_index])
 				continue;
+			
+			float base_cost = get_terrain_movement_base_cost(hero, x, y);
+			int tentative_cost = current_cost + (int)(base_cost * (i >= 4 ? 14.f : 10.f));
+			if(field.cost[neighbor_index] == -1 || tentative_cost < field.cost[neighbor_index]) {
+				field.cost[neighbor_index] = tentative_cost;
+				field.predecessor[neighbor_index] = current_index;
+				field.penalty[neighbor_index] = (int)(base_cost * 10.f);
+				push_open_set(tentative_cost, neighbor_index);
+			}
+		}
+	}
+}
 
-			/*if(is_tile_guarded_by_monster(x, y) && !(x == x2 && y == y2)) {
-				auto target_interactable = get_interactable_object_for_tile(x2, y2);
-				bool target_monster = target_interactable && target_interactable->object_type == OBJECT_MAP_MONSTER;
-				map_monster_t* current_tile_monster = get_monster_guarding_tile(x, y);
+const reachability_field_t& adventure_map_t::get_reachability_field(const hero_t* hero, const game_t* game) const {
+	static const reachability_field_t empty_field;
+	if(!hero)
+		return empty_field;
+	
+	sync_reachability_objects();
+	auto& field = reachability_fields[hero->id];
+	if(is_reachability_field_current(hero, game, field))
+		return field;
+	
+	build_reachability_field(hero, game, field);
+	return field;
+}
 
-				if (!target_monster || (target_monster && current_tile_monster != static_cast<map_monster_t*>(target_interactable))) {
-					continue;
-				}
-			}*/
-			
-			//determine if the current move is diagonal (i >= 4) or not (i < 4)
-			bool diagonal = (i >= 4);
-			float base_cost = get_terrain_movement_base_cost_cached(x, y);
-			int move_cost = (int)(base_cost * (diagonal ? 14.f : 10.f));
-			int adjusted_g_score = g_score[current.x + (current.y * width)];
-			if(adjusted_g_score == -1)
-				adjusted_g_score = 0;
+namespace {
+uint32_t get_hero_movement_signature(const hero_t* hero) {
+	return (hero->is_artifact_equipped(ARTIFACT_SWAMPWADERS) ? 1u : 0u) | ((uint32_t)hero->get_secondary_skill_level(SKILL_PATHFINDING) << 1);
+}
+
+int get_visible_tile_count(const hero_t* hero, const game_t* game) {
+	return (game && game->player_valid(hero->player)) ? (int)game->get_player(hero->player).tile_visibility.count(true) : -1;
+}
+}
 
-			int tentative_g_score = adjusted_g_score + move_cost;// g_score[current] + move_cost;
+bool adventure_map_t::is_reachability_field_current(const hero_t* hero, const game_t* game, const reachability_field_t& field) const {
+	return hero && field.map_revision == reachability_revision && field.hero_id == hero->id && field.player == hero->player
+		&& field.origin_x == hero->x && field.origin_y == hero->y && field.hero_movement_signature == get_hero_movement_signature(hero)
+		&& field.visible_tile_count == get_visible_tile_count(hero, game) && field.width == width && field.height == height;
+}
 
-			if(g_score[neighbor.x + (neighbor.y * width)] == -1 || tentative_g_score < g_score[neighbor.x + (neighbor.y * width)]) {
-			//if(g_score.find(neighbor) == g_score.end() || tentative_g_score < g_score[neighbor]) {
-				came_from[neighbor] = current;
-				g_score[neighbor.x + (neighbor.y * width)] = tentative_g_score; //g_score[neighbor] = tentative_g_score;
-				f_score[neighbor] = tentative_g_score + heuristic(x, y, x2, y2);
-				penalty_score[neighbor] = (int)(base_cost * 10.f);
-				
-				if(open_set_coords.find(neighbor) == open_set_coords.end()) {
-					open_set.push(std::make_tuple(f_score[neighbor], x, y));
-					open_set_coords.insert(neighbor);
+void adventure_map_t::build_reachability_field(const hero_t* hero, const game_t* game, reachability_field_t& field) const {
+	compute_reachability_field(hero, game, field);
+	if(!hero)
+		return;
+	
+	field.hero_id = hero->id;
+	field.player = hero->player;
+	field.hero_movement_signature = get_hero_movement_signature(hero);
+	field.visible_tile_count = get_visible_tile_count(hero, game);
+	field.map_revision = reachability_revision;
+}
+
+void adventure_map_t::invalidate_reachability_fields(int x1, int y1, int x2, int y2) const {
+	//a change can reclassify tiles up to one away (guard zones), and a tile is only classified when a neighbour is
+	//expanded, so a field is only affected if it reached a tile within two of the rectangle
+	x1 = std::max(x1 - 2, 0);
+	y1 = std::max(y1 - 2, 0);
+	x2 = std::min(x2 + 2, (int)width - 1);
+	y2 = std::min(y2 + 2, (int)height - 1);
+	
+	for(auto& [hero_id, field] : reachability_fields) {
+		if(field.map_revision != reachability_revision || field.width != width || field.height != height)
+			continue;
+		
+		bool affected = false;
+		for(int y = y1; y <= y2 && !affected; y++) {
+			for(int x = x1; x <= x2; x++) {
+				if(field.cost[x + (y * width)] != -1) {
+					affected = true;
+					break;
 				}
 			}
 		}
+		
+		if(affected)
+			field.map_revision = 0;
 	}
+}
 
-	return route;
+void adventure_map_t::sync_reachability_objects() const {
+	if(reachability_object_count > objects.size()) {
+		invalidate_reachability_fields();
+		reachability_object_count = objects.size();
+		return;
+	}
+	
+	//same 8x8 footprint around the object's interactable tile that map objects are placed with
+	for(size_t i = reachability_object_count; i < objects.size(); i++) {
+		if(objects[i])
+			invalidate_reachability_fields(objects[i]->x - 3, objects[i]->y - 6, objects[i]->x + 4, objects[i]->y + 1);
+	}
+	reachability_object_count = objects.size();
+}
+
+void adventure_map_t::prepare_for_concurrent_reads() const {
+	if(is_monster_guard_cache_stale())
+		update_guarded_monster_cache();
+	
+	//a fresh rebuild leaves no stale entry for get_hero_id_at_tile to repair mid-read
+	update_hero_occupancy();
+	sync_object_index();
+	sync_reachability_objects();
 }
 
 int adventure_map_t::direction_to_offset(adventure_map_direction_e direction) {
@@ -1308,7 +1535,7 @@ map_action_e adventure_map_t::move_hero_to_tile(hero_t& hero, int x, int y, game
 		return MAP_ACTION_NONE;
 	
 	//get movement penalty
-	auto& destination_tile = get_tile(x, y);
+	auto destination_tile = get_tile_ref(x, y);
 	auto diagonal = are_tiles_diagonal(hero.x, hero.y, x, y);
 	auto movement_cost = get_terrain_movement_cost(&hero, x, y, diagonal);
 	if(hero.get_secondary_skill_level(SKILL_PATHFINDING)) {
@@ -1342,7 +1569,7 @@ map_action_e adventure_map_t::move_hero_to_tile(hero_t& hero, int x, int y, game
 	}
 
 	//todo
-	auto& previous_tile = get_tile(hero.x, hero.y);
+	auto previous_tile = get_tile_ref(hero.x, hero.y);
 	if(previous_tile.is_interactable()) {
 		auto obj = get_interactable_object_for_tile(hero.x, hero.y);
 		if(obj && obj->object_type == OBJECT_MAP_TOWN) {
@@ -1352,8 +1579,7 @@ map_action_e adventure_map_t::move_hero_to_tile(hero_t& hero, int x, int y, game
 		}
 	}
 	
-	hero.x = x;
-	hero.y = y;
+	place_hero(&hero, x, y);
 
 	//must be called AFTER we update the hero's position above
 	zero_hero_movement_points_if_low(&hero);
@@ -2119,6 +2345,7 @@ bool adventure_map_t::garrison_hero(hero_t* hero, town_t* town) {
 	town->visiting_hero = nullptr;
 	town->garrisoned_hero = hero;
 	//todo: need more checks here
+	set_hero_occupancy(hero, false);
 	hero->x = town->x;
 	hero->y = town->y;
 	hero->garrisoned = true;
@@ -2136,6 +2363,7 @@ bool adventure_map_t::ungarrison_hero(hero_t* hero, town_t* town) {
 	hero->x = town->x;
 	hero->y = town->y;
 	hero->garrisoned = false;
+	set_hero_occupancy(hero, true);
 	
 	return true;
 }
@@ -2212,6 +2440,8 @@ bool adventure_map_t::swap_visiting_and_garrisoned_heroes(town_t* town) {
 		//merge_troops
 	}
 
+	set_hero_occupancy(visiting, false);
+	
 	town->visiting_hero = garrisoned;
 	if(town->visiting_hero)
 		town->visiting_hero->garrisoned = false;
@@ -2220,6 +2450,7 @@ bool adventure_map_t::swap_visiting_and_garrisoned_heroes(town_t* town) {
 	if(town->garrisoned_hero)
 		town->garrisoned_hero->garrisoned = true;
 	
+	set_hero_occupancy(town->visiting_hero, true);
 	return true;
 }
 
@@ -2249,51 +2480,195 @@ uint16_t adventure_map_t::get_object_id(interactable_object_t* object) const {
 }
 
 const hero_t* adventure_map_t::get_hero_at_tile(int x, int y) const {
-	for(auto& h : heroes) {
-		if(h.second.x == x && h.second.y == y && !h.second.garrisoned)
-			return &h.second;
-	}
-
-	return nullptr;
+	int id = get_hero_id_at_tile(x, y);
+	return id == -1 ? nullptr : &heroes.at(id);
 };
 
 hero_t* adventure_map_t::get_hero_at_tile(int x, int y) {
-	for(auto& h : heroes) {
-		if(h.second.x == x && h.second.y == y && !h.second.garrisoned)
-			return &h.second;
+	int id = get_hero_id_at_tile(x, y);
+	return id == -1 ? nullptr : &heroes.at(id);
+}
+
+int adventure_map_t::get_hero_id_at_tile(int x, int y) const {
+	if(!tile_valid(x, y))
+		return -1;
+	
+	if(!hero_occupancy_valid || hero_occupancy_hero_count != heroes.size() || hero_occupancy.size() != (size_t)width * height)
+		update_hero_occupancy();
+	
+	int index = x + (y * width);
+	int id = hero_occupancy[index];
+	if(id == -1)
+		return -1;
+	
+	auto it = heroes.find(id);
+	if(it == heroes.end() || it->second.x != x || it->second.y != y || it->second.garrisoned) {
+		update_hero_occupancy();
+		id = hero_occupancy[index];
 	}
+	
+	return id;
+}
 
-	return nullptr;
+void adventure_map_t::update_hero_occupancy() const {
+	hero_occupancy.assign((size_t)width * height, -1);
+	
+	//walk backwards so that when two heroes share a tile the first one in id order wins, as the old linear scan did
+	for(auto it = heroes.rbegin(); it != heroes.rend(); it++) {
+		const auto& hero = it->second;
+		if(!hero.garrisoned && tile_valid(hero.x, hero.y))
+			hero_occupancy[hero.x + (hero.y * width)] = it->first;
+	}
+	
+	hero_occupancy_hero_count = heroes.size();
+	hero_occupancy_valid = true;
+}
+
+void adventure_map_t::set_hero_occupancy(const hero_t* hero, bool occupied) {
+	if(!hero_occupancy_valid || !hero || !tile_valid(hero->x, hero->y))
+		return;
+	
+	int& tile = hero_occupancy[hero->x + (hero->y * width)];
+	if(occupied && !hero->garrisoned)
+		tile = hero->id;
+	else if(!occupied && tile == hero->id)
+		tile = -1;
+}
+
+void adventure_map_t::place_hero(hero_t* hero, int x, int y) {
+	if(!hero)
+		return;
+	
+	const int previous_x = hero->x;
+	const int previous_y = hero->y;
+	mark_zone_graph_dirty(previous_x, previous_y);
+	set_hero_occupancy(hero, false);
+	hero->x = x;
+	hero->y = y;
+	set_hero_occupancy(hero, true);
+	//other heroes' fields treat this hero's old and new tiles differently now
+	invalidate_reachability_fields(previous_x, previous_y, previous_x, previous_y);
+	invalidate_reachability_fields(x, y, x, y);
+	mark_zone_graph_dirty(x, y);
 }
 
 int adventure_map_t::get_owned_mines_count(resource_e mine_type, player_e player) {
 	int count = 0;
 	
-	for(auto obj : objects) {
-		if(!obj || obj->object_type != OBJECT_MINE)
-			continue;
-		
-		auto mine = (mine_t*)obj;
-		
-		if(mine->mine_type != mine_type)
-			continue;
-		
-		//if we pass in PLAYER_NONE, return all mines that are owned by some player
-		if(player == PLAYER_NONE && mine->owner != PLAYER_NONE)
-			count++;
-		
-		if(mine->owner != PLAYER_NONE && mine->owner == player)
+	//if we pass in PLAYER_NONE, count all mines that are owned by some player
+	auto ids = (player == PLAYER_NONE) ? get_object_ids_of_type(OBJECT_MINE) : get_object_ids_owned_by(player, OBJECT_MINE);
+	for(auto id : ids) {
+		auto mine = (mine_t*)objects[id];
+		if(mine->mine_type == mine_type && mine->owner != PLAYER_NONE)
 			count++;
 	}
 	
 	return count;
 }
 
+void adventure_map_t::sync_object_index() const {
+	if(object_index.width == width && object_index.height == height && object_index.indexed_count == objects.size())
+		return;
+	
+	if(object_index.width != width || object_index.height != height || object_index.indexed_count > objects.size())
+		object_index.reset(width, height);
+	
+	for(size_t i = object_index.indexed_count; i < objects.size(); i++)
+		object_index.insert((uint16_t)i, objects[i]);
+	
+	object_index.indexed_count = objects.size();
+}
+
+std::vector<uint16_t> adventure_map_t::get_object_ids_of_type(interactable_object_e type) const {
+	sync_object_index();
+	
+	std::vector<uint16_t> ids;
+	if(type == OBJECT_UNKNOWN) {
+		for(uint16_t i = 0; i < objects.size(); i++) {
+			if(objects[i])
+				ids.push_back(i);
+		}
+	}
+	else if(type < object_index_t::TYPE_COUNT) {
+		ids = object_index.by_type[type];
+	}
+	
+	return ids;
+}
+
+std::vector<uint16_t> adventure_map_t::get_object_ids_in_radius(int x, int y, int radius, interactable_object_e type) const {
+	sync_object_index();
+	
+	std::vector<uint16_t> ids;
+	if(radius < 0 || !width || !height)
+		return ids;
+	
+	int first_column = std::max(x - radius, 0) / object_index_t::CHUNK_SIZE;
+	int last_column = std::min(x + radius, width - 1) / object_index_t::CHUNK_SIZE;
+	int first_row = std::max(y - radius, 0) / object_index_t::CHUNK_SIZE;
+	int last_row = std::min(y + radius, height - 1) / object_index_t::CHUNK_SIZE;
+	for(int row = first_row; row <= last_row; row++) {
+		for(int column = first_column; column <= last_column; column++) {
+			for(auto id : object_index.by_chunk[column + (row * object_index.chunk_columns)]) {
+				auto obj = objects[id];
+				if(!obj || (type != OBJECT_UNKNOWN && obj->object_type != type))
+					continue;
+				
+				if(abs(obj->x - x) <= radius && abs(obj->y - y) <= radius)
+					ids.push_back(id);
+			}
+		}
+	}
+	
+	std::sort(ids.begin(), ids.end());
+	return ids;
+}
+
+std::vector<uint16_t> adventure_map_t::get_object_ids_owned_by(player_e player, interactable_object_e type) const {
+	sync_object_index();
+	
+	std::vector<uint16_t> ids;
+	if(player >= object_index_t::OWNER_COUNT)
+		return ids;
+	
+	for(auto id : object_index.by_owner[player]) {
+		if(objects[id] && (type == OBJECT_UNKNOWN || objects[id]->object_type == type))
+			ids.push_back(id);
+	}
+	
+	return ids;
+}
+
+void adventure_map_t::set_object_owner(interactable_object_t* object, player_e owner) {
+	if(!object)
+		return;
+	
+	switch(object->object_type) {
+		case OBJECT_MAP_TOWN:
+			((town_t*)object)->player = owner;
+			break;
+		case OBJECT_MINE:
+			((mine_t*)object)->owner = owner;
+			break;
+		case OBJECT_WATERWHEEL:
+		case OBJECT_WINDMILL:
+		case OBJECT_WATCHTOWER:
+			((flaggable_object_t*)object)->owner = owner;
+			break;
+		default:
+			return;
+	}
+	
+	auto id = get_object_id(object);
+	if(id < object_index.indexed_count && objects[id] == object)
+		object_index.set_owner(id, owner);
+}
+
 bool adventure_map_t::get_passability(int x, int y) const {
 	if(!tile_valid(x, y))
 		return false;
 	
-	return get_tile(x, y).passability;
+	return tiles.get_passability(x, y);
 }
 
 bool adventure_map_t::is_route_passable(hero_t* hero, int x2, int y2, game_t* game) const {
@@ -2336,29 +2711,44 @@ QColor get_color_for_tile(terrain_type_e type) {
 	}
 }
 
-void draw_minimap(QImage& image, uint pixel_size, const adventure_map_t& map, const game_t* game, player_e player, const std::string& path_prefix, bool reveal_map) {
-	auto mapsize = pixel_size;
-	if(!map.width || !map.height)
-		return;
-
-	assert(std::max(map.width, map.height));
+std::vector<uint8_t> get_minimap_tiles(const adventure_map_t& map) {
+	std::vector<uint8_t> minimap_tiles((size_t)map.width * map.height);
+	for(int y = 0; y < map.height; y++) {
+		for(int x = 0; x < map.width; x++)
+			minimap_tiles[x + (y * map.width)] = map.tiles.get_terrain_type(x, y) | (map.get_passability(x, y) ? 0 : MINIMAP_TILE_IMPASSABLE);
+	}
 
-	auto scale = std::max(4u, mapsize / std::max(map.width, map.height));
+	return minimap_tiles;
+}
 
-	QImage terrain_img(map.width, map.height, QImage::Format_RGBA8888);
-	for(int y = 0; y < map.height; y++) {
-		for(int x = 0; x < map.width; x++) {
-			auto tile_type = map.tiles[y*map.width + x].terrain_type;
-			auto color = get_color_for_tile(tile_type);
+QImage draw_minimap_terrain(int width, int height, const uint8_t* minimap_tiles) {
+	QImage terrain_img(width, height, QImage::Format_RGBA8888);
+	for(int y = 0; y < height; y++) {
+		for(int x = 0; x < width; x++) {
+			auto tile = minimap_tiles[x + (y * width)];
+			auto color = get_color_for_tile((terrain_type_e)(tile & ~MINIMAP_TILE_IMPASSABLE));
 
-			if(!map.get_passability(x, y)) {
+			if(tile & MINIMAP_TILE_IMPASSABLE) {
 				float factor = .7f;
 				color = QColor(color.red() * factor, color.green() * factor, color.blue() * factor);
 			}
 			terrain_img.setPixelColor(x, y, color);
 		}
 	}
-	
+
+	return terrain_img;
+}
+
+void draw_minimap(QImage& image, uint pixel_size, const adventure_map_t& map, const game_t* game, player_e player, const std::string& path_prefix, bool reveal_map) {
+	auto mapsize = pixel_size;
+	if(!map.width || !map.height)
+		return;
+
+	assert(std::max(map.width, map.height));
+
+	auto scale = std::max(4u, mapsize / std::max(map.width, map.height));
+
+	auto terrain_img = draw_minimap_terrain(map.width, map.height, get_minimap_tiles(map).data());
 	image = map.width > map.height ? terrain_img.scaledToWidth(mapsize) : terrain_img.scaledToHeight(mapsize);
 	QPainter painter1(&image);
 
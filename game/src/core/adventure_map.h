@@ -4,7 +4,11 @@
 #include "core/player_configuration.h"
 #include "core/town.h"
 #include "core/hero.h"
+#include "core/object_index.h"
+#include "core/tile_store.h"
+#include "core/zone_graph.h"
 
+#include <cassert>
 #include <string>
 #include <bitset>
 #include <vector>
@@ -55,27 +59,6 @@ enum adventure_map_direction_e : uint8_t {
 	DIRECTION_NORTHWEST
 };
 
-enum terrain_type_e : uint8_t {
-	TERRAIN_UNKNOWN = 0,
-	TERRAIN_WATER,
-	TERRAIN_GRASS,
-	TERRAIN_DIRT,
-	TERRAIN_WASTELAND,
-	TERRAIN_LAVA,
-	TERRAIN_DESERT,
-	TERRAIN_BEACH,
-	TERRAIN_SNOW,
-	TERRAIN_SWAMP,
-	TERRAIN_JUNGLE
-};
-
-enum road_type_e : uint8_t {
-	ROAD_NONE = 0,
-	ROAD_DIRT,
-	ROAD_GRAVEL,
-	ROAD_COBBLESTONE
-};
-
 enum { TERRAIN_ANY = TERRAIN_UNKNOWN };
 
 enum map_action_e : uint8_t {
@@ -121,18 +104,6 @@ struct doodad_t {
 QDataStream& operator<<(QDataStream& stream, const doodad_t& doodad);
 QDataStream& operator>>(QDataStream& stream, doodad_t& doodad);
 
-struct map_tile_t {
-	asset_id_t asset_id = 0;
-	terrain_type_e terrain_type = TERRAIN_UNKNOWN;
-	road_type_e road_type = ROAD_NONE;
-	uint8_t passability = 1;
-	int8_t zone_id = -1;
-	uint16_t interactable_object = 0;
-	const std::string get_name() const;
-	bool is_interactable() const { return interactable_object != 0; }
-	bool is_passable() const { return passability == 1; }
-};
-
 QDataStream& operator<<(QDataStream& stream, const map_tile_t& tile);
 QDataStream& operator>>(QDataStream& stream, map_tile_t& tile);
 
@@ -159,6 +130,30 @@ struct step_t {
 
 typedef std::deque<step_t> route_t;
 
+//single-source movement cost field for one hero, built by adventure_map_t::compute_reachability_field.
+//cost is the total cost of a route ending on a tile (-1 if unreachable); routes are rebuilt by walking predecessor
+struct reachability_field_t {
+	uint16_t width = 0;
+	uint16_t height = 0;
+	int origin_x = -1;
+	int origin_y = -1;
+	
+	//cache key, see adventure_map_t::get_reachability_field
+	int hero_id = -1;
+	player_e player = PLAYER_NONE;
+	uint32_t hero_movement_signature = 0;
+	int visible_tile_count = -1;
+	uint64_t map_revision = 0;
+	
+	std::vector<int> cost;
+	std::vector<int> predecessor;
+	std::vector<int> penalty;
+	
+	bool is_reachable(int x, int y) const;
+	int get_cost(int x, int y) const;
+	route_t get_route(int x, int y) const;
+};
+
 QColor get_qcolor_for_player_color(player_color_e pcolor);
 terrain_type_e get_faction_native_terrain(hero_class_e faction);
 hero_class_e get_faction_from_native_terrain_type(terrain_type_e terrain_type);
@@ -166,6 +161,11 @@ std::string get_color_string_for_player_color(player_color_e pcolor);
 std::string get_color_name_for_player_color(player_color_e pcolor);
 QColor get_color_for_tile(terrain_type_e type);
 void draw_minimap(QImage& image, uint pixel_size, const adventure_map_t& map, const game_t* game = nullptr, player_e = PLAYER_NONE, const std::string& path_prefix = std::string(), bool reveal_map = false);
+//one byte per tile (x + y * width): the terrain type, with MINIMAP_TILE_IMPASSABLE set for tiles that block movement.
+//enough to draw the terrain part of the minimap, e.g. for map previews
+const uint8_t MINIMAP_TILE_IMPASSABLE = 0x80;
+std::vector<uint8_t> get_minimap_tiles(const adventure_map_t& map);
+QImage draw_minimap_terrain(int width, int height, const uint8_t* minimap_tiles);
 
 template<typename T> T get_skill_value(const T& base, const T& per_level, int skill_level) {
 	if(skill_level == 0)
@@ -190,9 +190,17 @@ public:
 
 	static artifact_e get_random_artifact_of_rarity(artifact_rarity_e rarity, std::mt19937_64& rng);
 	static artifact_e get_random_artifact_of_rarity(artifact_rarity_e rarity);
-    //const map_tile_t& get_tile(int x, int y) const;
-	map_tile_t& get_tile(int x, int y);
-	const map_tile_t& get_tile(int x, int y) const;
+	//a copy of the tile; writes go through get_tile_ref, which refers into tiles
+	map_tile_ref_t get_tile_ref(int x, int y) {
+		assert(x >= 0 && x < width && y >= 0 && y < height);
+		assert(x < tiles.width && y < tiles.height);
+		return tiles.get_ref(x, y);
+	}
+	map_tile_t get_tile(int x, int y) const {
+		assert(x >= 0 && x < width && y >= 0 && y < height);
+		assert(x < tiles.width && y < tiles.height);
+		return tiles.get(x, y);
+	}
 	interactable_object_t* get_interactable_object_for_tile(int x, int y) const;
 	bool remove_interactable_object(interactable_object_t* object);
 	bool remove_hero(hero_t* hero);
@@ -201,11 +209,47 @@ public:
 	bool is_tile_guarded_by_monster(int x, int y) const;
 	mutable QBitArray monster_guarded_cache;
 	mutable bool monster_guarded_cache_valid = false;
+	//tile -> indices into objects of the monsters guarding it, ascending so the first entry is the monster the old
+	//objects scan would have found. kept in step with monster_guarded_cache
+	mutable std::vector<std::vector<uint16_t>> monster_guards;
 	void update_guarded_monster_cache() const;
+	bool is_monster_guard_cache_stale() const;
+	//updates the guard zone of the monster at objects[object_id] without a full rebuild. call with true after
+	//placing a monster, with false before moving or removing one (and with true again once it has moved)
+	void set_monster_guard(uint16_t object_id, bool guarding) const;
 	void populate_refugee_camp(refugee_camp_t* camp);
 	
 	route_t get_route(const hero_t* hero, int x2, int y2, const game_t* game) const;
 	route_t get_route_ignoring_blockables(const hero_t* hero, int x2, int y2, const game_t* game) const;
+	route_t find_route(const hero_t* hero, int x1, int y1, int x2, int y2, const game_t* game, bool ignore_blockables) const;
+	
+	//zone-level (HPA*) routing for long distances. the abstract path is planned with hero-independent costs and
+	//ignores fog of war, so the result is near-optimal rather than identical to get_route; each leg between portals
+	//is then refined with find_route. returns an empty route if any leg cannot be completed
+	route_t get_long_route(const hero_t* hero, int x2, int y2, const game_t* game) const;
+	//cost of the abstract path, -1 if the tile cannot be reached
+	int estimate_route_cost(const hero_t* hero, int x2, int y2) const;
+	//call after blocking content (objects, heroes, guards) on a tile changes outside of this class
+	void mark_zone_graph_dirty(int x, int y) const { zone_graph.mark_tile_dirty(x, y); }
+	mutable zone_graph_t zone_graph;
+	
+	//dijkstra from the hero's tile to every tile, applying the same movement rules as get_route
+	void compute_reachability_field(const hero_t* hero, const game_t* game, reachability_field_t& field) const;
+	//cached per hero id until the hero moves, its movement modifiers or the player's visibility change, something the
+	//field reached is invalidated, or the map revision is bumped. not thread-safe: the cache is shared by every caller
+	const reachability_field_t& get_reachability_field(const hero_t* hero, const game_t* game) const;
+	bool is_reachability_field_current(const hero_t* hero, const game_t* game, const reachability_field_t& field) const;
+	//compute_reachability_field plus the cache key, without touching reachability_fields: safe to call from several
+	//threads once prepare_for_concurrent_reads has run
+	void build_reachability_field(const hero_t* hero, const game_t* game, reachability_field_t& field) const;
+	void invalidate_reachability_fields() const { reachability_revision++; }
+	//only drops cached fields that reached tiles close enough to the rectangle for a change inside it to matter
+	void invalidate_reachability_fields(int x1, int y1, int x2, int y2) const;
+	//objects appended since the last query invalidate the fields around their footprint
+	void sync_reachability_objects() const;
+	mutable uint64_t reachability_revision = 1;
+	mutable size_t reachability_object_count = 0;
+	mutable std::map<int, reachability_field_t> reachability_fields;
 	
 	//route_t get_route_astar(hero_t* hero, int x2, int y2) const;
 	//route_t get_route_astar1(hero_t* hero, int x2, int y2) const;
@@ -230,9 +274,37 @@ public:
 	bool is_offset_interactable(const interactable_object_t* object, int x, int y);
 	const hero_t* get_hero_at_tile(int x, int y) const;
 	hero_t* get_hero_at_tile(int x, int y);
+	int get_hero_id_at_tile(int x, int y) const;
+	//moves a hero without any of move_hero_to_tile's visiting logic (e.g. teleports), keeping the map's caches current
+	void place_hero(hero_t* hero, int x, int y);
+	
+	//tile -> id of the non-garrisoned hero standing there (-1 if none). patched by place_hero, remove_hero and
+	//(un)garrisoning; rebuilt when the hero count changes or a lookup finds a hero that was moved behind its back
+	mutable std::vector<int> hero_occupancy;
+	mutable size_t hero_occupancy_hero_count = 0;
+	mutable bool hero_occupancy_valid = false;
+	void update_hero_occupancy() const;
+	void set_hero_occupancy(const hero_t* hero, bool occupied);
 	std::pair<std::string, std::string> get_troop_count_strings(uint troop_count, uint scouting_level, bool use_prefix = false) const; //crystal ball?
 	int get_owned_mines_count(resource_e mine_type, player_e player = PLAYER_NONE);
 	
+	//indexed object queries returning object ids (indices into objects) in ascending order. OBJECT_UNKNOWN matches
+	//every type
+	std::vector<uint16_t> get_object_ids_of_type(interactable_object_e type) const;
+	//objects whose x/y is within radius tiles of (x, y) on both axes
+	std::vector<uint16_t> get_object_ids_in_radius(int x, int y, int radius, interactable_object_e type = OBJECT_UNKNOWN) const;
+	std::vector<uint16_t> get_object_ids_owned_by(player_e player, interactable_object_e type = OBJECT_UNKNOWN) const;
+	//changes a town's player or a mine's/flaggable's owner and keeps the index in step; use instead of assigning directly
+	void set_object_owner(interactable_object_t* object, player_e owner);
+	//objects are only ever appended (removal leaves a null slot), so new ones are picked up on the next query
+	void sync_object_index() const;
+	mutable object_index_t object_index;
+	
+	//brings the lazily built caches (guard zones, hero occupancy, object index) up to date so that const queries other
+	//than get_reachability_field only read the map until it is next modified. the zone graph is left to the first
+	//get_long_route or estimate_route_cost, the only queries that use it
+	void prepare_for_concurrent_reads() const;
+	
 	//actions from player.  probably needs to be moved to client_t
 	bool can_hero_move_to_tile(hero_t* hero, int x, int y, game_t* game);
 	map_action_e move_hero_to_tile(hero_t& hero, int x, int y, game_t& game);
@@ -295,7 +367,7 @@ public:
 	
 	std::map<interactable_object_t*, uint8_t> player_object_visited_map;
 
-    std::vector<map_tile_t> tiles;
+    tile_store_t tiles;
 
 	std::vector<doodad_t> doodads;
     std::vector<interactable_object_t*> objects;
@@ -2,6 +2,11 @@
 #include "core/adventure_map.h"
 #include "core/utils_enum.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
 #include <thread>
 #include <iostream>
 
@@ -121,42 +126,82 @@ struct ai_goal_t {
 };
 
 
-int get_ai_value_for_object(interactable_object_t* object, const hero_t* hero, const game_t* game) {
-	int route_cost = game->map.get_route_cost_to_tile(hero, object->x, object->y, game);
-	if(route_cost == -1) //we can't reach this object
-		return 0;
-
-	float travel_cost = (route_cost / 100.f);
-
+//what the object is worth to the player before travel is taken into account
+int get_ai_base_value_for_object(const interactable_object_t* object, player_e player) {
 	switch(object->object_type) {
 		case OBJECT_RESOURCE: {
-			auto res = (map_resource_t*)object;
-			int value = res->resource_type == RESOURCE_GOLD ? 100 : (is_basic_resource(res->resource_type) ? 50 : 65);
-			return value / travel_cost;
+			auto res = (const map_resource_t*)object;
+			return res->resource_type == RESOURCE_GOLD ? 100 : (is_basic_resource(res->resource_type) ? 50 : 65);
 		}
 		case OBJECT_TREASURE_CHEST: {
-			return 70 / travel_cost;
+			return 70;
 		}
 		case OBJECT_ARTIFACT: {
-			auto art = (map_artifact_t*)object;
+			auto art = (const map_artifact_t*)object;
 			const auto& ainfo = game_config::get_artifact(art->artifact_id);
-			return (ainfo.rarity * 50) / travel_cost;
+			return ainfo.rarity * 50;
 		}
 		case OBJECT_MINE: {
-			auto mine = (mine_t*)object;
-			if(mine->owner == hero->player) //we already have this mine flagged
+			auto mine = (const mine_t*)object;
+			if(mine->owner == player) //we already have this mine flagged
 				return 0;
 
-			int value = mine->mine_type == RESOURCE_GOLD ? 500 : (is_basic_resource(mine->mine_type) ? 200 : 350);
 			//if we have no wood/ore income, bump up the value of capturing these mines
 			//todo
-			return value / travel_cost;
+			return mine->mine_type == RESOURCE_GOLD ? 500 : (is_basic_resource(mine->mine_type) ? 200 : 350);
 		}
 		default:
 			return 0;
 	}
-	
-	//return 0;
+}
+
+//route_cost is what it takes to reach the object (-1 if it can't be reached); a lower bound gives an upper bound on value
+int get_ai_value_for_object(interactable_object_t* object, const hero_t* hero, int route_cost) {
+	if(route_cost == -1) //we can't reach this object
+		return 0;
+
+	float travel_cost = (route_cost / 100.f);
+	return get_ai_base_value_for_object(object, hero->player) / travel_cost;
+}
+
+int get_ai_value_for_object(interactable_object_t* object, const hero_t* hero, const game_t* game) {
+	return get_ai_value_for_object(object, hero, game->map.get_reachability_field(hero, game).get_cost(object->x, object->y));
+}
+
+//the value the player's ai_value_field_t spreads for an object: its base value, scaled down by the share of the fight
+//a guard would take out of the player's strongest hero, or 0 if no hero could win it
+int get_ai_field_value_for_object(const game_t& game, const interactable_object_t* object, player_e player, int strongest_hero) {
+	int value = get_ai_base_value_for_object(object, player);
+	if(value <= 0 || object->object_type == OBJECT_MAP_MONSTER)
+		return value;
+
+	auto guard = game.map.get_monster_guarding_tile(object->x, object->y);
+	if(!guard)
+		return value;
+
+	int64_t guard_strength = calculate_monster_strength(guard);
+	if(strongest_hero < guard_strength || strongest_hero <= 0)
+		return 0;
+
+	return (int)((value * (int64_t)strongest_hero) / (strongest_hero + guard_strength));
+}
+
+//brings the player's value field in line with the map. must run serially, before heroes are planned against it
+void update_ai_value_field(game_t& game, player_e player) {
+	int strongest_hero = 0;
+	for(const auto& h : game.map.heroes) {
+		if(h.second.player == player)
+			strongest_hero = std::max(strongest_hero, get_hero_plus_army_strength(&h.second));
+	}
+
+	std::vector<int> values(game.map.objects.size(), 0);
+	for(size_t id = 0; id < game.map.objects.size(); id++) {
+		if(game.map.objects[id])
+			values[id] = get_ai_field_value_for_object(game, game.map.objects[id], player, strongest_hero);
+	}
+
+	game.map.prepare_for_concurrent_reads();
+	game.ai_value_fields[player].update(game.map, game.get_player(player).tile_visibility, values);
 }
 
 
@@ -256,12 +301,46 @@ void game_t::process_all_ai_turns() {
 std::vector<ai_goal_t> ai_player_goals;
 std::unordered_map<uint16_t, hero_role_e> hero_roles;
 
+//a goal found by the planning phase of process_ai_turn, along with what it was planned against
 struct hero_plan_t {
-	hero_t* hero = nullptr;
-	interactable_object_t* target = nullptr;
-	route_t route;
+	int hero_id = -1;
+	int origin_x = -1;
+	int origin_y = -1;
+	ai_goal_t goal;
+	uint16_t target_id = 0; //index into map.objects of goal.target_object
+};
+
+enum ai_turn_phase_e {
+	AI_TURN_PHASE_TOWNS,
+	AI_TURN_PHASE_PLANNING,
+	AI_TURN_PHASE_HEROES,
+	AI_TURN_PHASE_COUNT
+};
+
+//wall-clock budget for one player's turn, see player_configuration_t::ai_turn_time_budget_ms. a zero budget never runs out
+struct ai_turn_budget_t {
+	typedef std::chrono::steady_clock clock_t;
+
+	clock_t::time_point start = clock_t::now();
+	std::chrono::milliseconds budget{ 0 };
+	std::array<clock_t::duration, AI_TURN_PHASE_COUNT> phase_time{};
+	ai_turn_phase_e overrun_phase = AI_TURN_PHASE_COUNT; //the phase that was running when the budget ran out
+
+	bool is_limited() const { return budget.count() > 0; }
+	clock_t::duration elapsed() const { return clock_t::now() - start; }
+	bool expired() const { return is_limited() && elapsed() >= budget; }
+
+	void end_phase(ai_turn_phase_e phase, clock_t::time_point phase_start) {
+		phase_time[phase] += clock_t::now() - phase_start;
+		if(overrun_phase == AI_TURN_PHASE_COUNT && expired())
+			overrun_phase = phase;
+	}
 };
 
+int64_t to_milliseconds(std::chrono::steady_clock::duration duration) {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+}
+
 
 
 interactable_object_t* find_best_object(const hero_t& hero, const adventure_map_t& map, const game_t& game) {
@@ -270,20 +349,16 @@ interactable_object_t* find_best_object(const hero_t& hero, const adventure_map_
 	interactable_object_t* valuable_obj = nullptr;
 	int highest_value = 0;
 		
-	for(int y = hero.y - radius; y < hero.y + radius; y++) {
-		for(int x = hero.x - radius; x < hero.x + radius; x++) {
-			if(!map.tile_valid(x, y))
-				continue;
-				
-			auto obj = map.get_interactable_object_for_tile(x, y);
-			if(!obj)
-				continue;
-				
-			auto value = get_ai_value_for_object(obj, &hero, &game);
-			if(value > highest_value) {
-				highest_value = value;
-				valuable_obj = obj;
-			}
+	for(auto id : map.get_object_ids_in_radius(hero.x, hero.y, radius)) {
+		auto obj = map.objects[id];
+		//keep the old [-radius, radius) window
+		if(obj->x >= hero.x + radius || obj->y >= hero.y + radius)
+			continue;
+			
+		auto value = get_ai_value_for_object(obj, &hero, &game);
+		if(value > highest_value) {
+			highest_value = value;
+			valuable_obj = obj;
 		}
 	}
 
@@ -408,7 +483,7 @@ bool game_t::ai_move_hero_to_object(hero_t* hero, interactable_object_t* object)
 		return false;
 
 	auto player_num = hero->player;
-	auto route = map.get_route(hero, object->x, object->y, this);
+	auto route = map.get_reachability_field(hero, this).get_route(object->x, object->y);
 	
 	int starting_mp = hero->movement_points;
 	for(auto step = route.begin(); step != route.end(); step++) {
@@ -438,16 +513,103 @@ bool game_t::ai_move_hero_to_object(hero_t* hero, interactable_object_t* object)
 	return true;
 }
 
+// Objects worth a visit from the hero's tile, best first by the value they would have if every step cost as little as
+// a step can (cobblestone or water), ties to the lower object id. needs no pathfinding
+struct ai_goal_candidate_t {
+	interactable_object_t* object = nullptr;
+	uint16_t id = 0;
+	int estimated_value = 0; //never below the value the object's real route cost gives
+};
+
+int get_lowest_route_cost(int dx, int dy) {
+	const int cheapest_step = 5 * 10;
+	const int cheapest_diagonal_step = 5 * 14;
+	return (cheapest_step * (std::max(dx, dy) - std::min(dx, dy))) + (cheapest_diagonal_step * std::min(dx, dy));
+}
+
+void sort_hero_goal_candidates(std::vector<ai_goal_candidate_t>& candidates) {
+	std::stable_sort(candidates.begin(), candidates.end(), [](const ai_goal_candidate_t& a, const ai_goal_candidate_t& b) {
+		return a.estimated_value > b.estimated_value || (a.estimated_value == b.estimated_value && a.id < b.id);
+	});
+}
+
+// Candidates from the player's value field: whatever the tiles around the hero hold, however far away it is
+std::vector<ai_goal_candidate_t> get_hero_field_goal_candidates(const hero_t& hero, const game_t& game, const std::map<uint16_t, int>& reserved_targets) {
+	std::vector<ai_goal_candidate_t> candidates;
+	auto field = game.ai_value_fields.find(hero.player);
+	if(field == game.ai_value_fields.end())
+		return candidates;
+
+	const auto& map = game.map;
+	for(const auto& sample : field->second.sample(hero.x, hero.y, 1)) {
+		if(sample.object >= map.objects.size() || !map.objects[sample.object])
+			continue;
+
+		auto obj = map.objects[sample.object];
+		auto reservation = reserved_targets.find(sample.object);
+		if(reservation != reserved_targets.end() && reservation->second != hero.id)
+			continue; //another hero is already heading there
+
+		int dx = abs(obj->x - hero.x);
+		int dy = abs(obj->y - hero.y);
+		if(dx == 0 && dy == 0)
+			continue;
+
+		int estimated_value = get_ai_value_for_object(obj, &hero, get_lowest_route_cost(dx, dy));
+		if(estimated_value > 0)
+			candidates.push_back({ obj, sample.object, estimated_value });
+	}
+
+	sort_hero_goal_candidates(candidates);
+	return candidates;
+}
+
+std::vector<ai_goal_candidate_t> get_hero_goal_candidates(const hero_t& hero, const adventure_map_t& map, const std::map<uint16_t, int>& reserved_targets) {
+	// Define search radius - could be dynamic based on hero role (scouts search wider?)
+	int radius = 6; //hero.get_scouting_radius() > 0 ? hero.get_scouting_radius() : 10; // Example radius
+	int search_radius_sq = radius * radius;
+
+	std::vector<ai_goal_candidate_t> candidates;
+	for(auto id : map.get_object_ids_in_radius(hero.x, hero.y, radius)) {
+		auto obj = map.objects[id];
+
+		auto reservation = reserved_targets.find(id);
+		if(reservation != reserved_targets.end() && reservation->second != hero.id)
+			continue; //another hero is already heading there
+
+		//distance check
+		int dx = abs(obj->x - hero.x);
+		int dy = abs(obj->y - hero.y);
+		if(dx * dx + dy * dy > search_radius_sq || (dx == 0 && dy == 0))
+			continue; //object too far away
+
+		int estimated_value = get_ai_value_for_object(obj, &hero, get_lowest_route_cost(dx, dy));
+		if(estimated_value > 0)
+			candidates.push_back({ obj, id, estimated_value });
+	}
+
+	sort_hero_goal_candidates(candidates);
+	return candidates;
+}
+
 // Find the best *actionable* target for a hero
 // Considers object value, guards, and reachability
-ai_goal_t find_best_hero_goal(hero_t& hero, const adventure_map_t& map, const game_t& game) {
+// Only reads the map and game, so heroes can be planned on several threads at once (see process_ai_turn); targets
+// reserved by other heroes are skipped and exploration targets are left for ai_choose_explore_target.
+// candidates are what the player's value field holds around the hero, or the objects within a few tiles when it holds
+// nothing there.
+// candidates are routed in order of their estimated value, stopping once no estimate can beat the best real value. if
+// the budget runs out first, the best candidate routed so far wins, or failing that the best estimate
+ai_goal_t find_best_hero_goal(const hero_t& hero, const adventure_map_t& map, const game_t& game,
+							  const std::map<uint16_t, int>& reserved_targets, const ai_turn_budget_t& budget) {
 	ai_goal_t best_goal;
 	best_goal.priority = -1;
 
 	//first, are we in a town?  if so, determine if we should recruit troops
 	if(hero.in_town) {
 		//are we a 'main' hero?
-		if(hero_roles.find(hero.id) != hero_roles.end() && hero_roles[hero.id] == ROLE_MAIN) {
+		auto role = hero_roles.find(hero.id);
+		if(role != hero_roles.end() && role->second == ROLE_MAIN) {
 			auto obj = map.get_interactable_object_for_tile(hero.x, hero.y);
 			if(obj && obj->object_type == OBJECT_MAP_TOWN) {
 				auto town = (town_t*)obj;
@@ -466,36 +628,41 @@ ai_goal_t find_best_hero_goal(hero_t& hero, const adventure_map_t& map, const ga
 	}
 
 	int highest_value = -1;
+	uint16_t target_id = 0;
 	interactable_object_t* target_obj = nullptr;
 	map_monster_t* target_guard = nullptr;
 
-	// Define search radius - could be dynamic based on hero role (scouts search wider?)
-	int radius = 6; //hero.get_scouting_radius() > 0 ? hero.get_scouting_radius() : 10; // Example radius
-	int search_radius_sq = radius * radius;
+	auto candidates = get_hero_field_goal_candidates(hero, game, reserved_targets);
+	if(candidates.empty())
+		candidates = get_hero_goal_candidates(hero, map, reserved_targets);
 
-	for(auto obj : map.objects) {
-		if(!obj) continue;
+	for(const auto& candidate : candidates) {
+		//estimates only shrink from here on, and an equal value only wins with a lower object id
+		if(candidate.estimated_value < highest_value || (candidate.estimated_value == highest_value && candidate.id > target_id))
+			break;
 
-		//distance check
-		int dx = obj->x - hero.x;
-		int dy = obj->y - hero.y;
-		if(dx * dx + dy * dy > search_radius_sq)
-			continue; //object too far away
+		if(budget.expired()) {
+			if(!target_obj) {
+				highest_value = candidate.estimated_value;
+				target_obj = candidate.object;
+			}
+			break;
+		}
+
+		auto obj = candidate.object;
+		auto route = map.get_route(&hero, obj->x, obj->y, &game);
+		if(route.empty())
+			continue; //unreachable
 
 		// Get object value *for this hero* (considers guard winnability)
-		int current_value = get_ai_value_for_object(obj, &hero, &game);
+		int current_value = get_ai_value_for_object(obj, &hero, route.back().total_cost);
 
 		// Update best target if this object is better
-		if(current_value > highest_value)
-		{
-// Check reachability *before* finalizing (get_route_cost_to_tile handles this)
-			int cost_to_target = map.get_route_cost_to_tile(&hero, obj->x, obj->y, &game);
-			if(cost_to_target != -1)
-			{ // Reachable?
-				highest_value = current_value;
-				target_obj = obj;
-				//target_guard = guard; // Store the guard if present (even if null)
-			}
+		if(current_value > highest_value || (current_value == highest_value && candidate.id < target_id)) {
+			highest_value = current_value;
+			target_id = candidate.id;
+			target_obj = obj;
+			//target_guard = guard; // Store the guard if present (even if null)
 		}
 	}
 
@@ -524,23 +691,86 @@ ai_goal_t find_best_hero_goal(hero_t& hero, const adventure_map_t& map, const ga
 	 // No valuable objects found, maybe explore?
 		best_goal.goal = GOAL_EXPLORE; // Implement exploration logic separately
 		best_goal.priority = 5; // Low priority exploration goal
-		// Find a nearby unexplored tile as target_coord for exploration
-		int startx = hero.x;
-		int starty = hero.y;
-		int explore_radius = 6;
-		int xoff = (rand() % (explore_radius * 2)) - explore_radius;
-		int yoff = (rand() % (explore_radius * 2)) - explore_radius;
-		int destx = std::clamp(startx + xoff, 0, map.width - 1);
-		int desty = std::clamp(starty + yoff, 0, map.height - 1);
-		//bug? here if xoff and yoff == 0
-		best_goal.target_coord.x = destx;
-		best_goal.target_coord.y = desty;
-
 	}
 
 	return best_goal;
 }
 
+// Find a nearby unexplored tile as target_coord for exploration. draws from rand(), so it must only be called from the
+// serial part of process_ai_turn to keep turns reproducible
+void ai_choose_explore_target(const hero_t& hero, const adventure_map_t& map, ai_goal_t& goal) {
+	int startx = hero.x;
+	int starty = hero.y;
+	int explore_radius = 6;
+	int xoff = (rand() % (explore_radius * 2)) - explore_radius;
+	int yoff = (rand() % (explore_radius * 2)) - explore_radius;
+	int destx = std::clamp(startx + xoff, 0, map.width - 1);
+	int desty = std::clamp(starty + yoff, 0, map.height - 1);
+	//bug? here if xoff and yoff == 0
+	goal.target_coord.x = destx;
+	goal.target_coord.y = desty;
+}
+
+// A plan is stale once its hero has moved, or its target is gone or was claimed by a hero committed before it
+bool is_hero_plan_valid(const hero_plan_t& plan, const hero_t& hero, const adventure_map_t& map, const std::map<uint16_t, int>& reserved_targets) {
+	if(plan.hero_id != hero.id || plan.origin_x != hero.x || plan.origin_y != hero.y)
+		return false;
+
+	if(!plan.goal.target_object)
+		return true;
+
+	if(plan.target_id >= map.objects.size() || map.objects[plan.target_id] != plan.goal.target_object)
+		return false;
+
+	auto reservation = reserved_targets.find(plan.target_id);
+	return reservation == reserved_targets.end() || reservation->second == hero.id;
+}
+
+// Plans every hero in heroes against the current map, spreading them over worker threads. each plan depends only on
+// the map as it is now and on reserved_targets, never on which thread ran it or in what order
+void plan_hero_goals(const std::vector<const hero_t*>& heroes, const game_t& game, const std::map<uint16_t, int>& reserved_targets,
+					 const ai_turn_budget_t& budget, uint thread_count, std::vector<hero_plan_t>& plans) {
+	const auto& map = game.map;
+	plans.assign(heroes.size(), {});
+	if(heroes.empty())
+		return;
+
+	map.prepare_for_concurrent_reads();
+
+	auto plan_hero = [&](size_t index) {
+		const auto& hero = *heroes[index];
+		auto& plan = plans[index];
+		plan.hero_id = hero.id;
+		plan.origin_x = hero.x;
+		plan.origin_y = hero.y;
+		plan.goal = find_best_hero_goal(hero, map, game, reserved_targets, budget);
+		if(plan.goal.target_object)
+			plan.target_id = map.get_object_id(plan.goal.target_object);
+	};
+
+	if(!thread_count)
+		thread_count = std::max(1u, std::thread::hardware_concurrency());
+	thread_count = std::min<uint>(thread_count, (uint)heroes.size());
+
+	if(thread_count == 1) {
+		for(size_t i = 0; i < heroes.size(); i++)
+			plan_hero(i);
+		return;
+	}
+
+	std::atomic<size_t> next_hero = 0;
+	auto worker = [&]() {
+		for(size_t i = next_hero++; i < heroes.size(); i = next_hero++)
+			plan_hero(i);
+	};
+
+	std::vector<std::thread> workers;
+	for(uint i = 0; i < thread_count; i++)
+		workers.emplace_back(worker);
+	for(auto& thread : workers)
+		thread.join();
+}
+
 // Execute a single step towards the hero's current goal
 // Returns true if an action was taken (movement, interaction), false otherwise
 bool game_t::ai_execute_hero_step(hero_t* hero, ai_goal_t& current_goal) {
@@ -673,12 +903,9 @@ void print_debug_hero_goal(hero_t* hero, ai_goal_t& goal) {
 }
 
 void game_t::process_ai_turn(player_e player_num) {
-	//for(int i = 1; i < 5; i++) {
-		//int fake_delay_ms_REMOVE_ME = 10;//900;
-		//std::this_thread::sleep_for(std::chrono::milliseconds(fake_delay_ms_REMOVE_ME));
-		//std::cout << "calling ai_progress callback (" << i*20 << ")\n";
-		//ai_turn_progress_callback_fn(player_num, i*20);
-	//}
+	ai_turn_budget_t budget;
+	budget.budget = std::chrono::milliseconds(get_player_configuration(player_num).ai_turn_time_budget_ms);
+	auto phase_start = budget.start;
 
 	last_turn_actions[player_num].clear();
 
@@ -706,12 +933,35 @@ void game_t::process_ai_turn(player_e player_num) {
 			<< " at town '" << town->name << "' (" << town->x << ", " << town->y << ")." << std::endl;
 	}
 
+	budget.end_phase(AI_TURN_PHASE_TOWNS, phase_start);
+
+	//progress is the share of the heroes' movement points spent, or of the budget used if that is further along
+	int64_t starting_movement_points = 0;
+	int last_progress = -1;
+	auto report_progress = [&](bool done) {
+		int64_t movement_points = 0;
+		for(const auto& h : map.heroes) {
+			if(h.second.player == player_num)
+				movement_points += h.second.movement_points;
+		}
+
+		int progress = starting_movement_points ? (int)(100 * (starting_movement_points - movement_points) / starting_movement_points) : 0;
+		if(budget.is_limited())
+			progress = std::max(progress, (int)(100 * to_milliseconds(budget.elapsed()) / budget.budget.count()));
+		progress = done ? 100 : std::clamp(progress, 0, 99);
+
+		if(progress > last_progress && ai_turn_progress_callback_fn)
+			ai_turn_progress_callback_fn(player_num, progress);
+		last_progress = std::max(last_progress, progress);
+	};
+
 	for(auto& h : map.heroes) {
 		auto& hero = h.second;
 		if(hero.player != player_num)
 			continue;
 
 		hero_roles[hero.id] = classify_hero(&hero);
+		starting_movement_points += hero.movement_points;
 
 		replay_action_t action;
 		action.action = ACTION_REPLAY_SET_INITIAL_HERO_POSITION;
@@ -722,8 +972,13 @@ void game_t::process_ai_turn(player_e player_num) {
 	}
 	
 
+	//goals are planned in parallel against the map as it stands at the start of each round, then committed one hero
+	//at a time in id order. plans an earlier hero's moves invalidated are redone serially, so the outcome does not
+	//depend on ai_planning_thread_count. once the time budget runs out, goals are settled from estimates and the turn
+	//ends after the current round (the first round always runs)
 	std::vector<hero_plan_t> hero_plans;
-	std::set<uint32_t> reserved_targets;
+	std::vector<const hero_t*> heroes_to_plan;
+	std::map<uint16_t, int> reserved_targets; //object id -> id of the hero whose goal targets it
 
 	std::unordered_map<uint16_t, ai_goal_t> hero_current_goals;
 
@@ -731,9 +986,27 @@ void game_t::process_ai_turn(player_e player_num) {
 	int max_iterations = 200;
 	int i = 0;
 
-	while(can_any_hero_act && i < max_iterations) {
+	report_progress(false);
+	while(can_any_hero_act && i < max_iterations && (i == 0 || !budget.expired())) {
 		can_any_hero_act = false;
 
+		phase_start = ai_turn_budget_t::clock_t::now();
+		heroes_to_plan.clear();
+		for(auto& h : map.heroes) {
+			auto& hero = h.second;
+			if(hero.player != player_num || hero.movement_points < 50)
+				continue;
+
+			const auto& current_goal = hero_current_goals[hero.id];
+			if(current_goal.goal == GOAL_NONE || current_goal.priority <= 0)
+				heroes_to_plan.push_back(&hero);
+		}
+
+		update_ai_value_field(*this, player_num);
+		plan_hero_goals(heroes_to_plan, *this, reserved_targets, budget, ai_planning_thread_count, hero_plans);
+		budget.end_phase(AI_TURN_PHASE_PLANNING, phase_start);
+
+		phase_start = ai_turn_budget_t::clock_t::now();
 		for(auto& h : map.heroes) {
 			auto& hero = h.second;
 			if(hero.player != player_num || hero.movement_points < 50)
@@ -741,10 +1014,21 @@ void game_t::process_ai_turn(player_e player_num) {
 		
 			ai_goal_t& current_goal = hero_current_goals[hero.id];
 			if(current_goal.goal == GOAL_NONE || current_goal.priority <= 0) {
-				current_goal = find_best_hero_goal(hero, map, *this);
+				auto plan = std::find_if(hero_plans.begin(), hero_plans.end(), [&](const hero_plan_t& p) { return p.hero_id == hero.id; });
+				if(plan != hero_plans.end() && is_hero_plan_valid(*plan, hero, map, reserved_targets))
+					current_goal = plan->goal;
+				else
+					current_goal = find_best_hero_goal(hero, map, *this, reserved_targets, budget);
+
+				if(current_goal.goal == GOAL_EXPLORE)
+					ai_choose_explore_target(hero, map, current_goal);
+
 				print_debug_hero_goal(&hero, current_goal);
 				if(current_goal.goal == GOAL_NONE || current_goal.priority <= 0)
 					continue;
+
+				if(current_goal.target_object)
+					reserved_targets[map.get_object_id(current_goal.target_object)] = hero.id;
 			}
 
 			int s = 0;
@@ -753,16 +1037,26 @@ void game_t::process_ai_turn(player_e player_num) {
 					break;
 			}
 
-			current_goal = find_best_hero_goal(hero, map, *this);
-			print_debug_hero_goal(&hero, current_goal);
-			if(current_goal.goal != GOAL_NONE)
-				can_any_hero_act = true;
-
+			//planned again from where it stopped in the next round's planning phase
+			std::erase_if(reserved_targets, [&](const auto& reservation) { return reservation.second == hero.id; });
+			current_goal = ai_goal_t();
+			can_any_hero_act = true;
 		}
 
+		budget.end_phase(AI_TURN_PHASE_HEROES, phase_start);
+		report_progress(false);
 		i++;
 	}
 
+	if(budget.overrun_phase != AI_TURN_PHASE_COUNT) {
+		std::cout << "[" << magic_enum::enum_name(player_num).data() << "] ai turn took " << to_milliseconds(budget.elapsed())
+			<< "ms, over its " << budget.budget.count() << "ms budget; ran out during " << magic_enum::enum_name(budget.overrun_phase).data()
+			<< " (towns " << to_milliseconds(budget.phase_time[AI_TURN_PHASE_TOWNS]) << "ms, planning " << to_milliseconds(budget.phase_time[AI_TURN_PHASE_PLANNING])
+			<< "ms, heroes " << to_milliseconds(budget.phase_time[AI_TURN_PHASE_HEROES]) << "ms)." << std::endl;
+	}
+
+	report_progress(true);
+
 	//for(auto& h : map.heroes) {
 	//	auto& hero = h.second;
 	//	if(hero.player != player_num)
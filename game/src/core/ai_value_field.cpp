@@ -0,0 +1,358 @@
+#include "core/ai_value_field.h"
+#include "core/adventure_map.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace {
+const int dx[] = { 1, 0, -1, 0, 1, 1, -1, -1 };
+const int dy[] = { 0, 1, 0, -1, 1, -1, 1, -1 };
+
+//same step cost as adventure_map_t::find_route, without the hero's terrain/pathfinding modifiers
+int get_step_cost(const adventure_map_t& map, int x, int y, bool diagonal) {
+	return (int)(map.get_terrain_movement_base_cost(nullptr, x, y) * (diagonal ? 14.f : 10.f));
+}
+
+bool is_water(const adventure_map_t& map, int tile) {
+	return map.tiles.get_terrain_type(tile % map.width, tile / map.width) == TERRAIN_WATER;
+}
+}
+
+double ai_value_field_t::get_score(uint16_t object, int cost) const {
+	return objects[object].log_value - ((double)cost / HALF_LIFE_COST);
+}
+
+void ai_value_field_t::set_value(uint16_t object, int value) {
+	objects[object].value = value;
+	objects[object].log_value = value > 0 ? std::log2((double)value) : 0;
+}
+
+//highest score first; ties go to the lower object id, then the lower tile, so every build settles in the same order
+bool ai_value_field_t::pops_after(const push_t& a, const push_t& b) {
+	if(a.score != b.score)
+		return a.score < b.score;
+	if(a.object != b.object)
+		return a.object > b.object;
+	if(a.tile != b.tile)
+		return a.tile > b.tile;
+	return a.cost > b.cost;
+}
+
+bool ai_value_field_t::is_source_tile(uint16_t object, int tile) const {
+	return object < objects.size() && objects[object].x + (objects[object].y * width) == tile;
+}
+
+bool ai_value_field_t::can_hold(const adventure_map_t& map, int tile, uint16_t object) const {
+	const auto& map_tile = map.get_tile(tile % width, tile / width);
+	if(map_tile.terrain_type == TERRAIN_UNKNOWN || !visibility.testBit(tile))
+		return false;
+
+	if(is_source_tile(object, tile))
+		return true;
+
+	//an object's tile only ever holds the object itself
+	return map_tile.passability && (!map_tile.is_interactable() || map_tile.interactable_object - 1 == object);
+}
+
+bool ai_value_field_t::can_expand(const adventure_map_t& map, int tile, uint16_t object) const {
+	if(is_source_tile(object, tile))
+		return true;
+
+	return !map.tiles.get_interactable_object(tile % width, tile / width) && !map.is_tile_guarded_by_monster(tile % width, tile / width);
+}
+
+bool ai_value_field_t::is_better(const slot_t& a, const slot_t& b) const {
+	if(b.object == NO_OBJECT)
+		return true;
+
+	double a_score = get_score(a.object, a.cost);
+	double b_score = get_score(b.object, b.cost);
+	return a_score > b_score || (a_score == b_score && a.object < b.object);
+}
+
+//the slot the object would take on the tile at that cost, -1 if the tile already holds something better
+int ai_value_field_t::find_slot(int tile, uint16_t object, int cost) const {
+	const slot_t* tile_slots = &slots[(size_t)tile * SLOTS];
+	for(int s = 0; s < SLOTS; s++) {
+		if(tile_slots[s].object == object)
+			return tile_slots[s].cost <= cost ? -1 : s;
+	}
+
+	return is_better({ object, cost }, tile_slots[SLOTS - 1]) ? SLOTS - 1 : -1;
+}
+
+bool ai_value_field_t::accept(int tile, uint16_t object, int cost) {
+	int i = find_slot(tile, object, cost);
+	if(i == -1)
+		return false;
+
+	slot_t* tile_slots = &slots[(size_t)tile * SLOTS];
+	tile_slots[i] = { object, cost };
+	for(; i > 0 && is_better(tile_slots[i], tile_slots[i - 1]); i--)
+		std::swap(tile_slots[i], tile_slots[i - 1]);
+
+	return true;
+}
+
+void ai_value_field_t::push(std::vector<push_t>& open_set, int tile, uint16_t object, int cost) const {
+	if(objects[object].value <= 0 || find_slot(tile, object, cost) == -1)
+		return;
+
+	open_set.push_back({ get_score(object, cost), tile, object, cost });
+	std::push_heap(open_set.begin(), open_set.end(), pops_after);
+}
+
+void ai_value_field_t::push_neighbours(const adventure_map_t& map, std::vector<push_t>& open_set, int tile, uint16_t object, int cost) const {
+	const int x = tile % width;
+	const int y = tile / width;
+	const bool water = is_water(map, tile);
+	const bool source = is_source_tile(object, tile);
+
+	for(int i = 0; i < 8; i++) {
+		int nx = x + dx[i];
+		int ny = y + dy[i];
+		if(!map.tile_valid(nx, ny))
+			continue;
+
+		int neighbour = nx + (ny * width);
+		if((!source && is_water(map, neighbour) != water) || !can_hold(map, neighbour, object))
+			continue;
+
+		push(open_set, neighbour, object, cost + get_step_cost(map, nx, ny, i >= 4));
+	}
+}
+
+void ai_value_field_t::pull_from_neighbours(const adventure_map_t& map, std::vector<push_t>& open_set, int tile) const {
+	const int x = tile % width;
+	const int y = tile / width;
+	const bool water = is_water(map, tile);
+
+	for(int i = 0; i < 8; i++) {
+		int nx = x + dx[i];
+		int ny = y + dy[i];
+		if(!map.tile_valid(nx, ny))
+			continue;
+
+		int neighbour = nx + (ny * width);
+		for(int s = 0; s < SLOTS; s++) {
+			const auto& slot = slots[((size_t)neighbour * SLOTS) + s];
+			if(slot.object == NO_OBJECT || !can_expand(map, neighbour, slot.object))
+				continue;
+
+			if((!is_source_tile(slot.object, neighbour) && is_water(map, neighbour) != water) || !can_hold(map, tile, slot.object))
+				continue;
+
+			push(open_set, tile, slot.object, slot.cost + get_step_cost(map, x, y, i >= 4));
+		}
+	}
+}
+
+//best-first over scores: the first SLOTS distinct objects to reach a tile are the ones that score best there, and
+//only a tile that took an object passes it on
+void ai_value_field_t::propagate(const adventure_map_t& map, std::vector<push_t>& open_set) {
+	while(!open_set.empty()) {
+		std::pop_heap(open_set.begin(), open_set.end(), pops_after);
+		auto next = open_set.back();
+		open_set.pop_back();
+
+		if(accept(next.tile, next.object, next.cost) && can_expand(map, next.tile, next.object))
+			push_neighbours(map, open_set, next.tile, next.object, next.cost);
+	}
+}
+
+void ai_value_field_t::rebuild(const adventure_map_t& map, const std::vector<int>& values) {
+	width = map.width;
+	height = map.height;
+	slots.assign((size_t)width * height * SLOTS, {});
+	objects.assign(map.objects.size(), {});
+	valid = true;
+
+	std::vector<push_t> open_set;
+	for(uint16_t id = 0; id < map.objects.size(); id++) {
+		auto obj = map.objects[id];
+		if(!obj)
+			continue;
+
+		auto& state = objects[id];
+		set_value(id, id < values.size() ? values[id] : 0);
+		state.x = obj->x;
+		state.y = obj->y;
+		state.present = true;
+		state.is_monster = obj->object_type == OBJECT_MAP_MONSTER;
+
+		int tile = obj->x + (obj->y * width);
+		if(map.tile_valid(obj->x, obj->y) && can_hold(map, tile, id))
+			push(open_set, tile, id, 0);
+	}
+
+	propagate(map, open_set);
+}
+
+//the tiles holding an object always connect back to its own tile: an object that made a tile's best SLOTS also made
+//them on the tile it arrived from, since every other object there would have arrived too with the same step added
+void ai_value_field_t::collect_object_region(uint16_t object, std::vector<int>& region) {
+	const auto& state = objects[object];
+	if(state.x < 0 || state.y < 0 || state.x >= width || state.y >= height)
+		return;
+
+	auto holds_object = [&](int tile) {
+		for(int s = 0; s < SLOTS; s++) {
+			if(slots[((size_t)tile * SLOTS) + s].object == object)
+				return true;
+		}
+
+		return false;
+	};
+
+	const uint8_t IN_REGION = 1;
+	const uint8_t VISITED = 2;
+	std::vector<int> visited;
+	int start = state.x + (state.y * width);
+	if(holds_object(start)) {
+		tile_marks[start] |= VISITED;
+		visited.push_back(start);
+	}
+
+	for(size_t next = 0; next < visited.size(); next++) {
+		const int x = visited[next] % width;
+		const int y = visited[next] / width;
+		for(int i = 0; i < 8; i++) {
+			int nx = x + dx[i];
+			int ny = y + dy[i];
+			if(nx < 0 || ny < 0 || nx >= width || ny >= height)
+				continue;
+
+			int neighbour = nx + (ny * width);
+			if(!(tile_marks[neighbour] & VISITED) && holds_object(neighbour)) {
+				tile_marks[neighbour] |= VISITED;
+				visited.push_back(neighbour);
+			}
+		}
+	}
+
+	for(auto tile : visited) {
+		tile_marks[tile] &= ~VISITED;
+		if(!(tile_marks[tile] & IN_REGION)) {
+			tile_marks[tile] |= IN_REGION;
+			region.push_back(tile);
+		}
+	}
+}
+
+void ai_value_field_t::update(const adventure_map_t& map, const tile_bitset_t& player_visibility, const std::vector<int>& values) {
+	const int tile_count = map.width * map.height;
+	bool needs_rebuild = !valid || width != map.width || height != map.height || visibility.size() != tile_count
+		|| player_visibility.size() != tile_count || values.size() != map.objects.size() || objects.size() > map.objects.size();
+
+	//new objects, moved objects and tiles lost to fog can cut routes the field was built through
+	for(size_t id = objects.size(); id < map.objects.size() && !needs_rebuild; id++)
+		needs_rebuild = map.objects[id] != nullptr;
+
+	for(size_t id = 0; id < objects.size() && !needs_rebuild; id++) {
+		auto obj = map.objects[id];
+		needs_rebuild = obj && (!objects[id].present || obj->x != objects[id].x || obj->y != objects[id].y);
+	}
+
+	for(size_t w = 0; w < visibility.words.size() && !needs_rebuild; w++)
+		needs_rebuild = (visibility.words[w] & ~player_visibility.words[w]) != 0;
+
+	if(needs_rebuild) {
+		visibility = player_visibility.size() == tile_count ? player_visibility : tile_bitset_t(tile_count, false);
+		rebuild(map, values);
+		return;
+	}
+
+	objects.resize(map.objects.size());
+	tile_marks.assign(tile_count, 0);
+	std::vector<int> region;
+	std::vector<int> reseed;
+
+	for(size_t w = 0; w < visibility.words.size(); w++) {
+		for(uint64_t revealed = player_visibility.words[w] & ~visibility.words[w]; revealed; revealed &= revealed - 1)
+			reseed.push_back((int)(w * 64) + std::countr_zero(revealed));
+	}
+	visibility = player_visibility;
+
+	for(uint16_t id = 0; id < objects.size(); id++) {
+		auto& state = objects[id];
+		const bool removed = state.present && !map.objects[id];
+		if(state.value == values[id] && !removed)
+			continue;
+
+		collect_object_region(id, region);
+		set_value(id, values[id]);
+		if(!map.tile_valid(state.x, state.y))
+			continue;
+
+		reseed.push_back(state.x + (state.y * width));
+		if(removed) {
+			state.present = false;
+
+			//a monster's guard zone opens up along with its tile
+			for(int y = state.y - 1; state.is_monster && y <= state.y + 1; y++) {
+				for(int x = state.x - 1; x <= state.x + 1; x++) {
+					if(map.tile_valid(x, y))
+						reseed.push_back(x + (y * width));
+				}
+			}
+		}
+	}
+
+	for(auto tile : region)
+		std::fill_n(slots.begin() + ((size_t)tile * SLOTS), SLOTS, slot_t());
+
+	reseed.insert(reseed.end(), region.begin(), region.end());
+
+	std::vector<push_t> open_set;
+	for(auto tile : reseed) {
+		pull_from_neighbours(map, open_set, tile);
+
+		const auto& map_tile = map.get_tile(tile % width, tile / width);
+		if(map_tile.is_interactable()) {
+			uint16_t object = map_tile.interactable_object - 1;
+			if(is_source_tile(object, tile) && can_hold(map, tile, object))
+				push(open_set, tile, object, 0);
+		}
+
+		//what the tile already holds may now spread through it
+		for(int s = 0; s < SLOTS; s++) {
+			const auto slot = slots[((size_t)tile * SLOTS) + s];
+			if(slot.object != NO_OBJECT && can_expand(map, tile, slot.object))
+				push_neighbours(map, open_set, tile, slot.object, slot.cost);
+		}
+	}
+
+	propagate(map, open_set);
+}
+
+std::vector<ai_value_field_t::sample_t> ai_value_field_t::sample(int x, int y, int radius) const {
+	std::vector<sample_t> samples;
+	if(!valid)
+		return samples;
+
+	for(int ty = std::max(y - radius, 0); ty <= std::min(y + radius, height - 1); ty++) {
+		for(int tx = std::max(x - radius, 0); tx <= std::min(x + radius, width - 1); tx++) {
+			for(int s = 0; s < SLOTS; s++) {
+				const auto& slot = slots[((size_t)(tx + (ty * width)) * SLOTS) + s];
+				if(slot.object == NO_OBJECT || objects[slot.object].value <= 0)
+					continue;
+
+				auto it = std::find_if(samples.begin(), samples.end(), [&](const sample_t& sample) { return sample.object == slot.object; });
+				if(it == samples.end())
+					samples.push_back({ slot.object, slot.cost, 0 });
+				else
+					it->cost = std::min(it->cost, slot.cost);
+			}
+		}
+	}
+
+	for(auto& sample : samples)
+		sample.score = get_score(sample.object, sample.cost);
+
+	std::sort(samples.begin(), samples.end(), [](const sample_t& a, const sample_t& b) {
+		return a.score > b.score || (a.score == b.score && a.object < b.object);
+	});
+
+	return samples;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "core/fog_of_war.h"
+
+#include <cstdint>
+#include <vector>
+
+struct adventure_map_t;
+
+//per-player map of where the valuable objects are, for the adventure AI. every tile holds the SLOTS objects that look
+//best from it, scored as value * 2^(-cost / HALF_LIFE_COST) where cost is the hero-independent route cost out of the
+//object (objects, guarded tiles and fogged tiles stop the spread). the decay is exponential so that a step adds the same
+//amount to every object's cost without changing which of two objects scores higher; that is what lets update() patch
+//only the tiles an object reached instead of rebuilding the whole field
+struct ai_value_field_t {
+	static constexpr int SLOTS = 2;
+	static constexpr int HALF_LIFE_COST = 500; //five grass tiles
+	static constexpr uint16_t NO_OBJECT = 0xFFFF;
+
+	struct slot_t {
+		uint16_t object = NO_OBJECT; //index into adventure_map_t::objects
+		int cost = 0;
+		bool operator==(const slot_t& other) const = default;
+	};
+
+	//what the field was last built from, per object id
+	struct object_state_t {
+		int value = 0;
+		double log_value = 0;
+		int16_t x = -1;
+		int16_t y = -1;
+		bool present = false;
+		bool is_monster = false;
+	};
+
+	struct sample_t {
+		uint16_t object = NO_OBJECT;
+		int cost = 0;
+		double score = 0;
+	};
+
+	uint16_t width = 0;
+	uint16_t height = 0;
+	bool valid = false;
+	std::vector<slot_t> slots; //SLOTS per tile (x + y * width), best first
+	std::vector<object_state_t> objects;
+	tile_bitset_t visibility;
+
+	void invalidate() { valid = false; }
+	//values[id] is what map.objects[id] is worth to the player right now, 0 if nothing (including removed objects).
+	//objects that were removed or changed value and tiles that became visible are patched in; the field is rebuilt when
+	//the map changes size, gains or moves objects, or tiles fall back into fog
+	void update(const adventure_map_t& map, const tile_bitset_t& player_visibility, const std::vector<int>& values);
+	//every object held by a tile within radius of (x, y) on both axes, once each at its best score, best first
+	std::vector<sample_t> sample(int x, int y, int radius) const;
+	double get_score(uint16_t object, int cost) const;
+
+private:
+	struct push_t {
+		double score = 0;
+		int tile = -1;
+		uint16_t object = NO_OBJECT;
+		int cost = 0;
+	};
+
+	std::vector<uint8_t> tile_marks; //scratch for update()
+
+	static bool pops_after(const push_t& a, const push_t& b);
+	void set_value(uint16_t object, int value);
+	bool is_better(const slot_t& a, const slot_t& b) const;
+	int find_slot(int tile, uint16_t object, int cost) const;
+	void rebuild(const adventure_map_t& map, const std::vector<int>& values);
+	bool is_source_tile(uint16_t object, int tile) const;
+	bool can_hold(const adventure_map_t& map, int tile, uint16_t object) const;
+	bool can_expand(const adventure_map_t& map, int tile, uint16_t object) const;
+	bool accept(int tile, uint16_t object, int cost);
+	void push(std::vector<push_t>& open_set, int tile, uint16_t object, int cost) const;
+	void push_neighbours(const adventure_map_t& map, std::vector<push_t>& open_set, int tile, uint16_t object, int cost) const;
+	void pull_from_neighbours(const adventure_map_t& map, std::vector<push_t>& open_set, int tile) const;
+	void propagate(const adventure_map_t& map, std::vector<push_t>& open_set);
+	void collect_object_region(uint16_t object, std::vector<int>& region);
+};
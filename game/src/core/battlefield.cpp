@@ -921,11 +921,11 @@ uint32_t battlefield_t::calculate_damage(battlefield_unit_t& attacker, battlefie
 	auto min_damage = dmg_range.first;
 	auto max_damage = dmg_range.second;
 	
-	uint32_t base_dmg = utils::rand_range(min_damage, max_damage) * attacker.stack_size;
+	uint32_t base_dmg = utils::rand_range(min_damage, max_damage, rng) * attacker.stack_size;
 
 	auto damage = apply_damage_adjustments(base_dmg, attacker, defender, is_ranged_attack, is_retaliation, attack_from_hex, source_movement_hex);
 
-	if(army_of_attacker.is_affected_by_talent(TALENT_CRITICAL_STRIKE) && utils::rand_chance(20))
+	if(army_of_attacker.is_affected_by_talent(TALENT_CRITICAL_STRIKE) && utils::rand_chance(20, rng))
 		damage *= 1.5;
 
 	return damage;
@@ -1192,7 +1192,7 @@ float battlefield_t::get_damage_multiplier(battlefield_unit_t& attacker, battlef
 	float ignore_defense_amount = 1.f;
 	if(attacker.has_buff(BUFF_BEHEMOTH_CLAWS))
 		ignore_defense_amount = .4f;
-	if(utils::rand_chance(50) && army_of_attacker.is_affected_by_talent(TALENT_DESOLATOR))
+	if(utils::rand_chance(50, rng) && army_of_attacker.is_affected_by_talent(TALENT_DESOLATOR))
 		ignore_defense_amount -= .2f;
 	
 	defense *= ignore_defense_amount;
@@ -1476,7 +1476,7 @@ spell_result_e battlefield_t::cast_spell(battlefield_unit_t* caster, spell_e spe
 				SPELL_FORTITUDE,
 				SPELL_BLESS
 		};
-		spell_id = genie_spells[std::rand() % genie_spells.size()];
+		spell_id = genie_spells[rng() % genie_spells.size()];
 	}
 
 	if(!target_unit) {
@@ -1491,7 +1491,7 @@ spell_result_e battlefield_t::cast_spell(battlefield_unit_t* caster, spell_e spe
 		if(!targets.size())
 			return SPELL_RESULT_INVALID_TARGET;
 
-		target_unit = targets[std::rand() % targets.size()];
+		target_unit = targets[rng() % targets.size()];
 	}
 	else if(!is_spell_target_valid(friendly_army.hero, target_unit, spell_id)) {
 		return SPELL_RESULT_INVALID_TARGET;
@@ -1825,7 +1825,7 @@ spell_result_e battlefield_t::cast_spell(hero_t* caster, spell_e spell_id, int t
 
 			int target_count = caster->get_spell_effect_multiplier(spell_id) * spell.multiplier[0].get_value(get_hero_adjusted_power(caster));
 			for(int i = 0; i < target_count; i++) {
-				auto t = valid_targets[rand() % valid_targets.size()];
+				auto t = valid_targets[rng() % valid_targets.size()];
 				damage = spell.multiplier[1].get_value(get_hero_adjusted_power(caster), caster->get_spell_effect_multiplier(spell_id));
 				damage = calculate_magic_damage_to_stack(damage, *t, spell.damage_type);
 				auto kills = deal_magic_damage_to_stack(damage, *t);
@@ -2255,7 +2255,7 @@ spell_result_e battlefield_t::cast_spell(hero_t* caster, spell_e spell_id, int t
 	if(caster) {
 		caster->mana -= mana_cost;
 
-		if(caster->is_artifact_in_effect(ARTIFACT_FIFTYS_LUCKY_COIN) && (utils::rand_chance(50)))
+		if(caster->is_artifact_in_effect(ARTIFACT_FIFTYS_LUCKY_COIN) && (utils::rand_chance(50, rng)))
 			restore_hero_mana(caster, mana_cost, TALENT_NONE, ARTIFACT_FIFTYS_LUCKY_COIN);
 
 		//uupdate battle stats
@@ -2335,7 +2335,7 @@ battlefield_unit_t* get_random_troop(army_t::battlefield_unit_group_t& troops) {
 		
 		count++;
 		
-		if((std::rand() % count) == 0)
+		if((rng() % count) == 0)
 			chosen_index = i; //with probability 1/count, select this troop.
 	}
 	
@@ -2617,9 +2617,9 @@ void battlefield_t::reset() {
 		}
 
 		uint32_t seed = ((uint32_t)(defending_monster->x & 0xFFFF) << 16) | ((uint16_t)defending_monster->y & 0xFFFF); //fixme
-		std::mt19937_64 rng(seed);
+		std::mt19937_64 split_rng(seed);
 		std::uniform_int_distribution<int> dist(min_stacks, max_stacks);
-		int stack_count = dist(rng);
+		int stack_count = dist(split_rng);
 		stack_count = std::clamp(stack_count, 1, (int)game_config::HERO_TROOP_SLOTS);
 		stack_count = std::clamp(stack_count, 1, (int)defending_monster->quantity); //can't split into more stacks than we have creatures
 
@@ -2784,8 +2784,6 @@ void battlefield_t::setup_obstacles(bool only_clear) {
 	if(only_clear)
 		return;
 
-	//srand(time(nullptr));
-
 	//special case for ship combat
 	if(environment_type == BATTLEFIELD_ENVIRONMENT_WATER) {
 
@@ -2798,14 +2796,14 @@ void battlefield_t::setup_obstacles(bool only_clear) {
 	int covered_hexes = 0;
 	int attempts = 0;
 	int max_attempts = 1000;
-	const float coverage_percentage = utils::rand_rangef(6.0f, 12.0f);
+	const float coverage_percentage = utils::rand_rangef(6.0f, 12.0f, rng);
 	while(covered_hexes < ((coverage_percentage / 100.f) * game_config::BATTLEFIELD_WIDTH * game_config::BATTLEFIELD_HEIGHT) && attempts < max_attempts) {
 		//pick a random hex in the valid area
-		int start_x = obstacle_margin + (rand() % (game_config::BATTLEFIELD_WIDTH - (2 * obstacle_margin)));
-		int start_y = (rand() % game_config::BATTLEFIELD_HEIGHT);
+		int start_x = obstacle_margin + static_cast<int>(rng() % (game_config::BATTLEFIELD_WIDTH - (2 * obstacle_margin)));
+		int start_y = static_cast<int>(rng() % game_config::BATTLEFIELD_HEIGHT);
 		
 		//pick a random obstacle shape
-		const auto& shape = obstacle_shapes.at(rand() % obstacle_shapes.size());
+		const auto& shape = obstacle_shapes.at(rng() % obstacle_shapes.size());
 		
 		//see if the obstacle placement would work
 		bool placement_valid = true;
@@ -2843,7 +2841,13 @@ void battlefield_t::setup_obstacles(bool only_clear) {
 	
 }
 
+void battlefield_t::seed_rng() {
+	//without a fixed seed each battle draws one from the global rand() stream, so srand() still reproduces a game
+	rng.seed(rng_seed ? *rng_seed : (uint64_t)std::rand());
+}
+
 void battlefield_t::init_hero_creature_bank_battle(hero_t* attacker, army_t& defender, interactable_object_t* object) {
+	seed_rng();
 	defending_army = defender;
 	attacking_hero = attacker;
 	defending_hero = nullptr;
@@ -2869,6 +2873,7 @@ void battlefield_t::init_hero_creature_bank_battle(hero_t* attacker, army_t& def
 
 //todo: need to fold this and init_hero_hero_battle into one function
 void battlefield_t::init_hero_monster_battle(hero_t* attacker, map_monster_t* defender) {
+	seed_rng();
 	attacking_hero = attacker;
 	defending_hero = nullptr;
 	defending_town = nullptr;
@@ -2889,6 +2894,7 @@ void battlefield_t::init_hero_monster_battle(hero_t* attacker, map_monster_t* de
 }
 
 void battlefield_t::init_hero_town_battle(hero_t* attacker, town_t* defender, bool is_deathmatch_battle) {
+	seed_rng();
 	attacking_hero = attacker;
 	defending_hero = defender->garrisoned_hero ? defender->garrisoned_hero : defender->visiting_hero;
 	attacking_army.hero = attacker;
@@ -2913,6 +2919,7 @@ void battlefield_t::init_hero_town_battle(hero_t* attacker, town_t* defender, bo
 }
 
 void battlefield_t::init_hero_hero_battle(hero_t* attacker, hero_t* defender, bool is_deathmatch_battle) {
+	seed_rng();
 	attacking_hero = attacker;
 	defending_hero = defender;
 	attacking_army.hero = attacker;
@@ -3640,7 +3647,7 @@ void battlefield_t::compute_next_unit_to_move() {
 		//check for mismorale
 		int morale_chance = get_unit_morale_chance(*active_unit);
 		if(morale_chance < 0 && can_troop_act(*active_unit) && !active_unit->has_waited) { //can't mismorale on the wait turn
-			if(utils::rand_chance(std::abs(morale_chance))) {
+			if(utils::rand_chance(std::abs(morale_chance), rng)) {
 				//we mismoraled, emit the action and move on to the next unit
 				auto& active_unit_stats = (active_unit->is_attacker ? attacker_stats : defender_stats);
 				total_stats.total_negative_morale_procs++;
@@ -3894,7 +3901,7 @@ bool battlefield_t::move_unit(battlefield_unit_t& unit, int x, int y, bool final
 	//'finalize_action' should only be set when the unit is moving to another hex, not moving+attacking
 	if(finalize_action) {
 		//we can potentially morale here
-		bool morale = utils::rand_chance(get_unit_morale_chance(unit)) && can_troop_morale(unit);
+		bool morale = utils::rand_chance(get_unit_morale_chance(unit), rng) && can_troop_morale(unit);
 		if(morale) {
 			unit.has_moraled = true;
 			unit.has_moved = false;
@@ -4317,7 +4324,7 @@ void battlefield_t::handle_post_attack_effects(battlefield_unit_t& attacker, bat
 			int remaining_units = defender.original_stack_size % units_per_rebirth;
 			int remaining_chance = (remaining_units * reincarnation_chance);
 
-			int total_reincarnated = base_count + (utils::rand_chance(remaining_chance) ? 1 : 0);
+			int total_reincarnated = base_count + (utils::rand_chance(remaining_chance, rng) ? 1 : 0);
 
 			if(total_reincarnated > 0) {
 				defender.stack_size = total_reincarnated;
@@ -4348,21 +4355,21 @@ void battlefield_t::handle_post_attack_effects(battlefield_unit_t& attacker, bat
 
 	buff_e applied_buff = BUFF_NONE;
 
-	if(attacker.has_buff(BUFF_SEDUCE_ON_ATTACK) && utils::rand_chance(30)) {
+	if(attacker.has_buff(BUFF_SEDUCE_ON_ATTACK) && utils::rand_chance(30, rng)) {
 		if(!defender.has_buff(BUFF_UNDEAD) && !defender.has_buff(BUFF_MIND_SPELL_IMMUNITY) && !defender.has_buff(BUFF_ANIMATED)) {
 			defender.add_buff(BUFF_SEDUCED, 3);
 			applied_buff = BUFF_SEDUCED;
 		}
 	}
 	
-	if(attacker.has_buff(BUFF_BLIND_ON_ATTACK) && utils::rand_chance(20)) {
+	if(attacker.has_buff(BUFF_BLIND_ON_ATTACK) && utils::rand_chance(20, rng)) {
 		if(!defender.has_buff(BUFF_UNDEAD) && !defender.has_buff(BUFF_MIND_SPELL_IMMUNITY) && !defender.has_buff(BUFF_ANIMATED)) {
 			defender.add_buff(BUFF_BLINDED, 3);
 			applied_buff = BUFF_BLINDED;
 		}
 	}
 
-	if(attacker.has_buff(BUFF_POISON_ON_ATTACK) && utils::rand_chance(40)) {
+	if(attacker.has_buff(BUFF_POISON_ON_ATTACK) && utils::rand_chance(40, rng)) {
 		if(!defender.has_buff(BUFF_UNDEAD) && !defender.has_buff(BUFF_ANIMATED)) { //&& !defender.has_buff(BUFF_POISON_IMMUNITY)) {
 			uint8_t magnitude = attacker.stack_size > 255 ? 255 : (int8_t)attacker.stack_size;
 			defender.add_buff(BUFF_POISONED, 3, magnitude);
@@ -4426,30 +4433,30 @@ int battlefield_t::is_hit_lucky(battlefield_unit_t& unit) {
 
 	if(luck < 0) {
 		if(luck == -1)
-			return (utils::rand_chance(8) ? -1 : 0);
+			return (utils::rand_chance(8, rng) ? -1 : 0);
 		else if(luck == -2)
-			return (utils::rand_chance(16) ? -1 : 0);
+			return (utils::rand_chance(16, rng) ? -1 : 0);
 		else //luck <= -3
-			return (utils::rand_chance(24) ? -1 : 0);
+			return (utils::rand_chance(24, rng) ? -1 : 0);
 	}
 
 	//positive luck
 	if(luck == 1)
-		return (utils::rand_chance(5) ? 1 : 0);
+		return (utils::rand_chance(5, rng) ? 1 : 0);
 	else if(luck == 2)
-		return (utils::rand_chance(10) ? 1 : 0);
+		return (utils::rand_chance(10, rng) ? 1 : 0);
 	else if(luck == 3)
-		return (utils::rand_chance(15) ? 1 : 0);
+		return (utils::rand_chance(15, rng) ? 1 : 0);
 
 	//if we get here, luck > 3, and we need to check if the unit's hero
 	//has luck or not to see if they can benefit from additional luck
 	auto& army_of_unit = unit.is_attacker ? attacking_army : defending_army;
 	if(!army_of_unit.hero || !army_of_unit.hero->get_secondary_skill_level(SKILL_LUCK)) //no benefit
-		return (utils::rand_chance(15) ? 1 : 0);
+		return (utils::rand_chance(15, rng) ? 1 : 0);
 
 	//we do benefit from luck > +3
 	auto chance = 15 + 5 * (pow(luck - 3, .6));
-	return (utils::rand_chance(chance) ? 1 : 0);
+	return (utils::rand_chance(chance, rng) ? 1 : 0);
 }
 
 uint32_t battlefield_t::apply_luck_damage_modifier(const battlefield_unit_t& unit, uint32_t base_damage, int luck_effect) {
@@ -4566,7 +4573,7 @@ bool battlefield_t::attack_unit(battlefield_unit_t& attacker, battlefield_unit_t
 		}
 
 		//we can potentially morale here
-		bool morale = utils::rand_chance(get_unit_morale_chance(attacker)) && can_troop_morale(attacker);
+		bool morale = utils::rand_chance(get_unit_morale_chance(attacker), rng) && can_troop_morale(attacker);
 		if(morale) {
 			total_stats.total_positive_morale_procs++;
 			attacking_unit_stats.total_positive_morale_procs++;
@@ -4715,7 +4722,7 @@ bool battlefield_t::attack_unit(battlefield_unit_t& attacker, battlefield_unit_t
 		retaliation_count = 1;
 
 	//check for additional retaliation via Vengeance proc
-	if(retaliation_count && utils::rand_chance(30) && attacker.stack_size > 0 && army_of_defender.is_affected_by_talent(TALENT_VENGEANCE))
+	if(retaliation_count && utils::rand_chance(30, rng) && attacker.stack_size > 0 && army_of_defender.is_affected_by_talent(TALENT_VENGEANCE))
 		retaliation_count = 2;
 
 	for(int retaliation_number = 0; retaliation_number < retaliation_count; retaliation_number++) {
@@ -4788,7 +4795,7 @@ bool battlefield_t::attack_unit(battlefield_unit_t& attacker, battlefield_unit_t
 		additional_attack_count++;
 	if((ranged_attack && attacker.has_buff(BUFF_SHOOTS_TWICE)))
 		additional_attack_count++;
-	if(ranged_attack && army_of_attacker.is_affected_by_talent(TALENT_QUICKDRAW) && utils::rand_chance(20)) { //quickdraw proc
+	if(ranged_attack && army_of_attacker.is_affected_by_talent(TALENT_QUICKDRAW) && utils::rand_chance(20, rng)) { //quickdraw proc
 		additional_attack_count++;
 		quickdraw_proc = true;
 	}
@@ -4802,7 +4809,7 @@ bool battlefield_t::attack_unit(battlefield_unit_t& attacker, battlefield_unit_t
 	if(ranged_attack && attacker.unit_type == UNIT_ORC && army_of_attacker.is_affected_by_specialty(SPECIALTY_ORCS)) {
 		const auto& sp = game_config::get_specialty(SPECIALTY_ORCS);
 		int proc_chance = sp.multiplier.get_value(army_of_attacker.hero ? army_of_attacker.hero->level : 0);
-		if(utils::rand_chance(proc_chance))
+		if(utils::rand_chance(proc_chance, rng))
 			additional_attack_count++;
 	}
 
@@ -4851,7 +4858,7 @@ bool battlefield_t::attack_unit(battlefield_unit_t& attacker, battlefield_unit_t
 	}
 	
 	//we can potentially morale here
-	bool morale = utils::rand_chance(get_unit_morale_chance(attacker)) && can_troop_morale(attacker);
+	bool morale = utils::rand_chance(get_unit_morale_chance(attacker), rng) && can_troop_morale(attacker);
 	if(morale) {
 		total_stats.total_positive_morale_procs++;
 		attacking_unit_stats.total_positive_morale_procs++;
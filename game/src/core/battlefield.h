@@ -6,6 +6,8 @@
 #include "core/hero.h"
 #include "core/adventure_map.h"
 
+#include <optional>
+#include <random>
 #include <unordered_set>
 
 enum battle_action_e {
@@ -445,6 +447,10 @@ struct battlefield_t {
 	bool is_creature_bank_battle = false;
 	std::vector<artifact_e> captured_artifacts;
 
+	//dice for this battle only, so concurrent battles on separate battlefields don't share std::rand
+	std::mt19937_64 rng;
+	std::optional<uint64_t> rng_seed; //fixed seed for every battle on this battlefield, unset draws from std::rand()
+
 	//siege vars
 	int gate_hp = 2;
 	int main_turret_hp = 5;
@@ -518,6 +524,7 @@ struct battlefield_t {
 	void init_hero_town_battle(hero_t* attacker, town_t* defender, bool is_deathmatch_battle = false);
 	void init_hero_monster_battle(hero_t* attacker, map_monster_t* defender);
 	void init_hero_creature_bank_battle(hero_t* attacker, army_t& defender, interactable_object_t* object);
+	void seed_rng();
 	void setup_obstacles(bool only_clear = false);
 	void reset_castle_walls();
 	void reset();
@@ -0,0 +1,213 @@
+#include "core/block_compression.h"
+
+#include <QtEndian>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace {
+const int SEGMENT_HEADER_SIZE = 8; //magic, version, 3 reserved bytes
+const int BLOCK_HEADER_SIZE = 12;
+
+constexpr std::array<uint32_t, 256> make_crc32_table() {
+	std::array<uint32_t, 256> table = {};
+	for(uint32_t i = 0; i < 256; i++) {
+		uint32_t crc = i;
+		for(int bit = 0; bit < 8; bit++)
+			crc = (crc & 1) ? (0xEDB88320u ^ (crc >> 1)) : (crc >> 1);
+		table[i] = crc;
+	}
+
+	return table;
+}
+
+constexpr auto CRC32_TABLE = make_crc32_table();
+
+//qCompress() output is never much larger than its input; anything claiming to be is corrupt
+uint32_t get_maximum_compressed_size(uint32_t size) {
+	return size + (size / 8) + 64;
+}
+}
+
+uint32_t block_crc32(const char* data, size_t size, uint32_t crc) {
+	crc = ~crc;
+	for(size_t i = 0; i < size; i++)
+		crc = CRC32_TABLE[(crc ^ (uint8_t)data[i]) & 0xFF] ^ (crc >> 8);
+
+	return ~crc;
+}
+
+bool is_block_compressed(QIODevice* device) {
+	return device && device->peek(sizeof(BLOCK_COMPRESSION_MAGIC)) == QByteArray::fromRawData(BLOCK_COMPRESSION_MAGIC, sizeof(BLOCK_COMPRESSION_MAGIC));
+}
+
+//block_compressor_t
+block_compressor_t::block_compressor_t(QIODevice* target, int level) : target(target), level(level) {
+	block.reserve(BLOCK_COMPRESSION_BLOCK_SIZE);
+	QIODevice::open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+}
+
+block_compressor_t::~block_compressor_t() {
+	if(isOpen())
+		close();
+}
+
+void block_compressor_t::close() {
+	finish();
+	QIODevice::close();
+}
+
+qint64 block_compressor_t::writeData(const char* data, qint64 size) {
+	if(failed || finished)
+		return -1;
+
+	qint64 written = 0;
+	while(written < size) {
+		qint64 chunk = std::min<qint64>(size - written, BLOCK_COMPRESSION_BLOCK_SIZE - block.size());
+		block.append(data + written, chunk);
+		written += chunk;
+		if(block.size() == BLOCK_COMPRESSION_BLOCK_SIZE && !write_block())
+			return -1;
+	}
+
+	return size;
+}
+
+bool block_compressor_t::write_block() {
+	if(!started) {
+		char header[SEGMENT_HEADER_SIZE] = {};
+		memcpy(header, BLOCK_COMPRESSION_MAGIC, sizeof(BLOCK_COMPRESSION_MAGIC));
+		header[4] = (char)BLOCK_COMPRESSION_VERSION;
+		failed = target->write(header, SEGMENT_HEADER_SIZE) != SEGMENT_HEADER_SIZE;
+		started = true;
+	}
+
+	//an empty block is the end of the segment
+	QByteArray compressed;
+	if(!block.isEmpty())
+		compressed = qCompress(block, level);
+
+	uchar header[BLOCK_HEADER_SIZE];
+	qToBigEndian<uint32_t>((uint32_t)block.size(), header);
+	qToBigEndian<uint32_t>((uint32_t)compressed.size(), header + 4);
+	qToBigEndian<uint32_t>(block_crc32(block.constData(), block.size()), header + 8);
+	if(failed || target->write((const char*)header, BLOCK_HEADER_SIZE) != BLOCK_HEADER_SIZE || target->write(compressed) != compressed.size())
+		failed = true;
+
+	block.resize(0);
+	return !failed;
+}
+
+bool block_compressor_t::finish() {
+	if(finished)
+		return !failed;
+
+	if(!block.isEmpty())
+		write_block();
+	write_block();
+	finished = true;
+	return !failed;
+}
+
+//block_decompressor_t
+block_decompressor_t::block_decompressor_t(QIODevice* source) : source(source) {
+	QIODevice::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+qint64 block_decompressor_t::readData(char* data, qint64 size) {
+	qint64 total = 0;
+	while(total < size) {
+		if(block_offset >= block.size()) {
+			if(finished || !read_block())
+				break;
+			continue;
+		}
+
+		qint64 chunk = std::min<qint64>(size - total, block.size() - block_offset);
+		memcpy(data + total, block.constData() + block_offset, chunk);
+		block_offset += chunk;
+		total += chunk;
+	}
+
+	return (total == 0 && finished) ? -1 : total;
+}
+
+bool block_decompressor_t::read_block() {
+	auto fail = [this]() {
+		failed = true;
+		finished = true;
+		block.clear();
+		block_offset = 0;
+		return false;
+	};
+
+	if(!started) {
+		started = true;
+		char header[SEGMENT_HEADER_SIZE];
+		if(!source || source->read(header, SEGMENT_HEADER_SIZE) != SEGMENT_HEADER_SIZE)
+			return fail();
+		if(memcmp(header, BLOCK_COMPRESSION_MAGIC, sizeof(BLOCK_COMPRESSION_MAGIC)) != 0 || (uint8_t)header[4] != BLOCK_COMPRESSION_VERSION)
+			return fail();
+	}
+
+	uchar header[BLOCK_HEADER_SIZE];
+	if(source->read((char*)header, BLOCK_HEADER_SIZE) != BLOCK_HEADER_SIZE)
+		return fail();
+
+	uint32_t size = qFromBigEndian<uint32_t>(header);
+	uint32_t compressed_size = qFromBigEndian<uint32_t>(header + 4);
+	uint32_t crc = qFromBigEndian<uint32_t>(header + 8);
+	if(size == 0) {
+		finished = true;
+		block.clear();
+		block_offset = 0;
+		return false;
+	}
+
+	if(size > BLOCK_COMPRESSION_BLOCK_SIZE || compressed_size > get_maximum_compressed_size(size))
+		return fail();
+
+	QByteArray compressed = source->read(compressed_size);
+	if(compressed.size() != (qsizetype)compressed_size)
+		return fail();
+
+	block = qUncompress(compressed);
+	block_offset = 0;
+	if(block.size() != (qsizetype)size || block_crc32(block.constData(), block.size()) != crc)
+		return fail();
+
+	return true;
+}
+
+bool block_decompressor_t::finish() {
+	while(!finished) {
+		block_offset = block.size();
+		read_block();
+	}
+
+	block.clear();
+	block_offset = 0;
+	return !failed;
+}
+
+QByteArray block_compress(const QByteArray& data, int level) {
+	QByteArray compressed;
+	QBuffer buffer(&compressed);
+	buffer.open(QIODevice::WriteOnly);
+
+	block_compressor_t compressor(&buffer, level);
+	compressor.write(data);
+	compressor.finish();
+	return compressed;
+}
+
+bool block_uncompress(const QByteArray& data, QByteArray& uncompressed) {
+	QBuffer buffer;
+	buffer.setData(data);
+	buffer.open(QIODevice::ReadOnly);
+
+	block_decompressor_t decompressor(&buffer);
+	uncompressed = decompressor.readAll();
+	return decompressor.finish() && buffer.atEnd();
+}
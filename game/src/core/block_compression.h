@@ -0,0 +1,77 @@
+#pragma once
+
+#include "core/qt_headers.h"
+
+#include <cstdint>
+
+//a compressed segment of a stream: the magic and version, then blocks of up to BLOCK_COMPRESSION_BLOCK_SIZE bytes, each
+//{u32 size, u32 compressed size, u32 crc32 of the uncompressed bytes} followed by its qCompress() output, then a block
+//header with size 0. blocks are compressed and checked one at a time, so neither side ever holds more than one block
+//of each, and a segment ends where its end block does so it can sit in the middle of a larger stream (a save's game
+//info and map, then its save points)
+const char BLOCK_COMPRESSION_MAGIC[4] = { 'C', 'O', 'F', 'Z' };
+const uint8_t BLOCK_COMPRESSION_VERSION = 1;
+const int BLOCK_COMPRESSION_BLOCK_SIZE = 256 * 1024;
+const int BLOCK_COMPRESSION_DEFAULT_LEVEL = 1; //zlib's fastest: map and save data compress well enough at any level
+
+uint32_t block_crc32(const char* data, size_t size, uint32_t crc = 0);
+//true if the next bytes of device start a compressed segment; nothing is consumed
+bool is_block_compressed(QIODevice* device);
+
+//write-only device compressing what is written to it into target. finish() (or close()) writes the last block and the
+//end of the segment; target is left open
+struct block_compressor_t : public QIODevice {
+	block_compressor_t(QIODevice* target, int level = BLOCK_COMPRESSION_DEFAULT_LEVEL);
+	~block_compressor_t() override;
+
+	bool isSequential() const override { return true; }
+	void close() override;
+	bool finish();
+	bool has_failed() const { return failed; }
+
+protected:
+	qint64 readData(char*, qint64) override { return -1; }
+	qint64 writeData(const char* data, qint64 size) override;
+
+private:
+	QIODevice* target = nullptr;
+	int level = BLOCK_COMPRESSION_DEFAULT_LEVEL;
+	QByteArray block;
+	bool started = false;
+	bool finished = false;
+	bool failed = false;
+
+	bool write_block();
+};
+
+//read-only device decompressing one segment from source, which is left just past the segment's end. a block whose
+//checksum does not match ends the data early and sets has_failed()
+struct block_decompressor_t : public QIODevice {
+	block_decompressor_t(QIODevice* source);
+
+	bool isSequential() const override { return true; }
+	qint64 bytesAvailable() const override { return (block.size() - block_offset) + QIODevice::bytesAvailable(); }
+	bool atEnd() const override { return finished && block_offset >= block.size() && QIODevice::bytesAvailable() == 0; }
+	bool has_failed() const { return failed; }
+	//reads through to the end of the segment, for readers that stop before its last byte. false if it was not intact
+	bool finish();
+
+protected:
+	qint64 readData(char* data, qint64 size) override;
+	qint64 writeData(const char*, qint64) override { return -1; }
+
+private:
+	QIODevice* source = nullptr;
+	QByteArray block;
+	qsizetype block_offset = 0;
+	bool started = false;
+	bool finished = false;
+	bool failed = false;
+
+	bool read_block();
+};
+
+//whole-buffer helpers for data that is already in memory (save points)
+QByteArray block_compress(const QByteArray& data, int level = BLOCK_COMPRESSION_DEFAULT_LEVEL);
+//false if data is not a whole, intact segment
+bool block_uncompress(const QByteArray& data, QByteArray& uncompressed);
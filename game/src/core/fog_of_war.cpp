@@ -0,0 +1,195 @@
+#include "core/fog_of_war.h"
+#include "core/utils.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <mutex>
+
+#include "core/qt_headers.h"
+
+namespace {
+constexpr int MAX_CACHED_STENCIL_RADIUS = 256;
+
+void build_stencil(visibility_stencil_t& stencil, int radius) {
+	stencil.radius = radius;
+	stencil.half_width.clear();
+	if(radius <= 0)
+		return;
+
+	//the run can only shrink moving away from the centre row, so each row starts from the previous row's width
+	stencil.half_width.assign((2 * radius) - 1, -1);
+	int width = radius;
+	for(int dy = 0; dy < radius; dy++) {
+		while(width >= 0 && !(utils::dist(0, 0, width, dy) < radius))
+			width--;
+
+		stencil.half_width[(radius - 1) + dy] = (int16_t)width;
+		stencil.half_width[(radius - 1) - dy] = (int16_t)width;
+	}
+}
+
+uint64_t range_mask(int first_bit, int last_bit) {
+	uint64_t mask = ~0ull << first_bit;
+	if(last_bit < 63)
+		mask &= ~0ull >> (63 - last_bit);
+
+	return mask;
+}
+}
+
+tile_bitset_t::tile_bitset_t(int size, bool value) {
+	resize(size);
+	fill(value);
+}
+
+tile_bitset_t::tile_bitset_t(const QBitArray& bits) {
+	resize((int)bits.size());
+	for(int i = 0; i < bit_count; i++) {
+		if(bits.testBit(i))
+			setBit(i);
+	}
+}
+
+void tile_bitset_t::resize(int size) {
+	size = std::max(size, 0);
+	words.resize((size + 63) / 64, 0);
+	bit_count = size;
+
+	//like QBitArray, bits past the old size come back cleared
+	if(bit_count & 63)
+		words.back() &= ~0ull >> (64 - (bit_count & 63));
+}
+
+void tile_bitset_t::fill(bool value) {
+	std::fill(words.begin(), words.end(), value ? ~0ull : 0ull);
+	if(value && (bit_count & 63))
+		words.back() &= ~0ull >> (64 - (bit_count & 63));
+}
+
+int tile_bitset_t::count(bool on) const {
+	int set = 0;
+	for(auto word : words)
+		set += std::popcount(word);
+
+	return on ? set : bit_count - set;
+}
+
+QBitArray tile_bitset_t::to_qbitarray() const {
+	QBitArray bits(bit_count, false);
+	for(size_t w = 0; w < words.size(); w++) {
+		for(uint64_t word = words[w]; word; word &= word - 1)
+			bits.setBit((int)(w * 64) + std::countr_zero(word));
+	}
+
+	return bits;
+}
+
+int tile_bitset_t::set_range(int first, int last, std::vector<uint32_t>* newly_set) {
+	int count = 0;
+	for(int w = first >> 6; w <= (last >> 6); w++) {
+		const uint64_t mask = range_mask(w == (first >> 6) ? (first & 63) : 0, w == (last >> 6) ? (last & 63) : 63);
+		uint64_t added = mask & ~words[w];
+		words[w] |= mask;
+		count += std::popcount(added);
+		if(newly_set) {
+			for(; added; added &= added - 1)
+				newly_set->push_back((uint32_t)(w * 64) + std::countr_zero(added));
+		}
+	}
+
+	return count;
+}
+
+void tile_bitset_t::set_range_masked(int first, int last, const tile_bitset_t& mask) {
+	for(int w = first >> 6; w <= (last >> 6); w++)
+		words[w] |= range_mask(w == (first >> 6) ? (first & 63) : 0, w == (last >> 6) ? (last & 63) : 63) & mask.words[w];
+}
+
+QDataStream& operator<<(QDataStream& stream, const tile_bitset_t& bits) {
+	stream << bits.to_qbitarray();
+	return stream;
+}
+
+QDataStream& operator>>(QDataStream& stream, tile_bitset_t& bits) {
+	QBitArray qbits;
+	stream >> qbits;
+	bits = tile_bitset_t(qbits);
+	return stream;
+}
+
+const visibility_stencil_t& get_visibility_stencil(int radius) {
+	static std::array<visibility_stencil_t, MAX_CACHED_STENCIL_RADIUS + 1> stencils;
+	static std::array<std::once_flag, MAX_CACHED_STENCIL_RADIUS + 1> built;
+
+	radius = std::max(radius, 0);
+	if(radius > MAX_CACHED_STENCIL_RADIUS) {
+		static thread_local visibility_stencil_t large;
+		if(large.radius != radius || large.half_width.empty())
+			build_stencil(large, radius);
+
+		return large;
+	}
+
+	std::call_once(built[radius], [radius]() { build_stencil(stencils[radius], radius); });
+	return stencils[radius];
+}
+
+int apply_visibility_stencil(tile_bitset_t& visible, tile_bitset_t* observable, int width, int height, int x, int y,
+							 int reveal_radius, int observe_radius, std::vector<uint32_t>* newly_revealed) {
+	int revealed = 0;
+
+	//a tile is only revealed if it is also observed, so the reveal circle never exceeds the observe circle
+	const auto& reveal_stencil = get_visibility_stencil(std::min(reveal_radius, observe_radius));
+	for(int row = 0; row < (int)reveal_stencil.half_width.size(); row++) {
+		int ypos = y + row - (reveal_stencil.radius - 1);
+		int half_width = reveal_stencil.half_width[row];
+		if(ypos < 0 || ypos >= height || half_width < 0)
+			continue;
+
+		int first = std::max(x - half_width, 0);
+		int last = std::min(x + half_width, width - 1);
+		if(first <= last)
+			revealed += visible.set_range(first + (ypos * width), last + (ypos * width), newly_revealed);
+	}
+
+	if(!observable)
+		return revealed;
+
+	const auto& observe_stencil = get_visibility_stencil(observe_radius);
+	for(int row = 0; row < (int)observe_stencil.half_width.size(); row++) {
+		int ypos = y + row - (observe_stencil.radius - 1);
+		int half_width = observe_stencil.half_width[row];
+		if(ypos < 0 || ypos >= height || half_width < 0)
+			continue;
+
+		int first = std::max(x - half_width, 0);
+		int last = std::min(x + half_width, width - 1);
+		if(first <= last)
+			observable->set_range_masked(first + (ypos * width), last + (ypos * width), visible);
+	}
+
+	return revealed;
+}
+
+void apply_observer_stencil(std::vector<uint16_t>& observers, tile_bitset_t& observable, const tile_bitset_t& visible,
+							int width, int height, int x, int y, int observe_radius, int delta) {
+	const auto& stencil = get_visibility_stencil(observe_radius);
+	for(int row = 0; row < (int)stencil.half_width.size(); row++) {
+		int ypos = y + row - (stencil.radius - 1);
+		int half_width = stencil.half_width[row];
+		if(ypos < 0 || ypos >= height || half_width < 0)
+			continue;
+
+		int first = std::max(x - half_width, 0);
+		int last = std::min(x + half_width, width - 1);
+		for(int tile = first + (ypos * width); tile <= last + (ypos * width); tile++) {
+			auto& count = observers[tile];
+			count = (uint16_t)(count + delta);
+			if(delta > 0 && count == 1 && visible.testBit(tile))
+				observable.setBit(tile);
+			else if(delta < 0 && count == 0)
+				observable.clearBit(tile);
+		}
+	}
+}
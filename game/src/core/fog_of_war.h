@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+class QBitArray;
+class QDataStream;
+
+//flat bit array over map tiles (bit x + y * width) stored in 64-bit words, so runs of tiles can be set a word at a
+//time. keeps the subset of the QBitArray interface the game uses and streams in QBitArray format, so saves are unchanged
+struct tile_bitset_t {
+	tile_bitset_t() = default;
+	tile_bitset_t(int size, bool value = false);
+	explicit tile_bitset_t(const QBitArray& bits);
+
+	int size() const { return bit_count; }
+	void resize(int size);
+	void fill(bool value);
+	int count(bool on) const;
+	bool testBit(int index) const { assert(index >= 0 && index < bit_count); return (words[index >> 6] >> (index & 63)) & 1; }
+	void setBit(int index) { words[index >> 6] |= (1ull << (index & 63)); }
+	void setBit(int index, bool value) { if(value) setBit(index); else clearBit(index); }
+	void clearBit(int index) { words[index >> 6] &= ~(1ull << (index & 63)); }
+	QBitArray to_qbitarray() const;
+
+	//sets bits [first, last]; the bits that were clear before are appended to newly_set (if given) and counted
+	int set_range(int first, int last, std::vector<uint32_t>* newly_set = nullptr);
+	//sets the bits of [first, last] that are also set in mask
+	void set_range_masked(int first, int last, const tile_bitset_t& mask);
+
+	std::vector<uint64_t> words;
+	int bit_count = 0;
+};
+
+QDataStream& operator<<(QDataStream& stream, const tile_bitset_t& bits);
+QDataStream& operator>>(QDataStream& stream, tile_bitset_t& bits);
+
+//the tiles within radius of a point, as one run per row: a tile is included when utils::dist(0, 0, dx, dy) < radius,
+//which is the test the visibility loops used
+struct visibility_stencil_t {
+	int radius = 0;
+	std::vector<int16_t> half_width; //for dy = -(radius - 1) .. radius - 1, -1 if the row is empty
+};
+
+//precomputed for every radius a map can use; larger radii are built on demand
+const visibility_stencil_t& get_visibility_stencil(int radius);
+
+//anything that reveals fog around itself for a player: an allied hero, town, mine, flagged building or watchtower
+struct visibility_source_t {
+	uint32_t key = 0; //index into map.objects, or HERO_KEY | hero id
+	int16_t x = 0;
+	int16_t y = 0;
+	int16_t reveal_radius = 0;
+	int16_t observe_radius = 0;
+
+	static constexpr uint32_t HERO_KEY = 0x80000000u;
+	bool operator==(const visibility_source_t& other) const = default;
+};
+
+//per-player bookkeeping for incremental game_t::update_visibility. not saved: a loaded player starts invalid and
+//the first update applies every source. anything that edits the player's fog outside update_visibility clears valid
+struct visibility_state_t {
+	std::vector<visibility_source_t> sources; //what the last update applied, sorted by key
+	std::vector<uint16_t> observers; //per tile, how many of sources observe it
+	bool valid = false;
+	std::vector<uint32_t> newly_revealed; //tile offsets revealed since the last game_t::take_newly_revealed_tiles
+};
+
+//ORs the reveal stencil into visible and marks the visible tiles of the observe stencil in observable (null skips
+//observation). returns how many tiles were newly revealed
+int apply_visibility_stencil(tile_bitset_t& visible, tile_bitset_t* observable, int width, int height, int x, int y,
+							 int reveal_radius, int observe_radius, std::vector<uint32_t>* newly_revealed);
+//adds (delta 1) or removes (delta -1) one observer on every tile of the observe stencil around (x, y), setting or
+//clearing observable where a tile gains its first observer or loses its last. only visible tiles are observed
+void apply_observer_stencil(std::vector<uint16_t>& observers, tile_bitset_t& observable, const tile_bitset_t& visible,
+							int width, int height, int x, int y, int observe_radius, int delta);
@@ -1,4 +1,5 @@
 #include "core/game.h"
+#include "core/block_compression.h"
 #include "core/map_file.h"
 #include "core/adventure_map.h"
 #include "core/utils.h"
@@ -30,6 +31,7 @@ QDataStream& operator>>(QDataStream& stream, player_t& player) {
 	stream >> player.resources;
 	stream >> player.tile_visibility;
 	stream >> player.tile_observability;
+	player.visibility_state = visibility_state_t();
 	
 	return stream;
 }
@@ -431,42 +433,30 @@ int game_t::reveal_area(player_e player, int x, int y, int reveal_radius, int ob
 	if(!player_valid(player))
 		return 0;
 	
-	auto& tile_visibility = get_player(player).tile_visibility;
-	auto& tile_observability = get_player(player).tile_observability;
+	auto& pl = get_player(player);
+	const int tile_count = map.width * map.height;
+	if(pl.tile_visibility.size() != tile_count || pl.tile_observability.size() != tile_count)
+		return 0;
 	
 	if(observe_radius < reveal_radius)
 		observe_radius = reveal_radius;
 	
-	int revealed_tiles = 0;
-
-	for(int ypos = y - (observe_radius + 1); ypos < y + (observe_radius + 1); ypos++) {
-		for(int xpos = x - (observe_radius + 1); xpos < x + (observe_radius + 1); xpos++) {
-			if(!map.tile_valid(xpos, ypos))
-				continue;
-			
-			bool revealed = utils::dist(x, y, xpos, ypos) < reveal_radius;
-			bool observed = utils::dist(x, y, xpos, ypos) < observe_radius;
-			
-			if(!observed)
-				continue;
-			
-			auto offset = xpos + ypos * map.width;
+	int revealed_tiles = reveal_tiles(player, x, y, reveal_radius);
+	apply_visibility_stencil(pl.tile_visibility, &pl.tile_observability, map.width, map.height, x, y, 0, observe_radius, nullptr);
+	
+	//what this observes belongs to no visibility source, so the next update has to rebuild observability to drop it
+	pl.visibility_state.valid = false;
 
-			if(revealed) {
-				if(!tile_visibility.testBit(offset))
-					revealed_tiles++;
+	return revealed_tiles;
+}
 
-				tile_visibility.setBit(offset, true);
-			}
-			
-			if(tile_visibility.testBit(offset))
-				tile_observability.setBit(offset, true);
-		}
-	}
+int game_t::reveal_tiles(player_e player, int x, int y, int reveal_radius) {
+	auto& pl = get_player(player);
+	int revealed_tiles = apply_visibility_stencil(pl.tile_visibility, nullptr, map.width, map.height, x, y, reveal_radius,
+												  reveal_radius, &pl.visibility_state.newly_revealed);
 
-	update_achievement_stats(get_player(player).player_stats.exploration.fog_tiles_revealed, revealed_tiles, ACHIEVEMENT_REVEALING_THE_UNKNOWN);
+	update_achievement_stats(pl.player_stats.exploration.fog_tiles_revealed, revealed_tiles, ACHIEVEMENT_REVEALING_THE_UNKNOWN);
 
-	auto& pl = get_player(player);
 	if(pl.tile_visibility.count(true) == pl.tile_visibility.size() && pl.tile_visibility.size() > 0) {
 		const auto map_tiles = map.width * map.height;
 		if(map_tiles <= 72 * 72)
@@ -663,89 +653,151 @@ bool game_t::give_resource_to_player(player_e player, resource_e resource_type,
 	return true;
 }
 
-void game_t::update_visibility(player_e player) {
-	if(!player_valid(player))
-		return;
-
-	//auto& pl = get_player(player);
-	auto& tile_visibility = get_player(player).tile_visibility;
-	auto& tile_observability = get_player(player).tile_observability;
-	auto width = map.width;
-	auto height = map.height;
-	
-	//probably move this to load_map function
-	if(tile_visibility.size() != width * height) {
-		tile_visibility.resize(width * height);
-		tile_visibility.fill(false);
-		tile_observability.resize(width * height);
-		tile_observability.fill(false);
-	}
-	
-	tile_observability.fill(false);	
+std::vector<visibility_source_t> game_t::get_visibility_sources(player_e player) const {
+	std::vector<visibility_source_t> sources;
+	auto add_source = [&sources](uint32_t key, int x, int y, int reveal_radius, int observe_radius) {
+		visibility_source_t source;
+		source.key = key;
+		source.x = (int16_t)x;
+		source.y = (int16_t)y;
+		source.reveal_radius = (int16_t)reveal_radius;
+		source.observe_radius = (int16_t)observe_radius;
+		sources.push_back(source);
+	};
 	
-	for(auto obj : map.objects) {
-		if(!obj)
+	//only owned objects reveal anything, so walk the owner buckets of the player's allies
+	std::vector<uint16_t> ids;
+	for(int owner = PLAYER_1; owner < object_index_t::OWNER_COUNT; owner++) {
+		if(!are_players_allied((player_e)owner, player))
 			continue;
 		
+		auto owned = map.get_object_ids_owned_by((player_e)owner);
+		ids.insert(ids.end(), owned.begin(), owned.end());
+	}
+	std::sort(ids.begin(), ids.end());
+	
+	//objects go through reveal_area, which never observes less than it reveals
+	for(auto id : ids) {
+		auto obj = map.objects[id];
 		if(obj->object_type == OBJECT_MAP_TOWN) {
 			town_t* t = (town_t*)obj;
-			
-			if(!are_players_allied(t->player, player))
-				continue;
-			
-			//calculate front-door tile:
-			reveal_area(player, obj->x, obj->y, t->reveal_area, t->observation_area);
+			add_source(id, obj->x, obj->y, t->reveal_area, std::max(t->observation_area, t->reveal_area));
 		}
 		else if(obj->object_type == OBJECT_MINE) {
-			auto mine = (mine_t*)obj;
-			if(!are_players_allied(mine->owner, player))
-				continue;
-			
-			reveal_area(player, obj->x, obj->y, 3, 5);
+			add_source(id, obj->x, obj->y, 3, 5);
 		}
 		else if(obj->object_type == OBJECT_WINDMILL || obj->object_type == OBJECT_WATERWHEEL) { //flaggable objects
-			auto flaggable = (flaggable_object_t*)obj;
-			if(!are_players_allied(flaggable->owner, player))
-				continue;
-			
-			reveal_area(player, obj->x, obj->y, 3, 4);
+			add_source(id, obj->x, obj->y, 3, 4);
 		}
 		else if(obj->object_type == OBJECT_WATCHTOWER) {
 			auto tower = (flaggable_object_t*)obj;
-			if(tower->visited && are_players_allied(tower->owner, player)) {
+			if(tower->visited) {
 				auto date_diff = date - tower->date_visited;
-				reveal_area(player, obj->x, obj->y, 3, std::clamp(20 - date_diff, 3, 20));
+				add_source(id, obj->x, obj->y, 3, std::clamp(20 - date_diff, 3, 20));
 			}
 		}
-	}	
+	}
 	
 	for(auto& h : map.heroes) {
 		if(!are_players_allied(h.second.player, player))
 			continue;
 		
-		int xp = h.second.x;
-		int yp = h.second.y;
-		int rev_rad = h.second.get_scouting_radius() + 1;
-		int obs_rad = h.second.get_observation_radius() + 1;
-		for(int y = yp - obs_rad; y < yp + obs_rad; y++) {
-			for(int x = xp - obs_rad; x < xp + obs_rad; x++) {
-				if(!map.tile_valid(x, y))
-					continue;
-				
-				bool revealed = utils::dist(x, y, xp, yp) < rev_rad;
-				bool observed = utils::dist(x, y, xp, yp) < obs_rad;
-				
-				if(!observed)
-					continue;
-				
-				if(revealed)
-					tile_visibility.setBit(x + y*width, true);
-				
-				if(tile_visibility.testBit(x + y*width))
-					tile_observability.setBit(x + y*width, true);
+		add_source(visibility_source_t::HERO_KEY | (uint32_t)h.first, h.second.x, h.second.y,
+				   h.second.get_scouting_radius() + 1, h.second.get_observation_radius() + 1);
+	}
+	
+	return sources;
+}
+
+void game_t::update_visibility(player_e player) {
+	if(!player_valid(player))
+		return;
+
+	auto& pl = get_player(player);
+	auto& state = pl.visibility_state;
+	auto width = map.width;
+	auto height = map.height;
+	
+	//probably move this to load_map function
+	if(pl.tile_visibility.size() != width * height) {
+		pl.tile_visibility.resize(width * height);
+		pl.tile_visibility.fill(false);
+		pl.tile_observability.resize(width * height);
+		pl.tile_observability.fill(false);
+		state.valid = false;
+	}
+	
+	auto sources = get_visibility_sources(player);
+	const size_t tile_count = (size_t)width * height;
+	
+	//anything that changed the fog behind our back (loading, reveal_area) means nothing from the last update can be trusted
+	std::vector<const visibility_source_t*> removed;
+	std::vector<bool> added(sources.size(), true);
+	if(!state.valid || state.observers.size() != tile_count) {
+		state.sources.clear();
+		state.observers.assign(tile_count, 0);
+		pl.tile_observability.fill(false);
+	}
+	else {
+		size_t previous = 0;
+		for(size_t i = 0; i < sources.size(); i++) {
+			while(previous < state.sources.size() && state.sources[previous].key < sources[i].key)
+				removed.push_back(&state.sources[previous++]);
+			
+			if(previous < state.sources.size() && state.sources[previous] == sources[i]) {
+				added[i] = false;
+				previous++;
+				continue;
 			}
+			
+			//moved or resized: its old observe circle comes off and the new one goes on
+			if(previous < state.sources.size() && state.sources[previous].key == sources[i].key)
+				removed.push_back(&state.sources[previous++]);
 		}
+		
+		while(previous < state.sources.size())
+			removed.push_back(&state.sources[previous++]);
 	}
+	
+	for(auto source : removed)
+		apply_observer_stencil(state.observers, pl.tile_observability, pl.tile_visibility, width, height, source->x, source->y,
+							   source->observe_radius, -1);
+	
+	//revealing is cumulative, so only new positions reveal; a tile revealed now is observed if anything observes it
+	const size_t first_revealed = state.newly_revealed.size();
+	for(size_t i = 0; i < sources.size(); i++) {
+		const auto& source = sources[i];
+		if(!added[i])
+			continue;
+		
+		const int reveal_radius = std::min(source.reveal_radius, source.observe_radius);
+		if(source.key & visibility_source_t::HERO_KEY)
+			apply_visibility_stencil(pl.tile_visibility, nullptr, width, height, source.x, source.y, reveal_radius, reveal_radius,
+									 &state.newly_revealed);
+		else
+			reveal_tiles(player, source.x, source.y, reveal_radius);
+		
+		apply_observer_stencil(state.observers, pl.tile_observability, pl.tile_visibility, width, height, source.x, source.y,
+							   source.observe_radius, 1);
+	}
+	
+	for(size_t i = first_revealed; i < state.newly_revealed.size(); i++) {
+		auto tile = state.newly_revealed[i];
+		if(state.observers[tile])
+			pl.tile_observability.setBit(tile);
+	}
+	
+	state.sources = std::move(sources);
+	state.valid = true;
+}
+
+std::vector<uint32_t> game_t::take_newly_revealed_tiles(player_e player) {
+	if(!player_valid(player))
+		return {};
+	
+	std::vector<uint32_t> tiles;
+	tiles.swap(get_player(player).visibility_state.newly_revealed);
+	return tiles;
 }
 
 bool game_t::end_turn(player_e player) {
@@ -1175,7 +1227,7 @@ void game_t::accept_battle_results() {
 			for(auto& tr : battle.defending_town->garrison_troops)
 				tr.clear();
 
-			battle.defending_town->player = battle.attacking_hero->player;
+			map.set_object_owner(battle.defending_town, battle.attacking_hero->player);
 			update_achievement_stats(get_player(battle.attacking_hero->player).player_stats.total_towns_captured, 1, ACHIEVEMENT_TOWNSHIP);
 			update_interactable_object_callback_fn(battle.defending_town);
 		}
@@ -1354,7 +1406,7 @@ map_action_e game_t::interact_with_object(hero_t* hero, interactable_object_t* o
 			return MAP_ACTION_BATTLE_INITIATED;
 		}
 		else {
-			town->player = hero->player;
+			map.set_object_owner(town, hero->player);
 			update_achievement_stats(get_player(hero->player).player_stats.total_towns_captured, 1, ACHIEVEMENT_TOWNSHIP);
 			map.hero_visit_town(hero, town);
 			return MAP_ACTION_OBJECT_UPDATED;
@@ -1365,7 +1417,7 @@ map_action_e game_t::interact_with_object(hero_t* hero, interactable_object_t* o
 	else if(object->object_type == OBJECT_MINE) {
 		auto mine = (mine_t*)object;
 		if(mine->owner != hero->player) { //fixme for allied players
-			mine->owner = hero->player;
+			map.set_object_owner(mine, hero->player);
 			show_dialog_callback_fn(DIALOG_TYPE_MINE, object, hero, 0, 0);
 
 			update_achievement_stats(get_player(hero->player).player_stats.total_mines_flagged, 1, ACHIEVEMENT_MINE_OVER_MATTER);
@@ -1385,7 +1437,7 @@ map_action_e game_t::interact_with_object(hero_t* hero, interactable_object_t* o
 		res.set_value_for_type(resource, quantity);
 		get_player(hero->player).resources += res;
 
-		mill->owner = hero->player;
+		map.set_object_owner(mill, hero->player);
 		mill->visited = 0x80;
 
 		int info_val = (resource << 4) | quantity;
@@ -1423,8 +1475,7 @@ map_action_e game_t::interact_with_object(hero_t* hero, interactable_object_t* o
 			return MAP_ACTION_NONE;
 
 		auto dest = destinations.at(rand() % destinations.size());
-		hero->x = dest->x;
-		hero->y = dest->y;
+		map.place_hero(hero, dest->x, dest->y);
 		update_achievement_stats(get_player(hero->player).player_stats.exploration.portals_used, 1, ACHIEVEMENT_DIMENSIONAL_DRIFT);
 		
 		return MAP_ACTION_HERO_TELEPORTED;
@@ -1452,8 +1503,7 @@ map_action_e game_t::interact_with_object(hero_t* hero, interactable_object_t* o
 			return MAP_ACTION_NONE;
 
 		auto dest = destinations.at(rand() % destinations.size());
-		hero->x = dest->x;
-		hero->y = dest->y;
+		map.place_hero(hero, dest->x, dest->y);
 		
 		return MAP_ACTION_HERO_TELEPORTED;
 	}
@@ -1755,7 +1805,7 @@ map_action_e game_t::make_dialog_choice(hero_t* hero, interactable_object_t* obj
 		auto watchtower = (flaggable_object_t*)object;
 		auto revealed_tiles = reveal_area(hero->player, hero->x, hero->y, 20, 20);
 
-		watchtower->owner = hero->player;
+		map.set_object_owner(watchtower, hero->player);
 		//watchtower->visited 
 		update_achievement_stats(get_player(hero->player).player_stats.exploration.fog_tiles_revealed_watchtower, revealed_tiles, ACHIEVEMENT_THE_NIGHTS_WATCH);
 		if(revealed_tiles > 0)
@@ -2059,8 +2109,7 @@ spell_result_e game_t::cast_adventure_spell(hero_t* caster, spell_e spell_id, co
 		if(existing && existing != caster)
 			return SPELL_RESULT_INVALID_TARGET;
 
-		caster->x = caster->start_of_day_x;
-		caster->y = caster->start_of_day_y;
+		map.place_hero(caster, dest_x, dest_y);
 		caster->mana -= mana_cost;
 
 		auto obj = map.get_interactable_object_for_tile(dest_x, dest_y);
@@ -2096,8 +2145,7 @@ spell_result_e game_t::cast_adventure_spell(hero_t* caster, spell_e spell_id, co
 		if(route.empty())
 			return SPELL_RESULT_INVALID_TARGET;
 		
-		caster->x = target.x;
-		caster->y = target.y;
+		map.place_hero(caster, target.x, target.y);
 		caster->wormhole_casts_today++;
 		caster->mana -= mana_cost;
 
@@ -2790,94 +2838,43 @@ uint game_t::write_game_info(QDataStream& stream, const game_t* game) {
 }
 
 uint game_t::save_game(const std::string& filename) {
-	std::string filepath = filename;
-	QFile file(QString::fromStdString(filepath));
-	
-	//first we check to see if an existing save game with this name exists
-	if(file.exists()) {
-
-		if(!file.open(QIODevice::ReadWrite))
-			return 1;//MAP_COULD_NOT_OPEN_FILE;
-
-
-		QDataStream stream(&file);
-
-		save_game_header_t header;
-		auto result = read_save_game_header_stream(stream, header);
-		if(result != 0)
-			return -2;
+	uint result = 0;
+	save_game_async(filename, [&result](uint save_result) { result = save_result; });
+	wait_for_saves();
+	return result;
+}
 
-		//update the header info
-		header.save_points++;
-		header.total_days = date + 1;
-		header.last_save_time = QDateTime::currentDateTime();
-		
-		//seek back to the start of the file, then write the updated header
-		if(!file.seek(0))
-			return 1;
-		write_save_game_header_stream(stream, header);
+void game_t::save_game_async(const std::string& filename, std::function<void(uint)> completion_fn) {
+	save_worker_t::completion_fn_t worker_completion_fn;
+	if(completion_fn)
+		worker_completion_fn = [completion_fn](const std::string&, uint result) { completion_fn(result); };
 
-		//append the save point info
-		if(!file.seek(file.size()))
-			return 1;
-		stream << date;
-		stream << (uint16_t)map.heroes.size();
-		for(const auto& hero : map.heroes) {
-			stream << hero.second;
-		}
-		
-		stream << (uint32_t)map.objects.size();
-		for(auto obj : map.objects) {
-			//when we write an existing game, some map objects can be null(removed, e.g.resources)
-			if(!obj) {
-				stream << OBJECT_UNKNOWN;
-				continue;
-			}
+	save_worker->queue(capture_save_snapshot(filename), std::move(worker_completion_fn));
+}
 
-			QBuffer buffer;
-			buffer.open(QIODevice::WriteOnly);
-			QDataStream object_stream(&buffer);
+void game_t::wait_for_saves() {
+	save_worker->wait();
+}
 
-			//write object data to temporary stream
-			object_stream << obj->asset_id << obj->x << obj->y;
-			obj->write_data(object_stream);
+save_game_snapshot_t game_t::capture_save_snapshot(const std::string& filename) const {
+	save_game_snapshot_t snapshot;
+	snapshot.filename = filename;
+	snapshot.map_name = map.name;
+	snapshot.date = date;
+	snapshot.compressed = compress_saves;
+	snapshot.state = capture_save_state(*this);
 
-			//write size followed by the buffer contents to main stream
-			uint16_t total_size = buffer.size();
-			stream << obj->object_type;
-			stream << total_size;
-			stream.writeRawData(buffer.data().constData(), buffer.size());
-		}
-		
-		//write the visibility data
-		stream << (uint8_t)players.size();
-		for(auto& p : players) {
-			stream << p.tile_visibility;
-		}
-		
-		file.close();
-		return 0;
+	//a save that does not exist yet starts with the game info and map. a save queued before it is written finds the
+	//file there and appends its state instead
+	if(!QFile::exists(QString::fromStdString(filename))) {
+		QBuffer buffer(&snapshot.base);
+		buffer.open(QIODevice::WriteOnly);
+		QDataStream stream(&buffer);
+		game_t::write_game_info(stream, this);
+		write_map_file_stream(stream, map);
 	}
-	
-	//if we get here, we need to create a new save game file
-	if(!file.open(QIODevice::WriteOnly))
-		return 1;//MAP_COULD_NOT_OPEN_FILE;
-	
-	QDataStream stream(&file);
-	
-	save_game_header_t header;
-	header.map_name = map.name;
-	header.save_name = "my save";
-	header.started_date = QDateTime::currentDateTime();
-	header.last_save_time = QDateTime::currentDateTime();
-	header.save_points = 0;
-	header.total_days = date + 1;
-	
-	write_save_game_header_stream(stream, header);
-	game_t::write_game_info(stream, this);
-	write_map_file_stream(stream, map);
-	
-	return 0; //SUCCESS
+
+	return snapshot;
 }
 
 uint game_t::load_saved_game_info(QDataStream& stream, save_game_header_t& header, game_t* game_info, std::vector<save_checkpoint_t>& checkpoints) {
@@ -2890,15 +2887,26 @@ uint game_t::load_saved_game_info(QDataStream& stream, save_game_header_t& heade
 	
 	game_t::read_save_game_header_stream(stream, header);
 	
-	read_game_info(stream, game_info);
-	
 	//fixme: this is likely broken
 	map_file_header_t map_file_header;
-	auto err = read_map_file_stream(stream, game_info->map, map_file_header);
+	map_error_e err = SUCCESS;
+	if(is_block_compressed(stream.device())) {
+		block_decompressor_t decompressor(stream.device());
+		QDataStream base_stream(&decompressor);
+		read_game_info(base_stream, game_info);
+		err = read_map_file_stream(base_stream, game_info->map, map_file_header);
+		if(!decompressor.finish())
+			return MAP_COMPRESSED_DATA_INVALID;
+	}
+	else {
+		read_game_info(stream, game_info);
+		err = read_map_file_stream(stream, game_info->map, map_file_header);
+	}
 	if(err != SUCCESS)
 		return err;
 	
-	//we create an initial save-point which contains the initial game data
+	//we create an initial save-point which contains the initial game data. removed objects keep their slot, as they do
+	//in the save points after it
 	save_checkpoint_t checkpoint;
 	//checkpoint.heroes.resize(game_info->map.heroes.size())
 	for(auto& h : game_info->map.heroes)
@@ -2907,8 +2915,10 @@ uint game_t::load_saved_game_info(QDataStream& stream, save_game_header_t& heade
 	checkpoint.date = game_info->date;
 	checkpoint.objects.reserve(game_info->map.objects.size());
 	for(auto obj : game_info->map.objects) {
-		if(!obj)
+		if(!obj) {
+			checkpoint.objects.push_back(nullptr);
 			continue;
+		}
 		
 		auto new_obj = interactable_object_t::make_new_object(obj->object_type);
 		interactable_object_t::copy_interactable_object(new_obj, obj);
@@ -2922,80 +2932,20 @@ uint game_t::load_saved_game_info(QDataStream& stream, save_game_header_t& heade
 	
 	checkpoints.push_back(checkpoint);
 	
+	//each save point is rebuilt from the one before it, and decoded into a checkpoint of its own
+	save_state_t state;
 	for(uint i = 0; i < header.save_points; i++) {
-		save_checkpoint_t chkpt;
-		
-		uint16_t day;
-		stream >> day;
-		chkpt.date = day;
-		//read heroes
-		uint16_t hero_count = 0;
-		stream >> hero_count;
-		if(hero_count > MAXIMUM_HERO_COUNT)
-			return MAP_TOO_MANY_HEROES;
-		
-		for(int n = 0; n < hero_count; n++) {
-			hero_t hero;
-			stream >> hero;
-			chkpt.heroes.push_back(hero);
-		}
-		
-		//read interactable objects
-		uint32_t object_count;
-		stream >> object_count;
-		if(object_count > MAXIMUM_OBJECTS_COUNT)
-			return MAP_TOO_MANY_OBJECTS;
-
-		if(object_count != game_info->map.objects.size())
-			return 3;
-		
-		chkpt.objects.resize(object_count);
-		for(uint32_t n = 0; n < object_count; n++) {
-			interactable_object_e type;
-			stream >> type;
-			if(type == OBJECT_UNKNOWN) {
-				chkpt.objects[n] = nullptr;
-				continue;
-			}
-
-			auto obj = interactable_object_t::make_new_object(type);
-
-			uint16_t object_size = 0;
-			stream >> object_size;
-
-			//read object data into a temporary buffer first
-			QByteArray buffer_data;
-			buffer_data.resize(object_size);
-			stream.readRawData(buffer_data.data(), object_size);
-
-			QBuffer buffer(&buffer_data);
-			buffer.open(QIODevice::ReadOnly);
-			QDataStream object_stream(&buffer);
-
-			if(!obj) { //we don't understand this object type, skip past it
-				chkpt.objects[n] = nullptr;
-				continue;
-			}
-
-			//read the base class members from the buffer
-			object_stream >> obj->asset_id >> obj->x >> obj->y;
-
-			//read the derived class data
-			obj->read_data(object_stream);
+		err = read_save_point(stream, state);
+		if(err != SUCCESS)
+			return err;
 
-			chkpt.objects[n] = obj;
-		}
-		
-		//read the visibility data
-		uint8_t players_size = 0;
-		stream >> players_size;
-		assert(players_size == game_info->players.size());
-		chkpt.visibility_map.resize(players_size);
-		for(auto& p : chkpt.visibility_map) {
-			stream >> p;
-		}
+		if(state.objects.size() != game_info->map.objects.size())
+			return 3;
 		
-		checkpoints.push_back(chkpt);
+		checkpoints.emplace_back();
+		err = make_save_checkpoint(state, checkpoints.back());
+		if(err != SUCCESS)
+			return err;
 	}
 	
 	return 0; //SUCCESS
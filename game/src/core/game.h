@@ -8,12 +8,16 @@
 #include "core/battlefield.h"
 #include "core/qt_headers.h"
 #include "core/achievements.h"
+#include "core/fog_of_war.h"
+#include "core/ai_value_field.h"
+#include "core/save_worker.h"
 
 #include <string>
 #include <array>
 #include <thread>
 #include <random>
 #include <functional>
+#include <memory>
 
 enum hero_class_e : uint16_t;
 enum player_color_e : uint8_t;
@@ -71,7 +75,7 @@ struct save_checkpoint_t {
 	uint16_t date = 0;
 	std::vector<interactable_object_t*> objects;
 	std::vector<hero_t> heroes;
-	std::vector<QBitArray> visibility_map;
+	std::vector<tile_bitset_t> visibility_map;
 	//QBitArray observability_map;
 	//movement plans for heroes
 	
@@ -204,8 +208,9 @@ struct player_t {
 	std::bitset<16> keys_found = 0;
 	resource_group_t resources;
 	game_stats_t player_stats;
-	QBitArray tile_visibility;
-	QBitArray tile_observability;
+	tile_bitset_t tile_visibility;
+	tile_bitset_t tile_observability;
+	visibility_state_t visibility_state;
 };
 
 QDataStream& operator<<(QDataStream& stream, const player_t& player);
@@ -372,7 +377,16 @@ struct game_t {
 	lua_State* _lua_state = nullptr;
 
 	std::map<player_e, std::vector<replay_action_t>> last_turn_actions;
+	//where each AI player's valuable objects are, patched at the start of every planning round
+	std::map<player_e, ai_value_field_t> ai_value_fields;
+	//writes this game's saves off the game thread. shared by copies of the game, so that saves to one file stay in order
+	std::shared_ptr<save_worker_t> save_worker = std::make_shared<save_worker_t>();
+	//block-compress the game info, map and save points of saves (see block_compression.h); saves load either way
+	bool compress_saves = false;
 	std::vector<std::pair<hero_t*, uint64_t>> hero_unallocated_xp;
+	//worker threads used to plan AI heroes' goals, 0 for std::thread::hardware_concurrency(). turns play out the same
+	//for any value
+	uint ai_planning_thread_count = 0;
 
 
 	int get_day() { return (date % 7) + 1; }
@@ -445,9 +459,23 @@ struct game_t {
 	bool is_tile_observable(int x, int y, player_e player) const;
 	bool is_tile_visible_and_observable(int x, int y, player_e player) const;
 	void update_visibility();
+	//incremental: only sources that appeared, moved, changed radius or changed owner since the last update are
+	//applied. observability is kept as per-tile observer counts, so a source that moves or goes away only takes its
+	//old observe circle off; everything is rebuilt once the fog was edited elsewhere (reveal_area, loading)
 	void update_visibility(player_e player);
+	std::vector<visibility_source_t> get_visibility_sources(player_e player) const;
 	int reveal_area(player_e player, int x, int y, int reveal_radius, int observe_radius);
+	//reveal_area without observing, for visibility sources whose observation update_visibility counts itself
+	int reveal_tiles(player_e player, int x, int y, int reveal_radius);
+	//tile offsets (x + y * width) revealed for the player since the last call, for the UI and network layers
+	std::vector<uint32_t> take_newly_revealed_tiles(player_e player);
+	//blocks until the save is written, returns 0 on success
 	uint save_game(const std::string& filename);
+	//captures the game on the calling thread and writes it on the save worker's. completion_fn, if given, is called on
+	//that thread with what save_game() would have returned, and must not wait for saves itself
+	void save_game_async(const std::string& filename, std::function<void(uint)> completion_fn = nullptr);
+	void wait_for_saves();
+	save_game_snapshot_t capture_save_snapshot(const std::string& filename) const;
 	static uint read_save_game_header_stream(QDataStream& stream, save_game_header_t& header);
 	static uint write_save_game_header_stream(QDataStream& stream, const save_game_header_t& header);
 	static uint load_saved_game_info(QDataStream& stream, save_game_header_t& header, game_t* game_info, std::vector<save_checkpoint_t>& checkpoints);
@@ -1029,6 +1029,7 @@ const object_info_t& game_config::get_object_info(interactable_object_t* object)
 	return get_object_info(object->object_type, object->asset_id);
 }
 
+//draws from rand(), so map setup seeded with srand() keeps picking the same names
 const std::string game_config::get_random_town_name(town_type_e town_type) {
 	std::vector<std::string> names;
 	for(auto& tn : town_names) {
@@ -1036,12 +1037,26 @@ const std::string game_config::get_random_town_name(town_type_e town_type) {
 			names.push_back(tn.second);
 	}
 	
+	if(!names.size())
+		return "FIXME RANDOM";
+	
+	return names[rand() % names.size()];
+}
+
+const std::string game_config::get_random_town_name(town_type_e town_type, std::mt19937_64& rng) {
+	std::vector<std::string> names;
+	for(auto& tn : town_names) {
+		if(tn.first == town_type)
+			names.push_back(tn.second);
+	}
+	
 	if(!names.size())
 		return "FIXME RANDOM";
 	//assert(names.size());
 	
 	
-	return names[rand() % names.size()];
+	std::uniform_int_distribution<size_t> dist(0, names.size() - 1);
+	return names[dist(rng)];
 }
 
 float game_config::get_attack_bonus_multiplier() {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <random>
 #include <string>
 #include <vector>
 
@@ -110,6 +111,7 @@ public:
 	static const spell_t& get_spell(spell_e spell_id);
 	static const achievement_t& get_achievement(achievement_e id);
 	static const std::string get_random_town_name(town_type_e town_type);
+	static const std::string get_random_town_name(town_type_e town_type, std::mt19937_64& rng);
 	static const buff_info_t& get_buff_info(buff_e buff_id);
 	
 	static const std::vector<hero_t>& get_heroes() { return heroes; }
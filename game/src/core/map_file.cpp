@@ -1,8 +1,14 @@
 #include "core/map_file.h"
+#include "core/block_compression.h"
+#include "core/map_file_v2.h"
 
 #include "core/qt_headers.h"
 #include "core/utils_enum.h"
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 using utils::get_enum_value;
 using utils::name_from_enum;
 
@@ -37,11 +43,24 @@ map_error_e validate_map_file_header(const map_file_header_t& header) {
 }
 
 map_error_e read_map_file_header_c(const std::string& filename, map_file_header_t& header) {
+	//a compressed map is a compressed map stream, which starts with its header; only the first block is decompressed
+	{
+		QFile file(QString::fromStdString(filename));
+		if(file.open(QIODevice::ReadOnly) && is_block_compressed(&file)) {
+			block_decompressor_t decompressor(&file);
+			QDataStream stream(&decompressor);
+			if(read_map_file_header(stream, header) != SUCCESS || stream.status() != QDataStream::Ok || decompressor.has_failed())
+				return MAP_COULD_NOT_READ_HEADER;
+
+			return validate_map_file_header(header);
+		}
+	}
+
 	FILE* fp = fopen(filename.c_str(), "rb");
 	if(!fp)
 		return MAP_COULD_NOT_OPEN_FILE;
 
-	if(fread(&header, MAP_FILE_HEADER_SIZE, 1, fp) != MAP_FILE_HEADER_SIZE) {
+	if(fread(&header, MAP_FILE_HEADER_SIZE, 1, fp) != 1) {
 		fclose(fp);
 		return MAP_COULD_NOT_READ_HEADER;
 	}
@@ -152,6 +171,16 @@ map_error_e read_map_file(const std::string& filename, adventure_map_t& map) {
 }
 
 map_error_e read_map_file(const std::string& filename, adventure_map_t& map, map_file_header_t& header) {
+	if(is_map_file_v2(filename)) {
+		map_file_view_t view;
+		auto err = view.open(filename);
+		if(err != SUCCESS)
+			return err;
+		
+		header = view.get_header();
+		return view.read_map(map);
+	}
+	
 	QFile file(QString::fromStdString(filename));
 	if(!file.open(QIODevice::ReadOnly))
 		return MAP_COULD_NOT_OPEN_FILE;
@@ -159,12 +188,21 @@ map_error_e read_map_file(const std::string& filename, adventure_map_t& map, map
 	//clear any existing data in the map
 	map.clear();
 	
+	if(is_block_compressed(&file)) {
+		block_decompressor_t decompressor(&file);
+		QDataStream stream(&decompressor);
+		auto err = read_map_file_stream(stream, map, header);
+		if(!decompressor.finish())
+			return MAP_COMPRESSED_DATA_INVALID;
+		return err;
+	}
+	
 	QDataStream stream(&file);
 	
 	return read_map_file_stream(stream, map, header);
 }
 
-map_error_e read_map_file_stream(QDataStream& stream, adventure_map_t& map, map_file_header_t& header) {
+map_error_e read_map_file_stream(QDataStream& stream, adventure_map_t& map, map_file_header_t& header, uint thread_count) {
 	//clear any existing data in the map
 	map.clear();
 	
@@ -178,42 +216,28 @@ map_error_e read_map_file_stream(QDataStream& stream, adventure_map_t& map, map_
 		return err;
 	
 	
-	map.width = header.width;
-	map.height = header.height;
-	map.players = header.players;
-	map.difficulty = header.difficulty;
-	map.win_condition = header.win_condition;
-	map.loss_condition = header.loss_condition;
-	map.map_uuid = header.map_uuid;
-	map.name = header.name;
-	map.description = header.description;
-	//map.minimap = header.minimap;
+	set_map_file_header(map, header);
 	
 	//read player specifications
-	for(auto& pc : map.player_configurations) {
-		stream >> pc.player_number;
-		stream >> pc.color;
-		stream >> pc.team;
-		stream >> pc.allowed_classes;
-		stream >> pc.allowed_player_type;
-	}
+	read_map_player_configurations(stream, map);
 	
 	
-	map.tiles.clear();
-	map.tiles.resize(map.width * map.height);
+	map.tiles.reset(map.width, map.height);
 	
 	//read terrain
 	for(int i = 0; i < map.width * map.height; i++) {
-		stream >> map.tiles[i];
+		map_tile_t tile;
+		stream >> tile;
 		
 		
 		auto e = stream.status();
 		if(e != QDataStream::Ok)
 			return MAP_TILE_DATA_INVALID;
 		
-		if(map.tiles[i].passability > 2)
+		if(tile.passability > 2)
 			return MAP_TILE_DATA_INVALID;
-		//if(map.tiles[i].terrain_type)
+		//if(tile.terrain_type)
+		map.tiles.get_ref(i) = tile;
 	}
 	
 	//read doodads
@@ -233,48 +257,36 @@ map_error_e read_map_file_stream(QDataStream& stream, adventure_map_t& map, map_
 			return MAP_DOODAD_DATA_INVALID;
 	}
 	
-	//read interactable objects
+	//read interactable objects. the records are length-prefixed, so they are gathered first and decoded together
 	uint32_t object_count;
 	stream >> object_count;
 	if(object_count > MAXIMUM_OBJECTS_COUNT)
 		return MAP_TOO_MANY_OBJECTS;
 
-	map.objects.resize(object_count);
+	QByteArray object_data;
+	std::vector<map_file_record_t> object_records(object_count);
+	std::vector<uint32_t> object_offsets(object_count, 0);
 	for(uint32_t i = 0; i < object_count; i++) {
 		interactable_object_e type;
 		stream >> type;
-		if(type == OBJECT_UNKNOWN) {
-			map.objects[i] = nullptr;
+		object_records[i].type = type;
+		if(type == OBJECT_UNKNOWN)
 			continue;
-		}
-
-		auto obj = interactable_object_t::make_new_object(type);
 
 		uint16_t object_size = 0;
 		stream >> object_size;
 
-		//read object data into a temporary buffer first
-		QByteArray buffer_data;
-		buffer_data.resize(object_size);
-		stream.readRawData(buffer_data.data(), object_size);
-
-		QBuffer buffer(&buffer_data);
-		buffer.open(QIODevice::ReadOnly);
-		QDataStream object_stream(&buffer);
-
-		if(!obj) { //we don't understand this object type, skip past it
-			map.objects[i] = nullptr;
-			continue;
-		}
-
-		//read the base class members from the buffer
-		object_stream >> obj->asset_id >> obj->x >> obj->y;
+		object_offsets[i] = object_data.size();
+		object_records[i].size = object_size;
+		object_data.resize(object_data.size() + object_size);
+		stream.readRawData(object_data.data() + object_offsets[i], object_size);
+	}
 
-		//read the derived class data
-		obj->read_data(object_stream);
+	for(uint32_t i = 0; i < object_count; i++)
+		object_records[i].data = object_data.constData() + object_offsets[i];
 
-		map.objects[i] = obj;
-	}
+	//objects we don't understand are skipped past. records are not checked for overruns here, v1 files never were
+	decode_map_object_records(object_records, map.objects, thread_count);
 	
 	//read heroes
 	uint16_t hero_count = 0;
@@ -286,35 +298,30 @@ map_error_e read_map_file_stream(QDataStream& stream, adventure_map_t& map, map_
 	uint16_t magic1;
 	stream >> magic1;
 	
+	QByteArray hero_data;
+	std::vector<map_file_record_t> hero_records(hero_count);
+	std::vector<uint32_t> hero_offsets(hero_count, 0);
 	for(int i = 0; i < hero_count; i++) {
 		uint16_t hero_size;
 		stream >> hero_size;
 
-		//read hero data into a temporary buffer
-		QByteArray buffer_data;
-		buffer_data.resize(hero_size);
-		stream.readRawData(buffer_data.data(), hero_size);
+		hero_offsets[i] = hero_data.size();
+		hero_records[i].size = hero_size;
+		hero_data.resize(hero_data.size() + hero_size);
+		stream.readRawData(hero_data.data() + hero_offsets[i], hero_size);
+	}
 
-		QBuffer buffer(&buffer_data);
-		buffer.open(QIODevice::ReadOnly);
-		QDataStream hero_stream(&buffer);
-
-		hero_t hero;
-		hero_stream >> hero;
-		if(map.heroes.count(hero.id) != 0)
-			return MAP_DUPLICATE_HERO_ID;
-		
-		map.heroes[hero.id] = hero;
-
-		int player = hero.player;
-		player--;
-		if(player >= 0 && player < std::ssize(map.player_configurations)) {
-			if(map.player_configurations[player].starting_hero_id == -1) {
-				map.player_configurations[player].starting_hero_id = hero.id;
-				map.player_configurations[player].is_hero_set_by_map = true;
-			}
-		}
+	for(int i = 0; i < hero_count; i++)
+		hero_records[i].data = hero_data.constData() + hero_offsets[i];
 
+	//as with objects, hero records were never checked for overruns. heroes are added in file order, so the first
+	//duplicate id is still the one reported
+	std::vector<hero_t> heroes;
+	decode_map_hero_records(hero_records, heroes, thread_count);
+	for(const auto& hero : heroes) {
+		err = add_map_file_hero(map, hero);
+		if(err != SUCCESS)
+			return err;
 	}	
 	
 	//read magic
@@ -324,23 +331,150 @@ map_error_e read_map_file_stream(QDataStream& stream, adventure_map_t& map, map_
 	return SUCCESS;
 }
 
-map_error_e write_map_file(const std::string& filename, const adventure_map_t& map) {
+namespace {
+//records per thread below which starting another thread costs more than it saves
+const size_t MINIMUM_RECORDS_PER_THREAD = 64;
+
+template<typename decode_fn_t> map_error_e decode_map_records(size_t count, uint thread_count, decode_fn_t decode) {
+	std::vector<map_error_e> errors(count, SUCCESS);
+
+	if(!thread_count)
+		thread_count = std::max(1u, std::thread::hardware_concurrency());
+	thread_count = (uint)std::min<size_t>(thread_count, std::max<size_t>(1, count / MINIMUM_RECORDS_PER_THREAD));
+
+	if(thread_count == 1) {
+		for(size_t i = 0; i < count; i++)
+			errors[i] = decode(i);
+	}
+	else {
+		std::atomic<size_t> next_record = 0;
+		auto worker = [&]() {
+			for(size_t i = next_record++; i < count; i = next_record++)
+				errors[i] = decode(i);
+		};
+
+		std::vector<std::thread> workers;
+		for(uint i = 0; i < thread_count; i++)
+			workers.emplace_back(worker);
+		for(auto& thread : workers)
+			thread.join();
+	}
+
+	for(auto err : errors) {
+		if(err != SUCCESS)
+			return err;
+	}
+
+	return SUCCESS;
+}
+}
+
+map_error_e decode_map_object_records(const std::vector<map_file_record_t>& records, std::vector<interactable_object_t*>& objects, uint thread_count) {
+	objects.assign(records.size(), nullptr);
+	return decode_map_records(records.size(), thread_count, [&](size_t i) {
+		const auto& record = records[i];
+		if(record.type == OBJECT_UNKNOWN)
+			return SUCCESS;
+
+		return read_map_object_record((interactable_object_e)record.type, record.data, record.size, objects[i]);
+	});
+}
+
+map_error_e decode_map_hero_records(const std::vector<map_file_record_t>& records, std::vector<hero_t>& heroes, uint thread_count) {
+	heroes.assign(records.size(), hero_t());
+	return decode_map_records(records.size(), thread_count, [&](size_t i) {
+		auto bytes = QByteArray::fromRawData(records[i].data, records[i].size);
+		QDataStream hero_stream(bytes);
+		hero_stream >> heroes[i];
+
+		return hero_stream.status() == QDataStream::Ok ? SUCCESS : MAP_HERO_DATA_INVALID;
+	});
+}
+
+map_error_e read_map_object_record(interactable_object_e type, const char* data, int size, interactable_object_t*& object) {
+	object = interactable_object_t::make_new_object(type);
+	if(!object)
+		return SUCCESS;
+
+	auto bytes = QByteArray::fromRawData(data, size);
+	QDataStream object_stream(bytes);
+
+	//read the base class members, then the derived class data
+	object_stream >> object->asset_id >> object->x >> object->y;
+	object->read_data(object_stream);
+
+	return object_stream.status() == QDataStream::Ok ? SUCCESS : MAP_OBJECT_DATA_INVALID;
+}
+
+QByteArray write_map_object_record(const interactable_object_t* object) {
+	QBuffer buffer;
+	buffer.open(QIODevice::WriteOnly);
+	QDataStream object_stream(&buffer);
+
+	object_stream << object->asset_id << object->x << object->y;
+	object->write_data(object_stream);
+
+	return buffer.data();
+}
+
+map_error_e add_map_file_hero(adventure_map_t& map, const hero_t& hero) {
+	if(map.heroes.count(hero.id) != 0)
+		return MAP_DUPLICATE_HERO_ID;
+	
+	map.heroes[hero.id] = hero;
+
+	int player = hero.player;
+	player--;
+	if(player >= 0 && player < std::ssize(map.player_configurations)) {
+		if(map.player_configurations[player].starting_hero_id == -1) {
+			map.player_configurations[player].starting_hero_id = hero.id;
+			map.player_configurations[player].is_hero_set_by_map = true;
+		}
+	}
+
+	return SUCCESS;
+}
+
+map_error_e write_map_file(const std::string& filename, const adventure_map_t& map, bool compressed) {
 	QFile file(QString::fromStdString(filename));
 	if(!file.open(QIODevice::WriteOnly))
 		return MAP_COULD_NOT_OPEN_FILE;
 	
+	if(compressed) {
+		block_compressor_t compressor(&file);
+		QDataStream stream(&compressor);
+		auto err = write_map_file_stream(stream, map);
+		if(!compressor.finish() && err == SUCCESS)
+			err = MAP_COMPRESSED_DATA_INVALID;
+		return err;
+	}
 
 	QDataStream stream(&file);
 	return write_map_file_stream(stream, map);
 }
 
-map_error_e write_map_file_stream(QDataStream& stream, const adventure_map_t& map) {
+void set_map_file_header(adventure_map_t& map, const map_file_header_t& header) {
+	map.width = header.width;
+	map.height = header.height;
+	map.players = header.players;
+	map.difficulty = header.difficulty;
+	map.win_condition = header.win_condition;
+	map.loss_condition = header.loss_condition;
+	map.map_uuid = header.map_uuid;
+	map.name = std::string(header.name, strnlen(header.name, sizeof(header.name)));
+	map.description = std::string(header.description, strnlen(header.description, sizeof(header.description)));
+	//map.minimap = header.minimap;
+}
+
+map_file_header_t get_map_file_header(const adventure_map_t& map, uint8_t version_major) {
 	map_file_header_t header;
 	header.map_uuid = map.map_uuid;
-	header.version_major = 1;
+	header.version_major = version_major;
 	header.version_minor = 0;
 	header.width = map.width;
 	header.height = map.height;
+	memset(header.name, 0, sizeof(header.name));
+	memset(header.description, 0, sizeof(header.description));
 	std::string name = map.name;
 	if(name.length() >= sizeof(header.name) / sizeof(char) - 1)
 		name = name.substr(0, 31);
@@ -357,7 +491,31 @@ map_error_e write_map_file_stream(QDataStream& stream, const adventure_map_t& ma
 	header.difficulty = map.difficulty;
 	header.win_condition = map.win_condition;
 	header.loss_condition = map.loss_condition;
-	
+	return header;
+}
+
+void read_map_player_configurations(QDataStream& stream, adventure_map_t& map) {
+	for(auto& pc : map.player_configurations) {
+		stream >> pc.player_number;
+		stream >> pc.color;
+		stream >> pc.team;
+		stream >> pc.allowed_classes;
+		stream >> pc.allowed_player_type;
+	}
+}
+
+void write_map_player_configurations(QDataStream& stream, const adventure_map_t& map) {
+	for(auto& pc : map.player_configurations) {
+		stream << pc.player_number;
+		stream << pc.color;
+		stream << pc.team;
+		stream << pc.allowed_classes;
+		stream << pc.allowed_player_type;
+	}
+}
+
+map_error_e write_map_file_stream(QDataStream& stream, const adventure_map_t& map) {
+	auto header = get_map_file_header(map, 1);
 	auto err = write_map_file_header(stream, header);
 	if(err != SUCCESS)
 		return MAP_COULD_NOT_WRITE_HEADER;
@@ -368,21 +526,15 @@ map_error_e write_map_file_stream(QDataStream& stream, const adventure_map_t& ma
 		return err;
 	
 	//write player specifications
-	for(auto& pc : map.player_configurations) {
-		stream << pc.player_number;
-		stream << pc.color;
-		stream << pc.team;
-		stream << pc.allowed_classes;
-		stream << pc.allowed_player_type;
-	}
+	write_map_player_configurations(stream, map);
 
 	//todo: move to 'validate_map()' function
-	if(map.tiles.size() != map.width * map.height)
+	if(map.tiles.width != map.width || map.tiles.height != map.height)
 		return MAP_TILE_DATA_INVALID;
 	
 	//write terrain
-	for(auto& tile : map.tiles) {
-		stream << tile;
+	for(size_t i = 0; i < map.tiles.size(); i++) {
+		stream << map.tiles[i];
 		
 		auto e = stream.status();
 		if(e != QDataStream::Ok)
@@ -404,19 +556,12 @@ map_error_e write_map_file_stream(QDataStream& stream, const adventure_map_t& ma
 			continue;
 		}
 
-		QBuffer buffer;
-		buffer.open(QIODevice::WriteOnly);
-		QDataStream object_stream(&buffer);
-
-		//write object data to temporary stream
-		object_stream << obj->asset_id << obj->x << obj->y;
-		obj->write_data(object_stream);
-
-		//write size followed by the buffer contents to main stream
-		uint16_t total_size = buffer.size();
+		//write size followed by the record to main stream
+		auto record = write_map_object_record(obj);
+		uint16_t total_size = record.size();
 		stream << obj->object_type;
 		stream << total_size;
-		stream.writeRawData(buffer.data().constData(), buffer.size());
+		stream.writeRawData(record.constData(), record.size());
 	}
 	
 	//write heroes
@@ -684,7 +829,13 @@ map_error_e read_map_file_json(const std::string& filepath, adventure_map_t& map
 	if(!file.open(QIODevice::ReadOnly))
 		return MAP_COULD_NOT_OPEN_FILE;
 	
-	auto bytes = file.readAll();
+	return read_map_file_json(file.readAll(), map);
+}
+
+map_error_e read_map_file_json(const QByteArray& bytes, adventure_map_t& map) {
+	//clear any existing data in the map
+	map.clear();
+	
 	auto json_document = QJsonDocument::fromJson(bytes);
 	
 	if(!json_document.isObject()) {
@@ -739,6 +890,8 @@ map_error_e read_map_file_json(const std::string& filepath, adventure_map_t& map
 	
 	if(json.contains("tiles") && json["tiles"].isArray()) {
 		QJsonArray tilesArray = json["tiles"].toArray();
+		map.tiles.reset(map.width, map.height);
+		size_t tile_count = 0;
 		for(const auto& tileValue : tilesArray) {
 			if(tileValue.isObject()) {
 				QJsonObject tileObj = tileValue.toObject();
@@ -749,7 +902,8 @@ map_error_e read_map_file_json(const std::string& filepath, adventure_map_t& map
 				tile.passability = tileObj["passability"].toInt();
 				tile.zone_id = tileObj["zone_id"].toInt();
 				tile.interactable_object = tileObj["interactable_object"].toInt();
-				map.tiles.push_back(tile);
+				if(tile_count < map.tiles.size())
+					map.tiles.get_ref(tile_count++) = tile;
 			}
 		}
 	}
@@ -794,6 +948,9 @@ map_error_e read_map_file_json(const std::string& filepath, adventure_map_t& map
 			
 			map.objects.push_back(obj);
 		}
+		
+		//bulk load; let the next guard query rebuild the index once
+		map.monster_guarded_cache_valid = false;
 	}
 	
 	if (json.contains("heroes") && json["heroes"].isArray()) {
@@ -857,7 +1014,8 @@ map_error_e write_map_file_json(const std::string& path, const adventure_map_t&
 	json["player_configurations"] = playerConfigs;
 	
 	QJsonArray tilesArray;
-	for(const auto& tile : map.tiles) {
+	for(size_t i = 0; i < map.tiles.size(); i++) {
+		const auto tile = map.tiles[i];
 		QJsonObject tileJson;
 		tileJson["asset_id"] = tile.asset_id;
 		tileJson["terrain_type"] = name_from_enum(tile.terrain_type);
@@ -71,7 +71,11 @@ enum map_error_e {
     MAP_TOO_MANY_HEROES,
     MAP_TOO_MANY_TOWNS,
 	MAP_DUPLICATE_HERO_ID,
-	MAP_JSON_FORMAT_ERROR
+	MAP_JSON_FORMAT_ERROR,
+	MAP_SECTION_INVALID,
+	MAP_OBJECT_DATA_INVALID,
+	MAP_SAVE_POINT_INVALID,
+	MAP_COMPRESSED_DATA_INVALID
 };
 
 const int file_magic_value = 0xB16A57;
@@ -85,8 +89,33 @@ map_error_e write_map_file_header(QDataStream& stream, const map_file_header_t&
 map_error_e write_map_file_header_c(const std::string& filename, const map_file_header_t& header);
 map_error_e read_map_file(const std::string& filename, adventure_map_t& map);
 map_error_e read_map_file(const std::string& filename, adventure_map_t& map, map_file_header_t& header);
-map_error_e read_map_file_stream(QDataStream& stream, adventure_map_t& map, map_file_header_t& header);
+map_error_e read_map_file_stream(QDataStream& stream, adventure_map_t& map, map_file_header_t& header, uint thread_count = 0);
 map_error_e read_map_file_json(const std::string& filename, adventure_map_t& map);
-map_error_e write_map_file(const std::string& filename, const adventure_map_t& map);
+map_error_e read_map_file_json(const QByteArray& bytes, adventure_map_t& map);
+//compressed files are block_compressor_t segments around the same stream; read_map_file() takes either
+map_error_e write_map_file(const std::string& filename, const adventure_map_t& map, bool compressed = false);
 map_error_e write_map_file_stream(QDataStream& stream, const adventure_map_t& map);
 map_error_e write_map_file_json(const std::string& path, const adventure_map_t& map);
+
+void set_map_file_header(adventure_map_t& map, const map_file_header_t& header);
+map_file_header_t get_map_file_header(const adventure_map_t& map, uint8_t version_major);
+void read_map_player_configurations(QDataStream& stream, adventure_map_t& map);
+void write_map_player_configurations(QDataStream& stream, const adventure_map_t& map);
+//one object record as written by write_map_file_stream (asset id, x, y, then the type's own data). object is null for
+//types this build does not know, which is not an error
+map_error_e read_map_object_record(interactable_object_e type, const char* data, int size, interactable_object_t*& object);
+QByteArray write_map_object_record(const interactable_object_t* object);
+//adds a hero read from a map file, making it its player's starting hero if the map did not set one
+map_error_e add_map_file_hero(adventure_map_t& map, const hero_t& hero);
+
+//an object or hero record located in a map file but not decoded yet
+struct map_file_record_t {
+	uint16_t type = 0; //interactable_object_e for objects, unused for heroes
+	const char* data = nullptr;
+	uint32_t size = 0;
+};
+
+//decode located records across threads (0 for std::thread::hardware_concurrency()) into objects[i] / heroes[i], in
+//record order whatever the thread count. every record is decoded; the error returned is that of the first failing one
+map_error_e decode_map_object_records(const std::vector<map_file_record_t>& records, std::vector<interactable_object_t*>& objects, uint thread_count = 0);
+map_error_e decode_map_hero_records(const std::vector<map_file_record_t>& records, std::vector<hero_t>& heroes, uint thread_count = 0);
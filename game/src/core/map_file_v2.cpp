@@ -0,0 +1,655 @@
+#include "core/map_file_v2.h"
+#include "core/block_compression.h"
+#include "core/utils.h"
+
+#include "core/qt_headers.h"
+#include <QCryptographicHash>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <cstring>
+#include <utility>
+
+static_assert(sizeof(asset_id_t) == 2 && sizeof(terrain_type_e) == 1 && sizeof(road_type_e) == 1, "tile columns are written as they are laid out in memory");
+
+namespace {
+const size_t TILE_BYTES = sizeof(asset_id_t) + sizeof(terrain_type_e) + sizeof(road_type_e) + sizeof(uint8_t) + sizeof(int8_t) + sizeof(uint16_t);
+
+template<typename T> void append_le(QByteArray& bytes, T value) {
+	T le = qToLittleEndian(value);
+	bytes.append((const char*)&le, sizeof(T));
+}
+
+template<typename T> T read_le(const uchar* bytes) {
+	return qFromLittleEndian<T>(bytes);
+}
+
+void pad_to_8(QByteArray& bytes) {
+	while(bytes.size() % 8)
+		bytes.append('\0');
+}
+
+template<typename T> void append_column(QByteArray& bytes, const std::vector<T>& column) {
+	auto offset = bytes.size();
+	bytes.resize(offset + (column.size() * sizeof(T)));
+	if constexpr(sizeof(T) == 1)
+		memcpy(bytes.data() + offset, column.data(), column.size());
+	else
+		qToLittleEndian<T>(column.data(), column.size(), bytes.data() + offset);
+	pad_to_8(bytes);
+}
+
+template<typename T> const uchar* read_column(const uchar* bytes, std::vector<T>& column) {
+	if constexpr(sizeof(T) == 1)
+		memcpy(column.data(), bytes, column.size());
+	else
+		qFromLittleEndian<T>(bytes, column.size(), column.data());
+	return bytes + (((column.size() * sizeof(T)) + 7) & ~(size_t)7);
+}
+
+struct section_bytes_t {
+	map_file_section_e type = MAP_SECTION_PLAYERS;
+	uint32_t item_count = 0;
+	QByteArray bytes;
+};
+
+//record table (type, offset from the section start, size), then the records back to back
+section_bytes_t make_record_section(map_file_section_e type, const std::vector<std::pair<uint16_t, QByteArray>>& records) {
+	section_bytes_t section;
+	section.type = type;
+	section.item_count = (uint32_t)records.size();
+
+	uint32_t offset = (uint32_t)records.size() * MAP_FILE_V2_RECORD_ENTRY_SIZE;
+	for(const auto& [record_type, record] : records) {
+		append_le<uint16_t>(section.bytes, record_type);
+		append_le<uint16_t>(section.bytes, 0);
+		append_le<uint32_t>(section.bytes, offset);
+		append_le<uint32_t>(section.bytes, (uint32_t)record.size());
+		offset += record.size();
+	}
+
+	for(const auto& record : records)
+		section.bytes.append(record.second);
+
+	return section;
+}
+}
+
+map_error_e map_file_view_t::open(const std::string& filename) {
+	close();
+	file.setFileName(QString::fromStdString(filename));
+	if(!file.open(QIODevice::ReadOnly))
+		return MAP_COULD_NOT_OPEN_FILE;
+
+	size = file.size();
+	data = size ? file.map(0, size) : nullptr;
+	if(!data) {
+		close();
+		return MAP_COULD_NOT_OPEN_FILE;
+	}
+
+	return read_section_table();
+}
+
+map_error_e map_file_view_t::open(const uchar* bytes, size_t byte_count) {
+	close();
+	data = bytes;
+	size = byte_count;
+	return read_section_table();
+}
+
+void map_file_view_t::close() {
+	if(file.isOpen()) {
+		if(data)
+			file.unmap((uchar*)data);
+		file.close();
+	}
+
+	data = nullptr;
+	size = 0;
+	sections.clear();
+}
+
+map_error_e map_file_view_t::read_section_table() {
+	auto fail = [&](map_error_e err) {
+		close();
+		return err;
+	};
+
+	if(!data || size < MAP_FILE_V2_HEADER_SIZE || memcmp(data, MAP_FILE_V2_MAGIC, sizeof(MAP_FILE_V2_MAGIC)) != 0)
+		return fail(MAP_COULD_NOT_READ_HEADER);
+
+	uint16_t version_major = read_le<uint16_t>(data + 4);
+	uint16_t version_minor = read_le<uint16_t>(data + 6);
+	if(version_major != 2 || version_minor > 255)
+		return fail(MAP_VERSION_INVALID);
+
+	header.version_major = (uint8_t)version_major;
+	header.version_minor = (uint8_t)version_minor;
+	header.width = read_le<uint16_t>(data + 8);
+	header.height = read_le<uint16_t>(data + 10);
+	header.players = data[12];
+	header.difficulty = data[13];
+	header.win_condition = (win_condition_e)data[14];
+	header.loss_condition = (loss_condition_e)data[15];
+	header.map_uuid = QUuid::fromRfc4122(QByteArray::fromRawData((const char*)data + 16, 16));
+	memcpy(header.name, data + 32, sizeof(header.name));
+	memcpy(header.description, data + 64, sizeof(header.description));
+
+	auto err = validate_map_file_header(header);
+	if(err != SUCCESS)
+		return fail(err);
+
+	uint32_t section_count = read_le<uint32_t>(data + 320);
+	if(section_count > (size - MAP_FILE_V2_HEADER_SIZE) / MAP_FILE_V2_SECTION_ENTRY_SIZE)
+		return fail(MAP_SECTION_INVALID);
+
+	sections.resize(section_count);
+	for(uint32_t i = 0; i < section_count; i++) {
+		const uchar* entry = data + MAP_FILE_V2_HEADER_SIZE + (i * MAP_FILE_V2_SECTION_ENTRY_SIZE);
+		auto& section = sections[i];
+		section.type = (map_file_section_e)read_le<uint32_t>(entry);
+		section.item_count = read_le<uint32_t>(entry + 4);
+		section.offset = read_le<uint64_t>(entry + 8);
+		section.size = read_le<uint64_t>(entry + 16);
+		if(section.offset > size || section.size > size - section.offset)
+			return fail(MAP_SECTION_INVALID);
+	}
+
+	auto objects = find_section(MAP_SECTION_OBJECTS);
+	if(objects && objects->item_count > MAXIMUM_OBJECTS_COUNT)
+		return fail(MAP_TOO_MANY_OBJECTS);
+
+	auto heroes = find_section(MAP_SECTION_HEROES);
+	if(heroes && heroes->item_count > MAXIMUM_HERO_COUNT)
+		return fail(MAP_TOO_MANY_HEROES);
+
+	for(auto section : { objects, heroes }) {
+		if(section && section->size / MAP_FILE_V2_RECORD_ENTRY_SIZE < section->item_count)
+			return fail(MAP_SECTION_INVALID);
+	}
+
+	return SUCCESS;
+}
+
+const map_file_section_t* map_file_view_t::find_section(map_file_section_e type) const {
+	for(const auto& section : sections) {
+		if(section.type == type)
+			return &section;
+	}
+
+	return nullptr;
+}
+
+const uint8_t* map_file_view_t::get_minimap_tiles() const {
+	auto section = find_section(MAP_SECTION_MINIMAP);
+	if(!section || section->size != (uint64_t)header.width * header.height)
+		return nullptr;
+
+	return data + section->offset;
+}
+
+size_t map_file_view_t::get_object_count() const {
+	auto section = find_section(MAP_SECTION_OBJECTS);
+	return section ? section->item_count : 0;
+}
+
+size_t map_file_view_t::get_hero_count() const {
+	auto section = find_section(MAP_SECTION_HEROES);
+	return section ? section->item_count : 0;
+}
+
+map_error_e map_file_view_t::get_record(map_file_section_e type, size_t index, map_file_record_t& record) const {
+	auto section = find_section(type);
+	if(!section || index >= section->item_count)
+		return MAP_SECTION_INVALID;
+
+	const uchar* entry = data + section->offset + (index * MAP_FILE_V2_RECORD_ENTRY_SIZE);
+	record.type = read_le<uint16_t>(entry);
+	uint32_t offset = read_le<uint32_t>(entry + 4);
+	record.size = read_le<uint32_t>(entry + 8);
+	if(offset > section->size || record.size > section->size - offset)
+		return MAP_SECTION_INVALID;
+
+	record.data = (const char*)data + section->offset + offset;
+	return SUCCESS;
+}
+
+map_error_e map_file_view_t::read_object(size_t index, interactable_object_t*& object) const {
+	object = nullptr;
+
+	map_file_record_t record;
+	auto err = get_record(MAP_SECTION_OBJECTS, index, record);
+	if(err != SUCCESS || record.type == OBJECT_UNKNOWN)
+		return err;
+
+	err = read_map_object_record((interactable_object_e)record.type, record.data, record.size, object);
+	if(err != SUCCESS) {
+		delete object;
+		object = nullptr;
+	}
+
+	return err;
+}
+
+map_error_e map_file_view_t::read_hero(size_t index, hero_t& hero) const {
+	map_file_record_t record;
+	auto err = get_record(MAP_SECTION_HEROES, index, record);
+	if(err != SUCCESS)
+		return err;
+
+	auto bytes = QByteArray::fromRawData(record.data, record.size);
+	QDataStream hero_stream(bytes);
+	hero_stream >> hero;
+
+	return hero_stream.status() == QDataStream::Ok ? SUCCESS : MAP_HERO_DATA_INVALID;
+}
+
+map_error_e map_file_view_t::read_tiles(adventure_map_t& map) const {
+	auto section = find_section(MAP_SECTION_TILES);
+	if(!section || section->item_count != tile_store_t::CHUNK_SIZE)
+		return MAP_TILE_DATA_INVALID;
+
+	auto& tiles = map.tiles;
+	tiles.reset(map.width, map.height);
+	if(section->size < tiles.asset_id.size() * TILE_BYTES)
+		return MAP_TILE_DATA_INVALID;
+
+	const uchar* column = data + section->offset;
+	column = read_column(column, tiles.asset_id);
+	column = read_column(column, tiles.terrain_type);
+	column = read_column(column, tiles.road_type);
+	column = read_column(column, tiles.passability);
+	column = read_column(column, tiles.zone_id);
+	read_column(column, tiles.interactable_object);
+
+	for(auto passability : tiles.passability) {
+		if(passability > 2)
+			return MAP_TILE_DATA_INVALID;
+	}
+
+	return SUCCESS;
+}
+
+map_error_e map_file_view_t::read_doodads(adventure_map_t& map) const {
+	auto section = find_section(MAP_SECTION_DOODADS);
+	if(!section)
+		return SUCCESS;
+
+	if(section->item_count > MAXIMUM_DOODAD_COUNT)
+		return MAP_TOO_MANY_DOODADS;
+
+	if(section->size / MAP_FILE_V2_DOODAD_SIZE < section->item_count)
+		return MAP_DOODAD_DATA_INVALID;
+
+	map.doodads.resize(section->item_count);
+	for(uint32_t i = 0; i < section->item_count; i++) {
+		const uchar* record = data + section->offset + (i * MAP_FILE_V2_DOODAD_SIZE);
+		auto& doodad = map.doodads[i];
+		doodad.asset_id = read_le<uint16_t>(record);
+		doodad.z = read_le<uint16_t>(record + 2);
+		doodad.x = read_le<int32_t>(record + 4);
+		doodad.y = read_le<int32_t>(record + 8);
+		doodad.width = record[12];
+		doodad.height = record[13];
+
+		if(doodad.x < -1024 || doodad.y < -1024)
+			return MAP_DOODAD_DATA_INVALID;
+
+		if(doodad.width > 10 || doodad.height > 10)
+			return MAP_DOODAD_DATA_INVALID;
+	}
+
+	return SUCCESS;
+}
+
+map_error_e map_file_view_t::read_map(adventure_map_t& map, uint thread_count) const {
+	map.clear();
+	if(!data)
+		return MAP_COULD_NOT_READ_HEADER;
+
+	set_map_file_header(map, header);
+
+	auto players = find_section(MAP_SECTION_PLAYERS);
+	if(!players)
+		return MAP_SECTION_INVALID;
+
+	auto player_bytes = QByteArray::fromRawData((const char*)data + players->offset, players->size);
+	QDataStream player_stream(player_bytes);
+	read_map_player_configurations(player_stream, map);
+
+	auto err = read_tiles(map);
+	if(err != SUCCESS)
+		return err;
+
+	err = read_doodads(map);
+	if(err != SUCCESS)
+		return err;
+
+	//locate every record, then decode them all together
+	std::vector<map_file_record_t> object_records(get_object_count());
+	for(size_t i = 0; i < object_records.size(); i++) {
+		err = get_record(MAP_SECTION_OBJECTS, i, object_records[i]);
+		if(err != SUCCESS)
+			return err;
+	}
+
+	std::vector<map_file_record_t> hero_records(get_hero_count());
+	for(size_t i = 0; i < hero_records.size(); i++) {
+		err = get_record(MAP_SECTION_HEROES, i, hero_records[i]);
+		if(err != SUCCESS)
+			return err;
+	}
+
+	err = decode_map_object_records(object_records, map.objects, thread_count);
+	if(err != SUCCESS)
+		return err;
+
+	std::vector<hero_t> heroes;
+	err = decode_map_hero_records(hero_records, heroes, thread_count);
+	if(err != SUCCESS)
+		return err;
+
+	for(const auto& hero : heroes) {
+		err = add_map_file_hero(map, hero);
+		if(err != SUCCESS)
+			return err;
+	}
+
+	return SUCCESS;
+}
+
+bool is_map_file_v2(const std::string& filename) {
+	QFile file(QString::fromStdString(filename));
+	if(!file.open(QIODevice::ReadOnly))
+		return false;
+
+	char magic[sizeof(MAP_FILE_V2_MAGIC)];
+	return file.read(magic, sizeof(magic)) == sizeof(magic) && memcmp(magic, MAP_FILE_V2_MAGIC, sizeof(magic)) == 0;
+}
+
+map_error_e write_map_file_v2(const std::string& filename, const adventure_map_t& map) {
+	QByteArray bytes;
+	auto err = write_map_file_v2(map, bytes);
+	if(err != SUCCESS)
+		return err;
+
+	QFile file(QString::fromStdString(filename));
+	if(!file.open(QIODevice::WriteOnly))
+		return MAP_COULD_NOT_OPEN_FILE;
+
+	return file.write(bytes) == bytes.size() ? SUCCESS : MAP_COULD_NOT_WRITE_HEADER;
+}
+
+map_error_e write_map_file_v2(const adventure_map_t& map, QByteArray& bytes) {
+	auto header = get_map_file_header(map, 2);
+	auto err = validate_map_file_header(header);
+	if(err != SUCCESS)
+		return err;
+
+	if(map.tiles.width != map.width || map.tiles.height != map.height)
+		return MAP_TILE_DATA_INVALID;
+	if(map.doodads.size() > MAXIMUM_DOODAD_COUNT)
+		return MAP_TOO_MANY_DOODADS;
+	if(map.objects.size() > MAXIMUM_OBJECTS_COUNT)
+		return MAP_TOO_MANY_OBJECTS;
+	if(map.heroes.size() > MAXIMUM_HERO_COUNT)
+		return MAP_TOO_MANY_HEROES;
+
+	std::vector<section_bytes_t> sections;
+
+	QBuffer player_buffer;
+	player_buffer.open(QIODevice::WriteOnly);
+	QDataStream player_stream(&player_buffer);
+	write_map_player_configurations(player_stream, map);
+	sections.push_back({ MAP_SECTION_PLAYERS, (uint32_t)map.player_configurations.size(), player_buffer.data() });
+
+	auto minimap_tiles = get_minimap_tiles(map);
+	sections.push_back({ MAP_SECTION_MINIMAP, 0, QByteArray((const char*)minimap_tiles.data(), minimap_tiles.size()) });
+
+	section_bytes_t tiles = { MAP_SECTION_TILES, tile_store_t::CHUNK_SIZE, QByteArray() };
+	append_column(tiles.bytes, map.tiles.asset_id);
+	append_column(tiles.bytes, map.tiles.terrain_type);
+	append_column(tiles.bytes, map.tiles.road_type);
+	append_column(tiles.bytes, map.tiles.passability);
+	append_column(tiles.bytes, map.tiles.zone_id);
+	append_column(tiles.bytes, map.tiles.interactable_object);
+	sections.push_back(std::move(tiles));
+
+	section_bytes_t doodads = { MAP_SECTION_DOODADS, (uint32_t)map.doodads.size(), QByteArray() };
+	for(const auto& doodad : map.doodads) {
+		append_le<uint16_t>(doodads.bytes, doodad.asset_id);
+		append_le<uint16_t>(doodads.bytes, doodad.z);
+		append_le<int32_t>(doodads.bytes, doodad.x);
+		append_le<int32_t>(doodads.bytes, doodad.y);
+		append_le<uint8_t>(doodads.bytes, doodad.width);
+		append_le<uint8_t>(doodads.bytes, doodad.height);
+		append_le<uint16_t>(doodads.bytes, 0);
+	}
+	sections.push_back(std::move(doodads));
+
+	//removed objects keep their slot so that object ids survive the round trip
+	std::vector<std::pair<uint16_t, QByteArray>> records;
+	records.reserve(map.objects.size());
+	for(auto obj : map.objects)
+		records.emplace_back(obj ? obj->object_type : OBJECT_UNKNOWN, obj ? write_map_object_record(obj) : QByteArray());
+	sections.push_back(make_record_section(MAP_SECTION_OBJECTS, records));
+
+	records.clear();
+	for(const auto& hero_pair : map.heroes) {
+		QBuffer buffer;
+		buffer.open(QIODevice::WriteOnly);
+		QDataStream hero_stream(&buffer);
+		hero_stream << hero_pair.second;
+		records.emplace_back(0, buffer.data());
+	}
+	sections.push_back(make_record_section(MAP_SECTION_HEROES, records));
+
+	bytes.clear();
+	bytes.append(MAP_FILE_V2_MAGIC, sizeof(MAP_FILE_V2_MAGIC));
+	append_le<uint16_t>(bytes, header.version_major);
+	append_le<uint16_t>(bytes, header.version_minor);
+	append_le<uint16_t>(bytes, header.width);
+	append_le<uint16_t>(bytes, header.height);
+	append_le<uint8_t>(bytes, header.players);
+	append_le<uint8_t>(bytes, header.difficulty);
+	append_le<uint8_t>(bytes, header.win_condition);
+	append_le<uint8_t>(bytes, header.loss_condition);
+	bytes.append(header.map_uuid.toRfc4122());
+	bytes.append(header.name, sizeof(header.name));
+	bytes.append(header.description, sizeof(header.description));
+	append_le<uint32_t>(bytes, (uint32_t)sections.size());
+	append_le<uint32_t>(bytes, 0);
+
+	uint64_t offset = MAP_FILE_V2_HEADER_SIZE + (sections.size() * MAP_FILE_V2_SECTION_ENTRY_SIZE);
+	for(const auto& section : sections) {
+		append_le<uint32_t>(bytes, section.type);
+		append_le<uint32_t>(bytes, section.item_count);
+		append_le<uint64_t>(bytes, offset);
+		append_le<uint64_t>(bytes, section.bytes.size());
+		offset += (section.bytes.size() + 7) & ~7;
+	}
+
+	for(const auto& section : sections) {
+		bytes.append(section.bytes);
+		pad_to_8(bytes);
+	}
+
+	return SUCCESS;
+}
+
+map_error_e read_map_file_preview(const std::string& filename, map_file_header_t& header, std::vector<uint8_t>& minimap_tiles) {
+	minimap_tiles.clear();
+	if(!is_map_file_v2(filename)) {
+		adventure_map_t map;
+		auto err = read_map_file(filename, map, header);
+		if(err == SUCCESS)
+			minimap_tiles = get_minimap_tiles(map);
+		return err;
+	}
+
+	map_file_view_t view;
+	auto err = view.open(filename);
+	if(err != SUCCESS)
+		return err;
+
+	header = view.get_header();
+	if(auto tiles = view.get_minimap_tiles())
+		minimap_tiles.assign(tiles, tiles + ((size_t)header.width * header.height));
+
+	return SUCCESS;
+}
+
+namespace {
+const size_t MAP_JSON_CACHE_KEY_SIZE = 48;
+const uint16_t MAP_JSON_CACHE_MAX_STRING = 0xffff;
+
+//the part of the cache header that a cache made from json starts with; the body crc and extras size follow it
+QByteArray make_map_json_cache_header(const QByteArray& json) {
+	QByteArray header;
+	header.append(MAP_JSON_CACHE_MAGIC, sizeof(MAP_JSON_CACHE_MAGIC));
+	append_le<uint32_t>(header, MAP_JSON_CACHE_VERSION);
+	append_le<uint64_t>(header, (uint64_t)json.size());
+	header.append(QCryptographicHash::hash(json, QCryptographicHash::Sha256));
+	return header;
+}
+
+//what read_map_file_json() sets that a version 2 file doesn't keep: the full name and description, and the player
+//fields the PLAYERS section leaves out. false if a string is too long to store, in which case no cache is written
+bool write_map_json_cache_extras(const adventure_map_t& map, QByteArray& bytes) {
+	if(map.name.size() > MAP_JSON_CACHE_MAX_STRING || map.description.size() > MAP_JSON_CACHE_MAX_STRING)
+		return false;
+
+	QDataStream stream(&bytes, QIODevice::WriteOnly);
+	stream_write_string(stream, map.name, MAP_JSON_CACHE_MAX_STRING);
+	stream_write_string(stream, map.description, MAP_JSON_CACHE_MAX_STRING);
+	for(const auto& config : map.player_configurations) {
+		if(config.player_name.size() > MAP_JSON_CACHE_MAX_STRING)
+			return false;
+
+		stream << config.is_human;
+		stream_write_string(stream, config.player_name, MAP_JSON_CACHE_MAX_STRING);
+		stream << config.selected_class;
+		stream << config.starting_hero_id;
+		stream << config.is_hero_set_by_map;
+		stream << config.was_class_random;
+		stream << config.was_hero_random;
+	}
+
+	return stream.status() == QDataStream::Ok;
+}
+
+//applied after the version 2 data loads, so the starting heroes add_map_file_hero() picked give way to the JSON's
+bool read_map_json_cache_extras(const QByteArray& bytes, adventure_map_t& map) {
+	QDataStream stream(bytes);
+	map.name = stream_read_string(stream, MAP_JSON_CACHE_MAX_STRING);
+	map.description = stream_read_string(stream, MAP_JSON_CACHE_MAX_STRING);
+	for(auto& config : map.player_configurations) {
+		stream >> config.is_human;
+		config.player_name = stream_read_string(stream, MAP_JSON_CACHE_MAX_STRING);
+		stream >> config.selected_class;
+		stream >> config.starting_hero_id;
+		stream >> config.is_hero_set_by_map;
+		stream >> config.was_class_random;
+		stream >> config.was_hero_random;
+	}
+
+	return stream.status() == QDataStream::Ok && stream.atEnd();
+}
+
+map_error_e read_map_json_cache(const std::string& cache_path, const QByteArray& expected_header, adventure_map_t& map) {
+	QFile file(QString::fromStdString(cache_path));
+	if(!file.open(QIODevice::ReadOnly))
+		return MAP_COULD_NOT_OPEN_FILE;
+
+	if(file.size() <= MAP_JSON_CACHE_HEADER_SIZE || file.read(MAP_JSON_CACHE_KEY_SIZE) != expected_header)
+		return MAP_VERSION_INVALID;
+
+	auto size = (size_t)file.size();
+	auto data = file.map(0, size);
+	if(!data)
+		return MAP_COULD_NOT_OPEN_FILE;
+
+	//a damaged body is caught here rather than trusted to the version 2 checks
+	auto body = data + MAP_JSON_CACHE_HEADER_SIZE;
+	auto body_size = size - MAP_JSON_CACHE_HEADER_SIZE;
+	auto body_crc = read_le<uint32_t>(data + MAP_JSON_CACHE_KEY_SIZE);
+	auto extras_size = (size_t)read_le<uint32_t>(data + MAP_JSON_CACHE_KEY_SIZE + 4);
+	if(block_crc32((const char*)body, body_size) != body_crc || extras_size >= body_size) {
+		file.unmap(data);
+		return MAP_SECTION_INVALID;
+	}
+
+	map_file_view_t view;
+	auto err = view.open(body + extras_size, body_size - extras_size);
+	if(err == SUCCESS)
+		err = view.read_map(map);
+	if(err == SUCCESS && !read_map_json_cache_extras(QByteArray::fromRawData((const char*)body, (int)extras_size), map))
+		err = MAP_SECTION_INVALID;
+	view.close();
+	file.unmap(data);
+	return err;
+}
+
+//written under a temporary name and renamed, so a cache is never seen half written
+void write_map_json_cache(const std::string& cache_path, QByteArray header, const adventure_map_t& map) {
+	QByteArray body;
+	if(!write_map_json_cache_extras(map, body))
+		return;
+
+	auto extras_size = body.size();
+	QByteArray bytes;
+	if(write_map_file_v2(map, bytes) != SUCCESS)
+		return;
+
+	body.append(bytes);
+	append_le<uint32_t>(header, block_crc32(body.constData(), body.size()));
+	append_le<uint32_t>(header, (uint32_t)extras_size);
+
+	QSaveFile file(QString::fromStdString(cache_path));
+	if(!file.open(QIODevice::WriteOnly))
+		return;
+	if(file.write(header) != header.size() || file.write(body) != body.size()) {
+		file.cancelWriting();
+		return;
+	}
+	file.commit();
+}
+}
+
+std::string get_map_json_cache_path(const std::string& filepath) {
+	return filepath + ".cache";
+}
+
+map_error_e read_map_file_json_cached(const std::string& filepath, adventure_map_t& map, bool* used_cache) {
+	if(used_cache)
+		*used_cache = false;
+
+	QFile file(QString::fromStdString(filepath));
+	if(!file.open(QIODevice::ReadOnly))
+		return MAP_COULD_NOT_OPEN_FILE;
+
+	auto json = file.readAll();
+	file.close();
+
+	auto cache_path = get_map_json_cache_path(filepath);
+	auto header = make_map_json_cache_header(json);
+	if(read_map_json_cache(cache_path, header, map) == SUCCESS) {
+		if(used_cache)
+			*used_cache = true;
+		return SUCCESS;
+	}
+
+	//missing, stale or damaged: the JSON decides, and the cache is rebuilt from what it loaded
+	auto err = read_map_file_json(json, map);
+	if(err != SUCCESS)
+		return err;
+
+	write_map_json_cache(cache_path, header, map);
+	return SUCCESS;
+}
+
+map_error_e update_map_json_cache(const std::string& filepath, bool* was_current) {
+	adventure_map_t map;
+	return read_map_file_json_cached(filepath, map, was_current);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "core/map_file.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//version 2 map files: a fixed little-endian header and section table, then the sections. tiles are the raw columns of
+//a tile_store_t so they load with a block copy, and object and hero records are listed in a table up front so each
+//one can be decoded on its own. files are mapped rather than read, and listing or previewing a map only touches the
+//header and the minimap section
+const char MAP_FILE_V2_MAGIC[4] = { 'C', 'O', 'F', '2' };
+const int MAP_FILE_V2_HEADER_SIZE = 328;
+const int MAP_FILE_V2_SECTION_ENTRY_SIZE = 24;
+const int MAP_FILE_V2_RECORD_ENTRY_SIZE = 12;
+const int MAP_FILE_V2_DOODAD_SIZE = 16;
+
+enum map_file_section_e : uint32_t {
+	MAP_SECTION_PLAYERS = 1, //player configurations, QDataStream encoded as in version 1 files
+	MAP_SECTION_MINIMAP, //get_minimap_tiles()
+	MAP_SECTION_TILES, //tile_store_t columns in declaration order; item_count is the chunk size they were laid out with
+	MAP_SECTION_DOODADS, //fixed-size records
+	MAP_SECTION_OBJECTS, //record table, then write_map_object_record() records
+	MAP_SECTION_HEROES, //record table, then QDataStream encoded heroes
+	MAP_SECTION_SCRIPTS //reserved: maps have no scripts of their own yet, hero scripts are part of the hero records
+};
+
+struct map_file_section_t {
+	map_file_section_e type = MAP_SECTION_PLAYERS;
+	uint32_t item_count = 0;
+	uint64_t offset = 0; //from the start of the file
+	uint64_t size = 0;
+};
+
+//a version 2 map file mapped from disk or held in memory. only the header and section table are read up front
+struct map_file_view_t {
+	map_file_view_t() = default;
+	map_file_view_t(const map_file_view_t&) = delete;
+	map_file_view_t& operator=(const map_file_view_t&) = delete;
+	~map_file_view_t() { close(); }
+
+	map_error_e open(const std::string& filename);
+	//data must stay valid until the view is closed
+	map_error_e open(const uchar* bytes, size_t byte_count);
+	void close();
+
+	const map_file_header_t& get_header() const { return header; }
+	const map_file_section_t* find_section(map_file_section_e type) const;
+	//width * height bytes as returned by get_minimap_tiles(), null if the file has none
+	const uint8_t* get_minimap_tiles() const;
+	size_t get_object_count() const;
+	size_t get_hero_count() const;
+	//object is null for removed objects and for types this build does not know
+	map_error_e read_object(size_t index, interactable_object_t*& object) const;
+	map_error_e read_hero(size_t index, hero_t& hero) const;
+	//objects and heroes are decoded across thread_count threads, see decode_map_object_records()
+	map_error_e read_map(adventure_map_t& map, uint thread_count = 0) const;
+
+private:
+	QFile file;
+	const uchar* data = nullptr;
+	size_t size = 0;
+	map_file_header_t header;
+	std::vector<map_file_section_t> sections;
+
+	map_error_e read_section_table();
+	map_error_e get_record(map_file_section_e type, size_t index, map_file_record_t& record) const;
+	map_error_e read_tiles(adventure_map_t& map) const;
+	map_error_e read_doodads(adventure_map_t& map) const;
+};
+
+bool is_map_file_v2(const std::string& filename);
+map_error_e write_map_file_v2(const std::string& filename, const adventure_map_t& map);
+map_error_e write_map_file_v2(const adventure_map_t& map, QByteArray& bytes);
+//the header and terrain minimap without loading the map. version 1 files have no minimap section, so theirs comes
+//from loading the whole map
+map_error_e read_map_file_preview(const std::string& filename, map_file_header_t& header, std::vector<uint8_t>& minimap_tiles);
+
+//binary caches of JSON maps, written next to the map as <map>.cache: a MAP_JSON_CACHE_HEADER_SIZE byte little-endian
+//header {magic, MAP_JSON_CACHE_VERSION, u64 JSON size, SHA-256 of the JSON, CRC-32 of the body, u32 extras size}.
+//the body is the extras (what the JSON reader sets that a version 2 file drops) followed by the map as a version 2
+//file, so a cache load gives the same map as read_map_file_json(). a cache is only used when the version, hash and
+//crc all match and the data loads, so editing the JSON or changing either format (bump the version) sends the next
+//load back to the JSON, which then rewrites the cache
+const char MAP_JSON_CACHE_MAGIC[4] = { 'C', 'O', 'F', 'C' };
+const uint32_t MAP_JSON_CACHE_VERSION = 2;
+const int MAP_JSON_CACHE_HEADER_SIZE = 56;
+
+std::string get_map_json_cache_path(const std::string& filepath);
+//read_map_file_json() through the cache. used_cache, if given, is set when the map came from the cache. failing to
+//write the cache is not an error, the map has loaded either way
+map_error_e read_map_file_json_cached(const std::string& filepath, adventure_map_t& map, bool* used_cache = nullptr);
+//writes the cache if it is missing or stale without keeping the map; was_current, if given, is set when it was neither
+map_error_e update_map_json_cache(const std::string& filepath, bool* was_current = nullptr);
@@ -0,0 +1,108 @@
+#include "core/object_index.h"
+#include "core/town.h"
+
+#include <algorithm>
+
+namespace {
+void insert_sorted(std::vector<uint16_t>& bucket, uint16_t index) {
+	auto it = std::lower_bound(bucket.begin(), bucket.end(), index);
+	if(it == bucket.end() || *it != index)
+		bucket.insert(it, index);
+}
+
+void erase_sorted(std::vector<uint16_t>& bucket, uint16_t index) {
+	auto it = std::lower_bound(bucket.begin(), bucket.end(), index);
+	if(it != bucket.end() && *it == index)
+		bucket.erase(it);
+}
+}
+
+player_e get_object_owner(const interactable_object_t* object) {
+	if(!object)
+		return PLAYER_NONE;
+
+	switch(object->object_type) {
+		case OBJECT_MAP_TOWN:
+			return ((const town_t*)object)->player;
+		case OBJECT_MINE:
+			return ((const mine_t*)object)->owner;
+		case OBJECT_WATERWHEEL:
+		case OBJECT_WINDMILL:
+		case OBJECT_WATCHTOWER:
+			return ((const flaggable_object_t*)object)->owner;
+		default:
+			return PLAYER_NONE;
+	}
+}
+
+void object_index_t::reset(int map_width, int map_height) {
+	width = map_width;
+	height = map_height;
+	chunk_columns = (width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	chunk_rows = (height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	indexed_count = 0;
+	entries.clear();
+	by_type.assign(TYPE_COUNT, {});
+	by_chunk.assign((size_t)chunk_columns * chunk_rows, {});
+	by_owner.assign(OWNER_COUNT, {});
+}
+
+int object_index_t::get_chunk(int x, int y) const {
+	if(x < 0 || y < 0 || x >= width || y >= height)
+		return -1;
+
+	return (x / CHUNK_SIZE) + ((y / CHUNK_SIZE) * chunk_columns);
+}
+
+void object_index_t::insert(uint16_t index, const interactable_object_t* object) {
+	if(entries.size() <= index)
+		entries.resize(index + 1);
+
+	if(!object || entries[index].indexed)
+		return;
+
+	auto& entry = entries[index];
+	entry.indexed = true;
+	entry.type = object->object_type;
+	entry.owner = get_object_owner(object);
+	entry.chunk = get_chunk(object->x, object->y);
+
+	if(entry.type < TYPE_COUNT)
+		insert_sorted(by_type[entry.type], index);
+
+	if(entry.chunk != -1)
+		insert_sorted(by_chunk[entry.chunk], index);
+
+	if(entry.owner < OWNER_COUNT)
+		insert_sorted(by_owner[entry.owner], index);
+}
+
+void object_index_t::remove(uint16_t index) {
+	if(index >= entries.size() || !entries[index].indexed)
+		return;
+
+	auto& entry = entries[index];
+	if(entry.type < TYPE_COUNT)
+		erase_sorted(by_type[entry.type], index);
+
+	if(entry.chunk != -1)
+		erase_sorted(by_chunk[entry.chunk], index);
+
+	if(entry.owner < OWNER_COUNT)
+		erase_sorted(by_owner[entry.owner], index);
+
+	entry = entry_t();
+}
+
+void object_index_t::set_owner(uint16_t index, player_e owner) {
+	if(index >= entries.size() || !entries[index].indexed || entries[index].owner == owner)
+		return;
+
+	auto& entry = entries[index];
+	if(entry.owner < OWNER_COUNT)
+		erase_sorted(by_owner[entry.owner], index);
+
+	entry.owner = owner;
+	if(entry.owner < OWNER_COUNT)
+		insert_sorted(by_owner[entry.owner], index);
+}
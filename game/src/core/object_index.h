@@ -0,0 +1,40 @@
+#pragma once
+
+#include "core/interactable_object.h"
+
+#include <cstdint>
+#include <vector>
+
+//town player, mine or flaggable owner; PLAYER_NONE for objects that cannot be owned
+player_e get_object_owner(const interactable_object_t* object);
+
+//adventure_map_t::objects bucketed by type, by the 16x16 chunk holding the object's x/y and by owner. every bucket
+//holds indices into objects in ascending order, so queries visit objects in the same order a scan of objects would
+struct object_index_t {
+	static constexpr int CHUNK_SIZE = 16;
+	static constexpr int TYPE_COUNT = OBJECT_UNUSED + 1;
+	static constexpr int OWNER_COUNT = PLAYER_NEUTRAL + 1;
+
+	struct entry_t {
+		bool indexed = false;
+		interactable_object_e type = OBJECT_UNKNOWN;
+		player_e owner = PLAYER_NONE;
+		int chunk = -1;
+	};
+
+	int width = 0;
+	int height = 0;
+	int chunk_columns = 0;
+	int chunk_rows = 0;
+	size_t indexed_count = 0; //objects [0, indexed_count) have been seen
+	std::vector<entry_t> entries;
+	std::vector<std::vector<uint16_t>> by_type;
+	std::vector<std::vector<uint16_t>> by_chunk;
+	std::vector<std::vector<uint16_t>> by_owner;
+
+	void reset(int map_width, int map_height);
+	void insert(uint16_t index, const interactable_object_t* object);
+	void remove(uint16_t index);
+	void set_owner(uint16_t index, player_e owner);
+	int get_chunk(int x, int y) const;
+};
@@ -38,6 +38,9 @@ struct player_configuration_t {
 	bool is_hero_set_by_map = false;
 	bool was_class_random = false;
 	bool was_hero_random = false;
+	//wall-clock limit on this player's ai turns, 0 for none. not saved. with a limit, which goals are picked depends on
+	//how fast the machine is, so seeded games only replay identically without one
+	uint ai_turn_time_budget_ms = 0;
 };
 
 
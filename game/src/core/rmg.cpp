@@ -6,12 +6,13 @@
 #include "core/brushes.h"
 #include "core/utils.h"
 
+#include <atomic>
+#include <chrono>
 #include <queue>
+#include <thread>
 
 const int TILE_SIZE = 128;
 
-static std::mt19937_64 rng;
-
 static uint32_t tile_hash(int x, int y) {
 	uint32_t h = static_cast<uint32_t>(x) * 2246822519u ^ static_cast<uint32_t>(y) * 3266489917u;
 	h ^= h >> 17;
@@ -22,35 +23,37 @@ static uint32_t tile_hash(int x, int y) {
 	return h;
 }
 
-const tree_brush_t* get_tree_brush_for_tile(int tilex, int tiley, map_tile_t& tile) {
-	static std::map<terrain_type_e, std::vector<const tree_brush_t*>> brushes_for_terrain;
-	if(brushes_for_terrain.size() == 0)	{
+const tree_brush_t* get_tree_brush_for_tile(int tilex, int tiley, const map_tile_t& tile) {
+	//built once, on first use from whichever thread is generating a map
+	static const auto brushes_for_terrain = [] {
+		std::map<terrain_type_e, std::vector<const tree_brush_t*>> brushes;
 		for(const auto& b : game_config::get_tree_brushes()) {
 			for(int i = 1; i < b.native_terrain_types.size(); i++) {
 				auto terrain = (terrain_type_e)i;
 				if(b.native_terrain_types.test(i))
-					brushes_for_terrain[terrain].push_back(&b);
+					brushes[terrain].push_back(&b);
 			}
 		}
-	}
+		return brushes;
+	}();
 
-	auto tile_terrain = tile.terrain_type;
-	if(!brushes_for_terrain.contains(tile_terrain) || !brushes_for_terrain[tile_terrain].size())
+	auto brushes = brushes_for_terrain.find(tile.terrain_type);
+	if(brushes == brushes_for_terrain.end() || !brushes->second.size())
 		return nullptr;
 
 	//brush_index = (uint64_t)tile_hash(x, y) * tree_brushes.size() >> 32
-	return brushes_for_terrain[tile_terrain][tile_hash(tilex, tiley) % brushes_for_terrain[tile_terrain].size()];
+	return brushes->second[tile_hash(tilex, tiley) % brushes->second.size()];
 }
 
-void draw_road_between_object_and_point(adventure_map_t& map, interactable_object_t* obj_start, coord_t end, road_type_e road_type);
-void draw_road_between_objects(adventure_map_t& map, interactable_object_t* obj_start, interactable_object_t* obj_end, road_type_e road_type);
-void draw_road_between_points(adventure_map_t& map, coord_t start, coord_t end, road_type_e road_type);
+void draw_road_between_object_and_point(adventure_map_t& map, interactable_object_t* obj_start, coord_t end, road_type_e road_type, std::mt19937_64& rng);
+void draw_road_between_objects(adventure_map_t& map, interactable_object_t* obj_start, interactable_object_t* obj_end, road_type_e road_type, std::mt19937_64& rng);
+void draw_road_between_points(adventure_map_t& map, coord_t start, coord_t end, road_type_e road_type, std::mt19937_64& rng);
 
-int rand_int() {
+int rand_int(std::mt19937_64& rng) {
 	return std::uniform_int_distribution<int>(0, INT_MAX)(rng);
 }
 
-std::pair<unit_type_e, int> get_monster_guard(int total_value, std::bitset<8> allowed_tiers = 0xf, bool melee = true, bool ranged = true) {
+std::pair<unit_type_e, int> get_monster_guard(int total_value, std::mt19937_64& rng, std::bitset<8> allowed_tiers = 0xf, bool melee = true, bool ranged = true) {
 	std::vector<unit_type_e> potential_unit_types;
 	for(auto& cr : game_config::get_creatures()) {
 		troop_t troop;
@@ -81,21 +84,21 @@ std::pair<unit_type_e, int> get_monster_guard(int total_value, std::bitset<8> al
 	return {unit_type, std::clamp(unit_count, 1, (int)game_config::MAX_TROOP_STACK_SIZE)};
 }
 
-coord_t get_rand_coord_in_range(int x, int y, int dist, int range = 0) {
+coord_t get_rand_coord_in_range(int x, int y, int dist, int range, std::mt19937_64& rng) {
 	int total_dist = dist + utils::rand_range(-range, range, rng);
 	int xoff = utils::rand_range(-total_dist, total_dist, rng);
 	int yoff = (xoff >= 0) ? total_dist - xoff : total_dist + xoff;
 	
-	if(rand_int() % 2 == 0)
+	if(rand_int(rng) % 2 == 0)
 		yoff = -yoff;
 	
 	return {x + xoff, y + yoff};
 }
 
-coord_t get_rand_coord_in_biome(const adventure_map_t& map, const biome_t& biome, int tries = 25) {
+coord_t get_rand_coord_in_biome(const adventure_map_t& map, const biome_t& biome, std::mt19937_64& rng, int tries = 25) {
 	for(int i = 0; i < tries; i++) {
-		int x = rand_int() % map.width;
-		int y = rand_int() % map.height;
+		int x = rand_int(rng) % map.width;
+		int y = rand_int(rng) % map.height;
 		if(map.get_tile(x, y).zone_id == biome.zone_id)
 			return {x, y};
 	}
@@ -108,7 +111,7 @@ void flood_fill_biome(adventure_map_t& map, biome_t& biome) {
 	queue.push(biome.terrain_center);
 	
 	// Ensure initial tile settings are consistent
-	auto& center_tile = map.get_tile(biome.terrain_center.x, biome.terrain_center.y);
+	auto center_tile = map.get_tile_ref(biome.terrain_center.x, biome.terrain_center.y);
 	auto initial_zone_id = center_tile.zone_id;
 	center_tile.terrain_type = biome.terrain_type;
 	center_tile.zone_id = biome.zone_id;
@@ -126,7 +129,7 @@ void flood_fill_biome(adventure_map_t& map, biome_t& biome) {
 			if (!map.tile_valid(adj.x, adj.y))
 				continue;
 
-			auto& adj_tile = map.get_tile(adj.x, adj.y);
+			auto adj_tile = map.get_tile_ref(adj.x, adj.y);
 
 			// Only process adjacent tiles that match the biome's terrain type but have not been updated yet
 			if (adj_tile.terrain_type == biome.terrain_type && adj_tile.zone_id == initial_zone_id) {
@@ -137,11 +140,11 @@ void flood_fill_biome(adventure_map_t& map, biome_t& biome) {
 	}
 };
 
-void draw_road_between_objects(adventure_map_t& map, interactable_object_t* obj_start, interactable_object_t* obj_end, road_type_e road_type) {
+void draw_road_between_objects(adventure_map_t& map, interactable_object_t* obj_start, interactable_object_t* obj_end, road_type_e road_type, std::mt19937_64& rng) {
 	coord_t mi = {obj_end->x, obj_end->y};
-	map.get_tile(mi.x, mi.y).road_type = road_type;
+	map.get_tile_ref(mi.x, mi.y).road_type = road_type;
 	mi.y++;
-	map.get_tile(mi.x, mi.y).road_type = road_type;
+	map.get_tile_ref(mi.x, mi.y).road_type = road_type;
 	int ew_direction = (mi.x <= obj_start->x) ? 1 : -1;
 
 	if(obj_end->y > obj_start->y) {
@@ -152,19 +155,19 @@ void draw_road_between_objects(adventure_map_t& map, interactable_object_t* obj_
 		for(int i = 0; i < padx; i++) {
 			if(map.tile_valid(mi.x, mi.y)) {
 				mi.x += ew_direction;
-				map.get_tile(mi.x, mi.y).road_type = road_type;
+				map.get_tile_ref(mi.x, mi.y).road_type = road_type;
 			}
 		}
 	}
 	
-	draw_road_between_object_and_point(map, obj_start, mi, road_type);
+	draw_road_between_object_and_point(map, obj_start, mi, road_type, rng);
 }
 
-void draw_road_between_object_and_point(adventure_map_t& map, interactable_object_t* obj_start, coord_t end, road_type_e road_type) {
+void draw_road_between_object_and_point(adventure_map_t& map, interactable_object_t* obj_start, coord_t end, road_type_e road_type, std::mt19937_64& rng) {
 	coord_t mi = { obj_start->x, obj_start->y };
-	map.get_tile(mi.x, mi.y).road_type = road_type;
+	map.get_tile_ref(mi.x, mi.y).road_type = road_type;
 	mi.y++;
-	map.get_tile(mi.x, mi.y).road_type = road_type;
+	map.get_tile_ref(mi.x, mi.y).road_type = road_type;
 	int ew_direction = (mi.x <= end.x) ? 1 : -1;
 
 	if(obj_start->y > end.y) {
@@ -175,15 +178,15 @@ void draw_road_between_object_and_point(adventure_map_t& map, interactable_objec
 		for(int i = 0; i < padx; i++) {
 			if(map.tile_valid(mi.x, mi.y)) {
 				mi.x += ew_direction;
-				map.get_tile(mi.x, mi.y).road_type = road_type;
+				map.get_tile_ref(mi.x, mi.y).road_type = road_type;
 			}
 		}
 	}
 	
-	draw_road_between_points(map, mi, end, road_type);
+	draw_road_between_points(map, mi, end, road_type, rng);
 }
 
-void draw_road_between_points(adventure_map_t& map, coord_t start, coord_t end, road_type_e road_type) {
+void draw_road_between_points(adventure_map_t& map, coord_t start, coord_t end, road_type_e road_type, std::mt19937_64& rng) {
 	// Calculate the direction vector from start to end
 	int dx = end.x - start.x;
 	int dy = end.y - start.y;
@@ -193,7 +196,7 @@ void draw_road_between_points(adventure_map_t& map, coord_t start, coord_t end,
 	int perpendicular_y = -dx;
 
 	// Randomize the choice of perpendicular direction
-	if (rand_int() % 2) {
+	if (rand_int(rng) % 2) {
 		perpendicular_x = -dy;
 		perpendicular_y = dx;
 	}
@@ -203,7 +206,7 @@ void draw_road_between_points(adventure_map_t& map, coord_t start, coord_t end,
 	float max_deviation = .5f;
 	float deviation_magnitude = utils::rand_rangef(min_deviation, max_deviation, rng);
 	float deviation_delta = .1f;
-	float deviation_direction = (rand_int() % 2 == 0) ? 1.f : -1.f;
+	float deviation_direction = (rand_int(rng) % 2 == 0) ? 1.f : -1.f;
 
 	coord_t virtual_end;
 	virtual_end.x = (int)(end.x + perpendicular_x * deviation_magnitude);
@@ -218,7 +221,7 @@ void draw_road_between_points(adventure_map_t& map, coord_t start, coord_t end,
 
 	while(true) {
 		if(map.tile_valid(pos.x, pos.y) && map.get_tile(pos.x, pos.y).is_passable()) {
-			map.get_tile(pos.x, pos.y).road_type = road_type;
+			map.get_tile_ref(pos.x, pos.y).road_type = road_type;
 		}
 		
 		if(pos.x == end.x && pos.y == end.y)
@@ -367,7 +370,7 @@ bool does_object_fit_at_location(adventure_map_t& map, interactable_object_e obj
 			if(!map.tile_valid(tilex, tiley))
 				return false;
 
-			const auto& tile = map.get_tile(tilex, tiley);
+			const auto tile = map.get_tile(tilex, tiley);
 			if(!tile.is_passable() || tile.is_interactable())
 				return false;
 
@@ -406,9 +409,12 @@ bool add_object_to_map(interactable_object_t* object, adventure_map_t& map, QBit
 	if(!map.tile_valid(object->x, object->y))
 		return false;
 
-	auto& tile = map.get_tile(object->x, object->y);
+	auto tile = map.get_tile_ref(object->x, object->y);
 	tile.interactable_object = object_offset;
 	tile.passability = 2;
+	map.mark_zone_graph_dirty(object->x, object->y);
+	if(object->object_type == OBJECT_MAP_MONSTER)
+		map.set_monster_guard(object_offset - 1, true);
 
 	//skip setting passability for known 1x1 objects
 	if(interactable_object_t::is_pickupable(object) || object->object_type == OBJECT_MAP_MONSTER) {
@@ -428,14 +434,16 @@ bool add_object_to_map(interactable_object_t* object, adventure_map_t& map, QBit
 				continue;
 
 			if(obj_info.interactability.test(offset)) {
-				map.get_tile(tilex, tiley).interactable_object = object_offset;
-				map.get_tile(tilex, tiley).passability = 2;
+				map.get_tile_ref(tilex, tiley).interactable_object = object_offset;
+				map.get_tile_ref(tilex, tiley).passability = 2;
+				map.mark_zone_graph_dirty(tilex, tiley);
 				if(obstacles.size())
 					obstacles.clearBit(tilex + map.width * tiley);
 			}
 
 			if(!obj_info.passability.test(offset)) {
-				map.get_tile(tilex, tiley).passability = 0;
+				map.get_tile_ref(tilex, tiley).passability = 0;
+				map.mark_zone_graph_dirty(tilex, tiley);
 				if(obstacles.size())
 					obstacles.clearBit(tilex + map.width * tiley);
 			}
@@ -445,6 +453,44 @@ bool add_object_to_map(interactable_object_t* object, adventure_map_t& map, QBit
 	return true;
 }
 
+bool is_object_accessible(const adventure_map_t& map, const interactable_object_t* object) {
+	const auto& obj_info = game_config::get_object_info(object->object_type, object->asset_id);
+	const bool pickupable = interactable_object_t::is_pickupable(object->object_type);
+	for(auto y = 0; y < 8; y++) {
+		for(auto x = 0; x < 8; x++) {
+			auto offset = y*8 + x;
+			if(!obj_info.interactability.test(offset))
+				continue;
+
+			auto tilex = object->x - 3 + x;
+			auto tiley = object->y - 6 + y;
+			if(!map.tile_valid(tilex, tiley))
+				return false;
+
+			if(!pickupable) {
+				if(!map.tile_valid(tilex, tiley + 1) || !map.get_tile(tilex, tiley + 1).is_passable())
+					return false;
+				continue;
+			}
+
+			bool has_passable_neighbour = false;
+			for(int ny = -1; ny <= 1 && !has_passable_neighbour; ny++) {
+				for(int nx = -1; nx <= 1; nx++) {
+					if((nx || ny) && map.tile_valid(tilex + nx, tiley + ny) && map.get_tile(tilex + nx, tiley + ny).is_passable()) {
+						has_passable_neighbour = true;
+						break;
+					}
+				}
+			}
+
+			if(!has_passable_neighbour)
+				return false;
+		}
+	}
+
+	return true;
+}
+
 bool is_road_diagonal(int x, int y, const adventure_map_t& map) {
 	bool top = map.tile_valid(x - 1, y) && map.get_tile(x - 1, y).road_type != ROAD_NONE;
 	bool bottom = map.tile_valid(x + 1, y) && map.get_tile(x + 1, y).road_type != ROAD_NONE;
@@ -454,13 +500,173 @@ bool is_road_diagonal(int x, int y, const adventure_map_t& map) {
 	return (top && left) || (top && right) || (bottom && left) || (bottom && right);
 }
 
-rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& biomes, int64_t map_seed) {
+namespace {
+//rows per band handed to a terrain thread at a time
+const int TERRAIN_ROW_BAND = 8;
+
+//calls process_band(first_row, end_row) for bands of TERRAIN_ROW_BAND rows, on thread_count threads (0 for
+//std::thread::hardware_concurrency()). bands may run in any order, so process_band must only touch its own rows
+template<typename band_fn_t> void for_each_row_band(int height, uint thread_count, band_fn_t process_band) {
+	const int band_count = (height + TERRAIN_ROW_BAND - 1) / TERRAIN_ROW_BAND;
+	if(!thread_count)
+		thread_count = std::max(1u, std::thread::hardware_concurrency());
+	thread_count = (uint)std::clamp(band_count, 1, (int)thread_count);
+
+	std::atomic<int> next_band = 0;
+	auto worker = [&]() {
+		for(int band = next_band++; band < band_count; band = next_band++)
+			process_band(band * TERRAIN_ROW_BAND, std::min(height, (band + 1) * TERRAIN_ROW_BAND));
+	};
+
+	if(thread_count == 1) {
+		worker();
+		return;
+	}
+
+	std::vector<std::thread> workers;
+	for(uint i = 0; i < thread_count; i++)
+		workers.emplace_back(worker);
+	for(auto& thread : workers)
+		thread.join();
+}
+
+//gives every tile the terrain of the biome nearest to it by distance plus noise, with zone id 100 + the biome's zone
+//for flood_fill_biome() to claim, and sets nearest_biome (row-major) to the biome nearest by distance alone, or -1 if
+//none is closer than the bleeding fixup's cutoff. the per-biome column terms are computed once up front and each row
+//works through flat per-biome arrays: its noise samples first, then the distances. every tile only depends on its own
+//coordinates, so the map is the same whatever the thread count
+void assign_biome_terrain(adventure_map_t& map, const std::vector<biome_t>& biomes, const siv::PerlinNoise& perlin, std::vector<int16_t>& nearest_biome, uint thread_count) {
+	const int width = map.width;
+	const int biome_count = (int)biomes.size();
+	const float dr = 4000.f;
+	const auto tfx = 4 / 250.f;
+	const auto tfy = 4 / 250.f;
+
+	//each biome samples the noise at its own frequency (2, 3, ... times the base)
+	std::vector<float> noise_x((size_t)biome_count * width);
+	std::vector<int> dx2((size_t)biome_count * width);
+	for(int b = 0; b < biome_count; b++) {
+		const int i = 2 + b;
+		for(int x = 0; x < width; x++) {
+			noise_x[(size_t)b * width + x] = x * tfx * i;
+			dx2[(size_t)b * width + x] = (x - biomes[b].terrain_center.x) * (x - biomes[b].terrain_center.x);
+		}
+	}
+
+	nearest_biome.assign((size_t)width * map.height, -1);
+
+	for_each_row_band(map.height, thread_count, [&](int first_row, int end_row) {
+		std::vector<float> distance((size_t)biome_count * width);
+		for(int y = first_row; y < end_row; y++) {
+			for(int b = 0; b < biome_count; b++) {
+				const int i = 2 + b;
+				const float noise_y = y * tfy * i;
+				const int dy2 = (y - biomes[b].terrain_center.y) * (y - biomes[b].terrain_center.y);
+				const float* row_noise_x = &noise_x[(size_t)b * width];
+				const int* row_dx2 = &dx2[(size_t)b * width];
+				float* row_distance = &distance[(size_t)b * width];
+				for(int x = 0; x < width; x++) {
+					auto df = (dr/2.f) - (perlin.octave2D_01(row_noise_x[x], noise_y, 1) * dr);
+					float d = row_dx2[x] + dy2;
+					d += df;
+					row_distance[x] = d;
+				}
+			}
+
+			for(int x = 0; x < width; x++) {
+				int dist = INT_MAX;
+				terrain_type_e nearest = TERRAIN_WATER;
+				int nearest_zone_id = -1;
+				int closest_dist = 10000;
+				int16_t closest = -1;
+				for(int b = 0; b < biome_count; b++) {
+					const auto& biome = biomes[b];
+					float d = distance[(size_t)b * width + x];
+					if(d < (dist * biome.scale)) {
+						nearest = biome.terrain_type;
+						nearest_zone_id = biome.zone_id;
+						dist = d;
+					}
+
+					int plain_d = dx2[(size_t)b * width + x] + ((y - biome.terrain_center.y) * (y - biome.terrain_center.y));
+					if(plain_d < closest_dist) {
+						closest_dist = plain_d;
+						closest = (int16_t)b;
+					}
+				}
+
+				auto tile = map.get_tile_ref(x, y);
+				tile.terrain_type = nearest;
+				tile.zone_id = 100 + nearest_zone_id;
+				//clear any existing roads
+				tile.road_type = ROAD_NONE;
+				nearest_biome[(size_t)y * width + x] = closest;
+			}
+		}
+	});
+}
+}
+
+std::vector<biome_t> make_four_player_biomes(int size) {
+	const coord_t centers[] = { { size / 4, size / 4 }, { (3 * size) / 4, size / 4 }, { size / 4, (3 * size) / 4 }, { (3 * size) / 4, (3 * size) / 4 }, { size / 2, size / 2 } };
+
+	std::vector<biome_t> biomes(5);
+	for(int i = 0; i < (int)biomes.size(); i++) {
+		auto& biome = biomes[i];
+		biome.zone_id = i;
+		biome.terrain_center = centers[i];
+		biome.zone_connections.fill(-1);
+		biome.spawn_roads_to_basic_mines = true;
+
+		biome_object_info_t artifact;
+		artifact.interactable_object_type = OBJECT_ARTIFACT;
+		artifact.max_spawned = 4;
+		artifact.value = 1500;
+		artifact.guarded = true;
+		biome.placeable_objects.push_back(artifact);
+
+		biome_object_info_t box;
+		box.interactable_object_type = OBJECT_PANDORAS_BOX;
+		box.max_spawned = 1;
+		box.value = 3000;
+		box.guarded = true;
+		biome.placeable_objects.push_back(box);
+
+		if(i < 4) {
+			biome.player = (player_e)(PLAYER_1 + i);
+			biome.zone_connections[0] = 4;
+		}
+		else {
+			biome.neutral_town_count = 1;
+			biome.total_value = 15000;
+			for(int c = 0; c < 4; c++)
+				biome.zone_connections[c] = c;
+		}
+	}
+
+	return biomes;
+}
+
+rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& biomes, int64_t map_seed, uint thread_count) {
 	siv::PerlinNoise::seed_type seed = map_seed;
 	if(seed == -1)
 		seed = std::random_device()(); //(static_cast<uint64_t>(rd()) << 32) | rd();
 
-	rng.seed(seed);
-	const siv::PerlinNoise perlin{seed};
+	rmg_context_t context(seed, thread_count);
+	return generate_random_map(map, biomes, context);
+}
+
+rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& biomes, rmg_context_t& context) {
+	auto& rng = context.rng;
+	const auto thread_count = context.thread_count;
+	const siv::PerlinNoise perlin{context.seed};
+
+	auto stage_start = std::chrono::steady_clock::now();
+	auto end_stage = [&](rmg_stage_e stage) {
+		auto now = std::chrono::steady_clock::now();
+		context.stage_microseconds[stage] += std::chrono::duration_cast<std::chrono::microseconds>(now - stage_start).count();
+		stage_start = now;
+	};
 
 	const float frequency = 4.0;
 	const double fx = (frequency / map.width);
@@ -476,70 +682,34 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 			b.terrain_type = get_faction_native_terrain(b.faction);
 		/*else if(no towns in biome) {
 			if(b.terrain_type == TERRAIN_UNKNOWN)
-				b.terrain_type = (terrain_type_e)(2 + rand_int() % 8);
+				b.terrain_type = (terrain_type_e)(2 + rand_int(rng) % 8);
 		}*/
 	}	
 
-	for (int y = 0; y < map.height; ++y) {
-		for (int x = 0; x < map.width; ++x) {
-			map_tile_t& tile = map.get_tile(x, y);
-
-			int dist = INT_MAX;
-			int i = 2;
-			terrain_type_e nearest = TERRAIN_WATER;
-			int nearest_zone_id = -1;
-			
-			for(auto& b : biomes) {
-				float scale = b.scale;
-				
-				float d = utils::eu_dist(x, y, b.terrain_center.x, b.terrain_center.y);
-				float dr = 4000.f;
-				auto tfx = 4 / 250.f;
-				auto tfy = 4 / 250.f;
-				auto df = (dr/2.f) - (perlin.octave2D_01(x * tfx * i, y * tfy * i, 1) * dr);
-				d += df;
-				if(d < (dist * scale)) {
-					nearest = b.terrain_type;
-					nearest_zone_id = b.zone_id;
-					dist = d;
-				}
-
-				i++;
-			}
-			
-			tile.terrain_type = nearest;
-			tile.zone_id = 100 + nearest_zone_id;
-			//clear any existing roads
-			tile.road_type = ROAD_NONE;
-		}
-	}
+	std::vector<int16_t> nearest_biome;
+	assign_biome_terrain(map, biomes, perlin, nearest_biome, thread_count);
+	end_stage(RMG_STAGE_TERRAIN);
 
 	for(auto& b : biomes)
 		flood_fill_biome(map, b);
 
-	//fixup 'bleeding'
-	for(int y = 0; y < map.height; y++) {
-		for(int x = 0; x < map.width; x++) {
-			auto& tile = map.get_tile(x, y);
-			if(tile.zone_id < 100)
-				continue;
+	//fixup 'bleeding': tiles no flood fill reached go to the biome whose center is closest
+	for_each_row_band(map.height, thread_count, [&](int first_row, int end_row) {
+		for(int y = first_row; y < end_row; y++) {
+			for(int x = 0; x < map.width; x++) {
+				auto tile = map.get_tile_ref(x, y);
+				if(tile.zone_id < 100)
+					continue;
 
-			biome_t* closest_biome = nullptr;
-			int closest_dist = 10000;
-			for(auto& b : biomes) {
-				auto d = utils::eu_dist(x, y, b.terrain_center.x, b.terrain_center.y);
-				if(d < closest_dist) {
-					closest_dist = d;
-					closest_biome = &b;
+				auto closest = nearest_biome[(size_t)y * map.width + x];
+				if(closest >= 0) {
+					tile.zone_id = biomes[closest].zone_id;
+					tile.terrain_type = biomes[closest].terrain_type;
 				}
 			}
-
-			if(closest_biome) {
-				tile.zone_id = closest_biome->zone_id;
-				tile.terrain_type = closest_biome->terrain_type;
-			}
 		}
-	}
+	});
+	end_stage(RMG_STAGE_FLOOD_FILL);
 
 	QBitArray obstacle_tiles;
 	obstacle_tiles.resize(map.width * map.height);
@@ -571,7 +741,7 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 		//add mines
 		for(int n = 0; n < 2; n++) {
 			for(int i = 0; i < 10; i++) {
-				auto pos = get_rand_coord_in_range(main_town_x, main_town_y, 15 - i, 5);
+				auto pos = get_rand_coord_in_range(main_town_x, main_town_y, 15 - i, 5, rng);
 				
 				if(!map.tile_valid(pos.x, pos.y) || !map.get_tile(pos.x, pos.y).is_passable() || map.get_tile(pos.x, pos.y).zone_id != b.zone_id)
 					continue;
@@ -595,7 +765,7 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 				
 				//put road between town and mines
 				if(b.spawn_roads_to_basic_mines)
-					draw_road_between_objects(map, mine, main_town, ROAD_COBBLESTONE);
+					draw_road_between_objects(map, mine, main_town, ROAD_COBBLESTONE, rng);
 
 				break;
 			}
@@ -603,7 +773,7 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 		
 		for(int i = 0; i < b.neutral_town_count; i++) {
 			for(int n = 0; n < 10; n++) {
-				auto pos = get_rand_coord_in_range(main_town_x, main_town_y, 40 - n, 5);
+				auto pos = get_rand_coord_in_range(main_town_x, main_town_y, 40 - n, 5, rng);
 				
 				if(!map.tile_valid(pos.x, pos.y) || !map.get_tile(pos.x, pos.y).is_passable() || map.get_tile(pos.x, pos.y).zone_id != b.zone_id)
 					continue;
@@ -616,12 +786,13 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 				town->x = pos.x;
 				town->y = pos.y;
 				town->town_type = town_t::hero_class_to_town_type(get_random_hero_class(HERO_CLASS_ALL, rng));
+				town->name = game_config::get_random_town_name(town->town_type, rng);
 				town->player = PLAYER_NONE;
 				town->town_id = current_town_id++;
 				town->setup_default_spells();
 
 				add_object_to_map(town, map);
-				draw_road_between_objects(map, main_town, town, ROAD_COBBLESTONE);
+				draw_road_between_objects(map, main_town, town, ROAD_COBBLESTONE, rng);
 				//biome_towns.push_back(town);
 				break;
 			}
@@ -629,6 +800,8 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 		
 	}
 	
+	end_stage(RMG_STAGE_TOWNS);
+
 	auto desert_town = biome_towns[4];
 	//find zone-connecting locations
 	for(int i = 0; i < 4; i++) {
@@ -638,15 +811,15 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 
 		//draw_road_between_points(map, biomes[4].terrain_center, biomes[i].terrain_center);
 		//draw_road_between_objects(map, biome_towns[4], biome_towns[i], ROAD_COBBLESTONE);
-		draw_road_between_object_and_point(map, btown, connection_pt, ROAD_COBBLESTONE);
-		draw_road_between_object_and_point(map, desert_town, connection_pt, ROAD_COBBLESTONE);
+		draw_road_between_object_and_point(map, btown, connection_pt, ROAD_COBBLESTONE, rng);
+		draw_road_between_object_and_point(map, desert_town, connection_pt, ROAD_COBBLESTONE, rng);
 
 		auto monster = (map_monster_t*)interactable_object_t::make_new_object(OBJECT_MAP_MONSTER);
 		
 		std::bitset<8> tiers = 0;
 		tiers.set(5);
 		tiers.set(6);
-		auto minfo = get_monster_guard(45000, tiers);
+		auto minfo = get_monster_guard(45000, rng, tiers);
 		monster->unit_type = minfo.first;
 		monster->quantity = minfo.second;
 		//monster->asset_id = 274;
@@ -656,10 +829,11 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 		
 		//map.get_tile(connection_pt.x, connection_pt.y).terrain_type = TERRAIN_WATER;
 	}
+	end_stage(RMG_STAGE_ROADS);
 	
 	for (int y = 0; y < map.height; ++y) {
 		for (int x = 0; x < map.width; ++x) {
-			auto& tile = map.get_tile(x, y);
+			auto tile = map.get_tile(x, y);
 
 			int dx[] = { 1, 0, -1, 0, 1, 1, -1, -1 };
 			int dy[] = { 0, 1, 0, -1, 1, -1, 1, -1 };
@@ -673,7 +847,7 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 				if(!map.tile_valid(nx, ny))
 					continue;
 
-				auto& neighbor = map.get_tile(nx, ny);
+				auto neighbor = map.get_tile(nx, ny);
 				if(neighbor.zone_id != tile.zone_id) {
 				//if(neighbor.terrain_type != tile.terrain_type) {
 					is_edge = true;
@@ -697,7 +871,7 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 
 	for (int y = 0; y < map.height; ++y) {
  		for (int x = 0; x < map.width; ++x) {
- 			map_tile_t& tile = map.get_tile(x, y);
+ 			auto tile = map.get_tile(x, y);
 
  			// Generate a noise value for this tile
  			auto noise = perlin.octave2D_01(x * ofx, y * ofy, 1);
@@ -711,6 +885,7 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 			}
  		}
  	}
+	end_stage(RMG_STAGE_DOODADS);
 
 	for(auto& b : biomes) {
 		int total_biome_value = 0;
@@ -718,7 +893,7 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 			int placed_objects = 0;
 			for(int i = 0; i < o.max_spawned; i++) {
 				for(int n = 0; n < 50; n++) {
-					auto pos = get_rand_coord_in_biome(map, b);
+					auto pos = get_rand_coord_in_biome(map, b, rng);
 					if(!does_object_fit_at_location(map, o.interactable_object_type, pos, o.guarded))
 						continue;
 
@@ -728,7 +903,7 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 
 					auto modified_value = o.value;
 					if(o.interactable_object_type == OBJECT_ARTIFACT) {
-						int rarity = 1 + (rand_int() % 4);
+						int rarity = 1 + (rand_int(rng) % 4);
 						auto art = ((map_artifact_t*)obj);
 						art->artifact_id = adventure_map_t::get_random_artifact_of_rarity((artifact_rarity_e)rarity, rng);
 						art->asset_id = game_config::get_artifact(art->artifact_id).asset_id;
@@ -736,7 +911,7 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 					}
 					else if(o.interactable_object_type == OBJECT_PANDORAS_BOX) {
 						auto box = (pandoras_box_t*)obj;
-						int type = rand_int() % 2;
+						int type = rand_int(rng) % 2;
 						pandoras_box_t::reward_t reward;
 						
 						if(type == 0) {
@@ -746,7 +921,7 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 						}
 						else if(type == 1) {
 							reward.type = pandoras_box_t::PANDORAS_BOX_REWARD_EXPERIENCE;
-							reward.magnitude = 5000 + ((rand_int() % 5) * 2500);
+							reward.magnitude = 5000 + ((rand_int(rng) % 5) * 2500);
 							modified_value += (reward.magnitude / 500);
 						}
 
@@ -779,7 +954,7 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 
 						auto monster = (map_monster_t*)interactable_object_t::make_new_object(OBJECT_MAP_MONSTER);
 
-						auto minfo = get_monster_guard(modified_value);
+						auto minfo = get_monster_guard(modified_value, rng);
 						monster->unit_type = minfo.first;
 						monster->quantity = minfo.second;
 
@@ -794,6 +969,8 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 		}
 	}
 
+	end_stage(RMG_STAGE_OBJECTS);
+
 	//first pass, place mountains
 	for (int y = 0; y < map.height; ++y) {
  		for (int x = 0; x < map.width; ++x) {
@@ -802,7 +979,7 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 
 			int dx[] = {-1, 0, 1};
 			auto noise = perlin.octave2D_01(x * ofx / 5., y * ofy / 5., 1);
-			bool place_mountain_here = utils::rand_chance(90 * noise);
+			bool place_mountain_here = utils::rand_chance(90 * noise, rng);
 			if(!place_mountain_here)
 				continue;
 
@@ -861,7 +1038,7 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 						continue;
 
 					int tile_offset = tilex + tiley * map.width;
-					map.get_tile(tilex, tiley).passability = 0;
+					map.get_tile_ref(tilex, tiley).passability = 0;
 					obstacle_tiles.clearBit(tile_offset);
 				}
 			}
@@ -874,7 +1051,7 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 			if(!obstacle_tiles.testBit(x + y * map.width))
 				continue;
 
- 			map_tile_t& tile = map.get_tile(x, y);
+ 			auto tile = map.get_tile_ref(x, y);
 			auto brush = get_tree_brush_for_tile(x, y, tile);
 			if(brush) {
 				for(const auto& b : brush->tree_placement_info) {
@@ -890,11 +1067,13 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 		}
 	}
 
+	end_stage(RMG_STAGE_DOODADS);
+
 	//add resources
 	for(const auto& b : biomes) {
 		int count = b.resource_frequency * 20 * (map.width / 100.f);
 		for(int i = 0; i < count; i++) {
-			auto pos = get_rand_coord_in_biome(map, b);
+			auto pos = get_rand_coord_in_biome(map, b, rng);
 			if(!map.tile_valid(pos.x, pos.y) || !map.get_tile(pos.x, pos.y).is_passable())
 				continue;
 			
@@ -917,7 +1096,7 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 	for(const auto& b : biomes) {
 		int count = 15 * (map.width / 100.f);
 		for(int i = 0; i < count; i++) {
-			auto pos = get_rand_coord_in_biome(map, b);
+			auto pos = get_rand_coord_in_biome(map, b, rng);
 			if(!map.tile_valid(pos.x, pos.y) || !map.get_tile(pos.x, pos.y).is_passable())
 				continue;
 			
@@ -935,7 +1114,7 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 			auto tx = town->x;
 			auto ty = town->y;
 
-			auto pos = get_rand_coord_in_range(tx, ty, 5 + i);
+			auto pos = get_rand_coord_in_range(tx, ty, 5 + i, 0, rng);
 			if(!map.tile_valid(pos.x, pos.y) || !map.get_tile(pos.x, pos.y).is_passable())
 				continue;
 			
@@ -961,6 +1140,7 @@ rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& bio
 		i++;
 	}
 	map.players = i;
+	end_stage(RMG_STAGE_OBJECTS);
 
 	return RMG_RESULT_OK;
 }
@@ -37,6 +37,37 @@ enum rmg_result_e {
 	RMG_RESULT_ERROR
 };
 
+//the stages of generate_random_map(), in the order they run
+enum rmg_stage_e {
+	RMG_STAGE_TERRAIN, //biome terrain and zones
+	RMG_STAGE_FLOOD_FILL, //biome flood fills and the bleeding fixup
+	RMG_STAGE_TOWNS, //towns, their basic mines and the roads to them
+	RMG_STAGE_ROADS, //guarded roads between zones
+	RMG_STAGE_OBJECTS, //biome objects and their guards, resources, treasure
+	RMG_STAGE_DOODADS, //obstacle tiles, mountains and trees
+	RMG_STAGE_COUNT
+};
+
+//everything random map generation draws from. every random choice comes from rng, so a map depends only on its biomes
+//and the seed, and maps generated with contexts of their own can be generated on several threads at once
+struct rmg_context_t {
+	rmg_context_t(uint32_t map_seed, uint terrain_thread_count = 0) : seed(map_seed), rng(map_seed), thread_count(terrain_thread_count) {}
+
+	uint32_t seed = 0; //also seeds the terrain noise
+	std::mt19937_64 rng;
+	uint thread_count = 0; //for the terrain pass, 0 for std::thread::hardware_concurrency()
+	std::array<int64_t, RMG_STAGE_COUNT> stage_microseconds = {}; //added to by each generate_random_map()
+};
+
 bool add_object_to_map(interactable_object_t* object, adventure_map_t& map);
 bool add_object_to_map(interactable_object_t* object, adventure_map_t& map, QBitArray& obstacles);
-rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& biomes, int64_t map_seed = -1);
+//checked once the object is on the map: a hero must be able to step onto every tile it interacts with. for most
+//objects that is does_object_fit_at_location()'s rule, a passable tile below; pickups, which it doesn't check, only
+//need a passable tile next to them
+bool is_object_accessible(const adventure_map_t& map, const interactable_object_t* object);
+rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& biomes, rmg_context_t& context);
+//with a context seeded from map_seed, or from std::random_device if it is -1
+rmg_result_e generate_random_map(adventure_map_t& map, std::vector<biome_t>& biomes, int64_t map_seed = -1, uint thread_count = 0);
+//four player zones in the corners of a size x size map around a neutral center connected to all of them; the layout
+//rmg_harness validates and the generator tests run on
+std::vector<biome_t> make_four_player_biomes(int size);
@@ -0,0 +1,454 @@
+#include "core/save_checkpoint.h"
+
+#include "core/block_compression.h"
+#include "core/game.h"
+
+namespace {
+//differing bytes closer together than this are written as one run
+const qsizetype RUN_MERGE_GAP = 8;
+
+struct byte_run_t {
+	uint32_t offset = 0;
+	uint32_t size = 0;
+};
+
+QByteArray write_hero_record(const hero_t& hero) {
+	QBuffer buffer;
+	buffer.open(QIODevice::WriteOnly);
+	QDataStream hero_stream(&buffer);
+	hero_stream << hero;
+	return buffer.data();
+}
+
+//the runs where two records of the same size differ
+std::vector<byte_run_t> get_changed_runs(const QByteArray& before, const QByteArray& after) {
+	std::vector<byte_run_t> runs;
+	for(qsizetype i = 0; i < after.size(); i++) {
+		if(before[i] == after[i])
+			continue;
+
+		if(!runs.empty() && i - (qsizetype)(runs.back().offset + runs.back().size) < RUN_MERGE_GAP)
+			runs.back().size = (uint32_t)(i + 1 - runs.back().offset);
+		else
+			runs.push_back({ (uint32_t)i, 1 });
+	}
+
+	return runs;
+}
+
+//a record that changed: only the runs that differ when it kept its size (a visit, a new owner, a quantity taken, a hero
+//moving), otherwise the whole record
+void write_changed_record(QDataStream& stream, const QByteArray* previous, const QByteArray& record) {
+	bool patch = previous && previous->size() == record.size();
+	stream << (uint8_t)patch;
+	if(!patch) {
+		stream << record;
+		return;
+	}
+
+	auto runs = get_changed_runs(*previous, record);
+	stream << (uint16_t)runs.size();
+	for(const auto& run : runs)
+		stream << run.offset << record.mid(run.offset, run.size);
+}
+
+//record holds the previous version, which can_patch says is the one the change was taken against
+map_error_e read_changed_record(QDataStream& stream, QByteArray& record, bool can_patch) {
+	uint8_t patch = 0;
+	stream >> patch;
+	if(!patch) {
+		stream >> record;
+		return SUCCESS;
+	}
+
+	if(!can_patch)
+		return MAP_SAVE_POINT_INVALID;
+
+	uint16_t run_count = 0;
+	stream >> run_count;
+	for(int run = 0; run < run_count; run++) {
+		uint32_t offset = 0;
+		QByteArray bytes;
+		stream >> offset >> bytes;
+		if(offset > record.size() || bytes.size() > record.size() - offset)
+			return MAP_SAVE_POINT_INVALID;
+
+		record.replace(offset, bytes.size(), bytes);
+	}
+
+	return SUCCESS;
+}
+
+void write_keyframe(QDataStream& stream, const save_state_t& state) {
+	stream << (uint16_t)state.heroes.size();
+	for(const auto& [id, record] : state.heroes)
+		stream << id << record;
+
+	stream << (uint32_t)state.objects.size();
+	for(const auto& object : state.objects)
+		stream << object.type << object.record;
+
+	stream << (uint8_t)state.visibility.size();
+	for(const auto& visibility : state.visibility)
+		stream << visibility;
+}
+
+void write_delta(QDataStream& stream, const save_state_t& state, const save_state_t& previous) {
+	std::vector<uint16_t> changed_heroes;
+	std::vector<uint16_t> removed_heroes;
+	for(const auto& [id, record] : state.heroes) {
+		auto previous_hero = previous.heroes.find(id);
+		if(previous_hero == previous.heroes.end() || previous_hero->second != record)
+			changed_heroes.push_back(id);
+	}
+	for(const auto& previous_hero : previous.heroes) {
+		if(!state.heroes.count(previous_hero.first))
+			removed_heroes.push_back(previous_hero.first);
+	}
+
+	stream << (uint16_t)changed_heroes.size();
+	for(auto id : changed_heroes) {
+		auto previous_hero = previous.heroes.find(id);
+		stream << id;
+		write_changed_record(stream, previous_hero != previous.heroes.end() ? &previous_hero->second : nullptr, state.heroes.at(id));
+	}
+
+	stream << (uint16_t)removed_heroes.size();
+	for(auto id : removed_heroes)
+		stream << id;
+
+	std::vector<uint32_t> changed_objects;
+	for(size_t i = 0; i < state.objects.size(); i++) {
+		if(i >= previous.objects.size() || !(state.objects[i] == previous.objects[i]))
+			changed_objects.push_back((uint32_t)i);
+	}
+
+	stream << (uint32_t)state.objects.size() << (uint32_t)changed_objects.size();
+	for(auto i : changed_objects) {
+		const auto& object = state.objects[i];
+		stream << i << object.type;
+		bool same_type = i < previous.objects.size() && previous.objects[i].type == object.type;
+		write_changed_record(stream, same_type ? &previous.objects[i].record : nullptr, object.record);
+	}
+
+	stream << (uint8_t)state.visibility.size();
+	for(size_t player = 0; player < state.visibility.size(); player++) {
+		const auto& bits = state.visibility[player];
+		bool patch = player < previous.visibility.size() && previous.visibility[player].size() == bits.size();
+		stream << (uint8_t)patch;
+		if(!patch) {
+			stream << bits;
+			continue;
+		}
+
+		const auto& previous_words = previous.visibility[player].words;
+		std::vector<uint32_t> changed_words;
+		for(size_t word = 0; word < bits.words.size(); word++) {
+			if(bits.words[word] != previous_words[word])
+				changed_words.push_back((uint32_t)word);
+		}
+
+		stream << (uint32_t)changed_words.size();
+		for(auto word : changed_words)
+			stream << word << (quint64)(bits.words[word] ^ previous_words[word]);
+	}
+}
+
+map_error_e read_keyframe(QDataStream& stream, save_state_t& state) {
+	uint16_t hero_count = 0;
+	stream >> hero_count;
+	if(hero_count > MAXIMUM_HERO_COUNT)
+		return MAP_TOO_MANY_HEROES;
+
+	state.heroes.clear();
+	for(int i = 0; i < hero_count; i++) {
+		uint16_t id = 0;
+		stream >> id;
+		stream >> state.heroes[id];
+	}
+
+	uint32_t object_count = 0;
+	stream >> object_count;
+	if(object_count > MAXIMUM_OBJECTS_COUNT)
+		return MAP_TOO_MANY_OBJECTS;
+
+	state.objects.resize(object_count);
+	for(auto& object : state.objects)
+		stream >> object.type >> object.record;
+
+	uint8_t player_count = 0;
+	stream >> player_count;
+	state.visibility.resize(player_count);
+	for(auto& visibility : state.visibility)
+		stream >> visibility;
+
+	return stream.status() == QDataStream::Ok ? SUCCESS : MAP_SAVE_POINT_INVALID;
+}
+
+map_error_e read_delta(QDataStream& stream, save_state_t& state) {
+	uint16_t changed_heroes = 0;
+	stream >> changed_heroes;
+	if(changed_heroes > MAXIMUM_HERO_COUNT)
+		return MAP_TOO_MANY_HEROES;
+
+	for(int i = 0; i < changed_heroes; i++) {
+		uint16_t id = 0;
+		stream >> id;
+		bool known = state.heroes.count(id) != 0;
+		auto err = read_changed_record(stream, state.heroes[id], known);
+		if(err != SUCCESS)
+			return err;
+	}
+
+	uint16_t removed_heroes = 0;
+	stream >> removed_heroes;
+	for(int i = 0; i < removed_heroes; i++) {
+		uint16_t id = 0;
+		stream >> id;
+		state.heroes.erase(id);
+	}
+
+	uint32_t object_count = 0;
+	uint32_t changed_objects = 0;
+	stream >> object_count >> changed_objects;
+	if(object_count > MAXIMUM_OBJECTS_COUNT)
+		return MAP_TOO_MANY_OBJECTS;
+	if(changed_objects > object_count)
+		return MAP_SAVE_POINT_INVALID;
+
+	state.objects.resize(object_count);
+	for(uint32_t n = 0; n < changed_objects; n++) {
+		uint32_t i = 0;
+		interactable_object_e type = OBJECT_UNKNOWN;
+		stream >> i >> type;
+		if(i >= object_count)
+			return MAP_SAVE_POINT_INVALID;
+
+		auto& object = state.objects[i];
+		bool same_type = object.type == type;
+		object.type = type;
+		auto err = read_changed_record(stream, object.record, same_type);
+		if(err != SUCCESS)
+			return err;
+	}
+
+	uint8_t player_count = 0;
+	stream >> player_count;
+	state.visibility.resize(player_count);
+	for(auto& bits : state.visibility) {
+		uint8_t patch = 0;
+		stream >> patch;
+		if(!patch) {
+			stream >> bits;
+			continue;
+		}
+
+		uint32_t changed_words = 0;
+		stream >> changed_words;
+		if(changed_words > bits.words.size())
+			return MAP_SAVE_POINT_INVALID;
+
+		for(uint32_t n = 0; n < changed_words; n++) {
+			uint32_t word = 0;
+			quint64 changed_bits = 0;
+			stream >> word >> changed_bits;
+			if(word >= bits.words.size())
+				return MAP_SAVE_POINT_INVALID;
+
+			bits.words[word] ^= changed_bits;
+		}
+	}
+
+	return stream.status() == QDataStream::Ok ? SUCCESS : MAP_SAVE_POINT_INVALID;
+}
+
+//a whole point as written before deltas: the date (already read), heroes streamed directly, then length-prefixed
+//object records and the visibility maps
+map_error_e read_legacy_point(QDataStream& stream, uint16_t date, save_state_t& state) {
+	state.date = date;
+
+	uint16_t hero_count = 0;
+	stream >> hero_count;
+	if(hero_count > MAXIMUM_HERO_COUNT)
+		return MAP_TOO_MANY_HEROES;
+
+	state.heroes.clear();
+	for(int i = 0; i < hero_count; i++) {
+		hero_t hero;
+		stream >> hero;
+		state.heroes[hero.id] = write_hero_record(hero);
+	}
+
+	uint32_t object_count = 0;
+	stream >> object_count;
+	if(object_count > MAXIMUM_OBJECTS_COUNT)
+		return MAP_TOO_MANY_OBJECTS;
+
+	state.objects.assign(object_count, {});
+	for(auto& object : state.objects) {
+		stream >> object.type;
+		if(object.type == OBJECT_UNKNOWN)
+			continue;
+
+		uint16_t object_size = 0;
+		stream >> object_size;
+		object.record.resize(object_size);
+		stream.readRawData(object.record.data(), object_size);
+	}
+
+	uint8_t player_count = 0;
+	stream >> player_count;
+	state.visibility.resize(player_count);
+	for(auto& visibility : state.visibility)
+		stream >> visibility;
+
+	return stream.status() == QDataStream::Ok ? SUCCESS : MAP_SAVE_POINT_INVALID;
+}
+}
+
+save_state_t capture_save_state(const game_t& game) {
+	save_state_t state;
+	state.date = game.date;
+
+	for(const auto& hero_pair : game.map.heroes)
+		state.heroes[hero_pair.second.id] = write_hero_record(hero_pair.second);
+
+	state.objects.resize(game.map.objects.size());
+	for(size_t i = 0; i < game.map.objects.size(); i++) {
+		if(auto obj = game.map.objects[i])
+			state.objects[i] = { obj->object_type, write_map_object_record(obj) };
+	}
+
+	state.visibility.reserve(game.players.size());
+	for(const auto& player : game.players)
+		state.visibility.push_back(player.tile_visibility);
+
+	return state;
+}
+
+map_error_e make_save_checkpoint(const save_state_t& state, save_checkpoint_t& checkpoint, uint thread_count) {
+	checkpoint.date = state.date;
+	checkpoint.visibility_map = state.visibility;
+
+	std::vector<map_file_record_t> object_records(state.objects.size());
+	for(size_t i = 0; i < state.objects.size(); i++) {
+		const auto& object = state.objects[i];
+		object_records[i] = { (uint16_t)object.type, object.record.constData(), (uint32_t)object.record.size() };
+	}
+
+	std::vector<map_file_record_t> hero_records;
+	hero_records.reserve(state.heroes.size());
+	for(const auto& hero : state.heroes)
+		hero_records.push_back({ 0, hero.second.constData(), (uint32_t)hero.second.size() });
+
+	auto err = decode_map_object_records(object_records, checkpoint.objects, thread_count);
+	auto hero_err = decode_map_hero_records(hero_records, checkpoint.heroes, thread_count);
+	return err != SUCCESS ? err : hero_err;
+}
+
+void write_save_point(QDataStream& stream, const save_state_t& state, const save_state_t* previous, bool compressed) {
+	QBuffer buffer;
+	buffer.open(QIODevice::WriteOnly);
+	QDataStream point_stream(&buffer);
+
+	point_stream << state.date;
+	if(previous)
+		write_delta(point_stream, state, *previous);
+	else
+		write_keyframe(point_stream, state);
+
+	uint8_t type = previous ? SAVE_POINT_DELTA : SAVE_POINT_KEYFRAME;
+	QByteArray point_data = buffer.data();
+	if(compressed) {
+		point_data = block_compress(point_data);
+		type |= SAVE_POINT_COMPRESSED;
+	}
+
+	//size-prefixed so that read_save_point_at() can step over points without decoding them
+	stream << SAVE_POINT_MARKER << type << (uint32_t)point_data.size();
+	stream.writeRawData(point_data.constData(), point_data.size());
+}
+
+map_error_e read_save_point(QDataStream& stream, save_state_t& state) {
+	uint16_t marker = 0;
+	stream >> marker;
+	if(stream.status() != QDataStream::Ok)
+		return MAP_SAVE_POINT_INVALID;
+
+	if(marker != SAVE_POINT_MARKER)
+		return read_legacy_point(stream, marker, state);
+
+	uint8_t type = 0;
+	uint32_t size = 0;
+	stream >> type >> size;
+
+	QByteArray point_data(size, Qt::Uninitialized);
+	if(stream.readRawData(point_data.data(), size) != (int)size)
+		return MAP_SAVE_POINT_INVALID;
+
+	if(type & SAVE_POINT_COMPRESSED) {
+		QByteArray compressed = point_data;
+		if(!block_uncompress(compressed, point_data))
+			return MAP_COMPRESSED_DATA_INVALID;
+		type &= ~SAVE_POINT_COMPRESSED;
+	}
+
+	QDataStream point_stream(point_data);
+	point_stream >> state.date;
+	if(type == SAVE_POINT_KEYFRAME)
+		return read_keyframe(point_stream, state);
+	if(type == SAVE_POINT_DELTA)
+		return read_delta(point_stream, state);
+
+	return MAP_SAVE_POINT_INVALID;
+}
+
+map_error_e read_save_point_at(QDataStream& stream, uint16_t point_count, uint16_t index, save_state_t& state) {
+	auto device = stream.device();
+	if(!device || device->isSequential() || index >= point_count)
+		return MAP_SAVE_POINT_INVALID;
+
+	//find where each point up to index starts, and which of them are keyframes
+	std::vector<qint64> offsets;
+	std::vector<bool> keyframes;
+	for(int i = 0; i <= index; i++) {
+		offsets.push_back(device->pos());
+
+		uint16_t marker = 0;
+		stream >> marker;
+		if(marker != SAVE_POINT_MARKER) {
+			//points written before deltas are whole, but the only way past one is to read it
+			save_state_t skipped;
+			auto err = read_legacy_point(stream, marker, skipped);
+			if(err != SUCCESS)
+				return err;
+
+			keyframes.push_back(true);
+			continue;
+		}
+
+		uint8_t type = 0;
+		uint32_t size = 0;
+		stream >> type >> size;
+		if(stream.status() != QDataStream::Ok || stream.skipRawData(size) != (int)size)
+			return MAP_SAVE_POINT_INVALID;
+
+		keyframes.push_back((type & ~SAVE_POINT_COMPRESSED) == SAVE_POINT_KEYFRAME);
+	}
+
+	int first = index;
+	while(first > 0 && !keyframes[first])
+		first--;
+
+	if(!keyframes[first] || !device->seek(offsets[first]))
+		return MAP_SAVE_POINT_INVALID;
+
+	state = {};
+	for(int i = first; i <= index; i++) {
+		auto err = read_save_point(stream, state);
+		if(err != SUCCESS)
+			return err;
+	}
+
+	return SUCCESS;
+}
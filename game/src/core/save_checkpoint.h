@@ -0,0 +1,66 @@
+#pragma once
+
+#include "core/fog_of_war.h"
+#include "core/map_file.h"
+#include "core/qt_headers.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+struct game_t;
+struct save_checkpoint_t;
+
+//save points appended by game_t::save_game after the base snapshot (the game info and map written when the save is
+//created). a keyframe holds every hero, object and visibility map; a delta holds what changed since the point before
+//it: heroes that changed or were removed, the byte runs of object records that changed and the visibility words that
+//changed. a save point is a keyframe when it is the first one a game_t writes to the file or SAVE_KEYFRAME_INTERVAL
+//points have passed since the last, which bounds how many deltas rebuilding any one point replays
+const uint16_t SAVE_POINT_MARKER = 0xFFFF; //points written before deltas start with their date, which is never this
+const int SAVE_KEYFRAME_INTERVAL = 16;
+
+enum save_point_type_e : uint8_t {
+	SAVE_POINT_KEYFRAME = 0,
+	SAVE_POINT_DELTA,
+	SAVE_POINT_COMPRESSED = 0x80 //flag: the point's body is a block_compress() segment
+};
+
+//a save point with heroes and objects kept in their serialized form, which is what deltas are taken against
+struct save_state_t {
+	struct object_t {
+		interactable_object_e type = OBJECT_UNKNOWN; //OBJECT_UNKNOWN for removed objects
+		QByteArray record; //write_map_object_record()
+		bool operator==(const object_t& other) const = default;
+	};
+
+	uint16_t date = 0;
+	std::map<uint16_t, QByteArray> heroes; //by hero id
+	std::vector<object_t> objects;
+	std::vector<tile_bitset_t> visibility; //per player
+};
+
+//what game_t last appended to a save, so that the next point can be written as a delta against it
+struct save_point_cache_t {
+	std::string filename;
+	uint16_t save_points = 0; //the save's point count after that point
+	qint64 file_size = -1;
+	int deltas_since_keyframe = 0;
+	save_state_t state;
+
+	bool is_valid_for(const std::string& save_filename, uint16_t save_point_count, qint64 save_file_size) const {
+		return filename == save_filename && save_points == save_point_count && file_size == save_file_size;
+	}
+};
+
+save_state_t capture_save_state(const game_t& game);
+//decodes the state's heroes and objects, see decode_map_object_records()
+map_error_e make_save_checkpoint(const save_state_t& state, save_checkpoint_t& checkpoint, uint thread_count = 0);
+
+//previous null writes a keyframe
+void write_save_point(QDataStream& stream, const save_state_t& state, const save_state_t* previous, bool compressed = false);
+//reads the next point; deltas are applied to state, which must hold the point before
+map_error_e read_save_point(QDataStream& stream, save_state_t& state);
+//rebuilds point index of point_count without reading the deltas before its keyframe. the stream must be at the first
+//save point and its device seekable
+map_error_e read_save_point_at(QDataStream& stream, uint16_t point_count, uint16_t index, save_state_t& state);
@@ -0,0 +1,132 @@
+#include "core/save_worker.h"
+
+#include "core/block_compression.h"
+#include "core/game.h"
+
+uint write_save_snapshot(const save_game_snapshot_t& snapshot, save_point_cache_t& cache) {
+	QFile file(QString::fromStdString(snapshot.filename));
+	
+	//first we check to see if an existing save game with this name exists
+	if(file.exists()) {
+
+		if(!file.open(QIODevice::ReadWrite))
+			return 1;//MAP_COULD_NOT_OPEN_FILE;
+
+
+		QDataStream stream(&file);
+
+		save_game_header_t header;
+		auto result = game_t::read_save_game_header_stream(stream, header);
+		if(result != 0)
+			return -2;
+
+		//update the header info
+		header.save_points++;
+		header.total_days = snapshot.date + 1;
+		header.last_save_time = QDateTime::currentDateTime();
+		
+		//seek back to the start of the file, then write the updated header
+		if(!file.seek(0))
+			return 1;
+		game_t::write_save_game_header_stream(stream, header);
+
+		//append the save point, as a delta against the last one written if that is still the end of the file
+		if(!file.seek(file.size()))
+			return 1;
+
+		bool keyframe = !cache.is_valid_for(snapshot.filename, header.save_points - 1, file.size())
+			|| cache.deltas_since_keyframe + 1 >= SAVE_KEYFRAME_INTERVAL;
+		write_save_point(stream, snapshot.state, keyframe ? nullptr : &cache.state, snapshot.compressed);
+		
+		cache.filename = snapshot.filename;
+		cache.save_points = header.save_points;
+		cache.file_size = file.size();
+		cache.deltas_since_keyframe = keyframe ? 0 : cache.deltas_since_keyframe + 1;
+		cache.state = snapshot.state;
+		
+		file.close();
+		return 0;
+	}
+	
+	//if we get here, we need to create a new save game file
+	if(snapshot.base.isEmpty() || !file.open(QIODevice::WriteOnly))
+		return 1;//MAP_COULD_NOT_OPEN_FILE;
+	
+	QDataStream stream(&file);
+	
+	save_game_header_t header;
+	header.map_name = snapshot.map_name;
+	header.save_name = "my save";
+	header.started_date = QDateTime::currentDateTime();
+	header.last_save_time = QDateTime::currentDateTime();
+	header.save_points = 0;
+	header.total_days = snapshot.date + 1;
+	
+	game_t::write_save_game_header_stream(stream, header);
+	if(snapshot.compressed) {
+		block_compressor_t compressor(&file);
+		compressor.write(snapshot.base);
+		if(!compressor.finish())
+			return 1;
+	}
+	else {
+		stream.writeRawData(snapshot.base.constData(), snapshot.base.size());
+	}
+	
+	return 0; //SUCCESS
+}
+
+save_worker_t::~save_worker_t() {
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+
+	if(thread.joinable())
+		thread.join();
+}
+
+void save_worker_t::queue(save_game_snapshot_t snapshot, completion_fn_t completion_fn) {
+	{
+		std::lock_guard lock(mutex);
+		jobs.push_back({ std::move(snapshot), std::move(completion_fn) });
+		if(!thread.joinable())
+			thread = std::thread(&save_worker_t::run, this);
+	}
+	wake.notify_one();
+}
+
+void save_worker_t::wait() {
+	std::unique_lock lock(mutex);
+	idle.wait(lock, [this]() { return jobs.empty() && !busy; });
+}
+
+size_t save_worker_t::get_pending_count() {
+	std::lock_guard lock(mutex);
+	return jobs.size() + (busy ? 1 : 0);
+}
+
+void save_worker_t::run() {
+	std::unique_lock lock(mutex);
+	while(true) {
+		wake.wait(lock, [this]() { return stopping || !jobs.empty(); });
+		//saves still queued when the worker is destroyed are written before it stops
+		if(jobs.empty())
+			return;
+
+		auto job = std::move(jobs.front());
+		jobs.pop_front();
+		busy = true;
+		lock.unlock();
+
+		auto result = write_save_snapshot(job.snapshot, cache);
+		if(job.completion_fn)
+			job.completion_fn(job.snapshot.filename, result);
+
+		lock.lock();
+		busy = false;
+		if(jobs.empty())
+			idle.notify_all();
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "core/save_checkpoint.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+//what game_t::save_game writes, captured from the game in one pass so that the game can carry on while it is written
+struct save_game_snapshot_t {
+	std::string filename;
+	std::string map_name;
+	uint16_t date = 0;
+	bool compressed = false; //see game_t::compress_saves
+	QByteArray base; //game info and map, only captured when the save file does not exist yet
+	save_state_t state;
+};
+
+//writes snapshot to its file as game_t::save_game always has: a new save gets a header and the base snapshot, an
+//existing one gets a save point appended (see save_checkpoint.h). returns 0 on success
+uint write_save_snapshot(const save_game_snapshot_t& snapshot, save_point_cache_t& cache);
+
+//writes queued snapshots on a thread of its own, one at a time and in order, so that saves to one file can be deltas
+//against each other. the thread starts with the first save and is joined, after writing what is still queued, when
+//the worker is destroyed
+struct save_worker_t {
+	using completion_fn_t = std::function<void(const std::string& filename, uint result)>;
+
+	save_worker_t() = default;
+	save_worker_t(const save_worker_t&) = delete;
+	save_worker_t& operator=(const save_worker_t&) = delete;
+	~save_worker_t();
+
+	//completion_fn, if given, is called on the worker thread with write_save_snapshot()'s result
+	void queue(save_game_snapshot_t snapshot, completion_fn_t completion_fn = nullptr);
+	//blocks until everything queued so far is written
+	void wait();
+	size_t get_pending_count();
+
+private:
+	struct job_t {
+		save_game_snapshot_t snapshot;
+		completion_fn_t completion_fn;
+	};
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable idle;
+	std::deque<job_t> jobs;
+	bool busy = false;
+	bool stopping = false;
+	std::thread thread;
+	save_point_cache_t cache; //only touched by the worker thread
+
+	void run();
+};
@@ -0,0 +1,27 @@
+#include "core/tile_store.h"
+
+#include <algorithm>
+
+void tile_store_t::reset(int map_width, int map_height, const map_tile_t& tile) {
+	width = std::max(map_width, 0);
+	height = std::max(map_height, 0);
+	chunk_columns = (width + CHUNK_MASK) >> CHUNK_SHIFT;
+	chunk_rows = (height + CHUNK_MASK) >> CHUNK_SHIFT;
+
+	const size_t count = ((size_t)chunk_columns * chunk_rows) << (2 * CHUNK_SHIFT);
+	asset_id.assign(count, tile.asset_id);
+	terrain_type.assign(count, tile.terrain_type);
+	road_type.assign(count, tile.road_type);
+	passability.assign(count, tile.passability);
+	zone_id.assign(count, tile.zone_id);
+	interactable_object.assign(count, tile.interactable_object);
+}
+
+void tile_store_t::fill(const map_tile_t& tile) {
+	std::fill(asset_id.begin(), asset_id.end(), tile.asset_id);
+	std::fill(terrain_type.begin(), terrain_type.end(), tile.terrain_type);
+	std::fill(road_type.begin(), road_type.end(), tile.road_type);
+	std::fill(passability.begin(), passability.end(), tile.passability);
+	std::fill(zone_id.begin(), zone_id.end(), tile.zone_id);
+	std::fill(interactable_object.begin(), interactable_object.end(), tile.interactable_object);
+}
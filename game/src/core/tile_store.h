@@ -0,0 +1,119 @@
+#pragma once
+
+#include "core/interactable_object.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum terrain_type_e : uint8_t {
+	TERRAIN_UNKNOWN = 0,
+	TERRAIN_WATER,
+	TERRAIN_GRASS,
+	TERRAIN_DIRT,
+	TERRAIN_WASTELAND,
+	TERRAIN_LAVA,
+	TERRAIN_DESERT,
+	TERRAIN_BEACH,
+	TERRAIN_SNOW,
+	TERRAIN_SWAMP,
+	TERRAIN_JUNGLE
+};
+
+enum road_type_e : uint8_t {
+	ROAD_NONE = 0,
+	ROAD_DIRT,
+	ROAD_GRAVEL,
+	ROAD_COBBLESTONE
+};
+
+struct map_tile_t {
+	asset_id_t asset_id = 0;
+	terrain_type_e terrain_type = TERRAIN_UNKNOWN;
+	road_type_e road_type = ROAD_NONE;
+	uint8_t passability = 1;
+	int8_t zone_id = -1;
+	uint16_t interactable_object = 0;
+	const std::string get_name() const;
+	bool is_interactable() const { return interactable_object != 0; }
+	bool is_passable() const { return passability == 1; }
+};
+
+//one tile of a tile_store_t, with every field referring into the store's columns: reads and writes through it act on
+//the map. copies refer to the same tile, so it is only handed out by the *_ref accessors, never by get/get_tile
+struct map_tile_ref_t {
+	asset_id_t& asset_id;
+	terrain_type_e& terrain_type;
+	road_type_e& road_type;
+	uint8_t& passability;
+	int8_t& zone_id;
+	uint16_t& interactable_object;
+
+	map_tile_ref_t& operator=(const map_tile_t& tile) {
+		asset_id = tile.asset_id;
+		terrain_type = tile.terrain_type;
+		road_type = tile.road_type;
+		passability = tile.passability;
+		zone_id = tile.zone_id;
+		interactable_object = tile.interactable_object;
+		return *this;
+	}
+	map_tile_ref_t& operator=(const map_tile_ref_t& tile) { return *this = (map_tile_t)tile; }
+	operator map_tile_t() const { return { asset_id, terrain_type, road_type, passability, zone_id, interactable_object }; }
+
+	const std::string get_name() const { return map_tile_t(*this).get_name(); }
+	bool is_interactable() const { return interactable_object != 0; }
+	bool is_passable() const { return passability == 1; }
+};
+
+//adventure map tiles stored a column per field, so that loops reading one or two fields (routing, fog, map
+//generation) only pull those through the cache. the columns are laid out in CHUNK_SIZE x CHUNK_SIZE chunks, row by
+//row within a chunk and chunk by chunk across the map, which keeps a tile's neighbours close in memory; edge chunks are
+//padded. offsets handed out by the rest of the code stay row-major (x + y * width), index() maps between the two
+struct tile_store_t {
+	static constexpr int CHUNK_SHIFT = 5;
+	static constexpr int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+	static constexpr int CHUNK_MASK = CHUNK_SIZE - 1;
+
+	int width = 0;
+	int height = 0;
+	int chunk_columns = 0;
+	int chunk_rows = 0;
+
+	std::vector<asset_id_t> asset_id;
+	std::vector<terrain_type_e> terrain_type;
+	std::vector<road_type_e> road_type;
+	std::vector<uint8_t> passability;
+	std::vector<int8_t> zone_id;
+	std::vector<uint16_t> interactable_object; //object id + 1, 0 for none
+
+	//resizes to map_width x map_height and sets every tile to tile
+	void reset(int map_width, int map_height, const map_tile_t& tile = {});
+	void fill(const map_tile_t& tile);
+	void clear() { reset(0, 0); }
+	size_t size() const { return (size_t)width * height; }
+	bool empty() const { return !width || !height; }
+
+	size_t index(int x, int y) const {
+		size_t chunk = (size_t)(x >> CHUNK_SHIFT) + ((size_t)(y >> CHUNK_SHIFT) * chunk_columns);
+		return (chunk << (2 * CHUNK_SHIFT)) + (x & CHUNK_MASK) + ((y & CHUNK_MASK) << CHUNK_SHIFT);
+	}
+
+	map_tile_ref_t get_ref(int x, int y) {
+		size_t i = index(x, y);
+		return { asset_id[i], terrain_type[i], road_type[i], passability[i], zone_id[i], interactable_object[i] };
+	}
+	map_tile_t get(int x, int y) const {
+		size_t i = index(x, y);
+		return { asset_id[i], terrain_type[i], road_type[i], passability[i], zone_id[i], interactable_object[i] };
+	}
+	//by row-major offset
+	map_tile_ref_t get_ref(size_t offset) { return get_ref(offset % width, offset / width); }
+	map_tile_t operator[](size_t offset) const { return get(offset % width, offset / width); }
+
+	terrain_type_e get_terrain_type(int x, int y) const { return terrain_type[index(x, y)]; }
+	road_type_e get_road_type(int x, int y) const { return road_type[index(x, y)]; }
+	uint8_t get_passability(int x, int y) const { return passability[index(x, y)]; }
+	int8_t get_zone_id(int x, int y) const { return zone_id[index(x, y)]; }
+	uint16_t get_interactable_object(int x, int y) const { return interactable_object[index(x, y)]; }
+};
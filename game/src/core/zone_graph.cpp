@@ -0,0 +1,495 @@
+#include "core/zone_graph.h"
+#include "core/adventure_map.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+const int dx[] = { 1, 0, -1, 0, 1, 1, -1, -1 };
+const int dy[] = { 0, 1, 0, -1, 1, -1, 1, -1 };
+
+//same step cost as adventure_map_t::find_route, without the hero's terrain/pathfinding modifiers
+int get_step_cost(const adventure_map_t& map, int x, int y, bool diagonal) {
+	return (int)(map.get_terrain_movement_base_cost(nullptr, x, y) * (diagonal ? 14.f : 10.f));
+}
+
+bool is_water(const adventure_map_t& map, int tile) {
+	return map.tiles.get_terrain_type(tile % map.width, tile / map.width) == TERRAIN_WATER;
+}
+
+//dijkstra over a flat width*height array; touched remembers what to reset so the scratch can be reused
+struct zone_search_t {
+	std::vector<int> cost;
+	std::vector<int> came_from;
+	std::vector<int> touched;
+	std::vector<std::pair<int, int>> open_set;
+
+	void begin(size_t tile_count) {
+		if(cost.size() != tile_count) {
+			cost.assign(tile_count, -1);
+			came_from.assign(tile_count, -1);
+			touched.clear();
+		}
+
+		for(auto tile : touched) {
+			cost[tile] = -1;
+			came_from[tile] = -1;
+		}
+
+		touched.clear();
+		open_set.clear();
+	}
+
+	void push(int tile, int tile_cost, int parent) {
+		if(cost[tile] != -1 && cost[tile] <= tile_cost)
+			return;
+
+		if(cost[tile] == -1)
+			touched.push_back(tile);
+
+		cost[tile] = tile_cost;
+		came_from[tile] = parent;
+		open_set.push_back({tile_cost, tile});
+		std::push_heap(open_set.begin(), open_set.end(), std::greater<std::pair<int, int>>());
+	}
+
+	//returns -1 once the open set is empty
+	int pop() {
+		while(!open_set.empty()) {
+			std::pop_heap(open_set.begin(), open_set.end(), std::greater<std::pair<int, int>>());
+			auto entry = open_set.back();
+			open_set.pop_back();
+			if(entry.first == cost[entry.second])
+				return entry.second;
+		}
+
+		return -1;
+	}
+};
+}
+
+void zone_graph_t::mark_tile_dirty(int x, int y) {
+	if(width == 0 || height == 0)
+		return;
+
+	//a monster guards the tiles around it, so the neighbourhood's walkability can change too
+	for(int j = y - 1; j <= y + 1; j++) {
+		for(int i = x - 1; i <= x + 1; i++) {
+			if(i < 0 || j < 0 || i >= width || j >= height)
+				continue;
+
+			int tile = i + (j * width);
+			auto& cluster = clusters[tile_cluster[tile]];
+			cluster.dirty = true;
+			cluster.border_dirty = true;
+			dirty_tiles.push_back(tile);
+		}
+	}
+
+	portals_dirty = true;
+}
+
+bool zone_graph_t::is_walkable(const adventure_map_t& map, int x, int y) const {
+	const auto tile = map.get_tile(x, y);
+	return tile.passability && tile.terrain_type != TERRAIN_UNKNOWN && !tile.is_interactable()
+		   && map.get_hero_id_at_tile(x, y) == -1 && !map.is_tile_guarded_by_monster(x, y);
+}
+
+void zone_graph_t::rebuild_tiles(const adventure_map_t& map) {
+	width = map.width;
+	height = map.height;
+	const size_t tile_count = (size_t)width * height;
+
+	int cluster_for_zone[256];
+	std::fill(std::begin(cluster_for_zone), std::end(cluster_for_zone), -1);
+
+	clusters.clear();
+	tile_cluster.assign(tile_count, 0);
+	for(int y = 0; y < height; y++) {
+		for(int x = 0; x < width; x++) {
+			int8_t zone_id = map.tiles.get_zone_id(x, y);
+			int& cluster = cluster_for_zone[(uint8_t)zone_id];
+			if(cluster == -1) {
+				cluster = (int)clusters.size();
+				clusters.emplace_back();
+				clusters.back().zone_id = zone_id;
+			}
+
+			tile_cluster[x + (y * width)] = (int16_t)cluster;
+		}
+	}
+
+	//zone ids don't change after generation, so borders and neighbours are found once
+	walkable.assign(tile_count, 0);
+	for(int y = 0; y < height; y++) {
+		for(int x = 0; x < width; x++) {
+			int tile = x + (y * width);
+			walkable[tile] = is_walkable(map, x, y);
+
+			auto& cluster = clusters[tile_cluster[tile]];
+			bool border = false;
+			for(int i = 0; i < 8; i++) {
+				int nx = x + dx[i];
+				int ny = y + dy[i];
+				if(nx < 0 || ny < 0 || nx >= width || ny >= height)
+					continue;
+
+				int other = tile_cluster[nx + (ny * width)];
+				if(other == tile_cluster[tile])
+					continue;
+
+				border = true;
+				if(std::find(cluster.neighbours.begin(), cluster.neighbours.end(), other) == cluster.neighbours.end())
+					cluster.neighbours.push_back(other);
+			}
+
+			if(border)
+				cluster.border_tiles.push_back(tile);
+		}
+	}
+
+	dirty_tiles.clear();
+	links.clear();
+	portals.clear();
+	tile_portal.assign(tile_count, -1);
+	run_stamp.assign(tile_count, 0);
+	stamp = 0;
+	portals_dirty = true;
+}
+
+//every 8-connected run of walkable tiles in from_cluster bordering to_cluster gets one link, entered at the middle
+//of the run
+void zone_graph_t::add_links(const adventure_map_t& map, int from_cluster, int to_cluster) {
+	//first walkable neighbour of tile inside to_cluster on the same medium, -1 if there is none
+	auto get_crossing = [&](int tile) {
+		int x = tile % width;
+		int y = tile / width;
+		bool water = is_water(map, tile);
+		for(int i = 0; i < 8; i++) {
+			int nx = x + dx[i];
+			int ny = y + dy[i];
+			if(nx < 0 || ny < 0 || nx >= width || ny >= height)
+				continue;
+
+			int neighbor = nx + (ny * width);
+			if(tile_cluster[neighbor] == to_cluster && walkable[neighbor] && is_water(map, neighbor) == water)
+				return neighbor;
+		}
+
+		return -1;
+	};
+
+	if(++stamp == 0) {
+		std::fill(run_stamp.begin(), run_stamp.end(), 0);
+		stamp = 1;
+	}
+
+	std::vector<int> run;
+	for(auto tile : clusters[from_cluster].border_tiles) {
+		if(!walkable[tile] || run_stamp[tile] == stamp || get_crossing(tile) == -1)
+			continue;
+
+		const bool water = is_water(map, tile);
+		run.clear();
+		run.push_back(tile);
+		run_stamp[tile] = stamp;
+		for(size_t r = 0; r < run.size(); r++) {
+			int rx = run[r] % width;
+			int ry = run[r] / width;
+			for(int k = 0; k < 8; k++) {
+				int sx = rx + dx[k];
+				int sy = ry + dy[k];
+				if(sx < 0 || sy < 0 || sx >= width || sy >= height)
+					continue;
+
+				int next = sx + (sy * width);
+				if(!walkable[next] || tile_cluster[next] != from_cluster || is_water(map, next) != water)
+					continue;
+
+				if(run_stamp[next] == stamp || get_crossing(next) == -1)
+					continue;
+
+				run_stamp[next] = stamp;
+				run.push_back(next);
+			}
+		}
+
+		zone_link_t link;
+		link.from_cluster = from_cluster;
+		link.to_cluster = to_cluster;
+		link.entrance = run[run.size() / 2];
+		link.exit = get_crossing(link.entrance);
+		links.push_back(link);
+	}
+}
+
+void zone_graph_t::rebuild_portals(const adventure_map_t& map) {
+	for(auto tile : dirty_tiles)
+		walkable[tile] = is_walkable(map, tile % width, tile / width);
+	dirty_tiles.clear();
+
+	//a tile changing in one cluster can open or close runs on either side of its borders, so every link touching
+	//a flagged cluster is found again; links between two untouched clusters are kept
+	links.erase(std::remove_if(links.begin(), links.end(), [&](const zone_link_t& link) {
+		return clusters[link.from_cluster].border_dirty || clusters[link.to_cluster].border_dirty;
+	}), links.end());
+
+	for(int c = 0; c < (int)clusters.size(); c++) {
+		for(auto other : clusters[c].neighbours) {
+			if(clusters[c].border_dirty || clusters[other].border_dirty)
+				add_links(map, c, other);
+		}
+	}
+
+	for(auto& cluster : clusters) {
+		cluster.border_dirty = false;
+		cluster.portals.clear();
+	}
+
+	for(const auto& portal : portals)
+		tile_portal[portal.tile] = -1;
+	portals.clear();
+
+	auto get_or_add_portal = [&](int tile) {
+		if(tile_portal[tile] == -1) {
+			tile_portal[tile] = (int)portals.size();
+			portals.emplace_back();
+			portals.back().tile = tile;
+			portals.back().cluster = tile_cluster[tile];
+			clusters[tile_cluster[tile]].portals.push_back(tile_portal[tile]);
+		}
+
+		return tile_portal[tile];
+	};
+
+	for(const auto& link : links) {
+		int from = get_or_add_portal(link.entrance);
+		int to = get_or_add_portal(link.exit);
+		portals[from].crossings.push_back(to);
+		portals[to].crossings.push_back(from);
+	}
+
+	for(auto& portal : portals) {
+		std::sort(portal.crossings.begin(), portal.crossings.end());
+		portal.crossings.erase(std::unique(portal.crossings.begin(), portal.crossings.end()), portal.crossings.end());
+	}
+
+	//ordered by tile, so a cluster whose entrances didn't change keeps the table it has.
+	//a zone whose entrances moved needs its table rebuilt even if none of its own tiles changed
+	for(auto& cluster : clusters) {
+		std::sort(cluster.portals.begin(), cluster.portals.end(), [&](int lhs, int rhs) { return portals[lhs].tile < portals[rhs].tile; });
+
+		std::vector<int> portal_tiles;
+		for(auto p : cluster.portals)
+			portal_tiles.push_back(portals[p].tile);
+
+		if(portal_tiles != cluster.portal_tiles) {
+			cluster.portal_tiles = portal_tiles;
+			cluster.dirty = true;
+		}
+	}
+
+	portals_dirty = false;
+}
+
+void zone_graph_t::rebuild_cluster_distances(const adventure_map_t& map, zone_cluster_t& cluster) {
+	static thread_local zone_search_t search;
+
+	const size_t count = cluster.portals.size();
+	cluster.distances.assign(count * count, -1);
+	for(size_t i = 0; i < count; i++) {
+		const int source = portals[cluster.portals[i]].tile;
+		const int cluster_index = tile_cluster[source];
+		const bool water = is_water(map, source);
+
+		search.begin((size_t)width * height);
+		search.push(source, 0, -1);
+		for(int current = search.pop(); current != -1; current = search.pop()) {
+			int cx = current % width;
+			int cy = current / width;
+			for(int k = 0; k < 8; k++) {
+				int x = cx + dx[k];
+				int y = cy + dy[k];
+				if(x < 0 || y < 0 || x >= width || y >= height)
+					continue;
+
+				int next = x + (y * width);
+				if(!walkable[next] || tile_cluster[next] != cluster_index || is_water(map, next) != water)
+					continue;
+
+				search.push(next, search.cost[current] + get_step_cost(map, x, y, k >= 4), current);
+			}
+		}
+
+		for(size_t j = 0; j < count; j++)
+			cluster.distances[(i * count) + j] = search.cost[portals[cluster.portals[j]].tile];
+	}
+
+	cluster.dirty = false;
+}
+
+void zone_graph_t::update(const adventure_map_t& map) {
+	if(width != map.width || height != map.height || tile_cluster.size() != (size_t)map.width * map.height)
+		rebuild_tiles(map);
+
+	if(portals_dirty)
+		rebuild_portals(map);
+
+	for(auto& cluster : clusters) {
+		if(cluster.dirty)
+			rebuild_cluster_distances(map, cluster);
+	}
+}
+
+int zone_graph_t::find_path(const adventure_map_t& map, int x1, int y1, int x2, int y2, std::vector<int>* waypoints) {
+	if(waypoints)
+		waypoints->clear();
+
+	if(!map.tile_valid(x1, y1) || !map.tile_valid(x2, y2) || (x1 == x2 && y1 == y2))
+		return -1;
+
+	update(map);
+
+	const int start = x1 + (y1 * width);
+	const int goal = x2 + (y2 * width);
+	const bool water = is_water(map, start);
+	const auto& goal_tile = map.get_tile(x2, y2);
+	if(!goal_tile.passability || goal_tile.terrain_type == TERRAIN_UNKNOWN)
+		return -1;
+
+	static thread_local zone_search_t forward;
+	static thread_local zone_search_t backward;
+
+	//forward: from the start into its neighbours' clusters, then only within the cluster each tile belongs to.
+	//the goal may be an object, a hero or a ship and is only ever entered as the final step
+	int direct_cost = -1;
+	forward.begin((size_t)width * height);
+	forward.push(start, 0, -1);
+	for(int current = forward.pop(); current != -1; current = forward.pop()) {
+		int cx = current % width;
+		int cy = current / width;
+		for(int k = 0; k < 8; k++) {
+			int x = cx + dx[k];
+			int y = cy + dy[k];
+			if(x < 0 || y < 0 || x >= width || y >= height)
+				continue;
+
+			int next = x + (y * width);
+			int step = forward.cost[current] + get_step_cost(map, x, y, k >= 4);
+			if(next == goal) {
+				if(direct_cost == -1 || step < direct_cost)
+					direct_cost = step;
+				continue;
+			}
+
+			if(!walkable[next] || is_water(map, next) != water)
+				continue;
+
+			if(current != start && tile_cluster[next] != tile_cluster[current])
+				continue;
+
+			forward.push(next, step, current);
+		}
+	}
+
+	//backward: the cost of reaching the goal from each tile, again bounded to the cluster of the tile
+	backward.begin((size_t)width * height);
+	for(int k = 0; k < 8; k++) {
+		int x = x2 - dx[k];
+		int y = y2 - dy[k];
+		if(x < 0 || y < 0 || x >= width || y >= height)
+			continue;
+
+		int previous = x + (y * width);
+		if(walkable[previous] && is_water(map, previous) == water)
+			backward.push(previous, get_step_cost(map, x2, y2, k >= 4), goal);
+	}
+
+	for(int current = backward.pop(); current != -1; current = backward.pop()) {
+		int cx = current % width;
+		int cy = current / width;
+		for(int k = 0; k < 8; k++) {
+			int x = cx - dx[k];
+			int y = cy - dy[k];
+			if(x < 0 || y < 0 || x >= width || y >= height)
+				continue;
+
+			int previous = x + (y * width);
+			if(!walkable[previous] || is_water(map, previous) != water || tile_cluster[previous] != tile_cluster[current])
+				continue;
+
+			backward.push(previous, backward.cost[current] + get_step_cost(map, cx, cy, k >= 4), current);
+		}
+	}
+
+	//abstract dijkstra over the portals reached from the start
+	std::vector<int> portal_cost(portals.size(), -1);
+	std::vector<int> portal_parent(portals.size(), -1);
+	std::vector<std::pair<int, int>> open_set;
+	auto push_portal = [&](int portal, int cost, int parent) {
+		if(portal_cost[portal] != -1 && portal_cost[portal] <= cost)
+			return;
+
+		portal_cost[portal] = cost;
+		portal_parent[portal] = parent;
+		open_set.push_back({cost, portal});
+		std::push_heap(open_set.begin(), open_set.end(), std::greater<std::pair<int, int>>());
+	};
+
+	for(size_t p = 0; p < portals.size(); p++) {
+		int cost = forward.cost[portals[p].tile];
+		if(cost != -1 && portals[p].tile != start)
+			push_portal((int)p, cost, -1);
+	}
+
+	int best_cost = direct_cost;
+	int best_portal = -1;
+	while(!open_set.empty()) {
+		std::pop_heap(open_set.begin(), open_set.end(), std::greater<std::pair<int, int>>());
+		auto entry = open_set.back();
+		open_set.pop_back();
+
+		const int portal = entry.second;
+		const int cost = entry.first;
+		if(cost != portal_cost[portal])
+			continue;
+
+		if(best_cost != -1 && cost >= best_cost)
+			break;
+
+		int to_goal = backward.cost[portals[portal].tile];
+		if(to_goal != -1 && (best_cost == -1 || cost + to_goal < best_cost)) {
+			best_cost = cost + to_goal;
+			best_portal = portal;
+		}
+
+		const auto& cluster = clusters[portals[portal].cluster];
+		const size_t count = cluster.portals.size();
+		const size_t row = std::find(cluster.portals.begin(), cluster.portals.end(), portal) - cluster.portals.begin();
+		for(size_t j = 0; j < count; j++) {
+			int distance = cluster.distances[(row * count) + j];
+			if(distance > 0)
+				push_portal(cluster.portals[j], cost + distance, portal);
+		}
+
+		const int px = portals[portal].tile % width;
+		const int py = portals[portal].tile / width;
+		for(auto crossing : portals[portal].crossings) {
+			const int tile = portals[crossing].tile;
+			if(is_water(map, tile) != water)
+				continue;
+
+			bool diagonal = (tile % width) != px && (tile / width) != py;
+			push_portal(crossing, cost + get_step_cost(map, tile % width, tile / width, diagonal), portal);
+		}
+	}
+
+	if(waypoints && best_portal != -1) {
+		for(int p = best_portal; p != -1; p = portal_parent[p])
+			waypoints->push_back(portals[p].tile);
+
+		std::reverse(waypoints->begin(), waypoints->end());
+	}
+
+	return best_cost;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct adventure_map_t;
+
+//a connected run of tiles on a zone border gets one portal on each side; crossings link it to the portals on the
+//other side of the border
+struct zone_portal_t {
+	int tile = -1; //x + y * width
+	int cluster = -1;
+	std::vector<int> crossings;
+};
+
+//one entrance found on the border of cluster from_cluster with to_cluster: a tile in each, next to each other
+struct zone_link_t {
+	int from_cluster = -1;
+	int to_cluster = -1;
+	int entrance = -1;
+	int exit = -1;
+};
+
+//all tiles sharing a zone_id. distances is a portals.size() x portals.size() table of the cheapest path between two
+//portals that stays inside the cluster (-1 if there is none)
+struct zone_cluster_t {
+	int8_t zone_id = -1;
+	std::vector<int> border_tiles; //tiles next to another cluster, ascending
+	std::vector<int> neighbours; //clusters bordering this one
+	std::vector<int> portals; //ordered by tile
+	std::vector<int> portal_tiles; //what distances was built for, to detect when it needs rebuilding
+	std::vector<int> distances;
+	bool dirty = true;
+	bool border_dirty = true;
+};
+
+//HPA*-style abstraction of an adventure map over the zone_id regions assigned by the random map generator.
+//costs are the hero-independent terrain/road costs; tiles with objects, heroes or monster guards are not walkable.
+//built lazily on the first query, then patched: mark_tile_dirty queues the tile for a walkability check and flags
+//its clusters, and the next query re-derives only the entrances on those clusters' borders and only the distance
+//tables of clusters whose tiles or portals changed
+struct zone_graph_t {
+	uint16_t width = 0;
+	uint16_t height = 0;
+	bool portals_dirty = true;
+	std::vector<int16_t> tile_cluster;
+	std::vector<uint8_t> walkable;
+	std::vector<int> dirty_tiles;
+	std::vector<int> tile_portal;
+	std::vector<zone_cluster_t> clusters;
+	std::vector<zone_link_t> links;
+	std::vector<zone_portal_t> portals;
+
+	void invalidate() { width = 0; height = 0; portals_dirty = true; dirty_tiles.clear(); }
+	void mark_tile_dirty(int x, int y);
+	void update(const adventure_map_t& map);
+
+	//cheapest abstract path from (x1, y1) to (x2, y2), -1 if there is none. if waypoints is given it receives the
+	//portal tiles along the path (empty when the goal is reached without leaving the start's clusters)
+	int find_path(const adventure_map_t& map, int x1, int y1, int x2, int y2, std::vector<int>* waypoints);
+
+private:
+	std::vector<uint32_t> run_stamp;
+	uint32_t stamp = 0;
+
+	bool is_walkable(const adventure_map_t& map, int x, int y) const;
+	void rebuild_tiles(const adventure_map_t& map);
+	void rebuild_portals(const adventure_map_t& map);
+	void add_links(const adventure_map_t& map, int from_cluster, int to_cluster);
+	void rebuild_cluster_distances(const adventure_map_t& map, zone_cluster_t& cluster);
+};
@@ -39,6 +39,10 @@ combat_session_t::combat_session_t(game_t& game_instance)
 }
 
 void combat_session_t::configure(const combat_scenario_spec_t& spec) {
+        if(use_prepared_scenario && scenario_loaded && prepared.valid && spec == scenario_spec)
+                return;
+
+        invalidate_prepared_scenario();
         scenario_spec = spec;
         apply_loadout(scenario_spec.attacker, attacker_hero, true);
         apply_loadout(scenario_spec.defender, defender_hero, false);
@@ -49,16 +53,64 @@ void combat_session_t::configure(const combat_scenario_spec_t& spec) {
 battle_result_e combat_session_t::reset() {
         assert(scenario_loaded && "combat_session_t::reset called before configure");
 
-        apply_loadout(scenario_spec.attacker, attacker_hero, true);
-        apply_loadout(scenario_spec.defender, defender_hero, false);
-        configure_player_control();
+        if(use_prepared_scenario) {
+                if(!prepared.valid || prepared.captured_from != &simulator.battlefield())
+                        prepare_scenario();
+                restore_prepared_scenario();
+        }
+        else {
+                apply_loadout(scenario_spec.attacker, attacker_hero, true);
+                apply_loadout(scenario_spec.defender, defender_hero, false);
+                configure_player_control();
+                initialize_battle();
+        }
 
+        simulator.battlefield().start_combat();
+        return BATTLE_IN_PROGRESS;
+}
+
+void combat_session_t::initialize_battle() {
         auto& battlefield_instance = simulator.battlefield();
         battlefield_instance.environment_type = scenario_spec.environment;
         battlefield_instance.is_quick_combat = scenario_spec.quick_combat;
+        battlefield_instance.rng_seed = episode_seed;
         battlefield_instance.init_hero_hero_battle(&attacker_hero, &defender_hero, scenario_spec.is_deathmatch);
-        battlefield_instance.start_combat();
-        return BATTLE_IN_PROGRESS;
+}
+
+void combat_session_t::prepare_scenario() {
+        assert(scenario_loaded && "combat_session_t::prepare_scenario called before configure");
+
+        apply_loadout(scenario_spec.attacker, attacker_hero, true);
+        apply_loadout(scenario_spec.defender, defender_hero, false);
+        configure_player_control();
+        initialize_battle();
+
+        //snapshot is taken before start_combat so battle-start effects are still rolled per episode
+        prepared.attacker_hero = attacker_hero;
+        prepared.defender_hero = defender_hero;
+        prepared.battlefield = simulator.battlefield();
+        prepared.battlefield.fn_emit_combat_action = nullptr;
+        prepared.captured_from = &simulator.battlefield();
+        prepared.valid = true;
+}
+
+void combat_session_t::restore_prepared_scenario() {
+        attacker_hero = prepared.attacker_hero;
+        defender_hero = prepared.defender_hero;
+
+        //the snapshot was copied from this same battlefield, so its hex/queue unit pointers and hero pointers
+        //already refer to the live armies and to attacker_hero/defender_hero; a flat copy restores them as-is.
+        //the emit callback is owned by the simulator/environment and must survive the copy.
+        auto& battlefield_instance = simulator.battlefield();
+        auto emit_callback = std::move(battlefield_instance.fn_emit_combat_action);
+        battlefield_instance = prepared.battlefield;
+        battlefield_instance.fn_emit_combat_action = std::move(emit_callback);
+
+        //the snapshot's dice state is replaced so each episode rolls from its own seed, and the obstacles it was
+        //captured with are placed again from that seed so episodes don't all share one layout
+        battlefield_instance.rng_seed = episode_seed;
+        battlefield_instance.seed_rng();
+        battlefield_instance.setup_obstacles();
 }
 
 battle_result_e combat_session_t::reset(const combat_scenario_spec_t& spec) {
@@ -6,12 +6,15 @@
 #include "core/troop.h"
 
 #include <array>
+#include <optional>
 #include <string>
 #include <vector>
 
 struct troop_stack_spec_t {
         unit_type_e unit_type = UNIT_UNKNOWN;
         uint16_t stack_size = 0;
+
+        bool operator==(const troop_stack_spec_t&) const = default;
 };
 
 struct hero_loadout_spec_t {
@@ -33,6 +36,8 @@ struct hero_loadout_spec_t {
         std::vector<talent_e> talents;
         std::vector<spell_e> spellbook;
         std::vector<skill_e> enabled_skills;
+
+        bool operator==(const hero_loadout_spec_t&) const = default;
 };
 
 struct combat_scenario_spec_t {
@@ -41,6 +46,18 @@ struct combat_scenario_spec_t {
         bool is_deathmatch = false;
         battlefield_environment_e environment = BATTLEFIELD_ENVIRONMENT_GRASS;
         bool quick_combat = false;
+
+        bool operator==(const combat_scenario_spec_t&) const = default;
+};
+
+/// Fully initialised pre-battle state (heroes + battlefield before start_combat) captured once per scenario,
+/// so episodes of an unchanged scenario can be reset with a flat copy instead of rebuilding loadouts.
+struct prepared_scenario_t {
+        bool valid = false;
+        const battlefield_t* captured_from = nullptr;
+        hero_t attacker_hero;
+        hero_t defender_hero;
+        battlefield_t battlefield;
 };
 
 enum class combat_action_type_t : uint8_t {
@@ -65,10 +82,27 @@ public:
         void apply_spells_and_skills(const hero_loadout_spec_t& spec, hero_t& hero);
         void configure_player_control();
 
+        void prepare_scenario();
+        void invalidate_prepared_scenario() { prepared.valid = false; }
+        bool has_prepared_scenario() const { return prepared.valid; }
+
         battle_sim_t simulator;
         combat_scenario_spec_t scenario_spec;
         hero_t attacker_hero;
         hero_t defender_hero;
         bool scenario_loaded = false;
+
+        //when enabled, reset() restores the prepared snapshot and reconfiguring with an identical spec is a no-op.
+        //obstacles are re-rolled from episode_seed on every reset, but other setup rolls (such as talents that buff a
+        //random troop) keep the values the snapshot was taken with
+        bool use_prepared_scenario = false;
+        //seed for this session's battlefield dice (battlefield_t::rng_seed); unset draws one from std::rand() per battle
+        std::optional<uint32_t> episode_seed;
+
+private:
+        void initialize_battle();
+        void restore_prepared_scenario();
+
+        prepared_scenario_t prepared;
 };
 
@@ -3,6 +3,7 @@
 #include "combat_observation.h"
 
 #include <algorithm>
+#include <limits>
 #include <utility>
 
 combat_agent_t::combat_agent_t(std::size_t observation_dim,
@@ -46,3 +47,15 @@ combat_action_type_t combat_agent_t::select_action(const combat_observation_t& o
         action_index = std::clamp<int64_t>(action_index, 0, static_cast<int64_t>(ACTION_COUNT) - 1);
         return static_cast<combat_action_type_t>(action_index);
 }
+
+combat_action_type_t combat_agent_t::select_action(const combat_observation_t& observation, const std::vector<uint8_t>& legal_mask) const {
+        auto scores = evaluate(observation);
+        const auto action_count = std::min<std::size_t>(static_cast<std::size_t>(scores.size(0)), legal_mask.size());
+        for(std::size_t index = 0; index < action_count; ++index) {
+                if(!legal_mask[index])
+                        scores[static_cast<int64_t>(index)].fill_(-std::numeric_limits<float>::infinity());
+        }
+        auto action_index = scores.argmax().item<int64_t>();
+        action_index = std::clamp<int64_t>(action_index, 0, static_cast<int64_t>(ACTION_COUNT) - 1);
+        return static_cast<combat_action_type_t>(action_index);
+}
@@ -4,6 +4,7 @@
 
 #include <torch/torch.h>
 
+#include <cstdint>
 #include <vector>
 
 struct CombatNetworkOptions {
@@ -19,6 +20,8 @@ public:
                        torch::Device device = torch::kCUDA);
 
         combat_action_type_t select_action(const combat_observation_t& observation) const;
+        /// Greedy action restricted to entries of `legal_mask` that are non-zero; an empty mask allows every action.
+        combat_action_type_t select_action(const combat_observation_t& observation, const std::vector<uint8_t>& legal_mask) const;
         torch::Tensor evaluate(const combat_observation_t& observation) const;
 
         torch::nn::Sequential& model() { return policy_network; }
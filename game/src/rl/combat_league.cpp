@@ -0,0 +1,333 @@
+#include "combat_league.h"
+
+#include "combat_observation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+
+#include <torch/serialize.h>
+
+namespace {
+struct league_match_t {
+        std::size_t attacker = 0;
+        std::size_t defender = 0;
+        std::size_t scenario = 0;
+        uint32_t seed = 0;
+};
+
+uint32_t mix_seed(uint32_t seed, std::size_t index) {
+        uint64_t value = (static_cast<uint64_t>(seed) << 32) ^ static_cast<uint64_t>(index);
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdULL;
+        value ^= value >> 33;
+        value *= 0xc4ceb9fe1a85ec53ULL;
+        value ^= value >> 33;
+        return static_cast<uint32_t>(value);
+}
+
+std::string resolve_policy_path(const std::string& checkpoint_path) {
+        const std::filesystem::path path(checkpoint_path);
+        if(std::filesystem::is_directory(path))
+                return (path / "policy.pt").string();
+        return path.string();
+}
+
+std::vector<league_match_t> build_schedule(std::size_t participant_count, std::size_t scenario_count, const league_config_t& config) {
+        std::vector<league_match_t> schedule;
+        schedule.reserve(config.rounds * scenario_count * participant_count * (participant_count - 1));
+        for(std::size_t round = 0; round < config.rounds; ++round) {
+                for(std::size_t scenario = 0; scenario < scenario_count; ++scenario) {
+                        for(std::size_t attacker = 0; attacker < participant_count; ++attacker) {
+                                for(std::size_t defender = 0; defender < participant_count; ++defender) {
+                                        if(attacker == defender)
+                                                continue;
+
+                                        league_match_t match;
+                                        match.attacker = attacker;
+                                        match.defender = defender;
+                                        match.scenario = scenario;
+                                        match.seed = mix_seed(config.seed, schedule.size());
+                                        schedule.push_back(match);
+                                }
+                        }
+                }
+        }
+        return schedule;
+}
+
+//one worker's private copy of every network; built-in participants stay null
+std::vector<std::unique_ptr<combat_agent_t>> load_participant_agents(const std::vector<league_participant_t>& participants,
+                                                                     const league_config_t& config) {
+        std::vector<std::unique_ptr<combat_agent_t>> agents(participants.size());
+        for(std::size_t index = 0; index < participants.size(); ++index) {
+                if(participants[index].is_builtin())
+                        continue;
+
+                auto agent = std::make_unique<combat_agent_t>(observation_feature_count(), ACTION_COUNT, config.network_options, torch::kCPU);
+                torch::load(agent->model(), resolve_policy_path(participants[index].checkpoint_path), torch::Device(torch::kCPU));
+                agent->model()->eval();
+                agents[index] = std::move(agent);
+        }
+        return agents;
+}
+
+combat_action_type_t select_league_action(const combat_agent_t& agent, const combat_observation_t& observation, const league_config_t& config) {
+        if(config.legal_action_fn) {
+                if(const auto mask = config.legal_action_fn(observation))
+                        return agent.select_action(observation, *mask);
+        }
+        return agent.select_action(observation);
+}
+
+league_game_result_t play_match(combat_environment_t& environment,
+                                const league_match_t& match,
+                                const combat_scenario_spec_t& scenario,
+                                const std::vector<std::unique_ptr<combat_agent_t>>& agents,
+                                const league_config_t& config) {
+        const combat_agent_t* attacker_agent = agents[match.attacker].get();
+        const combat_agent_t* defender_agent = agents[match.defender].get();
+
+        //sides driven by a network are marked human so update_battle waits for apply_action;
+        //the built-in participant is left to the battlefield AI
+        auto spec = scenario;
+        spec.attacker.human_controlled = attacker_agent != nullptr;
+        spec.defender.human_controlled = defender_agent != nullptr;
+
+        auto& session = environment.session();
+        session.episode_seed = match.seed;
+        session.configure(spec);
+        session.reset();
+
+        league_game_result_t game;
+        game.attacker = match.attacker;
+        game.defender = match.defender;
+        game.scenario = match.scenario;
+
+        auto& battlefield = session.simulator.battlefield();
+        for(; game.steps < config.max_steps_per_game; ++game.steps) {
+                if(const auto* active = battlefield.get_active_unit()) {
+                        const auto* agent = active->is_attacker ? attacker_agent : defender_agent;
+                        if(agent && !session.apply_action(select_league_action(*agent, capture_observation(session), config))) {
+                                ++game.illegal_actions;
+                                session.apply_action(combat_action_type_t::AUTO_RESOLVE);
+                        }
+                }
+
+                game.result = session.step();
+                if(game.result != BATTLE_IN_PROGRESS)
+                        break;
+        }
+
+        return game;
+}
+
+//1 for an attacker win, 0 for a defender win, 0.5 for anything else (mutual loss or step limit)
+double attacker_score(battle_result_e result) {
+        switch(result) {
+        case BATTLE_ATTACKER_VICTORY:
+        case BATTLE_DEFENDER_HAS_FLED:
+                return 1.0;
+        case BATTLE_DEFENDER_VICTORY:
+        case BATTLE_ATTACKER_HAS_FLED:
+                return 0.0;
+        default:
+                return 0.5;
+        }
+}
+
+//maximum-likelihood Elo (Bradley-Terry) over the aggregate score matrix, anchored to a mean of 1500;
+//unlike sequential K-factor updates this does not depend on the order games finished in
+std::vector<double> fit_elo(const std::vector<std::vector<double>>& score, const std::vector<std::vector<std::size_t>>& games) {
+        constexpr int ITERATIONS = 2000;
+        constexpr double STEP = 32.0;
+        constexpr double MEAN_RATING = 1500.0;
+        constexpr double RATING_SPREAD = 1000.0;
+
+        const std::size_t count = score.size();
+        std::vector<double> ratings(count, MEAN_RATING);
+        for(int iteration = 0; iteration < ITERATIONS; ++iteration) {
+                for(std::size_t i = 0; i < count; ++i) {
+                        double expected = 0.0;
+                        double actual = 0.0;
+                        std::size_t played = 0;
+                        for(std::size_t j = 0; j < count; ++j) {
+                                if(i == j || games[i][j] == 0)
+                                        continue;
+
+                                const double probability = 1.0 / (1.0 + std::pow(10.0, (ratings[j] - ratings[i]) / 400.0));
+                                expected += probability * static_cast<double>(games[i][j]);
+                                actual += score[i][j];
+                                played += games[i][j];
+                        }
+                        if(played)
+                                ratings[i] += STEP * (actual - expected) / static_cast<double>(played);
+                }
+
+                const double mean = std::accumulate(ratings.begin(), ratings.end(), 0.0) / static_cast<double>(std::max<std::size_t>(count, 1));
+                for(auto& rating : ratings)
+                        rating = std::clamp(rating - mean + MEAN_RATING, MEAN_RATING - RATING_SPREAD, MEAN_RATING + RATING_SPREAD);
+        }
+        return ratings;
+}
+} // namespace
+
+double league_results_t::win_rate(std::size_t participant, std::size_t opponent) const {
+        if(participant >= games.size() || opponent >= games.size() || games[participant][opponent] == 0)
+                return 0.0;
+        return score[participant][opponent] / static_cast<double>(games[participant][opponent]);
+}
+
+double league_results_t::games_per_second() const {
+        if(wall_seconds <= 0.0)
+                return 0.0;
+        return static_cast<double>(game_results.size()) / wall_seconds;
+}
+
+void league_results_t::print_summary(std::ostream& stream) const {
+        const auto flags = stream.flags();
+        const auto precision = stream.precision();
+
+        std::size_t name_width = 8;
+        for(const auto& name : names)
+                name_width = std::max(name_width, name.size() + 2);
+
+        stream << "League: " << game_results.size() << " games (" << draws << " drawn) in "
+               << std::fixed << std::setprecision(2) << wall_seconds << "s, " << std::setprecision(1)
+               << games_per_second() << " games/s\n";
+
+        stream << "Win rate (row vs column):\n" << std::setw(static_cast<int>(name_width)) << "";
+        for(const auto& name : names)
+                stream << std::setw(static_cast<int>(name_width)) << name;
+        stream << "\n";
+        for(std::size_t i = 0; i < names.size(); ++i) {
+                stream << std::setw(static_cast<int>(name_width)) << names[i];
+                for(std::size_t j = 0; j < names.size(); ++j) {
+                        if(i == j)
+                                stream << std::setw(static_cast<int>(name_width)) << "-";
+                        else
+                                stream << std::setw(static_cast<int>(name_width)) << std::setprecision(3) << win_rate(i, j);
+                }
+                stream << "\n";
+        }
+
+        std::vector<std::size_t> order(names.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [this](std::size_t lhs, std::size_t rhs) { return elo[lhs] > elo[rhs]; });
+
+        stream << "Elo:\n";
+        for(auto index : order)
+                stream << "  " << std::setw(static_cast<int>(name_width)) << std::left << names[index] << std::right
+                       << std::setprecision(1) << elo[index] << "\n";
+
+        stream.flags(flags);
+        stream.precision(precision);
+}
+
+void league_results_t::write_csv(const std::string& path) const {
+        std::ofstream output(path, std::ios::trunc);
+        if(!output)
+                throw std::runtime_error("Could not open league CSV for writing: " + path);
+
+        output << "participant";
+        for(const auto& name : names)
+                output << "," << name;
+        output << "\n";
+        for(std::size_t i = 0; i < names.size(); ++i) {
+                output << names[i];
+                for(std::size_t j = 0; j < names.size(); ++j) {
+                        output << ",";
+                        if(i != j)
+                                output << win_rate(i, j);
+                }
+                output << "\n";
+        }
+
+        output << "\nparticipant,elo\n";
+        for(std::size_t i = 0; i < names.size(); ++i)
+                output << names[i] << "," << elo[i] << "\n";
+}
+
+league_results_t run_combat_league(const std::vector<league_participant_t>& participants,
+                                   const std::vector<combat_scenario_spec_t>& scenarios,
+                                   const league_config_t& config) {
+        if(participants.size() < 2)
+                throw std::invalid_argument("A league needs at least two participants");
+        if(scenarios.empty())
+                throw std::invalid_argument("A league needs at least one scenario");
+
+        const auto schedule = build_schedule(participants.size(), scenarios.size(), config);
+
+        std::size_t thread_count = config.thread_count ? config.thread_count : std::thread::hardware_concurrency();
+        thread_count = std::clamp<std::size_t>(thread_count, 1, std::max<std::size_t>(schedule.size(), 1));
+
+        //games are tiny networks on the CPU; parallelism comes from the workers, not from intra-op threads
+        torch::set_num_threads(1);
+
+        league_results_t results;
+        results.game_results.resize(schedule.size());
+
+        std::atomic<std::size_t> next_match{0};
+        std::vector<std::string> worker_errors(thread_count);
+        const auto start = std::chrono::steady_clock::now();
+
+        auto worker = [&](std::size_t worker_index) {
+                try {
+                        const auto agents = load_participant_agents(participants, config);
+                        game_t game_instance;
+                        //no prepared snapshots: one would keep the obstacles and setup rolls of whichever match this worker
+                        //prepared first, so every game rebuilds its battlefield from its own seed
+                        combat_environment_t environment(game_instance);
+
+                        for(std::size_t index = next_match.fetch_add(1); index < schedule.size(); index = next_match.fetch_add(1)) {
+                                const auto& match = schedule[index];
+                                results.game_results[index] = play_match(environment, match, scenarios[match.scenario], agents, config);
+                        }
+                } catch(const std::exception& ex) {
+                        worker_errors[worker_index] = ex.what();
+                        next_match.store(schedule.size());
+                }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(thread_count);
+        for(std::size_t index = 0; index < thread_count; ++index)
+                workers.emplace_back(worker, index);
+        for(auto& thread : workers)
+                thread.join();
+
+        for(const auto& error : worker_errors) {
+                if(!error.empty())
+                        throw std::runtime_error("League worker failed: " + error);
+        }
+
+        results.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        const std::size_t count = participants.size();
+        results.score.assign(count, std::vector<double>(count, 0.0));
+        results.games.assign(count, std::vector<std::size_t>(count, 0));
+        for(const auto& participant : participants)
+                results.names.push_back(participant.name);
+
+        for(const auto& game : results.game_results) {
+                const double attacker_points = attacker_score(game.result);
+                if(attacker_points == 0.5)
+                        ++results.draws;
+
+                results.score[game.attacker][game.defender] += attacker_points;
+                results.score[game.defender][game.attacker] += 1.0 - attacker_points;
+                ++results.games[game.attacker][game.defender];
+                ++results.games[game.defender][game.attacker];
+        }
+
+        results.elo = fit_elo(results.score, results.games);
+        return results;
+}
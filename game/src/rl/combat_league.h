@@ -0,0 +1,70 @@
+#pragma once
+
+#include "combat_agent.h"
+#include "combat_environment.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// One entrant in an evaluation league: either a saved policy network or the built-in battlefield AI.
+struct league_participant_t {
+        std::string name;
+        /// Path to a `policy.pt` file or to a checkpoint directory written by dqn_trainer_t::save_checkpoint.
+        /// Empty selects the built-in AI (battlefield_t::auto_move_troop) for that side.
+        std::string checkpoint_path;
+
+        [[nodiscard]] bool is_builtin() const { return checkpoint_path.empty(); }
+};
+
+struct league_config_t {
+        /// Every round plays each ordered pairing (so both sides) once on every scenario of the suite.
+        std::size_t rounds = 10;
+        /// Worker threads; 0 uses std::thread::hardware_concurrency().
+        std::size_t thread_count = 0;
+        /// Battle updates after which a game is scored as a draw.
+        std::size_t max_steps_per_game = 4096;
+        /// Seeds each game's battlefield (obstacles and dice), so results do not depend on which worker played a game.
+        uint32_t seed = 42;
+        CombatNetworkOptions network_options;
+        /// Restricts network participants to legal actions (non-zero entries); empty lets them pick any action.
+        std::function<std::optional<std::vector<uint8_t>>(const combat_observation_t&)> legal_action_fn;
+};
+
+struct league_game_result_t {
+        std::size_t attacker = 0;
+        std::size_t defender = 0;
+        std::size_t scenario = 0;
+        battle_result_e result = BATTLE_IN_PROGRESS;
+        std::size_t steps = 0;
+        std::size_t illegal_actions = 0;
+};
+
+struct league_results_t {
+        std::vector<std::string> names;
+        /// score[i][j]: points participant i took from games against j (win 1, draw 0.5).
+        std::vector<std::vector<double>> score;
+        std::vector<std::vector<std::size_t>> games;
+        std::vector<double> elo;
+        std::vector<league_game_result_t> game_results;
+        std::size_t draws = 0;
+        double wall_seconds = 0.0;
+
+        [[nodiscard]] double win_rate(std::size_t participant, std::size_t opponent) const;
+        [[nodiscard]] double games_per_second() const;
+        void print_summary(std::ostream& stream) const;
+        /// Writes the win-rate matrix followed by the Elo table as CSV.
+        void write_csv(const std::string& path) const;
+};
+
+/// Plays every ordered pairing of `participants` on every scenario for `config.rounds` rounds, spreading
+/// the games over worker threads that each own a game_t, a combat_environment_t and their own copies of the
+/// networks. Game outcomes are collected by game index and every game sets up its battlefield and rolls its dice
+/// from its own seed, so the matrices and Elo do not depend on scheduling or thread count.
+league_results_t run_combat_league(const std::vector<league_participant_t>& participants,
+                                   const std::vector<combat_scenario_spec_t>& scenarios,
+                                   const league_config_t& config);
@@ -4,6 +4,11 @@
 #include "core/magic_enum.hpp"
 
 #include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
 #include <limits>
 #include <numeric>
 #include <sstream>
@@ -23,6 +28,75 @@ double epsilon_schedule_t::value(std::size_t step) const {
         return start + fraction * (end - start);
 }
 
+std::atomic<uint64_t>& training_allocation_counter() {
+        static std::atomic<uint64_t> counter{0};
+        return counter;
+}
+
+double training_throughput_t::transitions_per_second() const {
+        if(wall_seconds <= 0.0)
+                return 0.0;
+        return static_cast<double>(transitions) / wall_seconds;
+}
+
+double training_throughput_t::allocations_per_step() const {
+        if(transitions == 0)
+                return 0.0;
+        return static_cast<double>(allocations) / static_cast<double>(transitions);
+}
+
+std::string training_throughput_t::to_json_line(std::size_t episode) const {
+        auto phase = [](std::ostringstream& stream, const char* name, const phase_timing_t& timing) {
+                stream << ",\"" << name << "_ms\":" << timing.total_ms()
+                       << ",\"" << name << "_calls\":" << timing.calls;
+        };
+
+        std::ostringstream stream;
+        stream << std::fixed << std::setprecision(3);
+        stream << "{\"episode\":" << episode
+               << ",\"transitions\":" << transitions
+               << ",\"optimisation_steps\":" << optimisation_steps
+               << ",\"wall_seconds\":" << wall_seconds
+               << ",\"transitions_per_sec\":" << transitions_per_second();
+#ifdef COF_COUNT_ALLOCATIONS
+        stream << ",\"allocations_per_step\":" << allocations_per_step();
+#endif
+        phase(stream, "env_reset", environment_reset);
+        phase(stream, "env_step", environment_step);
+        phase(stream, "observation_encode", observation_encode);
+        phase(stream, "action_select", action_select);
+        phase(stream, "replay_sample", replay_sample);
+        phase(stream, "forward_backward", forward_backward);
+        phase(stream, "target_sync", target_sync);
+        stream << "}";
+        return stream.str();
+}
+
+void training_throughput_t::print_summary(std::ostream& stream) const {
+        auto line = [this, &stream](const char* name, const phase_timing_t& timing) {
+                const double share = wall_seconds > 0.0 ? 100.0 * timing.total_ms() / (wall_seconds * 1e3) : 0.0;
+                stream << "  " << std::left << std::setw(20) << name << std::right
+                       << std::setw(12) << timing.total_ms() << " ms "
+                       << std::setw(10) << timing.mean_us() << " us/call "
+                       << std::setw(6) << share << "%\n";
+        };
+
+        stream << std::fixed << std::setprecision(3);
+        stream << "Throughput: " << transitions << " transitions in " << wall_seconds << " s ("
+               << transitions_per_second() << " transitions/s";
+#ifdef COF_COUNT_ALLOCATIONS
+        stream << ", " << allocations_per_step() << " allocations/step";
+#endif
+        stream << ")\n";
+        line("environment reset", environment_reset);
+        line("environment step", environment_step);
+        line("observation encode", observation_encode);
+        line("action select", action_select);
+        line("replay sample", replay_sample);
+        line("forward/backward", forward_backward);
+        line("target sync", target_sync);
+}
+
 replay_buffer_t::replay_buffer_t(std::size_t capacity, std::optional<uint32_t> seed)
         : max_capacity(capacity)
         , rng(seed ? *seed : std::random_device{}()) {
@@ -62,6 +136,157 @@ bool replay_buffer_t::ready_for_training(std::size_t minimum_size) const {
         return data.size() >= minimum_size;
 }
 
+namespace {
+constexpr uint32_t REPLAY_FILE_MAGIC = 0x594C5052; //"RPLY"
+constexpr uint32_t REPLAY_FILE_VERSION = 1;
+constexpr std::size_t REPLAY_RECORD_PREFIX_SIZE = 16; //action, reward, done + mask lengths
+
+struct replay_file_header_t {
+        uint32_t magic = REPLAY_FILE_MAGIC;
+        uint32_t version = REPLAY_FILE_VERSION;
+        uint64_t capacity = 0;
+        uint64_t count = 0;
+        uint32_t state_dim = 0;
+        uint32_t mask_dim = 0;
+        uint64_t rng_state_size = 0;
+};
+
+std::size_t align_to_8(std::size_t value) {
+        return (value + 7) & ~static_cast<std::size_t>(7);
+}
+
+//record layout: int64 action | float reward | u8 done | u8 legal_len | u8 next_legal_len | u8 pad |
+//               float state[state_dim] | float next_state[state_dim] | u8 legal[mask_dim] | u8 next_legal[mask_dim]
+std::size_t replay_record_size(std::size_t state_dim, std::size_t mask_dim) {
+        return align_to_8(REPLAY_RECORD_PREFIX_SIZE + (2 * state_dim * sizeof(float)) + (2 * mask_dim));
+}
+} // namespace
+
+void replay_buffer_t::save_to_file(const std::string& path, std::size_t mask_dim) const {
+        if(mask_dim > std::numeric_limits<uint8_t>::max())
+                throw std::invalid_argument("Replay file mask dimension must fit in a byte");
+
+        const std::size_t state_dim = data.empty() ? 0 : static_cast<std::size_t>(data.front().state.numel());
+
+        std::ostringstream rng_stream;
+        rng_stream << rng;
+        const auto rng_state = rng_stream.str();
+
+        replay_file_header_t header;
+        header.capacity = max_capacity;
+        header.count = data.size();
+        header.state_dim = static_cast<uint32_t>(state_dim);
+        header.mask_dim = static_cast<uint32_t>(mask_dim);
+        header.rng_state_size = rng_state.size();
+
+        const std::size_t record_size = replay_record_size(state_dim, mask_dim);
+        const std::size_t records_offset = align_to_8(sizeof(header) + rng_state.size());
+        const qint64 file_size = static_cast<qint64>(records_offset + (record_size * data.size()));
+
+        QFile file(QString::fromStdString(path));
+        if(!file.open(QIODevice::ReadWrite | QIODevice::Truncate) || !file.resize(file_size))
+                throw std::runtime_error("Could not create replay file: " + path);
+
+        uchar* mapped = file.map(0, file_size);
+        if(!mapped)
+                throw std::runtime_error("Could not map replay file: " + path);
+
+        std::memset(mapped, 0, static_cast<std::size_t>(file_size));
+        std::memcpy(mapped, &header, sizeof(header));
+        std::memcpy(mapped + sizeof(header), rng_state.data(), rng_state.size());
+
+        uchar* record = mapped + records_offset;
+        for(const auto& transition : data) {
+                auto state = transition.state.to(torch::kCPU, torch::kFloat32).contiguous();
+                auto next_state = transition.next_state.to(torch::kCPU, torch::kFloat32).contiguous();
+                if(static_cast<std::size_t>(state.numel()) != state_dim || static_cast<std::size_t>(next_state.numel()) != state_dim) {
+                        file.unmap(mapped);
+                        throw std::runtime_error("Replay buffer contains transitions of differing state sizes");
+                }
+
+                const uint8_t legal_len = static_cast<uint8_t>(std::min(transition.legal_actions_mask.size(), mask_dim));
+                const uint8_t next_legal_len = static_cast<uint8_t>(std::min(transition.next_legal_actions_mask.size(), mask_dim));
+                const uint8_t flags[4] = { static_cast<uint8_t>(transition.done ? 1 : 0), legal_len, next_legal_len, 0 };
+
+                std::memcpy(record, &transition.action, sizeof(int64_t));
+                std::memcpy(record + 8, &transition.reward, sizeof(float));
+                std::memcpy(record + 12, flags, sizeof(flags));
+
+                uchar* cursor = record + REPLAY_RECORD_PREFIX_SIZE;
+                std::memcpy(cursor, state.data_ptr<float>(), state_dim * sizeof(float));
+                cursor += state_dim * sizeof(float);
+                std::memcpy(cursor, next_state.data_ptr<float>(), state_dim * sizeof(float));
+                cursor += state_dim * sizeof(float);
+                std::memcpy(cursor, transition.legal_actions_mask.data(), legal_len);
+                cursor += mask_dim;
+                std::memcpy(cursor, transition.next_legal_actions_mask.data(), next_legal_len);
+
+                record += record_size;
+        }
+
+        file.unmap(mapped);
+}
+
+void replay_buffer_t::load_from_file(const std::string& path) {
+        QFile file(QString::fromStdString(path));
+        if(!file.open(QIODevice::ReadOnly))
+                throw std::runtime_error("Could not open replay file: " + path);
+
+        const qint64 file_size = file.size();
+        if(file_size < static_cast<qint64>(sizeof(replay_file_header_t)))
+                throw std::runtime_error("Replay file is truncated: " + path);
+
+        const uchar* mapped = file.map(0, file_size);
+        if(!mapped)
+                throw std::runtime_error("Could not map replay file: " + path);
+
+        replay_file_header_t header;
+        std::memcpy(&header, mapped, sizeof(header));
+
+        const std::size_t record_size = replay_record_size(header.state_dim, header.mask_dim);
+        const std::size_t records_offset = align_to_8(sizeof(header) + header.rng_state_size);
+        if(header.magic != REPLAY_FILE_MAGIC || header.version != REPLAY_FILE_VERSION
+           || static_cast<std::size_t>(file_size) < records_offset + (record_size * header.count)) {
+                file.unmap(const_cast<uchar*>(mapped));
+                throw std::runtime_error("Replay file is invalid or from an unsupported version: " + path);
+        }
+
+        std::istringstream rng_stream(std::string(reinterpret_cast<const char*>(mapped + sizeof(header)), header.rng_state_size));
+        rng_stream >> rng;
+
+        //if this buffer is smaller than the saved one, keep only the newest records
+        const std::size_t count = static_cast<std::size_t>(header.count);
+        const std::size_t first = count > max_capacity ? count - max_capacity : 0;
+        const auto state_dim = static_cast<int64_t>(header.state_dim);
+
+        data.clear();
+        for(std::size_t index = first; index < count; ++index) {
+                const uchar* record = mapped + records_offset + (index * record_size);
+
+                transition_t transition;
+                uint8_t flags[4] = {};
+                std::memcpy(&transition.action, record, sizeof(int64_t));
+                std::memcpy(&transition.reward, record + 8, sizeof(float));
+                std::memcpy(flags, record + 12, sizeof(flags));
+                transition.done = flags[0] != 0;
+
+                const uchar* cursor = record + REPLAY_RECORD_PREFIX_SIZE;
+                transition.state = torch::empty({state_dim}, torch::kFloat32);
+                std::memcpy(transition.state.data_ptr<float>(), cursor, header.state_dim * sizeof(float));
+                cursor += header.state_dim * sizeof(float);
+                transition.next_state = torch::empty({state_dim}, torch::kFloat32);
+                std::memcpy(transition.next_state.data_ptr<float>(), cursor, header.state_dim * sizeof(float));
+                cursor += header.state_dim * sizeof(float);
+                transition.legal_actions_mask.assign(cursor, cursor + std::min<uint32_t>(flags[1], header.mask_dim));
+                cursor += header.mask_dim;
+                transition.next_legal_actions_mask.assign(cursor, cursor + std::min<uint32_t>(flags[2], header.mask_dim));
+
+                data.push_back(std::move(transition));
+        }
+
+        file.unmap(const_cast<uchar*>(mapped));
+}
+
 discrete_action_space_t::discrete_action_space_t(std::vector<combat_action_type_t> mapping)
         : actions(std::move(mapping)) {
         if(actions.empty())
@@ -217,12 +442,31 @@ dqn_trainer_t::dqn_trainer_t(combat_environment_t& environment,
 
 training_metrics_t dqn_trainer_t::train(std::size_t episodes) {
         training_metrics_t metrics;
+        auto& throughput = metrics.throughput;
+
+        const auto training_start = std::chrono::steady_clock::now();
+        const uint64_t allocations_at_start = training_allocation_counter().load(std::memory_order_relaxed);
+        auto update_totals = [&]() {
+                throughput.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - training_start).count();
+                throughput.allocations = training_allocation_counter().load(std::memory_order_relaxed) - allocations_at_start;
+        };
 
         for(std::size_t episode = 0; episode < episodes; ++episode) {
                 auto scenario = scenario_generator(rng);
-                environment->configure(scenario);
-                auto observation = environment->reset();
-                auto state_tensor = observation_to_tensor(observation, device);
+                combat_observation_t observation;
+                {
+                        scoped_phase_timer_t timer(throughput.environment_reset);
+                        environment->configure(scenario);
+                        if(environment->session().use_prepared_scenario)
+                                environment->session().episode_seed = static_cast<uint32_t>(rng());
+                        observation = environment->reset();
+                }
+
+                torch::Tensor state_tensor;
+                {
+                        scoped_phase_timer_t timer(throughput.observation_encode);
+                        state_tensor = observation_to_tensor(observation, device);
+                }
 
                 const double epsilon = sample_epsilon();
                 float cumulative_reward = 0.0F;
@@ -237,12 +481,30 @@ training_metrics_t dqn_trainer_t::train(std::size_t episodes) {
 
                 while(!terminated) {
                         auto legal_mask = compute_legal_mask(observation);
-                        const int64_t action_index = select_action(state_tensor, epsilon, legal_mask);
+                        int64_t action_index = 0;
+                        {
+                                scoped_phase_timer_t timer(throughput.action_select);
+                                action_index = select_action(state_tensor, epsilon, legal_mask);
+                        }
                         const auto action = action_space.to_native(static_cast<std::size_t>(action_index));
 
-                        auto [next_observation, reward, done, result] = environment->step(action);
-                        (void)result;
-                        auto next_state_tensor = observation_to_tensor(next_observation, device);
+                        combat_observation_t next_observation;
+                        float reward = 0.0F;
+                        bool done = false;
+                        {
+                                scoped_phase_timer_t timer(throughput.environment_step);
+                                auto [stepped_observation, step_reward, step_done, result] = environment->step(action);
+                                (void)result;
+                                next_observation = stepped_observation;
+                                reward = step_reward;
+                                done = step_done;
+                        }
+
+                        torch::Tensor next_state_tensor;
+                        {
+                                scoped_phase_timer_t timer(throughput.observation_encode);
+                                next_state_tensor = observation_to_tensor(next_observation, device);
+                        }
                         auto next_legal_mask = compute_legal_mask(next_observation);
 
                         bool episode_done = done;
@@ -269,15 +531,18 @@ training_metrics_t dqn_trainer_t::train(std::size_t episodes) {
                         cumulative_reward += reward;
                         ++steps;
                         ++global_step;
+                        ++throughput.transitions;
 
                         if(replay_buffer->ready_for_training(config.minimum_buffer_size)
                            && global_step % config.training_frequency == 0) {
-                                if(auto loss = optimise_model())
+                                if(auto loss = optimise_model(&throughput))
                                         episode_losses.push_back(*loss);
                         }
 
-                        if(global_step % config.target_update_frequency == 0)
+                        if(global_step % config.target_update_frequency == 0) {
+                                scoped_phase_timer_t timer(throughput.target_sync);
                                 update_target_network();
+                        }
 
                         if(episode_done || truncated)
                                 terminated = true;
@@ -287,6 +552,16 @@ training_metrics_t dqn_trainer_t::train(std::size_t episodes) {
                 metrics.epsilon_values.push_back(epsilon);
                 metrics.losses.insert(metrics.losses.end(), episode_losses.begin(), episode_losses.end());
                 metrics.total_steps = global_step;
+                ++episodes_completed;
+
+                if(!config.checkpoint_directory.empty() && config.checkpoint_interval
+                   && episodes_completed % config.checkpoint_interval == 0)
+                        save_checkpoint(config.checkpoint_directory);
+
+                if(config.throughput_log_interval && (episode + 1) % config.throughput_log_interval == 0) {
+                        update_totals();
+                        emit_throughput(episode + 1, throughput);
+                }
 
                 if((episode + 1) % EPISODE_LOG_INTERVAL == 0) {
                     report_progress(episode + 1, metrics, environment->action_history);
@@ -294,9 +569,128 @@ training_metrics_t dqn_trainer_t::train(std::size_t episodes) {
                 }
         }
 
+        update_totals();
+
+        if(!config.checkpoint_directory.empty())
+                save_checkpoint(config.checkpoint_directory);
+
         return metrics;
 }
 
+namespace {
+//checkpoints are staged in "<dir>.tmp" and swapped in through "<dir>.old", so a crash never leaves a mixed set of files
+std::filesystem::path checkpoint_root(const std::string& directory) {
+        auto root = std::filesystem::path(directory).lexically_normal();
+        if(!root.has_filename())
+                root = root.parent_path();
+        return root;
+}
+
+std::filesystem::path checkpoint_sibling(const std::filesystem::path& root, const char* suffix) {
+        auto sibling = root;
+        sibling += suffix;
+        return sibling;
+}
+}
+
+void dqn_trainer_t::save_checkpoint(const std::string& directory) const {
+        namespace fs = std::filesystem;
+        const auto root = checkpoint_root(directory);
+        const auto staging = checkpoint_sibling(root, ".tmp");
+        const auto previous = checkpoint_sibling(root, ".old");
+
+        fs::remove_all(staging);
+        fs::create_directories(staging);
+
+        torch::save(policy_agent->model(), (staging / "policy.pt").string());
+        torch::save(target_agent->model(), (staging / "target.pt").string());
+        torch::save(*optimizer, (staging / "optimizer.pt").string());
+        replay_buffer->save_to_file((staging / "replay.bin").string(), action_space.size());
+
+        {
+                const auto state_path = staging / "trainer_state.txt";
+                std::ofstream state(state_path, std::ios::trunc);
+                if(!state)
+                        throw std::runtime_error("Could not write checkpoint state to " + state_path.string());
+
+                state << "version 1\n";
+                state << "global_step " << global_step << "\n";
+                state << "episodes " << episodes_completed << "\n";
+                state << "rng " << rng << "\n";
+                state.flush();
+                if(!state)
+                        throw std::runtime_error("Could not write checkpoint state to " + state_path.string());
+        }
+
+        //directory renames are atomic, so the checkpoint directory always holds either the old or the new checkpoint
+        fs::remove_all(previous);
+        if(fs::exists(root))
+                fs::rename(root, previous);
+        fs::rename(staging, root);
+        fs::remove_all(previous);
+}
+
+bool dqn_trainer_t::load_checkpoint(const std::string& directory) {
+        namespace fs = std::filesystem;
+        auto root = checkpoint_root(directory);
+        //a crash between the two renames in save_checkpoint leaves only the previous checkpoint
+        if(!fs::exists(root / "trainer_state.txt") && fs::exists(checkpoint_sibling(root, ".old") / "trainer_state.txt"))
+                root = checkpoint_sibling(root, ".old");
+
+        const auto state_path = root / "trainer_state.txt";
+        if(!fs::exists(state_path))
+                return false;
+
+        std::ifstream state(state_path);
+        if(!state)
+                throw std::runtime_error("Could not read checkpoint state from " + state_path.string());
+
+        std::string key;
+        while(state >> key) {
+                if(key == "version") {
+                        int version = 0;
+                        state >> version;
+                        if(version != 1)
+                                throw std::runtime_error("Unsupported checkpoint version in " + state_path.string());
+                } else if(key == "global_step") {
+                        state >> global_step;
+                } else if(key == "episodes") {
+                        state >> episodes_completed;
+                } else if(key == "rng") {
+                        state >> rng;
+                } else {
+                        throw std::runtime_error("Unknown checkpoint key '" + key + "' in " + state_path.string());
+                }
+        }
+
+        torch::load(policy_agent->model(), (root / "policy.pt").string(), device);
+        torch::load(target_agent->model(), (root / "target.pt").string(), device);
+        torch::load(*optimizer, (root / "optimizer.pt").string(), device);
+        policy_agent->model()->train();
+        target_agent->model()->eval();
+
+        const auto replay_path = root / "replay.bin";
+        if(fs::exists(replay_path))
+                replay_buffer->load_from_file(replay_path.string());
+
+        return true;
+}
+
+void dqn_trainer_t::emit_throughput(std::size_t episode, const training_throughput_t& throughput) {
+        const auto line = throughput.to_json_line(episode);
+        if(config.throughput_log_path.empty()) {
+                std::cout << line << std::endl;
+                return;
+        }
+
+        std::ofstream stream(config.throughput_log_path, std::ios::app);
+        if(!stream) {
+                std::cerr << "Could not open throughput log '" << config.throughput_log_path << "'\n";
+                return;
+        }
+        stream << line << "\n";
+}
+
 double dqn_trainer_t::sample_epsilon() const {
         return epsilon_schedule.value(global_step);
 }
@@ -387,10 +781,14 @@ torch::Tensor dqn_trainer_t::mask_to_tensor(const action_mask_t& mask, torch::De
         return tensor.to(torch::kBool);
 }
 
-std::optional<float> dqn_trainer_t::optimise_model() {
+std::optional<float> dqn_trainer_t::optimise_model(training_throughput_t* throughput) {
         if(replay_buffer->size() < config.batch_size)
                 return std::nullopt;
 
+        phase_timing_t unused_timing;
+        std::optional<scoped_phase_timer_t> sample_timer;
+        sample_timer.emplace(throughput ? throughput->replay_sample : unused_timing);
+
         auto transitions = replay_buffer->sample(config.batch_size);
 
         std::vector<torch::Tensor> state_batch;
@@ -420,6 +818,11 @@ std::optional<float> dqn_trainer_t::optimise_model() {
         auto rewards = torch::tensor(reward_batch, torch::TensorOptions().dtype(torch::kFloat32).device(device));
         auto next_states = torch::stack(next_state_batch);
         auto dones = torch::tensor(done_batch, torch::TensorOptions().dtype(torch::kFloat32).device(device));
+        sample_timer.reset();
+
+        scoped_phase_timer_t forward_backward_timer(throughput ? throughput->forward_backward : unused_timing);
+        if(throughput)
+                ++throughput->optimisation_steps;
 
         auto q_values = policy_agent->model()->forward(states);
         auto action_q = q_values.gather(1, actions.unsqueeze(1)).squeeze(1);
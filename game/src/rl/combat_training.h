@@ -3,12 +3,16 @@
 #include "combat_agent.h"
 #include "combat_environment.h"
 
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <deque>
 #include <functional>
 #include <memory>
 #include <optional>
+#include <ostream>
 #include <random>
+#include <string>
 #include <vector>
 
 struct dqn_config_t {
@@ -20,6 +24,10 @@ struct dqn_config_t {
         std::optional<std::size_t> max_steps_per_episode;
         std::optional<double> gradient_clip_norm = 5.0;
         double learning_rate = 1e-3;
+        std::size_t throughput_log_interval = 0; //episodes between JSON lines, 0 disables
+        std::string throughput_log_path; //empty writes JSON lines to stdout
+        std::string checkpoint_directory; //empty disables periodic checkpoints
+        std::size_t checkpoint_interval = 0; //episodes between checkpoints
 };
 
 struct epsilon_schedule_t {
@@ -30,11 +38,64 @@ struct epsilon_schedule_t {
         [[nodiscard]] double value(std::size_t step) const;
 };
 
+/// Process-wide allocation counter; incremented by the replacement operator new in main.cpp, which is only
+/// compiled with COF_COUNT_ALLOCATIONS defined. Throughput reports leave allocations out otherwise.
+std::atomic<uint64_t>& training_allocation_counter();
+
+struct phase_timing_t {
+        uint64_t nanoseconds = 0;
+        uint64_t calls = 0;
+
+        [[nodiscard]] double total_ms() const { return static_cast<double>(nanoseconds) / 1e6; }
+        [[nodiscard]] double mean_us() const { return calls ? static_cast<double>(nanoseconds) / 1e3 / static_cast<double>(calls) : 0.0; }
+};
+
+class scoped_phase_timer_t {
+public:
+        explicit scoped_phase_timer_t(phase_timing_t& timing)
+                : timing(timing)
+                , start(std::chrono::steady_clock::now()) {
+        }
+
+        ~scoped_phase_timer_t() {
+                const auto elapsed = std::chrono::steady_clock::now() - start;
+                timing.nanoseconds += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+                ++timing.calls;
+        }
+
+        scoped_phase_timer_t(const scoped_phase_timer_t&) = delete;
+        scoped_phase_timer_t& operator=(const scoped_phase_timer_t&) = delete;
+
+private:
+        phase_timing_t& timing;
+        std::chrono::steady_clock::time_point start;
+};
+
+struct training_throughput_t {
+        phase_timing_t environment_reset;
+        phase_timing_t environment_step;
+        phase_timing_t observation_encode;
+        phase_timing_t action_select;
+        phase_timing_t replay_sample;
+        phase_timing_t forward_backward;
+        phase_timing_t target_sync;
+        uint64_t transitions = 0;
+        uint64_t optimisation_steps = 0;
+        uint64_t allocations = 0;
+        double wall_seconds = 0.0;
+
+        [[nodiscard]] double transitions_per_second() const;
+        [[nodiscard]] double allocations_per_step() const;
+        [[nodiscard]] std::string to_json_line(std::size_t episode) const;
+        void print_summary(std::ostream& stream) const;
+};
+
 struct training_metrics_t {
         std::vector<float> episode_rewards;
         std::vector<float> losses;
         std::vector<double> epsilon_values;
         std::size_t total_steps = 0;
+        training_throughput_t throughput;
 };
 
 using action_mask_t = std::vector<uint8_t>;
@@ -61,6 +122,11 @@ public:
         [[nodiscard]] std::vector<transition_t> sample(std::size_t batch_size);
         [[nodiscard]] bool ready_for_training(std::size_t minimum_size) const;
 
+        /// Writes every stored transition as a fixed-size record into a memory-mapped binary file.
+        void save_to_file(const std::string& path, std::size_t mask_dim) const;
+        /// Replaces the buffer contents with the records of a file written by save_to_file.
+        void load_from_file(const std::string& path);
+
 private:
         std::size_t max_capacity;
         std::deque<transition_t> data;
@@ -98,6 +164,14 @@ public:
 
         [[nodiscard]] training_metrics_t train(std::size_t episodes);
 
+        /// Saves policy/target networks and optimizer (torch::save), the replay buffer and trainer counters.
+        /// The checkpoint is written to a staging directory and renamed into place as a whole.
+        void save_checkpoint(const std::string& directory) const;
+        /// Restores a checkpoint written by save_checkpoint. Returns false if the directory holds no checkpoint.
+        bool load_checkpoint(const std::string& directory);
+
+        [[nodiscard]] std::size_t completed_episodes() const { return episodes_completed; }
+
 private:
         [[nodiscard]] double sample_epsilon() const;
         [[nodiscard]] std::optional<action_mask_t> compute_legal_mask(const combat_observation_t& observation) const;
@@ -111,8 +185,9 @@ private:
         [[nodiscard]] torch::Tensor apply_legal_mask_batch(const torch::Tensor& q_values,
                                                            const std::vector<action_mask_t>& masks) const;
         [[nodiscard]] torch::Tensor mask_to_tensor(const action_mask_t& mask, torch::Device target_device) const;
-        [[nodiscard]] std::optional<float> optimise_model();
+        [[nodiscard]] std::optional<float> optimise_model(training_throughput_t* throughput = nullptr);
         void update_target_network();
+        void emit_throughput(std::size_t episode, const training_throughput_t& throughput);
 
         combat_environment_t* environment;
         combat_agent_t* policy_agent;
@@ -127,5 +202,6 @@ private:
         std::unique_ptr<torch::optim::Adam> optimizer;
         std::mt19937 rng;
         std::size_t global_step = 0;
+        std::size_t episodes_completed = 0;
 };
 
@@ -1,87 +1,393 @@
+#include "core/block_compression.h"
 #include "core/game.h"
 #include "core/game_config.h"
 
-const std::vector<unit_type_e> possible_units = { UNIT_PIXIE, UNIT_BISHOP, UNIT_ARCHER, UNIT_MINOTAUR };
-const std::vector<spell_e> known_spells = { SPELL_UNKNOWN, SPELL_BLESS, SPELL_CURSE, SPELL_AIR_SHIELD, SPELL_LIGHTNING_BOLT, SPELL_HASTE};
-const int troop_count = 4;
-const int evaluation_iterations = 100;
-
-const std::string config_path = "C:\\code\\ConquerorsOfFate\\Source\\ConquerorsOfFate\\homm\\";
-
-int main() {
-	game_config::load_game_data(config_path);
-
-	game_t game;
-	//setup_callbacks(game);
-
-	int iter = 0;
-	while(true) {
-		iter++;
-		battlefield_t battle;
-
-		hero_t hero = game_config::get_heroes()[0];
-		hero.attack = 0;
-		hero.defense = 0;
-		hero.power = 4;
-		hero.knowledge = 4;
-		hero.init_hero(0, TERRAIN_GRASS);
-		for(const auto& s : known_spells)
-			hero.learn_spell(s);
-
-		int total_army_hp = 0;
-		for(int i = 0; i < troop_count; i++) {
-			auto& tr = hero.troops[i];
-			tr.unit_type = utils::rand_item(possible_units);
-			tr.stack_size = 1 + rand() % 15;
-			const auto& cr = game_config::get_creature(tr.unit_type);
-			total_army_hp += (cr.health * tr.stack_size);
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//generates labelled spell/matchup outcomes for balance analysis and model pre-training.
+//every scenario is one cell of the command-line grid (power x knowledge) with a randomly drawn hero army and
+//a monster stack of roughly equal total health; for each spell in the list the hero casts it once at the start
+//of a quick combat and the battle is resolved --iterations times. one fixed-size record is written per
+//(scenario, spell) pair, into shards of --shard-scenarios scenarios that are generated in parallel.
+//
+//shard file layout (little endian): shard_header_t, then record_count outcome_record_t.
+//payload_crc32 covers the records, header_crc32 covers the header bytes before it; manifest.tsv lists every shard.
+
+namespace {
+
+constexpr uint32_t SHARD_MAGIC = 0x53464F43; //"COFS"
+constexpr uint16_t SHARD_VERSION = 1;
+constexpr uint TROOP_SLOTS = game_config::HERO_TROOP_SLOTS;
+
+#pragma pack(push, 1)
+struct outcome_record_t {
+	uint32_t scenario_index = 0;
+	uint16_t spell = 0;
+	uint8_t power = 0;
+	uint8_t knowledge = 0;
+	uint16_t troop_unit[TROOP_SLOTS] = {};
+	uint16_t troop_stack[TROOP_SLOTS] = {};
+	uint16_t monster_unit = 0;
+	uint16_t monster_quantity = 0;
+	uint32_t army_hp = 0;
+	uint16_t iterations = 0;
+	uint16_t attacker_victories = 0;
+};
+
+struct shard_header_t {
+	uint32_t magic = SHARD_MAGIC;
+	uint16_t version = SHARD_VERSION;
+	uint16_t record_size = sizeof(outcome_record_t);
+	uint32_t shard_index = 0;
+	uint32_t record_count = 0;
+	uint64_t seed = 0;
+	uint32_t payload_crc32 = 0;
+	uint32_t header_crc32 = 0;
+};
+#pragma pack(pop)
+
+struct generator_options_t {
+	std::string config_path;
+	std::string output_directory = "spell_data";
+	std::vector<unit_type_e> units = { UNIT_PIXIE, UNIT_BISHOP, UNIT_ARCHER, UNIT_MINOTAUR };
+	std::vector<spell_e> spells = { SPELL_UNKNOWN, SPELL_BLESS, SPELL_CURSE, SPELL_AIR_SHIELD, SPELL_LIGHTNING_BOLT, SPELL_HASTE };
+	std::vector<int> power_values = { 4 };
+	std::vector<int> knowledge_values = { 4 };
+	uint troop_slots = 4;
+	int max_stack_size = 15;
+	int samples_per_cell = 1000;
+	int iterations = 100;
+	int shard_scenarios = 1024;
+	uint thread_count = 0;
+	uint64_t seed = 1;
+};
+
+uint64_t mix_seed(uint64_t seed, uint64_t index) {
+	uint64_t value = seed + 0x9E3779B97F4A7C15ull * (index + 1);
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+	return value ^ (value >> 31);
+}
+
+std::vector<std::string> split_list(const std::string& value) {
+	std::vector<std::string> items;
+	std::stringstream stream(value);
+	std::string item;
+	while(std::getline(stream, item, ','))
+		if(!item.empty())
+			items.push_back(item);
+	return items;
+}
+
+template<typename enum_t>
+bool parse_enum_list(const std::string& value, const std::string& prefix, std::vector<enum_t>& out) {
+	out.clear();
+	for(auto item : split_list(value)) {
+		for(auto& c : item)
+			c = (char)std::toupper((unsigned char)c);
+
+		if(std::isdigit((unsigned char)item[0])) {
+			out.push_back((enum_t)std::stoi(item));
+			continue;
+		}
+		if(item == "NONE") {
+			out.push_back((enum_t)0);
+			continue;
+		}
+
+		auto parsed = magic_enum::enum_cast<enum_t>(item.rfind(prefix, 0) == 0 ? item : prefix + item);
+		if(!parsed) {
+			std::fprintf(stderr, "unknown value '%s'\n", item.c_str());
+			return false;
+		}
+		out.push_back(*parsed);
+	}
+	return !out.empty();
+}
+
+bool parse_int_list(const std::string& value, std::vector<int>& out) {
+	out.clear();
+	for(const auto& item : split_list(value))
+		out.push_back(std::stoi(item));
+	return !out.empty();
+}
+
+void print_usage(const char* program) {
+	std::printf("usage: %s [options]\n"
+		"  --config <path>            game data directory (default: built-in search path)\n"
+		"  --output <dir>             output directory for shards and manifest (default: spell_data)\n"
+		"  --units <list>             comma separated unit types drawn for both sides (e.g. PIXIE,ARCHER)\n"
+		"  --spells <list>            comma separated spells to evaluate, NONE for no spell\n"
+		"  --power <list>             hero power values in the grid (default: 4)\n"
+		"  --knowledge <list>         hero knowledge values in the grid (default: 4)\n"
+		"  --troop-slots <n>          hero army slots filled per scenario (default: 4)\n"
+		"  --max-stack <n>            maximum hero stack size (default: 15)\n"
+		"  --samples <n>              random armies per grid cell (default: 1000)\n"
+		"  --iterations <n>           battles per scenario and spell (default: 100)\n"
+		"  --shard-scenarios <n>      scenarios per shard (default: 1024)\n"
+		"  --threads <n>              worker threads (default: all cores)\n"
+		"  --seed <n>                 base seed (default: 1)\n", program);
+}
+
+bool parse_arguments(int argc, char** argv, generator_options_t& options) {
+	for(int i = 1; i < argc; i++) {
+		std::string key = argv[i];
+		if(key == "--help" || key == "-h")
+			return false;
+		if(i + 1 >= argc) {
+			std::fprintf(stderr, "option %s requires a value\n", key.c_str());
+			return false;
 		}
 
-		map_monster_t monster;
-		monster.unit_type = utils::rand_item(possible_units);
-		const auto& cr = game_config::get_creature(monster.unit_type);
-		monster.quantity = 1 + (total_army_hp / cr.health);
-
-		for(const auto& selected_spell : known_spells) {
-			int hero_victories = 0;
-			for(int i = 0; i < evaluation_iterations; i++) {
-				auto hero_copy = hero;
-				auto monster_copy = monster;
-				auto battle_copy = battle;
-				srand((iter * 1000) + i);
-				battle_copy.init_hero_monster_battle(&hero_copy, &monster_copy);
-				battle_copy.is_quick_combat = true;
-				//while(!battle_copy.is_attackers_turn())
-				//	battle_copy.auto_move_troop();
-
-				if(selected_spell != SPELL_UNKNOWN) {
-					battlefield_unit_t* target = nullptr;
-					for(auto& atr : battle_copy.attacking_army.troops) {
-						if(battle_copy.is_spell_target_valid(&hero_copy, &atr, selected_spell)) {
-							assert(selected_spell != SPELL_CURSE);
-							target = &atr;
-							break;
-						}
-					}
-					if(!target) {
-						for(auto& dtr : battle_copy.defending_army.troops) {
-							if(battle_copy.is_spell_target_valid(&hero_copy, &dtr, selected_spell)) {
-								assert(selected_spell != SPELL_HASTE);
-								target = &dtr;
-								break;
-							}
-						}
-					}
-
-					battle_copy.cast_spell(&hero_copy, selected_spell, -1, -1, target);
-				}
-		
-				auto result = battle_copy.compute_quick_combat();
-				if(result == BATTLE_ATTACKER_VICTORY)// && result != BATTLE_DEFENDER_VICTORY)
-					hero_victories++;
+		std::string value = argv[++i];
+		bool ok = true;
+		try {
+			if(key == "--config")
+				options.config_path = value;
+			else if(key == "--output")
+				options.output_directory = value;
+			else if(key == "--units")
+				ok = parse_enum_list(value, "UNIT_", options.units);
+			else if(key == "--spells")
+				ok = parse_enum_list(value, "SPELL_", options.spells);
+			else if(key == "--power")
+				ok = parse_int_list(value, options.power_values);
+			else if(key == "--knowledge")
+				ok = parse_int_list(value, options.knowledge_values);
+			else if(key == "--troop-slots")
+				options.troop_slots = (uint)std::stoi(value);
+			else if(key == "--max-stack")
+				options.max_stack_size = std::stoi(value);
+			else if(key == "--samples")
+				options.samples_per_cell = std::stoi(value);
+			else if(key == "--iterations")
+				options.iterations = std::stoi(value);
+			else if(key == "--shard-scenarios")
+				options.shard_scenarios = std::stoi(value);
+			else if(key == "--threads")
+				options.thread_count = (uint)std::stoi(value);
+			else if(key == "--seed")
+				options.seed = std::stoull(value);
+			else {
+				std::fprintf(stderr, "unknown option %s\n", key.c_str());
+				return false;
 			}
+		}
+		catch(const std::exception&) {
+			ok = false;
+		}
 
-			std::printf("win rate using spell[%s]: %.2f\n", magic_enum::enum_name(selected_spell).data(), 100.f * (float)hero_victories / evaluation_iterations);
+		if(!ok) {
+			std::fprintf(stderr, "invalid value for %s: %s\n", key.c_str(), value.c_str());
+			return false;
 		}
 	}
-}
\ No newline at end of file
+
+	if(options.troop_slots == 0 || options.troop_slots > TROOP_SLOTS || options.max_stack_size < 1 || options.samples_per_cell < 1
+		|| options.iterations < 1 || options.iterations > UINT16_MAX || options.shard_scenarios < 1) {
+		std::fprintf(stderr, "option out of range\n");
+		return false;
+	}
+
+	return true;
+}
+
+battlefield_unit_t* find_spell_target(battlefield_t& battle, hero_t* caster, spell_e spell) {
+	for(auto& troop : battle.attacking_army.troops)
+		if(battle.is_spell_target_valid(caster, &troop, spell))
+			return &troop;
+	for(auto& troop : battle.defending_army.troops)
+		if(battle.is_spell_target_valid(caster, &troop, spell))
+			return &troop;
+	return nullptr;
+}
+
+//builds one scenario from the shard rng and evaluates every spell against it
+void generate_scenario(const generator_options_t& options, uint32_t scenario_index, std::mt19937_64& rng, std::vector<outcome_record_t>& records) {
+	const size_t cell_count = options.power_values.size() * options.knowledge_values.size();
+	const size_t cell = (scenario_index / options.samples_per_cell) % cell_count;
+	const int power = options.power_values[cell % options.power_values.size()];
+	const int knowledge = options.knowledge_values[cell / options.power_values.size()];
+
+	hero_t hero = game_config::get_heroes()[0];
+	hero.attack = 0;
+	hero.defense = 0;
+	hero.power = power;
+	hero.knowledge = knowledge;
+	hero.init_hero(0, TERRAIN_GRASS);
+	for(auto spell : options.spells)
+		hero.learn_spell(spell);
+
+	outcome_record_t base;
+	base.scenario_index = scenario_index;
+	base.power = (uint8_t)power;
+	base.knowledge = (uint8_t)knowledge;
+	base.iterations = (uint16_t)options.iterations;
+
+	std::uniform_int_distribution<size_t> unit_distribution(0, options.units.size() - 1);
+	std::uniform_int_distribution<int> stack_distribution(1, options.max_stack_size);
+
+	for(uint i = 0; i < options.troop_slots; i++) {
+		auto& troop = hero.troops[i];
+		troop.unit_type = options.units[unit_distribution(rng)];
+		troop.stack_size = (uint16_t)stack_distribution(rng);
+		base.army_hp += game_config::get_creature(troop.unit_type).health * troop.stack_size;
+		base.troop_unit[i] = (uint16_t)troop.unit_type;
+		base.troop_stack[i] = troop.stack_size;
+	}
+
+	map_monster_t monster;
+	monster.unit_type = options.units[unit_distribution(rng)];
+	monster.quantity = (uint16_t)std::min<uint32_t>(UINT16_MAX, 1 + (base.army_hp / game_config::get_creature(monster.unit_type).health));
+	base.monster_unit = (uint16_t)monster.unit_type;
+	base.monster_quantity = monster.quantity;
+
+	//each battle rolls its own battlefield dice from battle_seed + i, so shards are reproducible on any thread count
+	const uint64_t battle_seed = rng();
+	for(auto spell : options.spells) {
+		auto record = base;
+		record.spell = (uint16_t)spell;
+
+		for(int i = 0; i < options.iterations; i++) {
+			auto hero_copy = hero;
+			auto monster_copy = monster;
+			battlefield_t battle;
+			battle.rng_seed = battle_seed + i;
+			battle.init_hero_monster_battle(&hero_copy, &monster_copy);
+			battle.is_quick_combat = true;
+
+			if(spell != SPELL_UNKNOWN)
+				battle.cast_spell(&hero_copy, spell, -1, -1, find_spell_target(battle, &hero_copy, spell));
+
+			if(battle.compute_quick_combat() == BATTLE_ATTACKER_VICTORY)
+				record.attacker_victories++;
+		}
+
+		records.push_back(record);
+	}
+}
+
+bool write_shard(const std::filesystem::path& path, uint32_t shard_index, uint64_t seed, const std::vector<outcome_record_t>& records, uint32_t& payload_crc) {
+	shard_header_t header;
+	header.shard_index = shard_index;
+	header.record_count = (uint32_t)records.size();
+	header.seed = seed;
+	header.payload_crc32 = block_crc32(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(outcome_record_t));
+	header.header_crc32 = block_crc32(reinterpret_cast<const char*>(&header), offsetof(shard_header_t, header_crc32));
+	payload_crc = header.payload_crc32;
+
+	//written under a temporary name so an interrupted run never leaves a shard that looks complete
+	auto temporary_path = path;
+	temporary_path += ".tmp";
+	{
+		std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+		if(!file)
+			return false;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(outcome_record_t));
+		if(!file)
+			return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporary_path, path, error);
+	return !error;
+}
+
+}
+
+int main(int argc, char** argv) {
+	generator_options_t options;
+	if(!parse_arguments(argc, argv, options)) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if(game_config::load_game_data(options.config_path) != 0) {
+		std::fprintf(stderr, "failed to load game data from '%s'\n", options.config_path.c_str());
+		return 1;
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(options.output_directory, error);
+	if(error) {
+		std::fprintf(stderr, "could not create output directory '%s'\n", options.output_directory.c_str());
+		return 1;
+	}
+
+	const uint64_t scenario_count = (uint64_t)options.power_values.size() * options.knowledge_values.size() * options.samples_per_cell;
+	const uint32_t shard_count = (uint32_t)((scenario_count + options.shard_scenarios - 1) / options.shard_scenarios);
+	uint thread_count = options.thread_count ? options.thread_count : std::max(1u, std::thread::hardware_concurrency());
+	thread_count = std::min<uint>(thread_count, shard_count);
+
+	std::printf("generating %llu scenarios x %zu spells x %d battles into %u shards on %u threads\n",
+		(unsigned long long)scenario_count, options.spells.size(), options.iterations, shard_count, thread_count);
+
+	std::atomic<uint32_t> next_shard = 0;
+	std::atomic<bool> failed = false;
+	std::vector<uint32_t> shard_crcs(shard_count, 0);
+	std::vector<uint32_t> shard_records(shard_count, 0);
+	std::mutex progress_mutex;
+	uint32_t shards_done = 0;
+
+	auto worker = [&]() {
+		std::vector<outcome_record_t> records;
+		for(uint32_t shard = next_shard++; shard < shard_count && !failed; shard = next_shard++) {
+			//each shard owns its rng, so the drawn scenarios do not depend on which worker ran it
+			const uint64_t shard_seed = mix_seed(options.seed, shard);
+			std::mt19937_64 rng(shard_seed);
+
+			records.clear();
+			records.reserve((size_t)options.shard_scenarios * options.spells.size());
+			const uint64_t first = (uint64_t)shard * options.shard_scenarios;
+			const uint64_t last = std::min<uint64_t>(scenario_count, first + options.shard_scenarios);
+			for(uint64_t scenario = first; scenario < last; scenario++)
+				generate_scenario(options, (uint32_t)scenario, rng, records);
+
+			char file_name[32];
+			std::snprintf(file_name, sizeof(file_name), "shard_%05u.bin", shard);
+			if(!write_shard(std::filesystem::path(options.output_directory) / file_name, shard, shard_seed, records, shard_crcs[shard])) {
+				std::fprintf(stderr, "failed to write %s\n", file_name);
+				failed = true;
+				return;
+			}
+			shard_records[shard] = (uint32_t)records.size();
+
+			std::lock_guard<std::mutex> lock(progress_mutex);
+			shards_done++;
+			std::printf("shard %u done (%u/%u)\n", shard, shards_done, shard_count);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for(uint i = 0; i < thread_count; i++)
+		workers.emplace_back(worker);
+	for(auto& thread : workers)
+		thread.join();
+
+	if(failed)
+		return 1;
+
+	std::ofstream manifest(std::filesystem::path(options.output_directory) / "manifest.tsv", std::ios::trunc);
+	manifest << "shard\trecords\trecord_size\tcrc32\n";
+	for(uint32_t shard = 0; shard < shard_count; shard++) {
+		char line[64];
+		std::snprintf(line, sizeof(line), "shard_%05u.bin\t%u\t%zu\t%08x\n", shard, shard_records[shard], sizeof(outcome_record_t), shard_crcs[shard]);
+		manifest << line;
+	}
+
+	return manifest ? 0 : 1;
+}
@@ -0,0 +1,36 @@
+TEMPLATE = app
+TARGET = spell_data_generation
+
+INCLUDEPATH += ../../..
+INCLUDEPATH += ../..
+
+CONFIG += qt console c++20 link_pkgconfig
+CONFIG -= app_bundle
+QT += core network gui
+PKGCONFIG += lua5.4
+
+LIBS += -llua5.4
+
+SOURCES += spell_data_generation.cpp \
+           ../core/ai_adventure_map.cpp \
+           ../core/ai_combat.cpp \
+           ../core/ai_value_field.cpp \
+           ../core/adventure_map.cpp \
+           ../core/hero.cpp \
+           ../core/artifact.cpp \
+           ../core/battlefield.cpp \
+           ../core/block_compression.cpp \
+           ../core/fog_of_war.cpp \
+           ../core/lua_api.cpp \
+           ../core/game.cpp \
+           ../core/game_config.cpp \
+           ../core/interactable_object.cpp \
+           ../core/map_file.cpp \
+           ../core/map_file_v2.cpp \
+           ../core/object_index.cpp \
+           ../core/script.cpp \
+           ../core/save_checkpoint.cpp \
+           ../core/save_worker.cpp \
+           ../core/tile_store.cpp \
+           ../core/town.cpp \
+           ../core/zone_graph.cpp
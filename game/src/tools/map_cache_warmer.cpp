@@ -0,0 +1,137 @@
+#include "core/game_config.h"
+#include "core/map_file_v2.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//builds the binary caches of every JSON map under a directory (see read_map_file_json_cached()), so that the first
+//load after installing or editing maps does not pay for parsing the JSON. caches that are already current are
+//checked and left alone; stale or damaged ones are rebuilt. maps are processed in parallel, one per worker at a time.
+//exits non-zero if any map fails to load.
+
+namespace {
+
+struct warmer_options_t {
+	std::string config_path;
+	std::string maps_directory = "Maps";
+	uint thread_count = 0;
+};
+
+void print_usage(const char* program) {
+	std::printf("usage: %s [options]\n"
+		"  --config <path>            game data directory (default: built-in search path)\n"
+		"  --maps <dir>               directory searched recursively for *.json maps (default: Maps)\n"
+		"  --threads <n>              worker threads (default: all cores)\n", program);
+}
+
+bool parse_arguments(int argc, char** argv, warmer_options_t& options) {
+	for(int i = 1; i < argc; i++) {
+		std::string key = argv[i];
+		if(key == "--help" || key == "-h")
+			return false;
+		if(i + 1 >= argc) {
+			std::fprintf(stderr, "option %s requires a value\n", key.c_str());
+			return false;
+		}
+
+		std::string value = argv[++i];
+		bool ok = true;
+		try {
+			if(key == "--config")
+				options.config_path = value;
+			else if(key == "--maps")
+				options.maps_directory = value;
+			else if(key == "--threads")
+				options.thread_count = (uint)std::stoi(value);
+			else {
+				std::fprintf(stderr, "unknown option %s\n", key.c_str());
+				return false;
+			}
+		}
+		catch(const std::exception&) {
+			ok = false;
+		}
+
+		if(!ok) {
+			std::fprintf(stderr, "invalid value for %s: %s\n", key.c_str(), value.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+}
+
+int main(int argc, char** argv) {
+	warmer_options_t options;
+	if(!parse_arguments(argc, argv, options)) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if(game_config::load_game_data(options.config_path) != 0) {
+		std::fprintf(stderr, "failed to load game data from '%s'\n", options.config_path.c_str());
+		return 1;
+	}
+
+	std::vector<std::string> map_paths;
+	std::error_code error;
+	for(std::filesystem::recursive_directory_iterator it(options.maps_directory, error), end; !error && it != end; it.increment(error)) {
+		if(it->is_regular_file() && it->path().extension() == ".json")
+			map_paths.push_back(it->path().string());
+	}
+	if(error) {
+		std::fprintf(stderr, "could not read maps directory '%s'\n", options.maps_directory.c_str());
+		return 1;
+	}
+	std::sort(map_paths.begin(), map_paths.end());
+
+	uint thread_count = options.thread_count ? options.thread_count : std::max(1u, std::thread::hardware_concurrency());
+	thread_count = std::max(1u, std::min<uint>(thread_count, (uint)map_paths.size()));
+
+	std::printf("warming caches for %zu maps in '%s' on %u threads\n", map_paths.size(), options.maps_directory.c_str(), thread_count);
+
+	const auto start = std::chrono::steady_clock::now();
+	std::atomic<size_t> next_map = 0;
+	std::atomic<uint> current_count = 0;
+	std::atomic<uint> rebuilt_count = 0;
+	std::atomic<uint> failed_count = 0;
+	std::mutex output_mutex;
+
+	auto worker = [&]() {
+		for(size_t i = next_map++; i < map_paths.size(); i = next_map++) {
+			bool was_current = false;
+			auto err = update_map_json_cache(map_paths[i], &was_current);
+
+			std::lock_guard<std::mutex> lock(output_mutex);
+			if(err != SUCCESS) {
+				failed_count++;
+				std::fprintf(stderr, "%s: %s\n", map_paths[i].c_str(), get_error_string_from_error_code(err).c_str());
+			}
+			else if(was_current)
+				current_count++;
+			else {
+				rebuilt_count++;
+				std::printf("%s: cache written\n", map_paths[i].c_str());
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for(uint i = 0; i < thread_count; i++)
+		workers.emplace_back(worker);
+	for(auto& thread : workers)
+		thread.join();
+
+	const auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+	std::printf("%u written, %u already current, %u failed in %lldms\n", rebuilt_count.load(), current_count.load(), failed_count.load(), (long long)millis);
+
+	return failed_count ? 1 : 0;
+}
@@ -0,0 +1,342 @@
+#include "core/game.h"
+#include "core/game_config.h"
+#include "core/rmg.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//generates random maps from the built-in biome templates on every core and validates each one, to measure how long
+//generation takes and how often it produces a map that cannot be played. map i of a run uses seed --seed + i and, under
+//--template all, the templates in turn, so any map reported invalid can be regenerated on its own with
+//--seed <its seed> --template <its template> --maps 1.
+//
+//a map is invalid if:
+//  - a player's town cannot reach another player's town (get_route, fighting guards and collecting pickups on the way)
+//  - two zones its template connects have no route between their towns
+//  - a town can reach a town in another zone without fighting a guard (get_route, blockables respected)
+//  - an object cannot be entered (is_object_accessible())
+//  - a mine cannot be reached from its zone's town
+//
+//every map gets its own rmg_context_t with a single terrain thread, so the maps themselves are generated in parallel.
+
+namespace {
+
+enum validation_failure_e : uint {
+	FAILURE_TOWN_UNREACHABLE = 1 << 0,
+	FAILURE_ZONE_CONNECTION_MISSING = 1 << 1,
+	FAILURE_ZONE_UNGUARDED = 1 << 2,
+	FAILURE_OBJECT_BLOCKED = 1 << 3,
+	FAILURE_MINE_UNREACHABLE = 1 << 4,
+	FAILURE_COUNT = 5
+};
+
+const char* FAILURE_NAMES[FAILURE_COUNT] = { "town unreachable", "zone connection missing", "zone crossing unguarded", "object blocked", "mine unreachable" };
+const char* STAGE_NAMES[RMG_STAGE_COUNT] = { "terrain", "flood fill", "towns", "roads", "objects", "doodads" };
+
+struct map_template_t {
+	const char* name;
+	int size;
+};
+
+const std::array<map_template_t, 3> MAP_TEMPLATES = { { { "small", 72 }, { "medium", 108 }, { "large", 144 } } };
+
+struct harness_options_t {
+	std::string config_path;
+	std::string template_name = "all";
+	int map_count = 1000;
+	uint thread_count = 0;
+	uint32_t seed = 1;
+	bool verbose = false;
+};
+
+struct map_result_t {
+	uint32_t seed = 0;
+	int template_index = 0;
+	bool generated = false;
+	uint failures = 0;
+	std::array<int64_t, RMG_STAGE_COUNT> stage_microseconds = {};
+	int64_t generation_microseconds = 0;
+	int64_t validation_microseconds = 0;
+};
+
+hero_t make_route_hero(const interactable_object_t* from) {
+	hero_t hero;
+	hero.player = PLAYER_1;
+	hero.x = (uint8_t)from->x;
+	hero.y = (uint8_t)from->y;
+	return hero;
+}
+
+bool has_route(const game_t& game, const interactable_object_t* from, const interactable_object_t* to, bool ignore_blockables) {
+	auto hero = make_route_hero(from);
+	const auto route = ignore_blockables ? game.map.get_route_ignoring_blockables(&hero, to->x, to->y, &game)
+		: game.map.get_route(&hero, to->x, to->y, &game);
+	return !route.empty();
+}
+
+uint validate_map(game_t& game, const std::vector<biome_t>& biomes) {
+	auto& map = game.map;
+	uint failures = 0;
+
+	//routes are taken as player 1, who sees the whole map
+	player_t player;
+	player.player_number = PLAYER_1;
+	player.tile_visibility = tile_bitset_t(map.width * map.height, true);
+	player.tile_observability = tile_bitset_t(map.width * map.height, true);
+	game.players.push_back(player);
+	map.monster_guarded_cache_valid = false;
+
+	//each biome's main town sits on its terrain center
+	std::vector<const interactable_object_t*> zone_towns(biomes.size(), nullptr);
+	for(size_t i = 0; i < biomes.size(); i++) {
+		auto town = map.get_interactable_object_for_tile(biomes[i].terrain_center.x, biomes[i].terrain_center.y);
+		if(town && town->object_type == OBJECT_MAP_TOWN)
+			zone_towns[i] = town;
+		else if(biomes[i].player != PLAYER_NONE)
+			failures |= FAILURE_TOWN_UNREACHABLE;
+	}
+
+	for(size_t a = 0; a < biomes.size(); a++) {
+		for(size_t b = 0; b < biomes.size(); b++) {
+			if(a == b || !zone_towns[a] || !zone_towns[b])
+				continue;
+
+			const bool players = biomes[a].player != PLAYER_NONE && biomes[b].player != PLAYER_NONE;
+			const bool connected = std::find(biomes[a].zone_connections.begin(), biomes[a].zone_connections.end(), biomes[b].zone_id) != biomes[a].zone_connections.end();
+			if((players || connected) && !has_route(game, zone_towns[a], zone_towns[b], true))
+				failures |= players ? FAILURE_TOWN_UNREACHABLE : FAILURE_ZONE_CONNECTION_MISSING;
+
+			if(has_route(game, zone_towns[a], zone_towns[b], false))
+				failures |= FAILURE_ZONE_UNGUARDED;
+		}
+	}
+
+	for(auto object : map.objects) {
+		if(!object)
+			continue;
+
+		if(!is_object_accessible(map, object))
+			failures |= FAILURE_OBJECT_BLOCKED;
+
+		if(object->object_type != OBJECT_MINE)
+			continue;
+
+		auto zone_id = map.get_tile(object->x, object->y).zone_id;
+		for(size_t i = 0; i < biomes.size(); i++) {
+			if(biomes[i].zone_id == zone_id && zone_towns[i] && !has_route(game, zone_towns[i], object, true))
+				failures |= FAILURE_MINE_UNREACHABLE;
+		}
+	}
+
+	return failures;
+}
+
+void generate_and_validate(map_result_t& result) {
+	const auto& map_template = MAP_TEMPLATES[result.template_index];
+	auto biomes = make_four_player_biomes(map_template.size);
+
+	game_t game;
+	game.map.width = map_template.size;
+	game.map.height = map_template.size;
+	game.map.tiles.reset(map_template.size, map_template.size);
+
+	rmg_context_t context(result.seed, 1);
+	auto start = std::chrono::steady_clock::now();
+	result.generated = generate_random_map(game.map, biomes, context) == RMG_RESULT_OK;
+	auto now = std::chrono::steady_clock::now();
+	result.generation_microseconds = std::chrono::duration_cast<std::chrono::microseconds>(now - start).count();
+	result.stage_microseconds = context.stage_microseconds;
+	if(!result.generated)
+		return;
+
+	start = now;
+	result.failures = validate_map(game, biomes);
+	result.validation_microseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+double percentile(const std::vector<int64_t>& sorted, double fraction) {
+	if(sorted.empty())
+		return 0.;
+	return sorted[std::min(sorted.size() - 1, (size_t)(fraction * (sorted.size() - 1) + .5))] / 1000.;
+}
+
+void print_timing(const char* name, std::vector<int64_t> microseconds) {
+	std::sort(microseconds.begin(), microseconds.end());
+	std::printf("  %-12s p50 %8.2fms  p90 %8.2fms  p99 %8.2fms  max %8.2fms\n", name,
+		percentile(microseconds, .5), percentile(microseconds, .9), percentile(microseconds, .99), percentile(microseconds, 1.));
+}
+
+void print_report(const std::vector<map_result_t>& results, int template_index) {
+	std::array<std::vector<int64_t>, RMG_STAGE_COUNT> stages;
+	std::vector<int64_t> generation;
+	std::vector<int64_t> validation;
+	std::array<int, FAILURE_COUNT> failure_counts = {};
+	int map_count = 0;
+	int errors = 0;
+	int invalid = 0;
+
+	for(const auto& result : results) {
+		if(result.template_index != template_index)
+			continue;
+
+		map_count++;
+		if(!result.generated) {
+			errors++;
+			continue;
+		}
+
+		for(int s = 0; s < RMG_STAGE_COUNT; s++)
+			stages[s].push_back(result.stage_microseconds[s]);
+		generation.push_back(result.generation_microseconds);
+		validation.push_back(result.validation_microseconds);
+
+		if(result.failures)
+			invalid++;
+		for(int f = 0; f < FAILURE_COUNT; f++) {
+			if(result.failures & (1u << f))
+				failure_counts[f]++;
+		}
+	}
+
+	if(!map_count)
+		return;
+
+	const auto& map_template = MAP_TEMPLATES[template_index];
+	std::printf("%s (%dx%d): %d maps, %d failed to generate, %d invalid (%.2f%%)\n", map_template.name, map_template.size, map_template.size,
+		map_count, errors, invalid, 100. * invalid / map_count);
+	for(int s = 0; s < RMG_STAGE_COUNT; s++)
+		print_timing(STAGE_NAMES[s], stages[s]);
+	print_timing("generation", generation);
+	print_timing("validation", validation);
+	for(int f = 0; f < FAILURE_COUNT; f++)
+		std::printf("  %-24s %6d (%.2f%%)\n", FAILURE_NAMES[f], failure_counts[f], 100. * failure_counts[f] / map_count);
+}
+
+void print_usage(const char* program) {
+	std::printf("usage: %s [options]\n"
+		"  --config <path>            game data directory (default: built-in search path)\n"
+		"  --template <name>          small, medium, large or all, taken in turn (default: all)\n"
+		"  --maps <n>                 maps to generate (default: 1000)\n"
+		"  --threads <n>              worker threads (default: all cores)\n"
+		"  --seed <n>                 seed of the first map, each next map uses the next seed (default: 1)\n"
+		"  --verbose <0|1>            list every invalid map (default: 0)\n", program);
+}
+
+bool parse_arguments(int argc, char** argv, harness_options_t& options) {
+	for(int i = 1; i < argc; i++) {
+		std::string key = argv[i];
+		if(key == "--help" || key == "-h")
+			return false;
+		if(i + 1 >= argc) {
+			std::fprintf(stderr, "option %s requires a value\n", key.c_str());
+			return false;
+		}
+
+		std::string value = argv[++i];
+		bool ok = true;
+		try {
+			if(key == "--config")
+				options.config_path = value;
+			else if(key == "--template") {
+				options.template_name = value;
+				ok = value == "all" || std::any_of(MAP_TEMPLATES.begin(), MAP_TEMPLATES.end(), [&](const map_template_t& t) { return value == t.name; });
+			}
+			else if(key == "--maps")
+				options.map_count = std::stoi(value);
+			else if(key == "--threads")
+				options.thread_count = (uint)std::stoi(value);
+			else if(key == "--seed")
+				options.seed = (uint32_t)std::stoul(value);
+			else if(key == "--verbose")
+				options.verbose = std::stoi(value) != 0;
+			else {
+				std::fprintf(stderr, "unknown option %s\n", key.c_str());
+				return false;
+			}
+		}
+		catch(const std::exception&) {
+			ok = false;
+		}
+
+		if(!ok || options.map_count <= 0) {
+			std::fprintf(stderr, "invalid value for %s: %s\n", key.c_str(), value.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+}
+
+int main(int argc, char** argv) {
+	harness_options_t options;
+	if(!parse_arguments(argc, argv, options)) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if(game_config::load_game_data(options.config_path) != 0) {
+		std::fprintf(stderr, "failed to load game data from '%s'\n", options.config_path.c_str());
+		return 1;
+	}
+
+	std::vector<int> template_indices;
+	for(int i = 0; i < (int)MAP_TEMPLATES.size(); i++) {
+		if(options.template_name == "all" || options.template_name == MAP_TEMPLATES[i].name)
+			template_indices.push_back(i);
+	}
+
+	std::vector<map_result_t> results(options.map_count);
+	for(int i = 0; i < options.map_count; i++) {
+		results[i].seed = options.seed + (uint32_t)i;
+		results[i].template_index = template_indices[i % template_indices.size()];
+	}
+
+	uint thread_count = options.thread_count ? options.thread_count : std::max(1u, std::thread::hardware_concurrency());
+	thread_count = std::min<uint>(thread_count, (uint)options.map_count);
+
+	std::printf("generating %d maps on %u threads\n", options.map_count, thread_count);
+
+	const auto start = std::chrono::steady_clock::now();
+	std::atomic<int> next_map = 0;
+	std::mutex output_mutex;
+	auto worker = [&]() {
+		for(int i = next_map++; i < options.map_count; i = next_map++) {
+			auto& result = results[i];
+			generate_and_validate(result);
+			if(!options.verbose || (result.generated && !result.failures))
+				continue;
+
+			std::lock_guard<std::mutex> lock(output_mutex);
+			std::printf("--seed %u --template %s:", result.seed, MAP_TEMPLATES[result.template_index].name);
+			if(!result.generated)
+				std::printf(" generation failed");
+			for(int f = 0; f < FAILURE_COUNT; f++) {
+				if(result.failures & (1u << f))
+					std::printf(" [%s]", FAILURE_NAMES[f]);
+			}
+			std::printf("\n");
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for(uint i = 0; i < thread_count; i++)
+		workers.emplace_back(worker);
+	for(auto& thread : workers)
+		thread.join();
+
+	const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::printf("%d maps in %.2fs (%.1f maps/s)\n", options.map_count, seconds, seconds > 0. ? options.map_count / seconds : 0.);
+	for(auto template_index : template_indices)
+		print_report(results, template_index);
+
+	bool any_errors = std::any_of(results.begin(), results.end(), [](const map_result_t& result) { return !result.generated; });
+	return any_errors ? 1 : 0;
+}
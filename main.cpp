@@ -1,14 +1,17 @@
 #include "core/game.h"
 #include "core/game_config.h"
 #include "rl/combat_environment.h"
+#include "rl/combat_league.h"
 #include "rl/combat_observation.h"
 #include "rl/combat_training.h"
 
 #include <algorithm>
 #include <cmath>
 #include <cctype>
+#include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <new>
 #include <numeric>
 #include <optional>
 #include <random>
@@ -19,6 +22,25 @@
 #include <utility>
 #include <vector>
 
+#ifdef COF_COUNT_ALLOCATIONS
+//counts heap allocations so training_throughput_t can report allocations per environment step.
+//this replaces the allocator for the whole process (qt and libtorch included), so it is only built on request
+void* operator new(std::size_t size) {
+        training_allocation_counter().fetch_add(1, std::memory_order_relaxed);
+        if(void* ptr = std::malloc(size ? size : 1))
+                return ptr;
+        throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+        std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+        std::free(ptr);
+}
+#endif
+
 namespace {
 
 struct cli_options_t {
@@ -37,6 +59,17 @@ struct cli_options_t {
         int epsilon_decay = 5'000;
         std::vector<int> hidden_layers;
         bool layer_norm = false;
+        bool prepared_reset = false;
+        int metrics_interval = 0;
+        std::string metrics_log;
+        std::string checkpoint_dir;
+        int checkpoint_interval = 0;
+        bool resume = false;
+        std::vector<std::string> league_agents;
+        int league_rounds = 10;
+        int league_threads = 0;
+        int league_scenarios = 8;
+        std::string league_csv;
         std::optional<std::string> device;
         std::string side = "attacker";
         std::optional<int> seed = 42;
@@ -92,6 +125,19 @@ void print_usage(const char* program) {
                   << "  --epsilon-decay <int>        Steps to anneal epsilon (default: 5000)\n"
                   << "  --hidden-layer <int>         Append a hidden layer width (can repeat)\n"
                   << "  --layer-norm[=bool]          Enable layer normalization in policy network\n"
+                  << "  --prepared-reset[=bool]      Reuse a prepared pre-battle snapshot when the scenario is unchanged\n"
+                  << "                               (obstacles are re-rolled per episode; other setup rolls are reused)\n"
+                  << "  --metrics-interval <int>     Episodes between throughput JSON lines (default: 0, off)\n"
+                  << "  --metrics-log <path>         Append throughput JSON lines to a file instead of stdout\n"
+                  << "  --checkpoint-dir <path>      Directory for resumable training checkpoints\n"
+                  << "  --checkpoint-interval <int>  Episodes between checkpoints (default: 0, only at the end)\n"
+                  << "  --resume[=bool]              Resume from the checkpoint in --checkpoint-dir if present\n"
+                  << "  --league-agent <spec>        Run an evaluation league instead of training; spec is\n"
+                  << "                               [name=]<policy.pt|checkpoint dir> or 'builtin' (repeatable)\n"
+                  << "  --league-rounds <int>        League rounds over all pairings and scenarios (default: 10)\n"
+                  << "  --league-threads <int>       League worker threads (default: 0, all cores)\n"
+                  << "  --league-scenarios <int>     Scenarios in the fixed league suite (default: 8)\n"
+                  << "  --league-csv <path>          Write the league win-rate matrix and Elo table as CSV\n"
                   << "  --device <str>               Torch device (e.g. cpu or cuda:0)\n"
                   << "  --side <attacker|defender>   Controlled combat side (default: attacker)\n"
                   << "  --seed <int>                 Random seed (default: 42)\n"
@@ -130,6 +176,28 @@ void apply_option(cli_options_t& options, const std::string& key, const std::str
                 options.hidden_layers.push_back(parse_int(value, "--hidden-layer"));
         } else if(key == "layer-norm") {
                 options.layer_norm = parse_bool(value);
+        } else if(key == "prepared-reset") {
+                options.prepared_reset = parse_bool(value);
+        } else if(key == "metrics-interval") {
+                options.metrics_interval = parse_int(value, "--metrics-interval");
+        } else if(key == "metrics-log") {
+                options.metrics_log = value;
+        } else if(key == "checkpoint-dir") {
+                options.checkpoint_dir = value;
+        } else if(key == "checkpoint-interval") {
+                options.checkpoint_interval = parse_int(value, "--checkpoint-interval");
+        } else if(key == "resume") {
+                options.resume = parse_bool(value);
+        } else if(key == "league-agent") {
+                options.league_agents.push_back(value);
+        } else if(key == "league-rounds") {
+                options.league_rounds = parse_int(value, "--league-rounds");
+        } else if(key == "league-threads") {
+                options.league_threads = parse_int(value, "--league-threads");
+        } else if(key == "league-scenarios") {
+                options.league_scenarios = parse_int(value, "--league-scenarios");
+        } else if(key == "league-csv") {
+                options.league_csv = value;
         } else if(key == "device") {
                 options.device = value;
         } else if(key == "side") {
@@ -174,6 +242,14 @@ cli_options_t parse_arguments(int argc, char** argv) {
                                 options.layer_norm = true;
                                 continue;
                         }
+                        if(key == "prepared-reset") {
+                                options.prepared_reset = true;
+                                continue;
+                        }
+                        if(key == "resume") {
+                                options.resume = true;
+                                continue;
+                        }
                         if(index + 1 >= argc)
                                 throw std::invalid_argument("Option --" + key + " requires a value");
                         value = argv[++index];
@@ -330,6 +406,76 @@ void validate_options(const cli_options_t& options) {
                 throw std::invalid_argument("--epsilon-decay must be non-negative");
         if(options.seed && *options.seed < 0)
                 throw std::invalid_argument("--seed must be non-negative");
+        if(options.metrics_interval < 0)
+                throw std::invalid_argument("--metrics-interval must be non-negative");
+        if(options.checkpoint_interval < 0)
+                throw std::invalid_argument("--checkpoint-interval must be non-negative");
+        if(options.resume && options.checkpoint_dir.empty())
+                throw std::invalid_argument("--resume requires --checkpoint-dir");
+        if(!options.league_agents.empty()) {
+                if(options.league_agents.size() < 2)
+                        throw std::invalid_argument("--league-agent must be given at least twice");
+                if(options.league_rounds <= 0)
+                        throw std::invalid_argument("--league-rounds must be positive");
+                if(options.league_threads < 0)
+                        throw std::invalid_argument("--league-threads must be non-negative");
+                if(options.league_scenarios <= 0)
+                        throw std::invalid_argument("--league-scenarios must be positive");
+        }
+}
+
+league_participant_t parse_league_agent(const std::string& value) {
+        league_participant_t participant;
+        if(to_lower(value) == "builtin") {
+                participant.name = "builtin";
+                return participant;
+        }
+
+        const auto equals_position = value.find('=');
+        if(equals_position != std::string::npos) {
+                participant.name = value.substr(0, equals_position);
+                participant.checkpoint_path = value.substr(equals_position + 1);
+        } else {
+                participant.name = value;
+                participant.checkpoint_path = value;
+        }
+
+        if(to_lower(participant.checkpoint_path) == "builtin")
+                participant.checkpoint_path.clear();
+        return participant;
+}
+
+int run_league(const cli_options_t& options, const CombatNetworkOptions& network_options) {
+        std::vector<league_participant_t> participants;
+        for(const auto& entry : options.league_agents)
+                participants.push_back(parse_league_agent(entry));
+
+        //fixed suite: the same seed always yields the same scenarios, so rounds are comparable across runs
+        std::mt19937 scenario_rng(static_cast<uint32_t>(options.seed.value_or(42)));
+        std::vector<combat_scenario_spec_t> scenarios;
+        for(int index = 0; index < options.league_scenarios; ++index)
+                scenarios.push_back(build_default_scenario(scenario_rng, options.scenario_options));
+
+        league_config_t config;
+        config.rounds = static_cast<std::size_t>(options.league_rounds);
+        config.thread_count = static_cast<std::size_t>(options.league_threads);
+        config.seed = static_cast<uint32_t>(options.seed.value_or(42));
+        config.network_options = network_options;
+        config.legal_action_fn = [](const combat_observation_t& observation) {
+                return std::optional<action_mask_t>(legal_action_mask(observation));
+        };
+
+        try {
+                const auto results = run_combat_league(participants, scenarios, config);
+                results.print_summary(std::cout);
+                if(!options.league_csv.empty())
+                        results.write_csv(options.league_csv);
+        } catch(const std::exception& ex) {
+                std::cerr << "Error: league failed: " << ex.what() << "\n";
+                return 1;
+        }
+
+        return 0;
 }
 
 double compute_mean(const std::vector<float>& values) {
@@ -387,12 +533,16 @@ int main(int argc, char** argv) {
         }
 
         combat_environment_t environment(game_instance, side);
+        environment.session().use_prepared_scenario = options.prepared_reset;
 
         const auto hidden_layers = resolve_hidden_layers(options.hidden_layers);
         CombatNetworkOptions policy_options;
         policy_options.hidden_layers = hidden_layers;
         policy_options.use_layer_norm = options.layer_norm;
 
+        if(!options.league_agents.empty())
+                return run_league(options, policy_options);
+
         torch::Device device = torch::kCUDA;
         if(options.device) {
                 try {
@@ -433,6 +583,10 @@ int main(int argc, char** argv) {
                                             ? options.gradient_clip
                                             : std::optional<double>();
         config.learning_rate = options.learning_rate;
+        config.throughput_log_interval = static_cast<std::size_t>(options.metrics_interval);
+        config.throughput_log_path = options.metrics_log;
+        config.checkpoint_directory = options.checkpoint_dir;
+        config.checkpoint_interval = static_cast<std::size_t>(options.checkpoint_interval);
 
         epsilon_schedule_t epsilon_schedule;
         epsilon_schedule.start = options.epsilon_start;
@@ -466,6 +620,20 @@ int main(int argc, char** argv) {
                                           device,
                                           seed_opt);
 
+        if(options.resume) {
+                try {
+                        if(trainer.load_checkpoint(options.checkpoint_dir))
+                                std::cout << "Resumed from checkpoint '" << options.checkpoint_dir << "' after "
+                                          << trainer.completed_episodes() << " episodes (" << replay_buffer.size()
+                                          << " replay transitions)\n";
+                        else
+                                std::cout << "No checkpoint found in '" << options.checkpoint_dir << "', starting fresh\n";
+                } catch(const std::exception& ex) {
+                        std::cerr << "Error: failed to load checkpoint: " << ex.what() << "\n";
+                        return 1;
+                }
+        }
+
         training_metrics_t metrics = trainer.train(static_cast<std::size_t>(options.episodes));
 
         std::cout << "Completed " << metrics.episode_rewards.size() << " episodes / " << metrics.total_steps
@@ -489,6 +657,8 @@ int main(int argc, char** argv) {
                           << " final=" << metrics.epsilon_values.back() << "\n";
         }
 
+        metrics.throughput.print_summary(std::cout);
+
         return 0;
 }
 
@@ -63,20 +63,18 @@ void expect_eq(size_t actual, size_t expected, const std::string& message) {
 void initialize_visible_game(game_t& game, uint width, uint height) {
         game.map.width = width;
         game.map.height = height;
-        game.map.tiles.assign(width * height, {});
+        map_tile_t grass;
+        grass.terrain_type = TERRAIN_GRASS;
+        grass.passability = 1;
+        game.map.tiles.reset(width, height, grass);
         game.map.monster_guarded_cache = QBitArray(width * height, false);
         game.map.monster_guarded_cache_valid = true;
 
-        for(auto& tile : game.map.tiles) {
-                tile.terrain_type = TERRAIN_GRASS;
-                tile.passability = 1;
-        }
-
         player_t player;
         player.player_number = PLAYER_1;
         player.is_human = true;
-        player.tile_visibility = QBitArray(width * height, true);
-        player.tile_observability = QBitArray(width * height, true);
+        player.tile_visibility = tile_bitset_t(width * height, true);
+        player.tile_observability = tile_bitset_t(width * height, true);
         game.players.push_back(player);
         game.remove_interactable_object_callback_fn = [](interactable_object_t*, bool) {};
 }
@@ -99,7 +97,7 @@ map_resource_t* add_resource_pickup(adventure_map_t& map, int x, int y, resource
         resource->min_quantity = quantity;
         resource->max_quantity = quantity;
         map.objects.push_back(resource);
-        map.get_tile(x, y).interactable_object = static_cast<uint16_t>(map.objects.size());
+        map.get_tile_ref(x, y).interactable_object = static_cast<uint16_t>(map.objects.size());
         return resource;
 }
 
@@ -111,7 +109,7 @@ mine_t* add_mine(adventure_map_t& map, int x, int y, resource_e resource_type, p
         mine->mine_type = resource_type;
         mine->owner = owner;
         map.objects.push_back(mine);
-        map.get_tile(x, y).interactable_object = static_cast<uint16_t>(map.objects.size());
+        map.get_tile_ref(x, y).interactable_object = static_cast<uint16_t>(map.objects.size());
         return mine;
 }
 
@@ -120,7 +118,7 @@ interactable_object_t* add_object(adventure_map_t& map, int x, int y, interactab
         object->x = x;
         object->y = y;
         map.objects.push_back(object);
-        map.get_tile(x, y).interactable_object = static_cast<uint16_t>(map.objects.size());
+        map.get_tile_ref(x, y).interactable_object = static_cast<uint16_t>(map.objects.size());
         return object;
 }
 
@@ -416,8 +414,8 @@ void test_terrain_traversal_progress_and_callbacks() {
         for(const auto& test_case : terrain_traversal_achievement_cases()) {
                 game_t game;
                 initialize_visible_game(game, 3, 3);
-                game.map.get_tile(2, 1).terrain_type = test_case.terrain_type;
-                game.map.get_tile(2, 1).road_type = ROAD_NONE;
+                game.map.get_tile_ref(2, 1).terrain_type = test_case.terrain_type;
+                game.map.get_tile_ref(2, 1).road_type = ROAD_NONE;
                 auto hero = make_hero(1, 1, 5000);
                 std::vector<achievement_e> earned;
                 game.achievement_earned_callback_fn = [&](achievement_e achievement) {
@@ -446,7 +444,7 @@ void test_road_traversal_progress_and_callbacks() {
         for(const auto road_type : road_traversal_cases()) {
                 game_t game;
                 initialize_visible_game(game, 3, 3);
-                game.map.get_tile(2, 1).road_type = road_type;
+                game.map.get_tile_ref(2, 1).road_type = road_type;
                 auto hero = make_hero(1, 1, 5000);
                 std::vector<achievement_e> earned;
                 game.achievement_earned_callback_fn = [&](achievement_e achievement) {
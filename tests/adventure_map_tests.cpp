@@ -1,10 +1,25 @@
 #include "core/adventure_map.h"
+#include "core/block_compression.h"
 #include "core/game.h"
+#include "core/map_file_v2.h"
+#include "core/rmg.h"
+#include "core/utils.h"
 
+#include <QDir>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdlib>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <queue>
+#include <random>
+#include <set>
 #include <string>
+#include <tuple>
 
 namespace {
 int failures = 0;
@@ -26,20 +41,18 @@ void expect_eq(int actual, int expected, const std::string& message) {
 void initialize_visible_game(game_t& game, uint width, uint height) {
         game.map.width = width;
         game.map.height = height;
-        game.map.tiles.assign(width * height, {});
+        map_tile_t grass;
+        grass.terrain_type = TERRAIN_GRASS;
+        grass.passability = 1;
+        game.map.tiles.reset(width, height, grass);
         game.map.monster_guarded_cache = QBitArray(width * height, false);
         game.map.monster_guarded_cache_valid = true;
 
-        for(auto& tile : game.map.tiles) {
-                tile.terrain_type = TERRAIN_GRASS;
-                tile.passability = 1;
-        }
-
         player_t player;
         player.player_number = PLAYER_1;
         player.is_human = true;
-        player.tile_visibility = QBitArray(width * height, true);
-        player.tile_observability = QBitArray(width * height, true);
+        player.tile_visibility = tile_bitset_t(width * height, true);
+        player.tile_observability = tile_bitset_t(width * height, true);
         game.players.push_back(player);
         game.achievement_earned_callback_fn = [](achievement_e) {};
 }
@@ -59,7 +72,7 @@ void add_pickup(adventure_map_t& map, int x, int y, interactable_object_e type =
         object->x = x;
         object->y = y;
         map.objects.push_back(object);
-        map.get_tile(x, y).interactable_object = static_cast<uint16_t>(map.objects.size());
+        map.get_tile_ref(x, y).interactable_object = static_cast<uint16_t>(map.objects.size());
 }
 
 void test_route_rejects_invalid_or_hidden_destinations() {
@@ -83,7 +96,7 @@ void test_route_avoids_blocked_tiles_and_uses_diagonals() {
         expect_eq(diagonal_route.back().tile.x, 2, "diagonal route should end at target x");
         expect_eq(diagonal_route.back().tile.y, 2, "diagonal route should end at target y");
 
-        game.map.get_tile(1, 1).passability = 0;
+        game.map.get_tile_ref(1, 1).passability = 0;
         auto detour = game.map.get_route(&hero, 2, 2, &game);
         expect_true(!detour.empty(), "route should still exist around a blocked diagonal tile");
         for(const auto& step : detour)
@@ -137,6 +150,1398 @@ void test_pathfinding_skill_allows_zero_movement_pickups() {
         expect_eq(hero.movement_points, 0, "zero-movement pathfinding pickup should not make movement negative");
 }
 
+//the std::map/std::set A* that adventure_map_t::find_route replaced, kept verbatim as the reference for
+//the differential test below
+route_t reference_route(const adventure_map_t& map, const hero_t* hero, int x2, int y2, const game_t* game, bool ignore_blockables) {
+        route_t route;
+        if(!hero || !map.tile_valid(x2, y2))
+                return route;
+
+        std::priority_queue<std::tuple<int, int, int>, std::vector<std::tuple<int, int, int>>, std::greater<std::tuple<int, int, int>>> open_set;
+        std::map<coord_t, coord_t> came_from;
+        std::map<coord_t, int> f_score;
+        std::map<coord_t, int> penalty_score;
+        std::vector<int> g_score(map.width * map.height, -1);
+        std::vector<float> movement_base_cost_cache(map.width * map.height, -1);
+
+        auto get_terrain_movement_base_cost_cached = [&](int x, int y) {
+                int index = x + (y * map.width);
+                auto value = movement_base_cost_cache[index];
+                if(value <= -1) {
+                        auto cost = map.get_terrain_movement_base_cost(hero, x, y);
+                        movement_base_cost_cache[index] = cost;
+                        return cost;
+                }
+                return value;
+        };
+
+        int x1 = hero->x;
+        int y1 = hero->y;
+        coord_t start = {x1, y1};
+        coord_t goal = {x2, y2};
+        f_score[start] = map.heuristic(x1, y1, x2, y2);
+        open_set.push(std::make_tuple(f_score[start], x1, y1));
+
+        bool on_land = map.get_tile(x1, y1).terrain_type != TERRAIN_WATER;
+        std::set<coord_t> open_set_coords;
+
+        while(!open_set.empty()) {
+                int current_x = std::get<1>(open_set.top());
+                int current_y = std::get<2>(open_set.top());
+                coord_t current = {current_x, current_y};
+                open_set.pop();
+
+                if(current == goal) {
+                        int max_steps = 10000;
+                        int s = 0;
+                        while(current != start) {
+                                route.push_front({current, g_score[current.x + (current.y * map.width)], penalty_score[current]});
+                                current = came_from[current];
+                                if(s++ > max_steps)
+                                        break;
+                        }
+                        break;
+                }
+
+                int dx[] = { 1, 0, -1, 0, 1, 1, -1, -1 };
+                int dy[] = { 0, 1, 0, -1, 1, -1, 1, -1 };
+
+                for(int i = 0; i < 8; i++) {
+                        int x = current_x + dx[i];
+                        int y = current_y + dy[i];
+                        coord_t neighbor = {x, y};
+
+                        if(!map.tile_valid(x, y) || !map.get_tile(x, y).passability || map.get_tile(x, y).terrain_type == TERRAIN_UNKNOWN)
+                                continue;
+                        if(!ignore_blockables && !game->is_tile_visible(x, y, hero->player))
+                                continue;
+
+                        if(on_land && map.get_tile(x, y).terrain_type == TERRAIN_WATER) {
+                                if(x != x2 || y != y2)
+                                        continue;
+                                auto obj = map.get_interactable_object_for_tile(x, y);
+                                if(!obj || obj->object_type != OBJECT_SHIP)
+                                        continue;
+                        }
+
+                        if(!on_land && map.get_tile(x, y).terrain_type != TERRAIN_WATER) {
+                                if(x != x2 || y != y2)
+                                        continue;
+                                if(map.get_tile(x, y).is_interactable())
+                                        continue;
+                        }
+
+                        if(!ignore_blockables && map.get_tile(x, y).is_interactable() && !(x == x2 && y == y2))
+                                continue;
+
+                        if((current_x == x1 && current_y == y1) && map.get_tile(x1, y1).is_interactable() &&
+                           (((x == x1) && ((y + 1) == y1)) || ((x + 1 == x1) && ((y + 1) == y1)) || ((x == x1 + 1) && ((y + 1) == y1)))) {
+                                auto obj = map.get_interactable_object_for_tile(current_x, current_y);
+                                if(obj && obj->object_type != OBJECT_SHIP)
+                                        continue;
+                        }
+
+                        if(map.get_tile(x, y).is_interactable() && !map.is_tile_guarded_by_monster(x, y)) {
+                                auto obj = map.get_interactable_object_for_tile(x, y);
+                                if(dy[i] == 1 && (!interactable_object_t::is_pickupable(obj) && (obj->object_type != OBJECT_SHIP)))
+                                        continue;
+                        }
+
+                        if(map.get_hero_at_tile(x, y) && !(x == x2 && y == y2))
+                                continue;
+
+                        if(!ignore_blockables && map.is_tile_guarded_by_monster(x, y) && !(x == x2 && y == y2)) {
+                                auto target_interactable = map.get_interactable_object_for_tile(x2, y2);
+                                bool target_monster = target_interactable && target_interactable->object_type == OBJECT_MAP_MONSTER;
+                                map_monster_t* current_tile_monster = map.get_monster_guarding_tile(x, y);
+                                if(!target_monster || current_tile_monster != static_cast<map_monster_t*>(target_interactable))
+                                        continue;
+                        }
+
+                        bool diagonal = (i >= 4);
+                        float base_cost = get_terrain_movement_base_cost_cached(x, y);
+                        int move_cost = (int)(base_cost * (diagonal ? 14.f : 10.f));
+                        int adjusted_g_score = g_score[current.x + (current.y * map.width)];
+                        if(adjusted_g_score == -1)
+                                adjusted_g_score = 0;
+
+                        int tentative_g_score = adjusted_g_score + move_cost;
+                        int& neighbor_g_score = g_score[neighbor.x + (neighbor.y * map.width)];
+                        if(neighbor_g_score == -1 || tentative_g_score < neighbor_g_score) {
+                                came_from[neighbor] = current;
+                                neighbor_g_score = tentative_g_score;
+                                f_score[neighbor] = tentative_g_score + map.heuristic(x, y, x2, y2);
+                                penalty_score[neighbor] = (int)(base_cost * 10.f);
+
+                                if(open_set_coords.find(neighbor) == open_set_coords.end()) {
+                                        open_set.push(std::make_tuple(f_score[neighbor], x, y));
+                                        open_set_coords.insert(neighbor);
+                                }
+                        }
+                }
+        }
+
+        return route;
+}
+
+bool routes_equal(const route_t& lhs, const route_t& rhs) {
+        if(lhs.size() != rhs.size())
+                return false;
+        for(size_t i = 0; i < lhs.size(); ++i) {
+                if(lhs[i].tile != rhs[i].tile || lhs[i].total_cost != rhs[i].total_cost || lhs[i].penalty != rhs[i].penalty)
+                        return false;
+        }
+        return true;
+}
+
+void test_tile_store_chunks_match_tile_views() {
+        constexpr uint width = 70;
+        constexpr uint height = 40;
+        game_t game;
+        initialize_visible_game(game, width, height);
+        expect_eq(static_cast<int>(game.map.tiles.size()), width * height, "the store should hold every tile of a map that is not a whole number of chunks");
+
+        for(uint y = 0; y < height; ++y) {
+                for(uint x = 0; x < width; ++x) {
+                        auto tile = game.map.get_tile_ref(x, y);
+                        tile.zone_id = static_cast<int8_t>((x + y) % 100);
+                        tile.interactable_object = static_cast<uint16_t>(x + y * width);
+                        if((x + y) % 3 == 0)
+                                tile.road_type = ROAD_GRAVEL;
+                }
+        }
+
+        const auto& map = game.map;
+        for(uint y = 0; y < height; ++y) {
+                for(uint x = 0; x < width; ++x) {
+                        const map_tile_t tile = map.get_tile(x, y);
+                        expect_eq(tile.zone_id, (x + y) % 100, "writes through get_tile_ref should reach the store");
+                        expect_eq(map.tiles.get_interactable_object(x, y), x + y * width, "each tile should have its own slot in the columns");
+                        expect_eq(map.tiles[x + y * width].road_type, (x + y) % 3 == 0 ? ROAD_GRAVEL : ROAD_NONE, "row-major offsets should find the same tile");
+                        expect_eq(map.tiles.get_terrain_type(x, y), TERRAIN_GRASS, "untouched columns should keep their values");
+                }
+        }
+
+        game.map.get_tile_ref(69, 39) = map.get_tile(0, 0);
+        expect_eq(map.get_tile(69, 39).interactable_object, 0, "assigning a tile should copy every field");
+        expect_eq(map.get_tile(68, 39).interactable_object, 68 + 39 * width, "assigning a tile should leave its neighbours alone");
+}
+
+void test_route_matches_reference_on_random_maps() {
+        constexpr uint size = 40;
+        constexpr int maps = 6;
+        constexpr int queries_per_map = 60;
+        const terrain_type_e land_types[] = { TERRAIN_GRASS, TERRAIN_DIRT, TERRAIN_DESERT, TERRAIN_SNOW, TERRAIN_SWAMP, TERRAIN_JUNGLE };
+
+        std::mt19937 rng(1234);
+        int mismatches = 0;
+        int reachable = 0;
+        for(int map_index = 0; map_index < maps; ++map_index) {
+                game_t game;
+                initialize_visible_game(game, size, size);
+                auto& visibility = game.get_player(PLAYER_1).tile_visibility;
+
+                for(uint y = 0; y < size; ++y) {
+                        for(uint x = 0; x < size; ++x) {
+                                auto tile = game.map.get_tile_ref(x, y);
+                                tile.terrain_type = land_types[rng() % std::size(land_types)];
+                                tile.passability = (rng() % 100) < 22 ? 0 : 1;
+                                if((rng() % 100) < 6)
+                                        tile.terrain_type = TERRAIN_WATER;
+                                if((rng() % 100) < 5)
+                                        visibility.clearBit(x + y * size);
+                        }
+                }
+
+                for(int pickup = 0; pickup < 30; ++pickup) {
+                        const int x = static_cast<int>(rng() % size);
+                        const int y = static_cast<int>(rng() % size);
+                        if(!game.map.get_tile(x, y).is_interactable() && game.map.get_tile(x, y).terrain_type != TERRAIN_WATER)
+                                add_pickup(game.map, x, y);
+                }
+
+                for(int query = 0; query < queries_per_map; ++query) {
+                        auto hero = make_hero(static_cast<int>(rng() % size), static_cast<int>(rng() % size));
+                        const int x2 = static_cast<int>(rng() % size);
+                        const int y2 = static_cast<int>(rng() % size);
+
+                        for(bool ignore_blockables : { false, true }) {
+                                const auto expected = reference_route(game.map, &hero, x2, y2, &game, ignore_blockables);
+                                const auto actual = ignore_blockables ? game.map.get_route_ignoring_blockables(&hero, x2, y2, &game)
+                                                                      : game.map.get_route(&hero, x2, y2, &game);
+                                if(!routes_equal(expected, actual))
+                                        ++mismatches;
+                                if(!expected.empty())
+                                        ++reachable;
+                        }
+                }
+        }
+
+        expect_eq(mismatches, 0, "flat-array routes should match the reference implementation");
+        expect_true(reachable > 0, "differential test should exercise reachable routes");
+}
+
+//get_route's A* settles each tile once and can occasionally return a slightly costlier path than the optimum,
+//so the exact field may undercut it but must never exceed it, and both must agree on whether a tile is reachable
+bool field_cost_agrees_with_route(int field_cost, int route_cost) {
+        if(field_cost == -1 || route_cost == -1)
+                return field_cost == route_cost;
+
+        return field_cost <= route_cost;
+}
+
+void test_reachability_field_matches_routes() {
+        constexpr uint size = 12;
+        game_t game;
+        initialize_visible_game(game, size, size);
+        auto hero = make_hero(1, 1);
+
+        for(uint y = 0; y < size - 2; ++y)
+                game.map.get_tile_ref(6, y).passability = 0;
+        game.map.get_tile_ref(9, 3).terrain_type = TERRAIN_SWAMP;
+        add_pickup(game.map, 3, 3);
+
+        const auto& field = game.map.get_reachability_field(&hero, &game);
+        int compared = 0;
+        for(uint y = 0; y < size; ++y) {
+                for(uint x = 0; x < size; ++x) {
+                        const auto route = game.map.get_route(&hero, x, y, &game);
+                        const int expected = route.empty() ? -1 : route.back().total_cost;
+                        expect_true(field_cost_agrees_with_route(field.get_cost(x, y), expected), "reachability cost should not exceed route cost at " + std::to_string(x) + "," + std::to_string(y));
+
+                        const auto field_route = field.get_route(x, y);
+                        expect_eq(field_route.empty(), route.empty(), "reachability route should exist exactly when get_route finds one");
+                        if(!field_route.empty()) {
+                                expect_true(field_route.back().tile == coord_t{static_cast<int>(x), static_cast<int>(y)}, "reachability route should end at the target");
+                                expect_eq(field_route.back().total_cost, field.get_cost(x, y), "reachability route should end with the field cost");
+                        }
+                        ++compared;
+                }
+        }
+        expect_eq(compared, static_cast<int>(size * size), "every tile should be compared");
+
+        expect_true(&game.map.get_reachability_field(&hero, &game) == &field, "unchanged hero should reuse the cached field");
+        expect_eq(game.map.get_reachability_field(&hero, &game).get_cost(6, 0), -1, "blocked tile should be unreachable");
+
+        hero.x = 2;
+        const auto& moved = game.map.get_reachability_field(&hero, &game);
+        expect_eq(moved.origin_x, 2, "moving the hero should rebuild its field");
+}
+
+void test_reachability_field_matches_routes_on_random_maps() {
+        constexpr uint size = 32;
+        constexpr int maps = 5;
+        constexpr int heroes_per_map = 4;
+        const terrain_type_e land_types[] = { TERRAIN_GRASS, TERRAIN_DIRT, TERRAIN_DESERT, TERRAIN_SNOW, TERRAIN_SWAMP, TERRAIN_JUNGLE };
+
+        std::mt19937 rng(4321);
+        int mismatches = 0;
+        int reachable = 0;
+        for(int map_index = 0; map_index < maps; ++map_index) {
+                game_t game;
+                initialize_visible_game(game, size, size);
+
+                for(uint y = 0; y < size; ++y) {
+                        for(uint x = 0; x < size; ++x) {
+                                auto tile = game.map.get_tile_ref(x, y);
+                                tile.terrain_type = land_types[rng() % std::size(land_types)];
+                                tile.passability = (rng() % 100) < 25 ? 0 : 1;
+                        }
+                }
+
+                for(int object = 0; object < 40; ++object) {
+                        const int x = static_cast<int>(rng() % size);
+                        const int y = static_cast<int>(rng() % size);
+                        if(game.map.get_tile(x, y).is_interactable())
+                                continue;
+
+                        const bool monster = object % 4 == 0;
+                        add_pickup(game.map, x, y, monster ? OBJECT_MAP_MONSTER : OBJECT_RESOURCE);
+                        if(monster)
+                                game.map.set_monster_guard(static_cast<uint16_t>(game.map.objects.size() - 1), true);
+                }
+
+                for(int hero_index = 0; hero_index < heroes_per_map; ++hero_index) {
+                        auto hero = make_hero(static_cast<int>(rng() % size), static_cast<int>(rng() % size));
+                        hero.id = hero_index;
+                        const auto& field = game.map.get_reachability_field(&hero, &game);
+                        for(uint y = 0; y < size; ++y) {
+                                for(uint x = 0; x < size; ++x) {
+                                        const auto route = game.map.get_route(&hero, x, y, &game);
+                                        const int expected = route.empty() ? -1 : route.back().total_cost;
+                                        if(!field_cost_agrees_with_route(field.get_cost(x, y), expected))
+                                                ++mismatches;
+                                        if(expected != -1)
+                                                ++reachable;
+                                }
+                        }
+                }
+        }
+
+        expect_eq(mismatches, 0, "reachability costs should not exceed get_route around blockers, objects and guards");
+        expect_true(reachable > 0, "differential test should exercise reachable tiles");
+}
+
+void test_reachability_fields_invalidate_locally() {
+        constexpr uint width = 20;
+        constexpr uint height = 10;
+        game_t game;
+        initialize_visible_game(game, width, height);
+        for(uint y = 0; y < height; ++y)
+                game.map.get_tile_ref(10, y).passability = 0;
+
+        auto west_hero = make_hero(2, 5);
+        west_hero.id = 1;
+        auto east_hero = make_hero(15, 5);
+        east_hero.id = 2;
+        game.map.heroes[west_hero.id] = west_hero;
+        game.map.heroes[east_hero.id] = east_hero;
+        auto* west = &game.map.heroes[west_hero.id];
+        auto* east = &game.map.heroes[east_hero.id];
+
+        const auto& west_field = game.map.get_reachability_field(west, &game);
+        const auto& east_field = game.map.get_reachability_field(east, &game);
+        expect_eq(west_field.get_cost(5, 5), 300, "open ground should cost three cardinal steps");
+
+        add_pickup(game.map, 4, 5);
+        expect_eq(game.map.get_reachability_field(west, &game).get_cost(5, 5), 380, "an added object should invalidate the field that reaches it");
+        expect_true(game.map.is_reachability_field_current(east, &game, east_field), "an object behind the wall should not invalidate the other field");
+
+        game.map.place_hero(east, 16, 6);
+        expect_true(game.map.is_reachability_field_current(west, &game, west_field), "a hero moving behind the wall should not invalidate the other field");
+        expect_eq(game.map.get_reachability_field(east, &game).origin_x, 16, "the moved hero should rebuild its own field");
+
+        game.map.place_hero(west, 8, 5);
+        const auto& rebuilt_east = game.map.get_reachability_field(east, &game);
+        expect_true(game.map.is_reachability_field_current(east, &game, rebuilt_east), "the east field should stay cached while nothing near it changes");
+        expect_eq(game.map.get_reachability_field(west, &game).get_cost(3, 5), 580, "the moved hero should route around the pickup from its new tile");
+}
+
+void test_zone_graph_routes_across_zones() {
+        constexpr uint width = 16;
+        constexpr uint height = 12;
+        game_t game;
+        initialize_visible_game(game, width, height);
+        auto hero = make_hero(1, 1);
+
+        for(uint y = 0; y < height; ++y) {
+                for(uint x = 0; x < width; ++x)
+                        game.map.get_tile_ref(x, y).zone_id = x < width / 2 ? 0 : 1;
+        }
+        for(uint y = 0; y < height; ++y) {
+                if(y != 5)
+                        game.map.get_tile_ref(width / 2, y).passability = 0;
+        }
+
+        const auto route = game.map.get_route(&hero, 14, 10, &game);
+        expect_true(!route.empty(), "goal across the zone border should be reachable");
+
+        const int estimate = game.map.estimate_route_cost(&hero, 14, 10);
+        expect_true(estimate >= route.back().total_cost, "zone estimate should not undercut the optimal route");
+
+        const auto long_route = game.map.get_long_route(&hero, 14, 10, &game);
+        expect_true(!long_route.empty(), "long route should be found through the gap");
+        if(!long_route.empty()) {
+                expect_true(long_route.back().tile == coord_t{14, 10}, "long route should end at the goal");
+                expect_true(long_route.back().total_cost >= route.back().total_cost, "long route should not beat the optimal route");
+                bool through_gap = false;
+                for(const auto& step : long_route)
+                        through_gap |= step.tile == coord_t{static_cast<int>(width / 2), 5};
+                expect_true(through_gap, "long route should cross the border at the gap");
+        }
+
+        expect_eq(game.map.estimate_route_cost(&hero, 5, 5) >= 0, true, "goal in the start zone should be reachable");
+
+        add_pickup(game.map, width / 2, 5);
+        auto* blocker = game.map.objects.back();
+        game.map.mark_zone_graph_dirty(width / 2, 5);
+        expect_eq(game.map.estimate_route_cost(&hero, 14, 10), -1, "blocking the gap should disconnect the zones");
+        expect_true(game.map.get_long_route(&hero, 14, 10, &game).empty(), "no long route should exist through a blocked gap");
+
+        game.map.remove_interactable_object(blocker);
+        expect_true(game.map.estimate_route_cost(&hero, 14, 10) >= 0, "removing the blocker should reconnect the zones");
+}
+
+std::vector<std::pair<int, std::vector<int>>> zone_graph_portal_links(const zone_graph_t& graph) {
+        std::vector<std::pair<int, std::vector<int>>> links;
+        for(const auto& portal : graph.portals) {
+                std::vector<int> crossing_tiles;
+                for(auto crossing : portal.crossings)
+                        crossing_tiles.push_back(graph.portals[crossing].tile);
+                std::sort(crossing_tiles.begin(), crossing_tiles.end());
+                links.push_back({ portal.tile, crossing_tiles });
+        }
+        std::sort(links.begin(), links.end());
+        return links;
+}
+
+void test_zone_graph_patches_match_rebuild() {
+        constexpr uint width = 30;
+        constexpr uint height = 20;
+        game_t game;
+        initialize_visible_game(game, width, height);
+        for(uint y = 0; y < height; ++y) {
+                for(uint x = 0; x < width; ++x)
+                        game.map.get_tile_ref(x, y).zone_id = static_cast<int8_t>(x / 10 + (y >= 10 ? 3 : 0));
+        }
+        auto hero = make_hero(1, 1);
+        hero.id = 1;
+        game.map.heroes[hero.id] = hero;
+        auto* walker = &game.map.heroes[hero.id];
+        auto traveller = make_hero(0, 0);
+        expect_true(game.map.estimate_route_cost(&traveller, 28, 18) >= 0, "the zones should start connected");
+
+        std::mt19937 rng(23);
+        std::vector<interactable_object_t*> blockers;
+        for(int step = 0; step < 60; ++step) {
+                const int x = static_cast<int>(rng() % width);
+                const int y = static_cast<int>(rng() % height);
+                if(step % 3 == 2 && !blockers.empty()) {
+                        game.map.remove_interactable_object(blockers.back());
+                        blockers.pop_back();
+                }
+                else if(step % 3 == 1) {
+                        if(!game.map.get_tile(x, y).is_interactable() && game.map.get_hero_id_at_tile(x, y) == -1)
+                                game.map.place_hero(walker, x, y);
+                }
+                else if(!game.map.get_tile(x, y).is_interactable() && game.map.get_hero_id_at_tile(x, y) == -1 && (x != 0 || y != 0)) {
+                        add_pickup(game.map, x, y);
+                        blockers.push_back(game.map.objects.back());
+                        game.map.mark_zone_graph_dirty(x, y);
+                }
+
+                const int goal_x = static_cast<int>(rng() % width);
+                const int goal_y = static_cast<int>(rng() % height);
+                const int patched = game.map.estimate_route_cost(&traveller, goal_x, goal_y);
+
+                zone_graph_t rebuilt;
+                const int expected = rebuilt.find_path(game.map, traveller.x, traveller.y, goal_x, goal_y, nullptr);
+                expect_eq(patched, expected, "a patched zone graph should estimate the same cost as a fresh one");
+                expect_true(zone_graph_portal_links(game.map.zone_graph) == zone_graph_portal_links(rebuilt), "a patched zone graph should have the same portals as a fresh one");
+        }
+}
+
+void test_hero_occupancy_tracks_moves_and_removals() {
+        constexpr uint size = 8;
+        game_t game;
+        initialize_visible_game(game, size, size);
+
+        auto first = make_hero(1, 1);
+        first.id = 3;
+        auto second = make_hero(4, 4);
+        second.id = 7;
+        game.map.heroes[first.id] = first;
+        game.map.heroes[second.id] = second;
+
+        expect_eq(game.map.get_hero_id_at_tile(1, 1), 3, "first hero should be found on its tile");
+        expect_eq(game.map.get_hero_id_at_tile(4, 4), 7, "second hero should be found on its tile");
+        expect_true(game.map.get_hero_at_tile(2, 2) == nullptr, "empty tile should have no hero");
+
+        game.map.place_hero(&game.map.heroes[3], 2, 2);
+        expect_true(game.map.get_hero_at_tile(1, 1) == nullptr, "hero should leave its old tile");
+        expect_true(game.map.get_hero_at_tile(2, 2) == &game.map.heroes[3], "hero should occupy its new tile");
+
+        game.map.heroes[7].x = 5;
+        expect_true(game.map.get_hero_at_tile(4, 4) == nullptr, "a hero moved directly should not be reported on its old tile");
+
+        expect_eq(game.map.get_hero_id_at_tile(5, 4), 7, "a hero moved directly should be found after the index heals");
+
+        game.map.remove_hero(&game.map.heroes[3]);
+        expect_true(game.map.get_hero_at_tile(2, 2) == nullptr, "removed hero should no longer occupy its tile");
+        expect_eq(game.map.get_hero_id_at_tile(-1, 0), -1, "invalid tiles should have no hero");
+}
+
+void test_monster_guard_zones_update_locally() {
+        constexpr uint width = 12;
+        constexpr uint height = 6;
+        game_t game;
+        initialize_visible_game(game, width, height);
+
+        add_pickup(game.map, 4, 2, OBJECT_MAP_MONSTER);
+        game.map.set_monster_guard(static_cast<uint16_t>(game.map.objects.size() - 1), true);
+        auto* first = game.map.objects.back();
+        add_pickup(game.map, 6, 2, OBJECT_MAP_MONSTER);
+        game.map.set_monster_guard(static_cast<uint16_t>(game.map.objects.size() - 1), true);
+        auto* second = game.map.objects.back();
+
+        expect_true(game.map.is_tile_guarded_by_monster(10, 1) == false, "tiles far from monsters should not be guarded");
+        expect_true(game.map.is_tile_guarded_by_monster(3, 3), "tiles next to a monster should be guarded on a non-square map");
+        expect_true(game.map.get_monster_guarding_tile(5, 2) == static_cast<map_monster_t*>(first), "shared tiles should report the first monster");
+        expect_true(game.map.get_monster_guarding_tile(7, 1) == static_cast<map_monster_t*>(second), "second monster should guard its own zone");
+
+        game.map.remove_interactable_object(first);
+        expect_true(game.map.monster_guarded_cache_valid, "removing a monster should not force a full rebuild");
+        expect_true(!game.map.is_tile_guarded_by_monster(3, 3), "defeated monster should stop guarding its zone");
+        expect_true(game.map.get_monster_guarding_tile(5, 2) == static_cast<map_monster_t*>(second), "overlapping zone should fall back to the other monster");
+
+        game.map.update_guarded_monster_cache();
+        for(uint y = 0; y < height; ++y) {
+                for(uint x = 0; x < width; ++x)
+                        expect_true(game.map.get_monster_guarding_tile(x, y) == (x >= 5 && x <= 7 && y >= 1 && y <= 3 ? static_cast<map_monster_t*>(second) : nullptr),
+                                    "rebuilt guard zones should match the incremental ones");
+        }
+}
+
+void test_visibility_updates_incrementally() {
+        constexpr uint size = 30;
+        game_t game;
+        initialize_visible_game(game, size, size);
+        auto& player = game.get_player(PLAYER_1);
+        player.tile_visibility.fill(false);
+        player.tile_observability.fill(false);
+
+        auto hero = make_hero(5, 5);
+        hero.id = 1;
+        game.map.heroes[hero.id] = hero;
+        const int radius = std::min(hero.get_scouting_radius(), hero.get_observation_radius()) + 1;
+
+        game.update_visibility(PLAYER_1);
+        auto revealed = game.take_newly_revealed_tiles(PLAYER_1);
+        expect_eq(static_cast<int>(revealed.size()), player.tile_visibility.count(true), "first update should report every revealed tile");
+
+        game.map.place_hero(&game.map.heroes[hero.id], 20, 20);
+        game.update_visibility(PLAYER_1);
+        revealed = game.take_newly_revealed_tiles(PLAYER_1);
+        expect_true(!revealed.empty(), "moving the hero should reveal new tiles");
+        for(auto tile : revealed)
+                expect_true(player.tile_visibility.testBit(tile), "newly revealed tiles should be visible");
+
+        for(uint y = 0; y < size; ++y) {
+                for(uint x = 0; x < size; ++x) {
+                        const bool near_start = utils::dist(5, 5, x, y) < radius;
+                        const bool near_hero = utils::dist(20, 20, x, y) < radius;
+                        expect_eq(player.tile_visibility.testBit(x + y * size), near_start || near_hero, "visibility should be the union of both hero positions");
+                        if(near_start && !near_hero)
+                                expect_true(!player.tile_observability.testBit(x + y * size), "tiles the hero left should no longer be observed");
+                }
+        }
+
+        game.update_visibility(PLAYER_1);
+        expect_true(game.take_newly_revealed_tiles(PLAYER_1).empty(), "an update without changes should reveal nothing");
+
+        const int far_tile = 3 + 27 * size;
+        game.reveal_area(PLAYER_1, 3, 27, 2, 2);
+        expect_true(player.tile_observability.testBit(far_tile), "reveal_area should observe the tiles it reveals");
+        game.update_visibility(PLAYER_1);
+        expect_true(player.tile_visibility.testBit(far_tile), "tiles revealed outside an update should stay revealed");
+        expect_true(!player.tile_observability.testBit(far_tile), "the next update should drop observation no source provides");
+}
+
+void test_visibility_moves_match_full_rebuild() {
+        constexpr uint size = 40;
+        game_t game;
+        initialize_visible_game(game, size, size);
+        auto& player = game.get_player(PLAYER_1);
+        player.tile_visibility.fill(false);
+        player.tile_observability.fill(false);
+
+        //two heroes whose circles overlap, so the one that stays keeps observing part of what the other leaves
+        auto anchor = make_hero(10, 10);
+        anchor.id = 1;
+        game.map.heroes[anchor.id] = anchor;
+        auto walker = make_hero(14, 12);
+        walker.id = 2;
+        game.map.heroes[walker.id] = walker;
+        game.update_visibility(PLAYER_1);
+
+        const int steps[][2] = { { 15, 13 }, { 17, 13 }, { 20, 16 }, { 13, 11 }, { 30, 30 }, { 11, 10 } };
+        for(const auto& step : steps) {
+                game.map.place_hero(&game.map.heroes[walker.id], step[0], step[1]);
+                game.update_visibility(PLAYER_1);
+                const auto patched = player.tile_observability;
+
+                player.visibility_state.valid = false;
+                game.update_visibility(PLAYER_1);
+                int mismatches = 0;
+                for(int tile = 0; tile < static_cast<int>(size * size); ++tile)
+                        mismatches += patched.testBit(tile) != player.tile_observability.testBit(tile);
+                expect_eq(mismatches, 0, "observability after a move should match a full rebuild");
+        }
+}
+
+void test_object_index_matches_object_scans() {
+        constexpr uint size = 40;
+        game_t game;
+        initialize_visible_game(game, size, size);
+        std::mt19937 rng(7);
+
+        for(int i = 0; i < 120; ++i) {
+                const int x = static_cast<int>(rng() % size);
+                const int y = static_cast<int>(rng() % size);
+                if(game.map.get_tile(x, y).is_interactable())
+                        continue;
+                add_pickup(game.map, x, y, i % 3 == 0 ? OBJECT_MINE : OBJECT_RESOURCE);
+        }
+
+        const int mine_count = static_cast<int>(game.map.get_object_ids_of_type(OBJECT_MINE).size());
+        int scanned_mines = 0;
+        for(auto* object : game.map.objects)
+                scanned_mines += object && object->object_type == OBJECT_MINE;
+        expect_eq(mine_count, scanned_mines, "type bucket should hold every mine");
+
+        for(int query = 0; query < 50; ++query) {
+                const int x = static_cast<int>(rng() % size);
+                const int y = static_cast<int>(rng() % size);
+                const int radius = static_cast<int>(rng() % 12);
+                std::vector<uint16_t> expected;
+                for(uint16_t id = 0; id < game.map.objects.size(); ++id) {
+                        const auto* object = game.map.objects[id];
+                        if(object && std::abs(object->x - x) <= radius && std::abs(object->y - y) <= radius)
+                                expected.push_back(id);
+                }
+                expect_true(game.map.get_object_ids_in_radius(x, y, radius) == expected, "radius query should match a scan of every object");
+        }
+
+        const auto mines = game.map.get_object_ids_of_type(OBJECT_MINE);
+        expect_true(!mines.empty(), "test map should contain mines");
+        auto* mine = static_cast<mine_t*>(game.map.objects[mines.front()]);
+        game.map.set_object_owner(mine, PLAYER_1);
+        expect_eq(mine->owner, PLAYER_1, "set_object_owner should update the mine");
+        expect_true(game.map.get_object_ids_owned_by(PLAYER_1) == std::vector<uint16_t>{mines.front()}, "owner bucket should follow ownership changes");
+
+        add_pickup(game.map, 0, 0, OBJECT_MINE);
+        expect_eq(static_cast<int>(game.map.get_object_ids_of_type(OBJECT_MINE).size()), mine_count + 1, "objects appended after indexing should be picked up");
+
+        game.map.remove_interactable_object(mine);
+        expect_true(game.map.get_object_ids_owned_by(PLAYER_1).empty(), "removed objects should leave the owner bucket");
+        expect_eq(static_cast<int>(game.map.get_object_ids_of_type(OBJECT_MINE).size()), mine_count, "removed objects should leave the type bucket");
+}
+
+void test_map_file_v2_round_trips_and_reads_lazily() {
+        constexpr uint width = 40;
+        constexpr uint height = 34;
+        game_t game;
+        initialize_visible_game(game, width, height);
+        auto& map = game.map;
+        map.name = "v2 round trip";
+        map.players = 2;
+
+        for(uint y = 0; y < height; ++y) {
+                for(uint x = 0; x < width; ++x) {
+                        auto tile = map.get_tile_ref(x, y);
+                        tile.asset_id = static_cast<asset_id_t>(x * 7 + y * 300);
+                        tile.terrain_type = (x + y) % 4 == 0 ? TERRAIN_WATER : TERRAIN_SNOW;
+                        tile.road_type = y == 5 ? ROAD_COBBLESTONE : ROAD_NONE;
+                        tile.passability = tile.terrain_type == TERRAIN_WATER ? 0 : 1;
+                        tile.zone_id = static_cast<int8_t>(x / 10);
+                }
+        }
+
+        map.doodads.push_back({ 12, 1, -3, 33, 2, 3 });
+        map.doodads.push_back({ 40, 0, 39, 0, 1, 1 });
+        add_pickup(map, 3, 3);
+        add_pickup(map, 20, 30, OBJECT_MINE);
+        add_pickup(map, 39, 33);
+        static_cast<map_resource_t*>(map.objects[2])->resource_type = RESOURCE_GOLD;
+        map.remove_interactable_object(map.objects[1]);
+        auto hero = make_hero(8, 9);
+        hero.id = 4;
+        map.heroes[hero.id] = hero;
+
+        QByteArray bytes;
+        expect_eq(write_map_file_v2(map, bytes), SUCCESS, "a valid map should write as version 2");
+
+        map_file_view_t view;
+        expect_eq(view.open(reinterpret_cast<const uchar*>(bytes.constData()), bytes.size()), SUCCESS, "the written bytes should open as a view");
+        expect_eq(view.get_header().width, width, "the header should carry the map width");
+        expect_true(std::string(view.get_header().name) == map.name, "the header should carry the map name");
+        expect_eq(static_cast<int>(view.get_object_count()), 3, "removed objects should keep their slot");
+        expect_eq(static_cast<int>(view.get_hero_count()), 1, "every hero should have a record");
+
+        const auto minimap = get_minimap_tiles(map);
+        const uint8_t* view_minimap = view.get_minimap_tiles();
+        expect_true(view_minimap && std::equal(minimap.begin(), minimap.end(), view_minimap), "the minimap section should match the map");
+
+        interactable_object_t* object = nullptr;
+        expect_eq(view.read_object(2, object), SUCCESS, "a single object should decode on its own");
+        expect_true(object && object->object_type == OBJECT_RESOURCE && object->x == 39 && object->y == 33, "the decoded object should keep its type and position");
+        expect_true(object && static_cast<map_resource_t*>(object)->resource_type == RESOURCE_GOLD, "the decoded object should keep its own data");
+        delete object;
+        expect_eq(view.read_object(1, object), SUCCESS, "a removed object should decode as empty");
+        expect_true(object == nullptr, "a removed object should stay removed");
+        expect_true(view.read_object(3, object) != SUCCESS, "records past the end should be rejected");
+
+        adventure_map_t loaded;
+        expect_eq(view.read_map(loaded), SUCCESS, "the whole map should load from the view");
+        expect_eq(loaded.width, width, "the loaded map should keep its size");
+        expect_eq(loaded.players, 2, "the loaded map should keep its header fields");
+        for(uint y = 0; y < height; ++y) {
+                for(uint x = 0; x < width; ++x) {
+                        const map_tile_t expected = map.get_tile(x, y);
+                        const map_tile_t actual = loaded.get_tile(x, y);
+                        expect_true(expected.asset_id == actual.asset_id && expected.terrain_type == actual.terrain_type
+                                    && expected.road_type == actual.road_type && expected.passability == actual.passability
+                                    && expected.zone_id == actual.zone_id && expected.interactable_object == actual.interactable_object,
+                                    "tiles should survive the block copy");
+                }
+        }
+        expect_eq(static_cast<int>(loaded.doodads.size()), 2, "doodads should round trip");
+        expect_eq(loaded.doodads[0].x, -3, "doodad positions should keep their sign");
+        expect_eq(loaded.doodads[0].height, 3, "doodad sizes should round trip");
+        expect_eq(static_cast<int>(loaded.objects.size()), 3, "objects should keep their ids");
+        expect_true(loaded.objects[0] && loaded.objects[1] == nullptr && loaded.objects[2], "removed objects should stay removed after loading");
+        expect_true(loaded.heroes.count(4) == 1 && loaded.heroes[4].x == 8, "heroes should round trip");
+
+        bytes.truncate(bytes.size() / 2);
+        map_file_view_t truncated;
+        expect_true(truncated.open(reinterpret_cast<const uchar*>(bytes.constData()), bytes.size()) != SUCCESS, "a truncated file should be rejected up front");
+}
+
+void test_map_file_records_decode_the_same_on_any_thread_count() {
+        constexpr uint size = 64;
+        game_t game;
+        initialize_visible_game(game, size, size);
+        auto& map = game.map;
+        map.players = 2;
+        std::mt19937 rng(11);
+        for(uint i = 0; i < 600; ++i) {
+                const int x = static_cast<int>(rng() % size);
+                const int y = static_cast<int>(rng() % size);
+                if(map.get_tile(x, y).is_interactable())
+                        continue;
+                add_pickup(map, x, y, i % 4 == 0 ? OBJECT_MINE : OBJECT_RESOURCE);
+                if(auto* resource = dynamic_cast<map_resource_t*>(map.objects.back()))
+                        resource->max_quantity = static_cast<uint16_t>(7 + i % 20);
+        }
+        map.remove_interactable_object(map.objects[5]);
+        for(int id = 0; id < 3; ++id) {
+                auto hero = make_hero(id, 10);
+                hero.id = id;
+                map.heroes[hero.id] = hero;
+        }
+
+        QByteArray bytes;
+        QBuffer buffer(&bytes);
+        buffer.open(QIODevice::WriteOnly);
+        QDataStream write_stream(&buffer);
+        expect_eq(write_map_file_stream(write_stream, map), SUCCESS, "the test map should write");
+
+        for(uint thread_count : { 1u, 8u }) {
+                QDataStream read_stream(bytes);
+                adventure_map_t loaded;
+                map_file_header_t header;
+                expect_eq(read_map_file_stream(read_stream, loaded, header, thread_count), SUCCESS, "the test map should load");
+                expect_eq(static_cast<int>(loaded.objects.size()), static_cast<int>(map.objects.size()), "every object slot should be loaded");
+                bool same = loaded.objects.size() == map.objects.size();
+                for(size_t i = 0; same && i < map.objects.size(); ++i) {
+                        const auto* expected = map.objects[i];
+                        const auto* actual = loaded.objects[i];
+                        if(!expected || !actual) {
+                                same = !expected && !actual;
+                                continue;
+                        }
+                        same = expected->object_type == actual->object_type && expected->x == actual->x && expected->y == actual->y;
+                        if(same && expected->object_type == OBJECT_RESOURCE)
+                                same = static_cast<const map_resource_t*>(expected)->max_quantity == static_cast<const map_resource_t*>(actual)->max_quantity;
+                }
+                expect_true(same, "objects should decode into their own slots on any thread count");
+                expect_true(loaded.heroes.size() == 3 && loaded.heroes[2].x == 2, "heroes should decode on any thread count");
+        }
+
+        QByteArray record = write_map_object_record(map.objects[0]);
+        std::vector<map_file_record_t> records(200, { static_cast<uint16_t>(map.objects[0]->object_type), record.constData(), static_cast<uint32_t>(record.size()) });
+        records[150].size = 2;
+        std::vector<interactable_object_t*> objects;
+        expect_eq(decode_map_object_records(records, objects, 4), MAP_OBJECT_DATA_INVALID, "a short record should be reported");
+        expect_true(objects[149] && objects[151] && objects[151]->x == map.objects[0]->x, "the other records should still decode");
+        for(auto* object : objects)
+                delete object;
+}
+
+void test_save_points_rebuild_from_deltas() {
+        const QString path = QDir::tempPath() + "/cof_save_point_test.sav";
+        const std::string filename = path.toStdString();
+        QFile::remove(path);
+
+        game_t game;
+        initialize_visible_game(game, 40, 40);
+        game.map.players = 1;
+        for(int i = 0; i < 40; ++i)
+                add_pickup(game.map, i, 3);
+        auto hero = make_hero(5, 5);
+        hero.id = 1;
+        game.map.heroes[hero.id] = hero;
+        expect_eq(game.save_game(filename), 0, "a new save should be created");
+
+        std::vector<qint64> point_sizes;
+        constexpr int days = 2 * SAVE_KEYFRAME_INTERVAL + 3;
+        for(int day = 1; day <= days; ++day) {
+                game.date = static_cast<uint16_t>(day);
+                game.map.heroes[1].x = static_cast<uint8_t>(day % 40);
+                static_cast<map_resource_t*>(game.map.objects[day % 40])->max_quantity = static_cast<uint16_t>(100 + day);
+                game.get_player(PLAYER_1).tile_visibility.clearBit(day * 37);
+                if(day == 4)
+                        game.map.remove_interactable_object(game.map.objects[0]);
+
+                const qint64 size_before = QFileInfo(path).size();
+                expect_eq(game.save_game(filename), 0, "save points should append");
+                point_sizes.push_back(QFileInfo(path).size() - size_before);
+        }
+        expect_true(point_sizes[1] * 4 < point_sizes[0], "a delta should be much smaller than a keyframe");
+        expect_true(point_sizes[SAVE_KEYFRAME_INTERVAL] > point_sizes[1] * 4, "keyframes should recur");
+
+        QFile file(path);
+        expect_true(file.open(QIODevice::ReadOnly), "the save should open");
+        QDataStream stream(&file);
+        save_game_header_t header;
+        game_t loaded;
+        std::vector<save_checkpoint_t> checkpoints;
+        expect_eq(game_t::load_saved_game_info(stream, header, &loaded, checkpoints), SUCCESS, "the save should load");
+        expect_eq(static_cast<int>(checkpoints.size()), days + 1, "every save point should load after the base");
+        for(int day = 1; day < static_cast<int>(checkpoints.size()); ++day) {
+                const auto& checkpoint = checkpoints[day];
+                expect_eq(checkpoint.date, day, "save points should keep their dates");
+                expect_true(checkpoint.heroes.size() == 1 && checkpoint.heroes[0].x == day % 40, "heroes should be rebuilt from deltas");
+                const auto* resource = static_cast<const map_resource_t*>(checkpoint.objects[day % 40]);
+                expect_true(resource && resource->max_quantity == 100 + day, "object changes should be rebuilt from deltas");
+                expect_true(day < 4 ? checkpoint.objects[0] != nullptr : checkpoint.objects[0] == nullptr, "removed objects should stay removed");
+                expect_true(!checkpoint.visibility_map[0].testBit(day * 37) && checkpoint.visibility_map[0].testBit(days * 37 + 1), "visibility should be rebuilt from deltas");
+                expect_true(day == days || checkpoint.visibility_map[0].testBit((day + 1) * 37), "later visibility changes should not leak back");
+        }
+
+        QFile seek_file(path);
+        seek_file.open(QIODevice::ReadOnly);
+        QDataStream seek_stream(&seek_file);
+        game_t seek_game;
+        map_file_header_t map_header;
+        game_t::read_save_game_header_stream(seek_stream, header);
+        game_t::read_game_info(seek_stream, &seek_game);
+        read_map_file_stream(seek_stream, seek_game.map, map_header);
+        save_state_t state;
+        expect_eq(read_save_point_at(seek_stream, header.save_points, days - 2, state), SUCCESS, "a single save point should be rebuilt");
+        expect_eq(state.date, days - 1, "the requested save point should be rebuilt");
+
+        for(auto& checkpoint : checkpoints) {
+                for(auto* object : checkpoint.objects)
+                        delete object;
+        }
+        QFile::remove(path);
+}
+
+void test_async_saves_capture_the_game_when_queued() {
+        constexpr int game_count = 3;
+        constexpr int days = 6;
+        std::vector<QString> paths;
+        std::vector<std::unique_ptr<game_t>> games;
+        std::atomic<int> completed = 0;
+        std::atomic<int> failed = 0;
+        for(int g = 0; g < game_count; ++g) {
+                paths.push_back(QDir::tempPath() + QString("/cof_async_save_test_%1.sav").arg(g));
+                QFile::remove(paths.back());
+                games.push_back(std::make_unique<game_t>());
+                auto& game = *games.back();
+                initialize_visible_game(game, 40, 40);
+                game.map.players = 1;
+                auto hero = make_hero(0, 0);
+                hero.id = 1;
+                game.map.heroes[hero.id] = hero;
+        }
+
+        auto on_saved = [&](uint result) {
+                ++completed;
+                failed += result != 0;
+        };
+
+        //every game queues a save a day without waiting, changing the hero straight after each one
+        for(int day = 0; day <= days; ++day) {
+                for(int g = 0; g < game_count; ++g) {
+                        auto& game = *games[g];
+                        game.date = static_cast<uint16_t>(day);
+                        game.map.heroes[1].x = static_cast<uint8_t>(day + g);
+                        game.save_game_async(paths[g].toStdString(), on_saved);
+                        game.map.heroes[1].x = 99;
+                }
+        }
+
+        for(auto& game : games)
+                game->wait_for_saves();
+        expect_eq(completed, game_count * (days + 1), "every queued save should complete");
+        expect_eq(failed, 0, "queued saves should succeed");
+
+        for(int g = 0; g < game_count; ++g) {
+                QFile file(paths[g]);
+                file.open(QIODevice::ReadOnly);
+                QDataStream stream(&file);
+                save_game_header_t header;
+                game_t loaded;
+                std::vector<save_checkpoint_t> checkpoints;
+                expect_eq(game_t::load_saved_game_info(stream, header, &loaded, checkpoints), SUCCESS, "an async save should load");
+                expect_eq(static_cast<int>(checkpoints.size()), days + 1, "saves should be written in the order they were queued");
+                for(int day = 0; day < static_cast<int>(checkpoints.size()); ++day) {
+                        expect_eq(checkpoints[day].heroes.front().x, day + g, "a save should hold the game as it was when queued");
+                        for(auto* object : checkpoints[day].objects)
+                                delete object;
+                }
+                QFile::remove(paths[g]);
+        }
+}
+
+void test_block_compression_round_trips_and_detects_corruption() {
+        std::mt19937 rng(5);
+        QByteArray data;
+        for(int i = 0; i < 3 * BLOCK_COMPRESSION_BLOCK_SIZE + 1234; ++i)
+                data.append(static_cast<char>('a' + rng() % 7));
+
+        QByteArray bytes;
+        QBuffer buffer(&bytes);
+        buffer.open(QIODevice::WriteOnly);
+        {
+                block_compressor_t compressor(&buffer);
+                for(qsizetype offset = 0; offset < data.size();) {
+                        const qsizetype chunk = std::min<qsizetype>(1 + rng() % 70000, data.size() - offset);
+                        compressor.write(data.constData() + offset, chunk);
+                        offset += chunk;
+                }
+                expect_true(compressor.finish(), "a segment should compress");
+        }
+        buffer.write("tail");
+        buffer.close();
+        expect_true(bytes.size() < data.size() / 2, "repetitive data should compress");
+
+        buffer.open(QIODevice::ReadOnly);
+        expect_true(is_block_compressed(&buffer), "a segment should be recognised");
+        block_decompressor_t decompressor(&buffer);
+        expect_true(decompressor.readAll() == data, "a segment should decompress to what was written");
+        expect_true(decompressor.finish() && !decompressor.has_failed(), "an intact segment should check out");
+        expect_true(buffer.read(4) == "tail", "reading a segment should stop at its end");
+        buffer.close();
+
+        QByteArray corrupted = bytes.left(bytes.size() - 4);
+        corrupted[corrupted.size() / 2] = static_cast<char>(corrupted[corrupted.size() / 2] ^ 0x40);
+        QByteArray uncompressed;
+        expect_true(!block_uncompress(corrupted, uncompressed), "a corrupted block should be rejected");
+
+        const QString path = QDir::tempPath() + "/cof_compressed_map_test.cofmap";
+        game_t game;
+        initialize_visible_game(game, 40, 40);
+        game.map.players = 1;
+        for(int i = 0; i < 40; ++i)
+                add_pickup(game.map, i, 7);
+        expect_eq(write_map_file(path.toStdString(), game.map, true), SUCCESS, "a compressed map should write");
+        map_file_header_t compressed_header;
+        expect_eq(read_map_file_header_c(path.toStdString(), compressed_header), SUCCESS, "a compressed map's header should read on its own");
+        expect_eq(compressed_header.width, 40, "the header read from a compressed map should carry the map size");
+        adventure_map_t loaded;
+        expect_eq(read_map_file(path.toStdString(), loaded), SUCCESS, "a compressed map should load");
+        expect_eq(static_cast<int>(loaded.objects.size()), 40, "a compressed map should keep its objects");
+        expect_eq(loaded.get_tile(39, 7).interactable_object, 40, "a compressed map should keep its tiles");
+        QFile::remove(path);
+
+        const QString save_path = QDir::tempPath() + "/cof_compressed_save_test.sav";
+        QFile::remove(save_path);
+        game.compress_saves = true;
+        for(int day = 0; day < 3; ++day) {
+                game.date = static_cast<uint16_t>(day);
+                game.get_player(PLAYER_1).tile_visibility.clearBit(day);
+                expect_eq(game.save_game(save_path.toStdString()), 0, "a compressed save should write");
+        }
+        QFile save_file(save_path);
+        save_file.open(QIODevice::ReadOnly);
+        QDataStream save_stream(&save_file);
+        save_game_header_t header;
+        game_t loaded_game;
+        std::vector<save_checkpoint_t> checkpoints;
+        expect_eq(game_t::load_saved_game_info(save_stream, header, &loaded_game, checkpoints), SUCCESS, "a compressed save should load");
+        expect_eq(static_cast<int>(checkpoints.size()), 3, "a compressed save should keep its points");
+        expect_true(checkpoints.size() == 3 && !checkpoints[2].visibility_map[0].testBit(2) && checkpoints[1].visibility_map[0].testBit(2), "compressed save points should rebuild");
+        for(auto& checkpoint : checkpoints) {
+                for(auto* object : checkpoint.objects)
+                        delete object;
+        }
+        QFile::remove(save_path);
+}
+
+void test_json_map_cache_follows_the_json() {
+        const QString path = QDir::tempPath() + "/cof_cached_map_test.json";
+        const std::string cache_path = get_map_json_cache_path(path.toStdString());
+        QFile::remove(QString::fromStdString(cache_path));
+
+        game_t game;
+        initialize_visible_game(game, 36, 36);
+        game.map.name = "cached";
+        game.map.players = 1;
+        for(int i = 0; i < 12; ++i)
+                add_pickup(game.map, i, 4);
+        expect_eq(write_map_file_json(path.toStdString(), game.map), SUCCESS, "a JSON map should write");
+
+        adventure_map_t loaded;
+        bool used_cache = true;
+        expect_eq(read_map_file_json_cached(path.toStdString(), loaded, &used_cache), SUCCESS, "a JSON map should load without a cache");
+        expect_true(!used_cache && QFile::exists(QString::fromStdString(cache_path)), "the first load should parse the JSON and write the cache");
+
+        expect_eq(read_map_file_json_cached(path.toStdString(), loaded, &used_cache), SUCCESS, "a JSON map should load from its cache");
+        expect_true(used_cache, "an unchanged map should come from the cache");
+        expect_true(loaded.name == "cached", "the cache should keep the header");
+        expect_eq(static_cast<int>(loaded.objects.size()), 12, "the cache should keep the objects");
+        expect_eq(loaded.get_tile(11, 4).interactable_object, 12, "the cache should keep the tiles");
+
+        game.map.name = "edited";
+        expect_eq(write_map_file_json(path.toStdString(), game.map), SUCCESS, "an edited JSON map should write");
+        expect_eq(read_map_file_json_cached(path.toStdString(), loaded, &used_cache), SUCCESS, "an edited map should load");
+        expect_true(!used_cache && loaded.name == "edited", "an edited map should be parsed again");
+
+        QFile cache_file(QString::fromStdString(cache_path));
+        cache_file.open(QIODevice::ReadWrite);
+        cache_file.seek(MAP_JSON_CACHE_HEADER_SIZE + 8);
+        cache_file.write("XXXX", 4);
+        cache_file.close();
+        expect_eq(read_map_file_json_cached(path.toStdString(), loaded, &used_cache), SUCCESS, "a map with a damaged cache should load");
+        expect_true(!used_cache && loaded.name == "edited", "a damaged cache should fall back to the JSON");
+        bool was_current = false;
+        expect_eq(update_map_json_cache(path.toStdString(), &was_current), SUCCESS, "the rebuilt cache should check out");
+        expect_true(was_current, "a fallback should rewrite the cache");
+
+        QFile::remove(path);
+        QFile::remove(QString::fromStdString(cache_path));
+}
+
+void test_json_map_cache_loads_the_same_map() {
+        const QString path = QDir::tempPath() + "/cof_cached_map_fields_test.json";
+        const std::string cache_path = get_map_json_cache_path(path.toStdString());
+        QFile::remove(QString::fromStdString(cache_path));
+
+        game_t game;
+        initialize_visible_game(game, 30, 28);
+        auto& map = game.map;
+        map.map_uuid = QUuid::createUuid();
+        map.players = 2;
+        map.difficulty = 3;
+        map.win_condition = WIN_CONDITION_CAPTURE_TOWN;
+        map.doodads.push_back({ 7, 2, -4, 20, 3, 2 });
+        add_pickup(map, 5, 6);
+        add_pickup(map, 9, 2, OBJECT_MINE);
+        auto& first = map.player_configurations[0];
+        first.player_number = PLAYER_1;
+        first.color = PLAYER_COLOR_BLUE;
+        first.is_human = true;
+        first.player_name = "first";
+        first.selected_class = HERO_CLASS_KNIGHT;
+        first.was_class_random = true;
+        auto& second = map.player_configurations[1];
+        second.player_number = PLAYER_2;
+        second.color = PLAYER_COLOR_RED;
+        second.team = 1;
+        second.allowed_player_type = PLAYER_TYPE_COMPUTER_ONLY;
+        second.starting_hero_id = 9;
+        second.was_hero_random = true;
+        //the first player has no starting hero in the JSON, which the version 2 reader would otherwise fill in
+        auto hero = make_hero(3, 4);
+        hero.id = 7;
+        hero.name = "cached hero";
+        map.heroes[hero.id] = hero;
+        expect_eq(write_map_file_json(path.toStdString(), map), SUCCESS, "a JSON map should write");
+
+        //names past the version 2 header's limits are only kept by the cache extras
+        QFile json_file(path);
+        json_file.open(QIODevice::ReadOnly);
+        auto json = QJsonDocument::fromJson(json_file.readAll()).object();
+        json_file.close();
+        auto header = json["header"].toObject();
+        header["name"] = QString(40, 'n');
+        header["description"] = QString(300, 'd');
+        json["header"] = header;
+        json_file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        json_file.write(QJsonDocument(json).toJson());
+        json_file.close();
+
+        adventure_map_t from_json;
+        adventure_map_t from_cache;
+        bool used_cache = false;
+        expect_eq(read_map_file_json(path.toStdString(), from_json), SUCCESS, "the JSON should load directly");
+        expect_eq(update_map_json_cache(path.toStdString()), SUCCESS, "the cache should build");
+        expect_eq(read_map_file_json_cached(path.toStdString(), from_cache, &used_cache), SUCCESS, "the map should load from its cache");
+        expect_true(used_cache, "the second load should come from the cache");
+
+        expect_true(from_cache.map_uuid == from_json.map_uuid && from_cache.width == from_json.width && from_cache.height == from_json.height
+                    && from_cache.players == from_json.players && from_cache.difficulty == from_json.difficulty
+                    && from_cache.win_condition == from_json.win_condition && from_cache.loss_condition == from_json.loss_condition,
+                    "the cache should keep the header fields");
+        expect_true(from_cache.name == from_json.name && from_json.name.size() == 40, "the cache should keep a long name");
+        expect_true(from_cache.description == from_json.description && from_json.description.size() == 300, "the cache should keep a long description");
+        for(size_t i = 0; i < from_json.player_configurations.size(); ++i) {
+                const auto& expected = from_json.player_configurations[i];
+                const auto& actual = from_cache.player_configurations[i];
+                expect_true(expected.player_number == actual.player_number && expected.color == actual.color && expected.team == actual.team
+                            && expected.is_human == actual.is_human && expected.player_name == actual.player_name
+                            && expected.selected_class == actual.selected_class && expected.allowed_classes == actual.allowed_classes
+                            && expected.allowed_player_type == actual.allowed_player_type && expected.starting_hero_id == actual.starting_hero_id
+                            && expected.is_hero_set_by_map == actual.is_hero_set_by_map && expected.was_class_random == actual.was_class_random
+                            && expected.was_hero_random == actual.was_hero_random,
+                            "the cache should keep every player configuration field");
+        }
+        expect_eq(from_cache.player_configurations[0].starting_hero_id, -1, "the cache should not pick a starting hero the JSON left unset");
+
+        for(uint y = 0; y < from_json.height; ++y) {
+                for(uint x = 0; x < from_json.width; ++x) {
+                        const map_tile_t expected = from_json.get_tile(x, y);
+                        const map_tile_t actual = from_cache.get_tile(x, y);
+                        expect_true(expected.asset_id == actual.asset_id && expected.terrain_type == actual.terrain_type
+                                    && expected.road_type == actual.road_type && expected.passability == actual.passability
+                                    && expected.zone_id == actual.zone_id && expected.interactable_object == actual.interactable_object,
+                                    "the cache should keep every tile");
+                }
+        }
+        expect_eq(static_cast<int>(from_cache.doodads.size()), static_cast<int>(from_json.doodads.size()), "the cache should keep the doodads");
+        for(size_t i = 0; i < from_json.doodads.size() && i < from_cache.doodads.size(); ++i) {
+                const auto& expected = from_json.doodads[i];
+                const auto& actual = from_cache.doodads[i];
+                expect_true(expected.asset_id == actual.asset_id && expected.z == actual.z && expected.x == actual.x && expected.y == actual.y
+                            && expected.width == actual.width && expected.height == actual.height,
+                            "the cache should keep every doodad field");
+        }
+        expect_eq(static_cast<int>(from_cache.objects.size()), static_cast<int>(from_json.objects.size()), "the cache should keep the objects");
+        for(size_t i = 0; i < from_json.objects.size() && i < from_cache.objects.size(); ++i) {
+                const auto* expected = from_json.objects[i];
+                const auto* actual = from_cache.objects[i];
+                expect_true(expected && actual && expected->object_type == actual->object_type && expected->asset_id == actual->asset_id
+                            && expected->x == actual->x && expected->y == actual->y,
+                            "the cache should keep every object");
+        }
+        expect_eq(static_cast<int>(from_cache.heroes.size()), static_cast<int>(from_json.heroes.size()), "the cache should keep the heroes");
+        for(const auto& [id, expected] : from_json.heroes) {
+                auto actual = from_cache.heroes.find(id);
+                expect_true(actual != from_cache.heroes.end() && actual->second.id == expected.id && actual->second.player == expected.player
+                            && actual->second.x == expected.x && actual->second.y == expected.y && actual->second.name == expected.name,
+                            "the cache should keep every hero under its JSON id");
+        }
+
+        QFile::remove(path);
+        QFile::remove(QString::fromStdString(cache_path));
+}
+
+void test_ai_value_field_patches_match_rebuild() {
+        constexpr uint size = 24;
+        game_t game;
+        initialize_visible_game(game, size, size);
+        auto& visibility = game.get_player(PLAYER_1).tile_visibility;
+        for(uint y = 0; y < size; ++y) {
+                for(uint x = 16; x < size; ++x)
+                        visibility.clearBit(x + y * size);
+        }
+
+        std::mt19937 rng(17);
+        for(int i = 0; i < 40; ++i) {
+                const int x = static_cast<int>(rng() % size);
+                const int y = static_cast<int>(rng() % size);
+                if(!game.map.get_tile(x, y).is_interactable())
+                        add_pickup(game.map, x, y);
+        }
+        for(int i = 0; i < 20; ++i)
+                game.map.get_tile_ref(rng() % size, rng() % size).terrain_type = TERRAIN_SWAMP;
+
+        if(!game.map.get_tile(8, 8).is_interactable()) {
+                add_pickup(game.map, 8, 8, OBJECT_MAP_MONSTER);
+                game.map.set_monster_guard(static_cast<uint16_t>(game.map.objects.size() - 1), true);
+        }
+
+        std::vector<int> values(game.map.objects.size());
+        for(size_t id = 0; id < values.size(); ++id)
+                values[id] = game.map.objects[id]->object_type == OBJECT_MAP_MONSTER ? 0 : 1 + static_cast<int>(rng() % 500);
+
+        ai_value_field_t field;
+        field.update(game.map, visibility, values);
+
+        auto expect_matches_rebuild = [&](const std::string& step) {
+                field.update(game.map, visibility, values);
+                ai_value_field_t rebuilt;
+                rebuilt.update(game.map, visibility, values);
+                expect_true(field.slots == rebuilt.slots, "patched value field should match a rebuild after " + step);
+        };
+
+        for(size_t id = 0; id < game.map.objects.size(); id += 5) {
+                game.map.remove_interactable_object(game.map.objects[id]);
+                values[id] = 0;
+        }
+        expect_matches_rebuild("pickups");
+
+        for(size_t id = 1; id < values.size(); id += 3) {
+                if(game.map.objects[id] && values[id])
+                        values[id] = id % 2 ? 0 : values[id] * 3;
+        }
+        expect_matches_rebuild("value changes");
+
+        for(uint y = 0; y < size; ++y) {
+                for(uint x = 16; x < 20; ++x)
+                        visibility.setBit(x + y * size);
+        }
+        expect_matches_rebuild("revealed tiles");
+
+        for(size_t id = 0; id < game.map.objects.size(); ++id) {
+                if(game.map.objects[id] && game.map.objects[id]->object_type == OBJECT_MAP_MONSTER)
+                        game.map.remove_interactable_object(game.map.objects[id]);
+        }
+        expect_matches_rebuild("a defeated guard");
+
+        auto samples = field.sample(3, 3, 1);
+        expect_true(!samples.empty(), "tiles near objects should hold them");
+        for(const auto& sample : samples) {
+                expect_true(game.map.objects[sample.object] != nullptr && values[sample.object] > 0, "samples should only hold objects still worth something");
+                expect_true(sample.score == field.get_score(sample.object, sample.cost), "samples should be scored by their cost");
+        }
+        expect_true(std::is_sorted(samples.begin(), samples.end(), [](const auto& a, const auto& b) { return a.score > b.score; }), "samples should come best first");
+}
+
+void initialize_ai_game(game_t& game) {
+        constexpr uint size = 32;
+        initialize_visible_game(game, size, size);
+        game.players[0].is_human = false;
+
+        //a human player still to move keeps end_turn from starting the next day
+        player_t human;
+        human.player_number = PLAYER_2;
+        human.is_human = true;
+        human.tile_visibility = tile_bitset_t(size * size, true);
+        human.tile_observability = tile_bitset_t(size * size, true);
+        game.players.push_back(human);
+
+        std::mt19937 rng(11);
+        for(int i = 0; i < 60; ++i) {
+                const int x = static_cast<int>(rng() % size);
+                const int y = static_cast<int>(rng() % size);
+                if(!game.map.get_tile(x, y).is_interactable())
+                        add_pickup(game.map, x, y);
+        }
+
+        for(int i = 0; i < 4; ++i) {
+                auto hero = make_hero(4 + (i * 7), 4 + (i * 7));
+                hero.id = static_cast<uint16_t>(i + 1);
+                if(!game.map.get_tile(hero.x, hero.y).is_interactable())
+                        game.map.heroes[hero.id] = hero;
+        }
+}
+
+std::vector<int> play_ai_turn(uint thread_count) {
+        game_t game;
+        initialize_ai_game(game);
+        game.ai_planning_thread_count = thread_count;
+
+        srand(5);
+        game.process_ai_turn(PLAYER_1);
+
+        std::vector<int> outcome;
+        for(const auto& action : game.last_turn_actions[PLAYER_1]) {
+                outcome.push_back(action.action);
+                outcome.push_back(action.tile_x);
+                outcome.push_back(action.tile_y);
+        }
+        for(const auto& [id, hero] : game.map.heroes) {
+                outcome.push_back(hero.x);
+                outcome.push_back(hero.y);
+                outcome.push_back(hero.movement_points);
+        }
+        outcome.push_back(static_cast<int>(game.map.objects.size()));
+        outcome.push_back(static_cast<int>(std::count(game.map.objects.begin(), game.map.objects.end(), nullptr)));
+        return outcome;
+}
+
+void test_ai_turn_is_independent_of_thread_count() {
+        const auto serial = play_ai_turn(1);
+        const auto parallel = play_ai_turn(4);
+        expect_true(serial.back() > 0, "AI heroes should pick up objects");
+        expect_true(parallel == serial, "AI turns should play out the same on any number of planning threads");
+}
+
+void test_ai_turn_reports_progress_within_budget() {
+        game_t game;
+        initialize_ai_game(game);
+        game.get_player_configuration(PLAYER_1).ai_turn_time_budget_ms = 1;
+
+        std::vector<int> progress;
+        game.ai_turn_progress_callback_fn = [&](player_e player, int percent) {
+                expect_eq(player, PLAYER_1, "progress should be reported for the player taking its turn");
+                progress.push_back(percent);
+        };
+
+        int starting_movement_points = 0;
+        for(const auto& [id, hero] : game.map.heroes)
+                starting_movement_points += hero.movement_points;
+
+        srand(5);
+        game.process_ai_turn(PLAYER_1);
+
+        int movement_points = 0;
+        for(const auto& [id, hero] : game.map.heroes)
+                movement_points += hero.movement_points;
+
+        expect_true(movement_points < starting_movement_points, "heroes should still act on a budget too small to route anything");
+        expect_true(!progress.empty() && progress.back() == 100, "the last progress report should be 100");
+        expect_true(std::is_sorted(progress.begin(), progress.end()), "progress should never go backwards");
+}
+
+bool generate_rmg_test_map(adventure_map_t& map, rmg_context_t& context, int size) {
+        auto biomes = make_four_player_biomes(size);
+        map.width = size;
+        map.height = size;
+        map.tiles.reset(size, size);
+        return generate_random_map(map, biomes, context) == RMG_RESULT_OK;
+}
+
+void expect_same_generated_map(const adventure_map_t& expected, const adventure_map_t& actual, const std::string& message) {
+        expect_true(expected.width == actual.width && expected.height == actual.height, message + ": map size");
+        int tile_mismatches = 0;
+        for(uint y = 0; y < expected.height; ++y) {
+                for(uint x = 0; x < expected.width; ++x) {
+                        const map_tile_t lhs = expected.get_tile(x, y);
+                        const map_tile_t rhs = actual.get_tile(x, y);
+                        if(lhs.asset_id != rhs.asset_id || lhs.terrain_type != rhs.terrain_type || lhs.road_type != rhs.road_type
+                           || lhs.passability != rhs.passability || lhs.zone_id != rhs.zone_id || lhs.interactable_object != rhs.interactable_object)
+                                ++tile_mismatches;
+                }
+        }
+        expect_eq(tile_mismatches, 0, message + ": every tile column");
+
+        expect_eq(static_cast<int>(actual.objects.size()), static_cast<int>(expected.objects.size()), message + ": object count");
+        for(size_t i = 0; i < expected.objects.size() && i < actual.objects.size(); ++i) {
+                const auto* lhs = expected.objects[i];
+                const auto* rhs = actual.objects[i];
+                expect_true((!lhs && !rhs) || (lhs && rhs && lhs->object_type == rhs->object_type && lhs->x == rhs->x && lhs->y == rhs->y),
+                            message + ": objects");
+        }
+
+        expect_eq(static_cast<int>(actual.doodads.size()), static_cast<int>(expected.doodads.size()), message + ": doodad count");
+        for(size_t i = 0; i < expected.doodads.size() && i < actual.doodads.size(); ++i) {
+                const auto& lhs = expected.doodads[i];
+                const auto& rhs = actual.doodads[i];
+                expect_true(lhs.asset_id == rhs.asset_id && lhs.x == rhs.x && lhs.y == rhs.y && lhs.width == rhs.width && lhs.height == rhs.height,
+                            message + ": doodads");
+        }
+}
+
+void test_random_maps_are_independent_of_thread_count() {
+        for(uint32_t seed : { 3u, 41u }) {
+                adventure_map_t serial;
+                rmg_context_t serial_context(seed, 1);
+                expect_true(generate_rmg_test_map(serial, serial_context, 72), "a random map should generate on one thread");
+
+                for(uint thread_count : { 3u, 8u }) {
+                        adventure_map_t threaded;
+                        rmg_context_t threaded_context(seed, thread_count);
+                        expect_true(generate_rmg_test_map(threaded, threaded_context, 72), "a random map should generate on several threads");
+                        expect_same_generated_map(serial, threaded, "seed " + std::to_string(seed) + " on " + std::to_string(thread_count) + " threads");
+                }
+        }
+}
+
+void test_random_map_seed_reproduces_the_map() {
+        adventure_map_t first;
+        rmg_context_t first_context(17, 2);
+        expect_true(generate_rmg_test_map(first, first_context, 72), "a random map should generate");
+
+        adventure_map_t second;
+        rmg_context_t second_context(17, 2);
+        expect_true(generate_rmg_test_map(second, second_context, 72), "a random map should generate again");
+        expect_same_generated_map(first, second, "a context seed");
+
+        //the seed overload seeds a context the same way
+        adventure_map_t from_seed;
+        auto biomes = make_four_player_biomes(72);
+        from_seed.width = 72;
+        from_seed.height = 72;
+        from_seed.tiles.reset(72, 72);
+        expect_true(generate_random_map(from_seed, biomes, 17, 2) == RMG_RESULT_OK, "a random map should generate from a seed");
+        expect_same_generated_map(first, from_seed, "a map seed");
+}
+
 void benchmark_pathfinding() {
         constexpr uint size = 64;
         constexpr int iterations = 100;
@@ -147,7 +1552,7 @@ void benchmark_pathfinding() {
         for(uint y = 0; y < size; ++y) {
                 if(y == size / 2)
                         continue;
-                game.map.get_tile(size / 2, y).passability = 0;
+                game.map.get_tile_ref(size / 2, y).passability = 0;
         }
 
         const auto start = std::chrono::steady_clock::now();
@@ -161,6 +1566,51 @@ void benchmark_pathfinding() {
         std::cout << "Pathfinding benchmark: " << iterations << " routes across " << size << "x" << size
                   << " map in " << micros << "us (" << (micros / iterations) << "us/route).\n";
 }
+void benchmark_map_compression() {
+        constexpr int iterations = 5;
+        const QDir maps_dir("../Maps");
+        const auto map_files = maps_dir.entryList({ "*.cofmap" }, QDir::Files, QDir::Name);
+        if(map_files.isEmpty()) {
+                std::cout << "Map compression benchmark: no maps in " << maps_dir.absolutePath().toStdString() << ", skipped.\n";
+                return;
+        }
+
+        qint64 total_raw = 0;
+        qint64 total_compressed = 0;
+        qint64 total_compress_micros = 0;
+        qint64 total_uncompress_micros = 0;
+        for(const auto& name : map_files) {
+                QFile file(maps_dir.filePath(name));
+                if(!file.open(QIODevice::ReadOnly))
+                        continue;
+                const QByteArray raw = file.readAll();
+
+                auto start = std::chrono::steady_clock::now();
+                QByteArray compressed;
+                for(int i = 0; i < iterations; ++i)
+                        compressed = block_compress(raw);
+                const auto compress_micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+                start = std::chrono::steady_clock::now();
+                QByteArray uncompressed;
+                bool intact = true;
+                for(int i = 0; i < iterations; ++i)
+                        intact = block_uncompress(compressed, uncompressed) && intact;
+                const auto uncompress_micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+                expect_true(intact && uncompressed == raw, "every map should survive compression");
+
+                total_raw += raw.size();
+                total_compressed += compressed.size();
+                total_compress_micros += compress_micros;
+                total_uncompress_micros += uncompress_micros;
+                std::cout << "  " << name.toStdString() << ": " << raw.size() << " -> " << compressed.size() << " bytes\n";
+        }
+
+        auto megabytes_per_second = [&](qint64 micros) { return micros ? (double)total_raw * iterations / micros : 0.0; };
+        std::cout << "Map compression benchmark: " << map_files.size() << " maps, " << total_raw << " -> " << total_compressed
+                  << " bytes (" << (total_raw ? 100 * total_compressed / total_raw : 0) << "%), compress "
+                  << megabytes_per_second(total_compress_micros) << " MB/s, decompress " << megabytes_per_second(total_uncompress_micros) << " MB/s.\n";
+}
 }
 
 int main() {
@@ -170,7 +1620,37 @@ int main() {
         test_interactable_tiles_only_allowed_as_destination();
         test_hero_movement_costs_and_boundaries();
         test_pathfinding_skill_allows_zero_movement_pickups();
+        test_tile_store_chunks_match_tile_views();
+        test_route_matches_reference_on_random_maps();
+        test_reachability_field_matches_routes();
+        test_reachability_field_matches_routes_on_random_maps();
+        test_reachability_fields_invalidate_locally();
+        test_zone_graph_routes_across_zones();
+        test_zone_graph_patches_match_rebuild();
+        test_hero_occupancy_tracks_moves_and_removals();
+        test_monster_guard_zones_update_locally();
+        test_visibility_updates_incrementally();
+        test_visibility_moves_match_full_rebuild();
+        test_object_index_matches_object_scans();
+        test_map_file_v2_round_trips_and_reads_lazily();
+        test_map_file_records_decode_the_same_on_any_thread_count();
+        test_save_points_rebuild_from_deltas();
+        test_async_saves_capture_the_game_when_queued();
+        test_block_compression_round_trips_and_detects_corruption();
+        test_json_map_cache_follows_the_json();
+        test_json_map_cache_loads_the_same_map();
+        test_ai_value_field_patches_match_rebuild();
+        test_ai_turn_is_independent_of_thread_count();
+        test_ai_turn_reports_progress_within_budget();
+        if(game_config::load_game_data("../") == 0) {
+                test_random_maps_are_independent_of_thread_count();
+                test_random_map_seed_reproduces_the_map();
+        }
+        else {
+                expect_true(false, "the random map tests need the game data");
+        }
         benchmark_pathfinding();
+        benchmark_map_compression();
 
         if(failures != 0) {
                 std::cerr << failures << " adventure map test(s) failed.\n";
@@ -14,14 +14,23 @@ LIBS += -llua5.4
 SOURCES += combat_core_tests.cpp \
            ../game/src/core/ai_adventure_map.cpp \
            ../game/src/core/ai_combat.cpp \
+           ../game/src/core/ai_value_field.cpp \
            ../game/src/core/adventure_map.cpp \
            ../game/src/core/hero.cpp \
            ../game/src/core/artifact.cpp \
            ../game/src/core/battlefield.cpp \
+           ../game/src/core/block_compression.cpp \
+           ../game/src/core/fog_of_war.cpp \
            ../game/src/core/lua_api.cpp \
            ../game/src/core/game.cpp \
            ../game/src/core/game_config.cpp \
            ../game/src/core/interactable_object.cpp \
            ../game/src/core/map_file.cpp \
+           ../game/src/core/map_file_v2.cpp \
+           ../game/src/core/object_index.cpp \
            ../game/src/core/script.cpp \
-           ../game/src/core/town.cpp
+           ../game/src/core/save_checkpoint.cpp \
+           ../game/src/core/save_worker.cpp \
+           ../game/src/core/tile_store.cpp \
+           ../game/src/core/town.cpp \
+           ../game/src/core/zone_graph.cpp
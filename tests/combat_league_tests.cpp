@@ -0,0 +1,96 @@
+#include "core/game_config.h"
+#include "rl/combat_league.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+int failures = 0;
+
+void expect_true(bool condition, const std::string& message) {
+        if(!condition) {
+                std::cerr << "FAIL: " << message << '\n';
+                ++failures;
+        }
+}
+
+template <typename T, typename U>
+void expect_eq(const T& actual, const U& expected, const std::string& message) {
+        if(!(actual == expected)) {
+                std::cerr << "FAIL: " << message << " (actual=" << actual << ", expected=" << expected << ")\n";
+                ++failures;
+        }
+}
+
+hero_loadout_spec_t make_loadout(player_e player, uint16_t hero_id, unit_type_e unit_type, uint16_t stack_size) {
+        hero_loadout_spec_t loadout;
+        loadout.player = player;
+        loadout.hero_id = hero_id;
+        loadout.attack = 2;
+        loadout.defense = 2;
+        loadout.mana = 12;
+        loadout.troops[0] = troop_stack_spec_t{unit_type, stack_size};
+        return loadout;
+}
+
+//two scenarios, so a worker that kept one battlefield between matches would show up in the results
+std::vector<combat_scenario_spec_t> make_league_scenarios() {
+        std::vector<combat_scenario_spec_t> scenarios(2);
+        scenarios[0].attacker = make_loadout(PLAYER_1, 1, static_cast<unit_type_e>(16), 20);
+        scenarios[0].defender = make_loadout(PLAYER_2, 2, static_cast<unit_type_e>(16), 20);
+        scenarios[1].attacker = make_loadout(PLAYER_1, 1, static_cast<unit_type_e>(16), 26);
+        scenarios[1].defender = make_loadout(PLAYER_2, 2, static_cast<unit_type_e>(16), 17);
+        return scenarios;
+}
+
+league_results_t run_builtin_league(std::size_t thread_count) {
+        const std::vector<league_participant_t> participants = { { "builtin_a", "" }, { "builtin_b", "" }, { "builtin_c", "" } };
+        league_config_t config;
+        config.rounds = 4;
+        config.thread_count = thread_count;
+        config.seed = 7;
+        return run_combat_league(participants, make_league_scenarios(), config);
+}
+
+void test_league_results_do_not_depend_on_thread_count() {
+        const auto serial = run_builtin_league(1);
+        const auto threaded = run_builtin_league(4);
+
+        expect_eq(threaded.game_results.size(), serial.game_results.size(), "both leagues should play the same schedule");
+        for(std::size_t i = 0; i < serial.game_results.size() && i < threaded.game_results.size(); ++i) {
+                const auto& lhs = serial.game_results[i];
+                const auto& rhs = threaded.game_results[i];
+                expect_true(lhs.attacker == rhs.attacker && lhs.defender == rhs.defender && lhs.scenario == rhs.scenario
+                            && lhs.result == rhs.result && lhs.steps == rhs.steps,
+                            "game " + std::to_string(i) + " should play out the same on any thread count");
+        }
+        expect_true(threaded.score == serial.score, "the score matrix should not depend on thread count");
+        expect_true(threaded.games == serial.games, "the games matrix should not depend on thread count");
+        expect_true(threaded.elo == serial.elo, "the Elo ratings should not depend on thread count");
+        expect_eq(threaded.draws, serial.draws, "the draw count should not depend on thread count");
+}
+} // namespace
+
+int main() {
+        auto config_root = std::filesystem::current_path();
+        while(!std::filesystem::exists(config_root / "config" / "creatures.tsv") && config_root.has_parent_path())
+                config_root = config_root.parent_path();
+
+        if(game_config::load_game_data(config_root.string() + "/") != 0) {
+                std::cerr << "FAIL: game config failed to load\n";
+                return EXIT_FAILURE;
+        }
+
+        test_league_results_do_not_depend_on_thread_count();
+
+        if(failures != 0) {
+                std::cerr << failures << " combat league test(s) failed.\n";
+                return EXIT_FAILURE;
+        }
+
+        std::cout << "All combat league tests passed.\n";
+        return EXIT_SUCCESS;
+}
@@ -0,0 +1,50 @@
+TEMPLATE = app
+TARGET = combat_league_tests
+
+INCLUDEPATH += ..
+INCLUDEPATH += ../game/src
+INCLUDEPATH += ../game/src/rl
+INCLUDEPATH += $$PWD/../libtorch/include
+INCLUDEPATH += $$PWD/../libtorch/include/torch/csrc/api/include
+
+CONFIG += qt debug console c++20 link_pkgconfig
+CONFIG -= app_bundle
+QT += core network gui
+PKGCONFIG += lua5.4
+
+LIBS += -llua5.4
+LIBS += -L$$PWD/../libtorch/lib -ltorch -ltorch_cpu -lc10 -ltorch_global_deps -lkineto
+
+QMAKE_CXXFLAGS += -D_GLIBCXX_USE_CXX11_ABI=1
+QMAKE_LFLAGS += -Wl,-rpath,$$PWD/../libtorch/lib
+QMAKE_LFLAGS += -Wl,--no-as-needed
+
+SOURCES += combat_league_tests.cpp \
+           ../game/src/core/ai_adventure_map.cpp \
+           ../game/src/core/ai_combat.cpp \
+           ../game/src/core/ai_value_field.cpp \
+           ../game/src/core/adventure_map.cpp \
+           ../game/src/core/hero.cpp \
+           ../game/src/core/artifact.cpp \
+           ../game/src/core/battlefield.cpp \
+           ../game/src/core/block_compression.cpp \
+           ../game/src/core/fog_of_war.cpp \
+           ../game/src/core/lua_api.cpp \
+           ../game/src/core/game.cpp \
+           ../game/src/core/game_config.cpp \
+           ../game/src/core/interactable_object.cpp \
+           ../game/src/core/map_file.cpp \
+           ../game/src/core/map_file_v2.cpp \
+           ../game/src/core/object_index.cpp \
+           ../game/src/core/script.cpp \
+           ../game/src/core/save_checkpoint.cpp \
+           ../game/src/core/save_worker.cpp \
+           ../game/src/core/tile_store.cpp \
+           ../game/src/core/town.cpp \
+           ../game/src/core/zone_graph.cpp \
+           ../game/src/rl/battle_sim.cpp \
+           ../game/src/rl/battle_session.cpp \
+           ../game/src/rl/combat_agent.cpp \
+           ../game/src/rl/combat_environment.cpp \
+           ../game/src/rl/combat_league.cpp \
+           ../game/src/rl/combat_observation.cpp